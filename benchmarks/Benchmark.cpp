@@ -0,0 +1,238 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/*****************************************************************************
+ * BenchmarkSuite class
+ *****************************************************************************/
+
+/* Returns the number of seconds taken to call a function a number of
+   times */
+static double time(const std::function<void()>& function, uint64_t calls) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < calls; ++i)
+        function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Returns a string with any characters that can't appear in a JSON string
+   escaped */
+static std::string escapeJSON(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+void BenchmarkSuite::add(const std::string& name, uint64_t operationsPerCall, std::function<void()> function) {
+    benchmarks.push_back({name, operationsPerCall, function});
+}
+
+BenchmarkSuite::Result BenchmarkSuite::run(const Benchmark& benchmark) const {
+    // Warm up (doubling the calls each time) to estimate the time per call
+    uint64_t calls     = 1;
+    double elapsed     = 0.0;
+    double callElapsed = time(benchmark.function, calls);
+    while (elapsed + callElapsed < warmUpTime) {
+        elapsed += callElapsed;
+        calls *= 2;
+        callElapsed = time(benchmark.function, calls);
+    }
+    double timePerCall = callElapsed / static_cast<double>(calls);
+
+    uint64_t callsPerSample = std::max<uint64_t>(1, static_cast<uint64_t>(sampleTime / std::max(timePerCall, 1e-9)));
+
+    double fastestSample = time(benchmark.function, callsPerSample);
+    for (unsigned int i = 1; i < sampleCount; ++i)
+        fastestSample = std::min(fastestSample, time(benchmark.function, callsPerSample));
+
+    Result result;
+    result.name         = benchmark.name;
+    result.operations   = callsPerSample * benchmark.operationsPerCall * sampleCount;
+    result.nsPerOp      = fastestSample * 1e9 / static_cast<double>(callsPerSample * benchmark.operationsPerCall);
+    result.opsPerSecond = 1e9 / result.nsPerOp;
+    return result;
+}
+
+std::vector<BenchmarkSuite::Result> BenchmarkSuite::run(const std::string& filter) const {
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (filter.empty() || benchmark.name.find(filter) != std::string::npos)
+            results.push_back(run(benchmark));
+    }
+    return results;
+}
+
+std::string BenchmarkSuite::toJSON(const std::vector<Result>& results, const std::map<std::string, std::string>& properties) {
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\n";
+    for (const auto& property : properties)
+        json << "  \"" << escapeJSON(property.first) << "\": \"" << escapeJSON(property.second) << "\",\n";
+    json << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        json << (i == 0 ? "\n" : ",\n");
+        json << "    {\"name\": \"" << escapeJSON(results[i].name) << "\", \"operations\": " << results[i].operations << ", \"nsPerOp\": " << results[i].nsPerOp << ", \"opsPerSecond\": " << results[i].opsPerSecond << "}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+bool BenchmarkSuite::readBaseline(const std::string& path, std::map<std::string, double>& nsPerOp) {
+    std::ifstream input(path);
+    if (! input.is_open())
+        return false;
+    std::stringstream stream;
+    stream << input.rdbuf();
+    std::string json = stream.str();
+
+    // Only documents written by toJSON need to be understood, so rather than
+    // parsing it fully just look for each name and the time following it
+    const std::string nameKey = "\"name\": \"";
+    const std::string timeKey = "\"nsPerOp\": ";
+    size_t position           = json.find(nameKey);
+    while (position != std::string::npos) {
+        // Find the end of the name (skipping escaped characters)
+        size_t start = position + nameKey.length();
+        size_t end   = start;
+        std::string name;
+        while (end < json.length() && json[end] != '"') {
+            if (json[end] == '\\')
+                ++end;
+            if (end < json.length())
+                name += json[end];
+            ++end;
+        }
+
+        size_t timePosition = json.find(timeKey, end);
+        if (timePosition == std::string::npos)
+            break;
+        nsPerOp[name] = std::strtod(json.c_str() + timePosition + timeKey.length(), nullptr);
+
+        position = json.find(nameKey, timePosition);
+    }
+    return true;
+}
+
+std::vector<BenchmarkSuite::Comparison> BenchmarkSuite::compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline, double tolerance) {
+    std::vector<Comparison> comparisons;
+    for (const Result& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0)
+            continue;
+
+        Comparison comparison;
+        comparison.name            = result.name;
+        comparison.nsPerOp         = result.nsPerOp;
+        comparison.baselineNsPerOp = it->second;
+        comparison.change          = result.nsPerOp / it->second - 1.0;
+        comparison.regressed       = comparison.change > tolerance;
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+/*****************************************************************************
+ * CheckSuite class
+ *****************************************************************************/
+
+void CheckSuite::add(const std::string& name, double bound, std::function<double()> function) {
+    checks.push_back({name, bound, function});
+}
+
+std::vector<CheckSuite::Result> CheckSuite::run(const std::string& filter) const {
+    std::vector<Result> results;
+    for (const Check& check : checks) {
+        if (filter.empty() || check.name.find(filter) != std::string::npos) {
+            double error = check.function();
+            results.push_back({check.name, error, check.bound, error <= check.bound});
+        }
+    }
+    return results;
+}
+
+/*****************************************************************************
+ * Running a benchmark program
+ *****************************************************************************/
+
+int utils_benchmark::run(int argc, char** argv, const CheckSuite& checks, BenchmarkSuite& suite, const std::map<std::string, std::string>& properties) {
+    std::string outputPath;
+    std::string baselinePath;
+    std::string filter;
+    double tolerance = 0.15;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue        = i + 1 < argc;
+        if (argument == "--output" && hasValue)
+            outputPath = argv[++i];
+        else if (argument == "--baseline" && hasValue)
+            baselinePath = argv[++i];
+        else if (argument == "--tolerance" && hasValue)
+            tolerance = std::strtod(argv[++i], nullptr);
+        else if (argument == "--filter" && hasValue)
+            filter = argv[++i];
+        else if (argument == "--quick") {
+            suite.setWarmUpTime(0.01);
+            suite.setSampleTime(0.005);
+            suite.setSampleCount(3);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--output <file>] [--baseline <file>] [--tolerance <fraction>] [--filter <text>] [--quick]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<CheckSuite::Result> checkResults = checks.run(filter);
+    unsigned int failures                        = 0;
+    for (const CheckSuite::Result& result : checkResults) {
+        std::cerr << std::left << std::setw(48) << result.name << std::right << std::scientific << std::setprecision(3)
+                  << " max error " << result.error << " (bound " << result.bound << ")" << (result.passed ? "" : "  FAILED") << std::defaultfloat << std::endl;
+        if (! result.passed)
+            ++failures;
+    }
+    std::cerr << failures << " of " << checkResults.size() << " checks failed" << std::endl;
+
+    std::vector<BenchmarkSuite::Result> results = suite.run(filter);
+    std::string json                            = BenchmarkSuite::toJSON(results, properties);
+    std::cout << json;
+
+    if (! outputPath.empty()) {
+        std::ofstream output(outputPath);
+        if (! output.is_open()) {
+            std::cerr << "Failed to write results to " << outputPath << std::endl;
+            return 2;
+        }
+        output << json;
+    }
+
+    if (baselinePath.empty())
+        return failures > 0 ? 1 : 0;
+
+    std::map<std::string, double> baseline;
+    if (! BenchmarkSuite::readBaseline(baselinePath, baseline)) {
+        std::cerr << "Failed to read baseline " << baselinePath << std::endl;
+        return 2;
+    }
+
+    std::vector<BenchmarkSuite::Comparison> comparisons = BenchmarkSuite::compare(results, baseline, tolerance);
+    unsigned int regressions                           = 0;
+    for (const BenchmarkSuite::Comparison& comparison : comparisons) {
+        std::cerr << std::left << std::setw(48) << comparison.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << comparison.nsPerOp << " ns/op (baseline " << comparison.baselineNsPerOp << ", "
+                  << std::showpos << comparison.change * 100.0 << std::noshowpos << "%)" << (comparison.regressed ? "  REGRESSION" : "") << std::endl;
+        if (comparison.regressed)
+            ++regressions;
+    }
+    std::cerr << regressions << " of " << comparisons.size() << " benchmarks regressed by more than " << tolerance * 100.0 << "%" << std::endl;
+
+    return regressions > 0 || failures > 0 ? 1 : 0;
+}
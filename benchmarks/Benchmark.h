@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && ! defined(__clang__)
+#include <intrin.h>
+#endif
+
+/*****************************************************************************
+ * utils_benchmark namespace - Helpers for writing benchmarks
+ *****************************************************************************/
+
+namespace utils_benchmark {
+    /* Prevents the compiler from removing the computation of a value (and
+       any writes to memory before this point) because the result is never
+       read */
+    template <typename T>
+    inline void doNotOptimise(const T& value) {
+#if defined(_MSC_VER) && ! defined(__clang__)
+        const volatile void* volatile address = &value;
+        (void) address;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "g"(&value) : "memory");
+#endif
+    }
+}  // namespace utils_benchmark
+
+/*****************************************************************************
+ * BenchmarkSuite class - Times a set of operations and reports the results
+ *                        as JSON, optionally comparing them to a baseline
+ *****************************************************************************/
+
+// Each benchmark is a function performing a fixed number of operations
+// (normally the same operation over an array of inputs so the cost of the
+// call itself is negligible). It is first run repeatedly for a warm up
+// period, which also estimates how many calls fit in a sample, and is then
+// timed over several samples. The fastest sample is reported as it is the
+// least affected by interruptions from the OS and other processes (which
+// only ever make a sample slower), keeping comparisons between runs stable.
+
+class BenchmarkSuite {
+public:
+    /* Timing of a single benchmark */
+    struct Result {
+        std::string name;
+        // Number of operations timed (across all samples)
+        uint64_t operations;
+        // Time per operation of the fastest sample and the equivalent
+        // throughput
+        double nsPerOp;
+        double opsPerSecond;
+    };
+
+    /* Comparison of a result to a baseline */
+    struct Comparison {
+        std::string name;
+        double nsPerOp;
+        double baselineNsPerOp;
+        // Relative change in the time per operation (positive is slower)
+        double change;
+        // States whether the change exceeds the tolerance
+        bool regressed;
+    };
+
+private:
+    /* Benchmark added to this suite */
+    struct Benchmark {
+        std::string name;
+        uint64_t operationsPerCall;
+        std::function<void()> function;
+    };
+
+    /* Benchmarks in the order they were added */
+    std::vector<Benchmark> benchmarks;
+
+    /* Time to run each benchmark for before timing it (in seconds) */
+    double warmUpTime = 0.05;
+
+    /* Target duration and number of samples to time */
+    double sampleTime        = 0.02;
+    unsigned int sampleCount = 7;
+
+    /* Runs a single benchmark */
+    Result run(const Benchmark& benchmark) const;
+
+public:
+    /* Constructor and destructor */
+    BenchmarkSuite() {}
+    virtual ~BenchmarkSuite() {}
+
+    /* Adds a benchmark where each call of function performs
+       operationsPerCall operations */
+    void add(const std::string& name, uint64_t operationsPerCall, std::function<void()> function);
+
+    /* Runs every benchmark whose name contains filter (all of them if it
+       is empty) and returns the results */
+    std::vector<Result> run(const std::string& filter = "") const;
+
+    /* Returns results as a JSON document (properties is written as extra
+       string values describing the configuration) */
+    static std::string toJSON(const std::vector<Result>& results, const std::map<std::string, std::string>& properties);
+
+    /* Reads the time per operation of each benchmark from a JSON document
+       previously written by toJSON, returns whether the file could be
+       read */
+    static bool readBaseline(const std::string& path, std::map<std::string, double>& nsPerOp);
+
+    /* Compares results to a baseline - a result has regressed when its time
+       per operation is more than (1 + tolerance) times the baseline's
+       (results without a baseline are skipped) */
+    static std::vector<Comparison> compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline, double tolerance);
+
+    /* Setters */
+    inline void setWarmUpTime(double seconds) { warmUpTime = seconds; }
+    inline void setSampleTime(double seconds) { sampleTime = seconds; }
+    inline void setSampleCount(unsigned int count) { sampleCount = count; }
+};
+
+/*****************************************************************************
+ * CheckSuite class - Measures how far the results of a set of operations are
+ *                    from reference results, failing any whose error is
+ *                    larger than the bound given for it
+ *****************************************************************************/
+
+// Used alongside the benchmarks so the faster paths they time are also
+// checked against what they promise (e.g. a SIMD path against the generic
+// one, or the documented error of an approximation). Each check returns the
+// largest error it found over its inputs, in whatever units its bound is
+// given in.
+
+class CheckSuite {
+public:
+    /* Outcome of a single check */
+    struct Result {
+        std::string name;
+        double error;
+        double bound;
+        // States whether the error is within the bound (it isn't when NaN)
+        bool passed;
+    };
+
+private:
+    /* Check added to this suite */
+    struct Check {
+        std::string name;
+        double bound;
+        std::function<double()> function;
+    };
+
+    /* Checks in the order they were added */
+    std::vector<Check> checks;
+
+public:
+    /* Constructor and destructor */
+    CheckSuite() {}
+    virtual ~CheckSuite() {}
+
+    /* Adds a check where function returns the largest error it measures */
+    void add(const std::string& name, double bound, std::function<double()> function);
+
+    /* Runs every check whose name contains filter (all of them if it is
+       empty) and returns the results */
+    std::vector<Result> run(const std::string& filter = "") const;
+};
+
+/*****************************************************************************
+ * Running a benchmark program
+ *****************************************************************************/
+
+// Usage: <program> [--output <file>] [--baseline <file>]
+//                  [--tolerance <fraction>] [--filter <text>] [--quick]
+//
+// The checks matching the filter are run first, with their results printed
+// to the standard error. The benchmarks matching it are then timed and the
+// results printed to the standard output as JSON (and also written to the
+// output file if given). When a baseline is given (itself written with
+// --output) a comparison is printed to the standard error. The exit code is
+// 1 if any check fails or any benchmark is slower than the baseline by more
+// than the tolerance (0.15 by default), and 2 if the arguments or files are
+// invalid. Baselines are only meaningful on the machine and build
+// configuration they were recorded with.
+
+namespace utils_benchmark {
+    /* Runs the checks and benchmarks of a program as described above given
+       its command line arguments (properties are written as extra values in
+       the JSON) and returns the exit code */
+    int run(int argc, char** argv, const CheckSuite& checks, BenchmarkSuite& suite, const std::map<std::string, std::string>& properties);
+}  // namespace utils_benchmark
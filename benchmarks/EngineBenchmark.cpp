@@ -0,0 +1,258 @@
+#include <random>
+
+#include "../src/core/BVH.h"
+#include "../src/core/maths/Quaternion.h"
+#include "../src/core/maths/Streams.h"
+#include "../src/core/render/MeshOptimiser.h"
+#include "Benchmark.h"
+#include "EngineChecks.h"
+#include "EngineInputs.h"
+
+/*****************************************************************************
+ * Engine benchmarks - Measures the performance of engine code that needs
+ *                     more than the maths classes (but still no window or
+ *                     GPU)
+ *****************************************************************************/
+
+// See utils_benchmark::run for the usage. Before anything is timed the
+// checks (see EngineChecks.h) matching the filter are run. Unlike the maths
+// benchmarks most calls are a whole pass over a large mesh, so their times
+// are given per triangle.
+
+/* Number of queries each BVH benchmark makes per call */
+static const size_t COUNT = 1024;
+
+/* Number of values in each stream (enough that the loop overheads don't
+   matter while still fitting in the L2 cache) */
+static const size_t STREAM_SIZE = 8192;
+
+/* Seed for generating inputs so every run measures the same data */
+static const unsigned int SEED = 12345;
+
+/* Generates the inputs for the benchmarks */
+class Inputs {
+private:
+    std::mt19937 generator;
+    std::uniform_real_distribution<float> unit;
+
+public:
+    // The spheres before and after each pass that is timed
+    MeshData* shuffled;
+    MeshData* vertexCache;
+    MeshData* overdraw;
+
+    // Hierarchy over the spheres queried with rays from outside them aimed
+    // somewhere inside (as when picking) and small boxes around them
+    MeshBVH bvh;
+    std::vector<Ray> rays;
+    std::vector<AABB> boxes;
+
+    // Hierarchy over instances of the spheres scattered around the origin
+    // queried with rays from anywhere between them
+    SceneBVH scene;
+    std::vector<Ray> sceneRays;
+
+    // Vectors and unit quaternions both as streams and as arrays of
+    // structures to compare them with
+    std::vector<Vector3f> vectors1, vectors2;
+    std::vector<Quaternion> quaternions1, quaternions2;
+    Vector3Stream vectorStream1, vectorStream2;
+    QuaternionStream quaternionStream1, quaternionStream2;
+
+    Inputs() : generator(SEED), unit(-1.0f, 1.0f) {
+        shuffled = createSpheres(SPHERES_SEGMENTS, SEED);
+
+        vertexCache = new MeshData(*shuffled);
+        std::vector<uint32_t> optimised;
+        MeshOptimiser::optimiseVertexCache(vertexCache, optimised);
+        vertexCache->getIndices().swap(optimised);
+
+        overdraw = new MeshData(*vertexCache);
+        MeshOptimiser::optimiseOverdraw(overdraw);
+
+        bvh.build(shuffled);
+        for (size_t i = 0; i < COUNT; ++i) {
+            Vector3f origin = randomDirection() * 3.0f;
+            rays.push_back(Ray(origin, (randomDirection() * 0.9f - origin).normalised()));
+
+            Vector3f centre = randomDirection() * (1.0f + unit(generator) * 0.1f);
+            boxes.push_back(AABB(centre - Vector3f(0.05f, 0.05f, 0.05f), centre + Vector3f(0.05f, 0.05f, 0.05f)));
+        }
+
+        std::vector<SceneBVH::Instance> instances;
+        for (unsigned int i = 0; i < 64; ++i) {
+            Matrix4f translation;
+            translation.initTranslation(Vector3f(unit(generator), unit(generator), unit(generator)) * 20.0f);
+            instances.push_back({&bvh, translation * Quaternion().initFromAxisAngle(randomDirection(), unit(generator) * 3.14159265f).toMatrix()});
+        }
+        scene.build(instances);
+        for (size_t i = 0; i < COUNT; ++i)
+            sceneRays.push_back(Ray(Vector3f(unit(generator), unit(generator), unit(generator)) * 20.0f, randomDirection()));
+
+        for (size_t i = 0; i < STREAM_SIZE; ++i) {
+            vectors1.push_back(Vector3f(unit(generator), unit(generator), unit(generator)));
+            vectors2.push_back(Vector3f(unit(generator), unit(generator), unit(generator)));
+            quaternions1.push_back(Quaternion().initFromAxisAngle(randomDirection(), unit(generator) * 3.14159265f));
+            quaternions2.push_back(Quaternion().initFromAxisAngle(randomDirection(), unit(generator) * 3.14159265f));
+        }
+        vectorStream1.assign(vectors1.data(), STREAM_SIZE);
+        vectorStream2.assign(vectors2.data(), STREAM_SIZE);
+        quaternionStream1.assign(quaternions1.data(), STREAM_SIZE);
+        quaternionStream2.assign(quaternions2.data(), STREAM_SIZE);
+    }
+
+    virtual ~Inputs() {
+        delete shuffled;
+        delete vertexCache;
+        delete overdraw;
+    }
+
+    inline Vector3f randomDirection() {
+        Vector3f direction;
+        do
+            direction = Vector3f(unit(generator), unit(generator), unit(generator));
+        while (direction.length() > 1.0f || direction.length() < 0.1f);
+        return direction.normalised();
+    }
+};
+
+/* Adds the benchmarks to a suite (the inputs must remain valid while it is
+   run) */
+static void addBenchmarks(BenchmarkSuite& suite, Inputs& in) {
+    static std::vector<uint32_t> indices(in.shuffled->getIndices().size());
+    const uint64_t triangles = in.shuffled->getIndices().size() / 3;
+
+    // Mesh optimisation (one operation is a triangle, and the index
+    // optimisations use the raw overloads over each sub data so nothing
+    // else is timed)
+    suite.add("MeshOptimiser::optimiseVertexCache", triangles, [&]() {
+        for (unsigned int i = 0; i < in.shuffled->getSubDataCount(); ++i) {
+            size_t first, last;
+            in.shuffled->getSubDataRange(i, first, last);
+            MeshOptimiser::optimiseVertexCache(indices.data() + first, in.shuffled->getIndices().data() + first, last - first);
+        }
+        utils_benchmark::doNotOptimise(indices);
+    });
+    suite.add("MeshOptimiser::optimiseOverdraw", triangles, [&]() {
+        size_t offset, stride;
+        const float* positions = in.vertexCache->getStream(MeshData::POSITION, offset, stride)->data() + offset;
+        for (unsigned int i = 0; i < in.vertexCache->getSubDataCount(); ++i) {
+            size_t first, last;
+            in.vertexCache->getSubDataRange(i, first, last);
+            MeshOptimiser::optimiseOverdraw(indices.data() + first, in.vertexCache->getIndices().data() + first, last - first, positions + in.vertexCache->getSubData(i).vertexOffset * stride, stride);
+        }
+        utils_benchmark::doNotOptimise(indices);
+    });
+    // Includes copying the mesh, as the pass rewrites it in place
+    suite.add("MeshOptimiser::optimiseVertexFetch (with copy)", triangles, [&]() {
+        MeshData data(*in.overdraw);
+        MeshOptimiser::optimiseVertexFetch(&data);
+        utils_benchmark::doNotOptimise(data.getIndices());
+    });
+
+    // Bounding volume hierarchies (building is timed per triangle and each
+    // query as one operation)
+    static std::vector<uint8_t> results(COUNT);
+    static std::vector<uint32_t> found;
+    suite.add("MeshBVH::build", triangles, [&]() {
+        MeshBVH bvh(in.shuffled);
+        utils_benchmark::doNotOptimise(bvh);
+    });
+    suite.add("MeshBVH::intersect", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            BVH::Hit hit;
+            results[i] = in.bvh.intersect(in.rays[i], hit);
+            utils_benchmark::doNotOptimise(hit);
+        }
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("MeshBVH::intersectsAny", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            results[i] = in.bvh.intersectsAny(in.rays[i]);
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("MeshBVH::query", COUNT, [&]() {
+        found.clear();
+        for (size_t i = 0; i < COUNT; ++i)
+            in.bvh.query(in.boxes[i], found);
+        utils_benchmark::doNotOptimise(found);
+    });
+    suite.add("SceneBVH::intersect (64 instances)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            BVH::Hit hit;
+            results[i] = in.scene.intersect(in.sceneRays[i], hit);
+            utils_benchmark::doNotOptimise(hit);
+        }
+        utils_benchmark::doNotOptimise(results);
+    });
+
+    // Structure of arrays streams, each followed by the same operation on an
+    // array of structures (one operation is a vector or quaternion)
+    static Vector3Stream vectorStream(STREAM_SIZE);
+    static QuaternionStream quaternionStream(STREAM_SIZE);
+    static std::vector<Vector3f> vectors(STREAM_SIZE);
+    static std::vector<Quaternion> quaternions(STREAM_SIZE);
+    suite.add("Vector3Stream::addScaled", STREAM_SIZE, [&]() {
+        in.vectorStream1.addScaled(in.vectorStream2, 1e-3f);
+        utils_benchmark::doNotOptimise(in.vectorStream1);
+    });
+    suite.add("Vector3Stream::addScaled (array of structures)", STREAM_SIZE, [&]() {
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            in.vectors1[i] += in.vectors2[i] * 1e-3f;
+        utils_benchmark::doNotOptimise(in.vectors1);
+    });
+    suite.add("Vector3Stream::cross", STREAM_SIZE, [&]() {
+        in.vectorStream1.cross(in.vectorStream2, vectorStream);
+        utils_benchmark::doNotOptimise(vectorStream);
+    });
+    suite.add("Vector3Stream::cross (array of structures)", STREAM_SIZE, [&]() {
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            vectors[i] = in.vectors1[i].cross(in.vectors2[i]);
+        utils_benchmark::doNotOptimise(vectors);
+    });
+    // Copies the inputs first so the same vectors are normalised every time
+    suite.add("Vector3Stream::normalise (with copy)", STREAM_SIZE, [&]() {
+        vectorStream = in.vectorStream2;
+        vectorStream.normalise();
+        utils_benchmark::doNotOptimise(vectorStream);
+    });
+    suite.add("Vector3Stream::normalise (array of structures with copy)", STREAM_SIZE, [&]() {
+        vectors = in.vectors2;
+        for (Vector3f& vector : vectors)
+            vector.normalise();
+        utils_benchmark::doNotOptimise(vectors);
+    });
+    suite.add("QuaternionStream::multiply", STREAM_SIZE, [&]() {
+        in.quaternionStream1.multiply(in.quaternionStream2, quaternionStream);
+        utils_benchmark::doNotOptimise(quaternionStream);
+    });
+    suite.add("QuaternionStream::multiply (array of structures)", STREAM_SIZE, [&]() {
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            quaternions[i] = in.quaternions1[i] * in.quaternions2[i];
+        utils_benchmark::doNotOptimise(quaternions);
+    });
+    suite.add("QuaternionStream::rotate", STREAM_SIZE, [&]() {
+        in.quaternionStream1.rotate(in.vectorStream2, vectorStream);
+        utils_benchmark::doNotOptimise(vectorStream);
+    });
+    suite.add("QuaternionStream::rotate (array of structures)", STREAM_SIZE, [&]() {
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            vectors[i] = Quaternion::rotate(in.vectors2[i], in.quaternions1[i]);
+        utils_benchmark::doNotOptimise(vectors);
+    });
+    suite.add("QuaternionStream::nlerp", STREAM_SIZE, [&]() {
+        QuaternionStream::nlerp(in.quaternionStream1, in.quaternionStream2, 0.3f, quaternionStream);
+        utils_benchmark::doNotOptimise(quaternionStream);
+    });
+}
+
+int main(int argc, char** argv) {
+    CheckSuite checks;
+    addEngineChecks(checks);
+
+    Inputs inputs;
+    BenchmarkSuite suite;
+    addBenchmarks(suite, inputs);
+
+    return utils_benchmark::run(argc, argv, checks, suite, {});
+}
@@ -0,0 +1,836 @@
+#include "EngineChecks.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <random>
+
+#include "../src/core/BVH.h"
+#include "../src/core/maths/Quaternion.h"
+#include "../src/core/maths/Streams.h"
+#include "../src/core/render/MeshOptimiser.h"
+#include "EngineInputs.h"
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+/* Seed for generating inputs so every run checks the same data */
+static const unsigned int SEED = 54321;
+
+/*****************************************************************************
+ * Mesh optimisation
+ *****************************************************************************/
+
+// The passes are run in the order a loader would use them on the same mesh
+// the benchmarks time, and each check compares one stage to the one before
+// it. Overdraw is measured with a depth tested software rasteriser from 14
+// directions around the mesh (along the axes and the diagonals), as the
+// number of pixels shaded per pixel covered.
+
+/* Copies of the mesh after each pass (created when first needed as the
+   passes take a while on a mesh this size) */
+class OptimisedMeshes {
+public:
+    MeshData* shuffled;
+    MeshData* vertexCache;
+    MeshData* overdraw;
+    MeshData* vertexFetch;
+
+    OptimisedMeshes() {
+        shuffled = createSpheres(SPHERES_SEGMENTS, SEED);
+
+        vertexCache = new MeshData(*shuffled);
+        std::vector<uint32_t> optimised;
+        MeshOptimiser::optimiseVertexCache(vertexCache, optimised);
+        vertexCache->getIndices().swap(optimised);
+
+        overdraw = new MeshData(*vertexCache);
+        MeshOptimiser::optimiseOverdraw(overdraw);
+
+        vertexFetch = new MeshData(*overdraw);
+        MeshOptimiser::optimiseVertexFetch(vertexFetch);
+    }
+
+    virtual ~OptimisedMeshes() {
+        delete shuffled;
+        delete vertexCache;
+        delete overdraw;
+        delete vertexFetch;
+    }
+
+    static const OptimisedMeshes& get() {
+        static OptimisedMeshes meshes;
+        return meshes;
+    }
+};
+
+/* Returns the triangles of each sub data of a mesh in a form that can be
+   compared regardless of the order they are drawn in (each one rotated to
+   start with its smallest index, then sorted) */
+static std::vector<std::vector<std::array<uint32_t, 3>>> getTriangleSets(MeshData* data) {
+    std::vector<std::vector<std::array<uint32_t, 3>>> sets(data->getSubDataCount());
+    const std::vector<uint32_t>& indices = data->getIndices();
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        size_t first, last;
+        data->getSubDataRange(i, first, last);
+        for (size_t j = first; j < last; j += 3) {
+            std::array<uint32_t, 3> triangle = {indices[j], indices[j + 1], indices[j + 2]};
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            sets[i].push_back(triangle);
+        }
+        std::sort(sets[i].begin(), sets[i].end());
+    }
+    return sets;
+}
+
+/* Returns the number of triangles in only one of two meshes */
+static double countChangedTriangles(MeshData* before, MeshData* after) {
+    std::vector<std::vector<std::array<uint32_t, 3>>> setsBefore = getTriangleSets(before);
+    std::vector<std::vector<std::array<uint32_t, 3>>> setsAfter  = getTriangleSets(after);
+    if (setsBefore.size() != setsAfter.size())
+        return std::numeric_limits<double>::infinity();
+
+    std::vector<std::array<uint32_t, 3>> changed;
+    for (size_t i = 0; i < setsBefore.size(); ++i)
+        std::set_symmetric_difference(setsBefore[i].begin(), setsBefore[i].end(), setsAfter[i].begin(), setsAfter[i].end(), std::back_inserter(changed));
+    return static_cast<double>(changed.size());
+}
+
+/* Returns the number of indices that differ between two meshes */
+static double countChangedIndices(MeshData* a, MeshData* b) {
+    const std::vector<uint32_t>& indicesA = a->getIndices();
+    const std::vector<uint32_t>& indicesB = b->getIndices();
+    if (indicesA.size() != indicesB.size())
+        return std::numeric_limits<double>::infinity();
+
+    double changed = 0.0;
+    for (size_t i = 0; i < indicesA.size(); ++i) {
+        if (indicesA[i] != indicesB[i])
+            changed += 1.0;
+    }
+    return changed;
+}
+
+/* Rasterises the front facing triangles of a mesh with a depth test from
+   each direction and returns the number of pixels shaded per pixel
+   covered */
+static double measureOverdraw(MeshData* data) {
+    const int size            = 256;
+    const float directions[] = {1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 1, 1, 1, 1, 1, -1, 1, -1, 1, 1, -1, -1, -1, 1, 1, -1, 1, -1, -1, -1, 1, -1, -1, -1};
+
+    size_t offset, stride;
+    const float* positions               = data->getStream(MeshData::POSITION, offset, stride)->data() + offset;
+    const std::vector<uint32_t>& indices = data->getIndices();
+
+    std::vector<float> depths(size * size);
+    double shaded  = 0.0;
+    double covered = 0.0;
+    for (unsigned int view = 0; view < 14; ++view) {
+        // Orthographic view along the direction
+        Vector3f forward = Vector3f(directions[view * 3], directions[view * 3 + 1], directions[view * 3 + 2]).normalised();
+        Vector3f up      = std::fabs(forward.getY()) > 0.9f ? Vector3f(1.0f, 0.0f, 0.0f) : Vector3f(0.0f, 1.0f, 0.0f);
+        Vector3f right   = forward.cross(up).normalised();
+        up               = right.cross(forward);
+
+        std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::max());
+        for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+            size_t first, last;
+            data->getSubDataRange(i, first, last);
+            const float* subDataPositions = positions + data->getSubData(i).vertexOffset * stride;
+
+            for (size_t j = first; j < last; j += 3) {
+                float x[3], y[3], z[3];
+                for (unsigned int corner = 0; corner < 3; ++corner) {
+                    const float* position = subDataPositions + indices[j + corner] * stride;
+                    Vector3f vertex(position[0], position[1], position[2]);
+                    x[corner] = (vertex.dot(right) * 0.45f + 0.5f) * size;
+                    y[corner] = (vertex.dot(up) * 0.45f + 0.5f) * size;
+                    z[corner] = vertex.dot(forward);
+                }
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (area <= 0.0f)
+                    continue;
+
+                int minX = std::max(0, static_cast<int>(std::min({x[0], x[1], x[2]})));
+                int maxX = std::min(size - 1, static_cast<int>(std::max({x[0], x[1], x[2]})) + 1);
+                int minY = std::max(0, static_cast<int>(std::min({y[0], y[1], y[2]})));
+                int maxY = std::min(size - 1, static_cast<int>(std::max({y[0], y[1], y[2]})) + 1);
+                for (int py = minY; py <= maxY; ++py) {
+                    for (int px = minX; px <= maxX; ++px) {
+                        float cx = px + 0.5f;
+                        float cy = py + 0.5f;
+                        float w0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) / area;
+                        float w1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) / area;
+                        float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                            continue;
+                        float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                        if (depth < depths[py * size + px]) {
+                            depths[py * size + px] = depth;
+                            shaded += 1.0;
+                        }
+                    }
+                }
+            }
+        }
+        for (float depth : depths) {
+            if (depth < std::numeric_limits<float>::max())
+                covered += 1.0;
+        }
+    }
+    return shaded / covered;
+}
+
+/* Returns the ACMR of a mesh over all of its sub data */
+static double measureACMR(MeshData* data) {
+    double misses = 0.0;
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        size_t first, last;
+        data->getSubDataRange(i, first, last);
+        misses += MeshOptimiser::analyseVertexCache(data->getIndices().data() + first, last - first).acmr * static_cast<double>((last - first) / 3);
+    }
+    return misses / static_cast<double>(data->getIndices().size() / 3);
+}
+
+/* Returns the number of values of the vertices used by each index of one
+   mesh that differ from those used by the same index of another (covering
+   every stream the spheres have) */
+static double countInconsistentValues(MeshData* before, MeshData* after) {
+    const std::vector<uint32_t>& indicesBefore = before->getIndices();
+    const std::vector<uint32_t>& indicesAfter  = after->getIndices();
+    if (indicesBefore.size() != indicesAfter.size() || before->getVertexCount() != after->getVertexCount())
+        return std::numeric_limits<double>::infinity();
+
+    size_t othersStride = before->getOthers().size() / before->getVertexCount();
+    double inconsistent = 0.0;
+    auto compare        = [&](const auto& valuesBefore, const auto& valuesAfter, size_t vertexBefore, size_t vertexAfter, size_t components) {
+        for (size_t k = 0; k < components; ++k) {
+            if (valuesBefore[vertexBefore * components + k] != valuesAfter[vertexAfter * components + k])
+                inconsistent += 1.0;
+        }
+    };
+    for (unsigned int i = 0; i < before->getSubDataCount(); ++i) {
+        size_t first, last;
+        before->getSubDataRange(i, first, last);
+        uint32_t vertexOffset = before->getSubData(i).vertexOffset;
+        for (size_t j = first; j < last; ++j) {
+            size_t vertexBefore = indicesBefore[j] + vertexOffset;
+            size_t vertexAfter  = indicesAfter[j] + vertexOffset;
+            compare(before->getOthers(), after->getOthers(), vertexBefore, vertexAfter, othersStride);
+            compare(before->getNormals(), after->getNormals(), vertexBefore, vertexAfter, 3);
+            compare(before->getBoneIndices(), after->getBoneIndices(), vertexBefore, vertexAfter, 4);
+            compare(before->getBoneWeights(), after->getBoneWeights(), vertexBefore, vertexAfter, 4);
+            compare(before->getMaterialIndices(), after->getMaterialIndices(), vertexBefore, vertexAfter, 1);
+        }
+    }
+    return inconsistent;
+}
+
+/* Returns the number of vertices of a mesh first used out of order (each
+   vertex range should be used in the order it is stored) */
+static double countOutOfOrderVertices(MeshData* data) {
+    const std::vector<uint32_t>& indices = data->getIndices();
+    double outOfOrder                    = 0.0;
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        size_t first, last;
+        data->getSubDataRange(i, first, last);
+        // The spheres' sub data don't share vertices, so each starts a new
+        // range
+        uint32_t next = 0;
+        for (size_t j = first; j < last; ++j) {
+            if (indices[j] == next)
+                ++next;
+            else if (indices[j] > next)
+                outOfOrder += 1.0;
+        }
+    }
+    return outOfOrder;
+}
+
+static void addMeshOptimiserChecks(CheckSuite& suite) {
+    // The overdraw pass only reorders triangles within each sub data, and
+    // should reduce overdraw well below that of the vertex cache order
+    // (measured at 0.63 times) without giving up much of its vertex cache
+    // efficiency (measured at 1.05 times the ACMR)
+    suite.add("MeshOptimiser::optimiseOverdraw (changed triangles)", 0.0, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        return countChangedTriangles(meshes.vertexCache, meshes.overdraw);
+    });
+    suite.add("MeshOptimiser::optimiseOverdraw (relative overdraw)", 0.8, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        return measureOverdraw(meshes.overdraw) / measureOverdraw(meshes.vertexCache);
+    });
+    suite.add("MeshOptimiser::optimiseOverdraw (relative ACMR)", 1.1, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        return measureACMR(meshes.overdraw) / measureACMR(meshes.vertexCache);
+    });
+    suite.add("MeshOptimiser::optimiseOverdraw (differences between runs)", 0.0, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        MeshData repeated(*meshes.vertexCache);
+        MeshOptimiser::optimiseOverdraw(&repeated);
+        return countChangedIndices(&repeated, meshes.overdraw);
+    });
+
+    // Every index of the vertex fetch order should still refer to the same
+    // values in every stream (which as each vertex's are unique also means
+    // the triangles are unchanged), with the vertices stored in order of
+    // first use
+    suite.add("MeshOptimiser::optimiseVertexFetch (inconsistent values)", 0.0, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        return countInconsistentValues(meshes.overdraw, meshes.vertexFetch);
+    });
+    suite.add("MeshOptimiser::optimiseVertexFetch (out of order vertices)", 0.0, []() { return countOutOfOrderVertices(OptimisedMeshes::get().vertexFetch); });
+    suite.add("MeshOptimiser::optimiseVertexFetch (differences between runs)", 0.0, []() {
+        const OptimisedMeshes& meshes = OptimisedMeshes::get();
+        MeshData repeated(*meshes.overdraw);
+        MeshOptimiser::optimiseVertexFetch(&repeated);
+        return countChangedIndices(&repeated, meshes.vertexFetch) + countInconsistentValues(&repeated, meshes.vertexFetch);
+    });
+}
+
+/*****************************************************************************
+ * Mesh transforms
+ *****************************************************************************/
+
+/* Returns the largest difference between the vertex data of a mesh
+   transformed by MeshData::transform and each vertex transformed with the
+   scalar matrix operations (normals by the inverse transpose and tangents
+   and bitangents as directions, all renormalised). Returns infinity if the
+   texture coordinates interleaved with them change. */
+static double meshTransformError(MeshData::SeparateFlags separateFlags) {
+    // Not a multiple of 4 so the remainder of the batch transforms is used
+    const size_t count = 1001;
+    std::mt19937 generator(SEED);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    const MeshData::DataType types[] = {MeshData::POSITION, MeshData::TEXTURE_COORD, MeshData::NORMAL, MeshData::TANGENT, MeshData::BITANGENT};
+    MeshDataBuilder builder(MeshData::DIMENSIONS_3D, separateFlags);
+    for (MeshData::DataType type : types) {
+        std::vector<float> values(count * (type == MeshData::TEXTURE_COORD ? 2 : 3));
+        for (float& value : values)
+            value = unit(generator);
+        if (type == MeshData::POSITION)
+            builder.addPositions(values.data(), count);
+        else if (type == MeshData::TEXTURE_COORD)
+            builder.addTextureCoords(values.data(), count);
+        else if (type == MeshData::NORMAL)
+            builder.addNormals(values.data(), count);
+        else if (type == MeshData::TANGENT)
+            builder.addTangents(values.data(), count);
+        else
+            builder.addBitangents(values.data(), count);
+    }
+    MeshData* mesh = builder.build(std::vector<MeshData::DataType>(std::begin(types), std::end(types)));
+    MeshData original(*mesh);
+
+    Matrix4f matrix;
+    Vector3f axis = Vector3f(unit(generator), unit(generator), 1.0f).normalised();
+    matrix.initTransform(Vector3f(unit(generator), unit(generator), unit(generator)) * 10.0f, Quaternion().initFromAxisAngle(axis, unit(generator) * 3.14159265f), Vector3f(1.25f, 1.25f, 1.25f) + Vector3f(unit(generator), unit(generator), unit(generator)) * 0.75f);
+    Matrix3f normalMatrix = Matrix3f(matrix.to3x3()).inverse().transpose();
+    mesh->transform(matrix);
+
+    double error = 0.0;
+    for (MeshData::DataType type : types) {
+        size_t offset, stride, originalOffset, originalStride;
+        const float* values         = mesh->getStream(type, offset, stride)->data() + offset;
+        const float* originalValues = original.getStream(type, originalOffset, originalStride)->data() + originalOffset;
+        for (size_t i = 0; i < count; ++i) {
+            const float* value         = values + i * stride;
+            const float* originalValue = originalValues + i * originalStride;
+            if (type == MeshData::TEXTURE_COORD) {
+                if (value[0] != originalValue[0] || value[1] != originalValue[1])
+                    return std::numeric_limits<double>::infinity();
+                continue;
+            }
+
+            Vector3f vector(originalValue[0], originalValue[1], originalValue[2]);
+            Vector3f expected;
+            if (type == MeshData::POSITION)
+                expected = Vector3f(matrix * Vector4f(vector, 1.0f));
+            else if (type == MeshData::NORMAL)
+                expected = (normalMatrix * vector).normalised();
+            else
+                expected = Vector3f(matrix * Vector4f(vector, 0.0f)).normalised();
+            for (unsigned int j = 0; j < 3; ++j)
+                error = std::max(error, std::fabs(static_cast<double>(value[j]) - expected[j]));
+        }
+    }
+    delete mesh;
+    return error;
+}
+
+static void addMeshTransformChecks(CheckSuite& suite) {
+    // The positions are within 1 of the origin before being scaled by up to
+    // 2 and translated by up to 10 on each axis, so they are rounded to
+    // about 1e-6
+    suite.add("MeshData::transform (interleaved)", 1e-5, []() { return meshTransformError(MeshData::SEPARATE_NONE); });
+    suite.add("MeshData::transform (separated)", 1e-5, []() { return meshTransformError(static_cast<MeshData::SeparateFlags>(MeshData::SEPARATE_POSITIONS | MeshData::SEPARATE_NORMALS | MeshData::SEPARATE_TANGENTS | MeshData::SEPARATE_BITANGENTS)); });
+}
+
+/*****************************************************************************
+ * Bounding volume hierarchies
+ *****************************************************************************/
+
+// Every query is compared to a brute force one over all of the triangles
+// (in double precision for rays). The spheres are smaller than those the
+// benchmarks use so this stays quick, and the rays start both inside and
+// outside them so every sphere gets hit.
+
+/* Number of rays and boxes each check uses */
+static const size_t QUERIES = 1000;
+
+/* Number of segments of the spheres checked */
+static const unsigned int BVH_SEGMENTS = 50;
+
+/* Returns the vertices of each triangle of a mesh in turn (taking the
+   vertex offsets of its sub data into account) transformed by a matrix */
+static std::vector<Vector3f> getTriangleVertices(MeshData* data, const Matrix4f& transform) {
+    size_t offset, stride;
+    const float* positions               = data->getStream(MeshData::POSITION, offset, stride)->data() + offset;
+    const std::vector<uint32_t>& indices = data->getIndices();
+
+    std::vector<Vector3f> vertices;
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        size_t first, last;
+        data->getSubDataRange(i, first, last);
+        for (size_t j = first; j < last; ++j) {
+            const float* position = positions + (indices[j] + data->getSubData(i).vertexOffset) * stride;
+            vertices.push_back(Vector3f(transform * Vector4f(position[0], position[1], position[2], 1.0f)));
+        }
+    }
+    return vertices;
+}
+
+/* Returns the bounds of some vertices */
+static AABB getBounds(const Vector3f* vertices, size_t count) {
+    AABB bounds(vertices[0], vertices[0]);
+    for (size_t i = 1; i < count; ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            bounds.min[j] = std::min(bounds.min[j], vertices[i][j]);
+            bounds.max[j] = std::max(bounds.max[j], vertices[i][j]);
+        }
+    }
+    return bounds;
+}
+
+/* Finds the distance to the closest triangle hit by a ray within
+   maxDistance, returns whether one was found */
+static bool intersectTriangles(const std::vector<Vector3f>& vertices, const Ray& ray, double maxDistance, double& distance) {
+    double origin[3]    = {ray.origin.getX(), ray.origin.getY(), ray.origin.getZ()};
+    double direction[3] = {ray.direction.getX(), ray.direction.getY(), ray.direction.getZ()};
+    distance            = maxDistance;
+    bool found          = false;
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        double a[3], edge1[3], edge2[3], t[3];
+        for (unsigned int j = 0; j < 3; ++j) {
+            a[j]     = vertices[i][j];
+            edge1[j] = vertices[i + 1][j] - a[j];
+            edge2[j] = vertices[i + 2][j] - a[j];
+            t[j]     = origin[j] - a[j];
+        }
+        double p[3]        = {direction[1] * edge2[2] - direction[2] * edge2[1], direction[2] * edge2[0] - direction[0] * edge2[2], direction[0] * edge2[1] - direction[1] * edge2[0]};
+        double determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+        if (determinant == 0.0)
+            continue;
+        double u    = (t[0] * p[0] + t[1] * p[1] + t[2] * p[2]) / determinant;
+        double q[3] = {t[1] * edge1[2] - t[2] * edge1[1], t[2] * edge1[0] - t[0] * edge1[2], t[0] * edge1[1] - t[1] * edge1[0]};
+        double v    = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) / determinant;
+        double hit  = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) / determinant;
+        if (u >= 0.0 && v >= 0.0 && u + v <= 1.0 && hit > 0.0 && hit < distance) {
+            distance = hit;
+            found    = true;
+        }
+    }
+    return found;
+}
+
+/* Returns random rays with origins inside a box of the given half size and
+   normalised directions */
+static std::vector<Ray> randomRays(std::mt19937& generator, float size, size_t count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays;
+    while (rays.size() < count) {
+        Vector3f direction(unit(generator), unit(generator), unit(generator));
+        Vector3f origin = Vector3f(unit(generator), unit(generator), unit(generator)) * size;
+        if (direction.length() > 0.1f)
+            rays.push_back(Ray(origin, direction.normalised()));
+    }
+    return rays;
+}
+
+/* Returns random boxes with centres inside a box of the given half size */
+static std::vector<AABB> randomBoxes(std::mt19937& generator, float size, float maxExtent, size_t count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> extent(0.0f, maxExtent);
+    std::vector<AABB> boxes;
+    for (size_t i = 0; i < count; ++i) {
+        Vector3f centre  = Vector3f(unit(generator), unit(generator), unit(generator)) * size;
+        Vector3f extents = Vector3f(extent(generator), extent(generator), extent(generator));
+        boxes.push_back(AABB(centre - extents, centre + extents));
+    }
+    return boxes;
+}
+
+/* Returns the largest difference between the closest hits found by a
+   query and by brute force over a set of triangles (or infinity if they
+   disagree on whether anything was hit) */
+template <typename Intersect>
+static double closestHitError(const std::vector<Vector3f>& vertices, const std::vector<Ray>& rays, Intersect intersect) {
+    double error = 0.0;
+    for (const Ray& ray : rays) {
+        BVH::Hit hit;
+        double distance;
+        bool found = intersect(ray, hit);
+        if (found != intersectTriangles(vertices, ray, std::numeric_limits<double>::max(), distance))
+            return std::numeric_limits<double>::infinity();
+        if (found)
+            error = std::max(error, std::fabs(hit.distance - distance));
+    }
+    return error;
+}
+
+/* Sphere mesh and hierarchy the checks use */
+class CheckedBVH {
+public:
+    MeshData* mesh;
+    MeshBVH bvh;
+    std::vector<Vector3f> vertices;
+
+    CheckedBVH() {
+        mesh = createSpheres(BVH_SEGMENTS, SEED);
+        bvh.build(mesh);
+
+        Matrix4f identity;
+        identity.initIdentity();
+        vertices = getTriangleVertices(mesh, identity);
+    }
+
+    virtual ~CheckedBVH() { delete mesh; }
+
+    static const CheckedBVH& get() {
+        static CheckedBVH checked;
+        return checked;
+    }
+};
+
+static void addBVHChecks(CheckSuite& suite) {
+    // Closest hits should match to within the rounding of the single
+    // precision intersection tests (the spheres have a radius of at most 1
+    // and the rays start within 2 of the centre)
+    suite.add("MeshBVH::intersect", 1e-5, []() {
+        const CheckedBVH& checked = CheckedBVH::get();
+        std::mt19937 generator(SEED);
+        return closestHitError(checked.vertices, randomRays(generator, 1.5f, QUERIES), [&](const Ray& ray, BVH::Hit& hit) { return checked.bvh.intersect(ray, hit); });
+    });
+    suite.add("MeshBVH::intersect (hit points)", 1e-5, []() {
+        const CheckedBVH& checked = CheckedBVH::get();
+        std::mt19937 generator(SEED);
+        double error = 0.0;
+        for (const Ray& ray : randomRays(generator, 1.5f, QUERIES)) {
+            BVH::Hit hit;
+            if (! checked.bvh.intersect(ray, hit))
+                continue;
+            const Vector3f* triangle = &checked.vertices[hit.triangle * 3];
+            Vector3f point           = triangle[0] + (triangle[1] - triangle[0]) * hit.u + (triangle[2] - triangle[0]) * hit.v;
+            error                    = std::max(error, static_cast<double>((point - ray.getPoint(hit.distance)).length()));
+        }
+        return error;
+    });
+    suite.add("MeshBVH::intersectsAny (wrong results)", 0.0, []() {
+        const CheckedBVH& checked = CheckedBVH::get();
+        std::mt19937 generator(SEED);
+        std::uniform_real_distribution<float> maxDistances(0.0f, 3.0f);
+        double wrong = 0.0;
+        for (const Ray& ray : randomRays(generator, 1.5f, QUERIES)) {
+            float maxDistance = maxDistances(generator);
+            double distance;
+            if (checked.bvh.intersectsAny(ray, maxDistance) != intersectTriangles(checked.vertices, ray, maxDistance, distance))
+                wrong += 1.0;
+        }
+        return wrong;
+    });
+    suite.add("MeshBVH::query (wrong results)", 0.0, []() {
+        const CheckedBVH& checked = CheckedBVH::get();
+        std::mt19937 generator(SEED);
+        double wrong = 0.0;
+        std::vector<uint32_t> triangles;
+        for (const AABB& box : randomBoxes(generator, 1.2f, 0.3f, QUERIES)) {
+            triangles.clear();
+            checked.bvh.query(box, triangles);
+            std::sort(triangles.begin(), triangles.end());
+
+            std::vector<uint32_t> expected;
+            for (size_t i = 0; i < checked.vertices.size(); i += 3) {
+                if (getBounds(&checked.vertices[i], 3).intersects(box))
+                    expected.push_back(static_cast<uint32_t>(i / 3));
+            }
+            if (triangles != expected)
+                wrong += 1.0;
+        }
+        return wrong;
+    });
+
+    // Instances of the spheres scattered (and scaled by up to 2) around the
+    // origin
+    suite.add("SceneBVH::intersect", 1e-4, []() {
+        const CheckedBVH& checked = CheckedBVH::get();
+        std::mt19937 generator(SEED);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<SceneBVH::Instance> instances;
+        std::vector<Vector3f> vertices;
+        for (unsigned int i = 0; i < 16; ++i) {
+            Matrix4f translation, rotation, scale;
+            translation.initTranslation(Vector3f(unit(generator), unit(generator), unit(generator)) * 4.0f);
+            rotation = Quaternion().initFromAxisAngle(Vector3f(unit(generator), unit(generator), 1.0f).normalised(), unit(generator) * 3.14159265f).toMatrix();
+            scale.initScale(Vector3f(1.25f + unit(generator) * 0.75f, 1.25f + unit(generator) * 0.75f, 1.25f + unit(generator) * 0.75f));
+            instances.push_back({&checked.bvh, translation * rotation * scale});
+
+            std::vector<Vector3f> instanceVertices = getTriangleVertices(checked.mesh, instances.back().transform);
+            vertices.insert(vertices.end(), instanceVertices.begin(), instanceVertices.end());
+        }
+        SceneBVH scene(instances);
+        return closestHitError(vertices, randomRays(generator, 6.0f, QUERIES / 4), [&](const Ray& ray, BVH::Hit& hit) { return scene.intersect(ray, hit); });
+    });
+}
+
+/*****************************************************************************
+ * Structure of arrays streams
+ *****************************************************************************/
+
+// Each operation is compared to the same operation on the vectors or
+// quaternions one at a time. The components are between -1 and 1 so absolute
+// errors suffice, and the size isn't a multiple of any SIMD width so the
+// remainders of the vectorised loops are checked too.
+
+/* Number of values in each stream checked */
+static const size_t STREAM_SIZE = 1001;
+
+/* Returns random vectors with components between -1 and 1 */
+static std::vector<Vector3f> randomVectors(std::mt19937& generator, size_t count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Vector3f> vectors;
+    for (size_t i = 0; i < count; ++i)
+        vectors.push_back(Vector3f(unit(generator), unit(generator), unit(generator)));
+    return vectors;
+}
+
+/* Returns random unit quaternions */
+static std::vector<Quaternion> randomQuaternions(std::mt19937& generator, size_t count) {
+    std::normal_distribution<float> normal;
+    std::vector<Quaternion> quaternions;
+    for (size_t i = 0; i < count; ++i)
+        quaternions.push_back(Quaternion(normal(generator), normal(generator), normal(generator), normal(generator)).normalised());
+    return quaternions;
+}
+
+/* Returns the largest difference between the components of two vectors */
+template <unsigned int N>
+static double vectorDifference(const Vector<float, N>& a, const Vector<float, N>& b) {
+    double result = 0.0;
+    for (unsigned int i = 0; i < N; ++i)
+        result = std::max(result, std::fabs(static_cast<double>(a[i]) - b[i]));
+    return result;
+}
+
+/* Returns the largest difference between the values in a stream and the
+   expected ones (or infinity if the sizes differ) */
+template <typename Stream, typename T>
+static double streamDifference(const Stream& stream, const std::vector<T>& expected) {
+    if (stream.size() != expected.size())
+        return std::numeric_limits<double>::infinity();
+    double result = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i)
+        result = std::max(result, vectorDifference(stream.get(i), expected[i]));
+    return result;
+}
+
+/* Returns the largest difference between two arrays of scalars */
+static double arrayDifference(const std::vector<float>& values, const std::vector<float>& expected) {
+    double result = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i)
+        result = std::max(result, std::fabs(static_cast<double>(values[i]) - expected[i]));
+    return result;
+}
+
+static void addStreamChecks(CheckSuite& suite) {
+    // Copying in and out of the streams should give back exactly the same
+    // values
+    suite.add("Vector3Stream (copies)", 0.0, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Vector3f> vectors = randomVectors(generator, STREAM_SIZE);
+
+        Vector3Stream appended;
+        for (const Vector3f& vector : vectors)
+            appended.append(vector);
+        std::vector<Vector3f> copied(STREAM_SIZE);
+        appended.copyTo(copied.data());
+
+        Vector3Stream sized(STREAM_SIZE);
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            sized.set(i, vectors[i]);
+
+        return std::max({streamDifference(Vector3Stream(vectors), vectors), streamDifference(appended, vectors), streamDifference(Vector3Stream(copied), vectors), streamDifference(sized, vectors),
+                         streamDifference(Vector3Stream(Vector3Stream(vectors).toVectors()), vectors)});
+    });
+    suite.add("QuaternionStream (copies)", 0.0, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternions = randomQuaternions(generator, STREAM_SIZE);
+
+        QuaternionStream appended;
+        for (const Quaternion& quaternion : quaternions)
+            appended.append(quaternion);
+        std::vector<Quaternion> copied(STREAM_SIZE);
+        appended.copyTo(copied.data());
+
+        QuaternionStream sized(STREAM_SIZE);
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            sized.set(i, quaternions[i]);
+
+        return std::max({streamDifference(QuaternionStream(quaternions), quaternions), streamDifference(appended, quaternions), streamDifference(QuaternionStream(copied), quaternions), streamDifference(sized, quaternions),
+                         streamDifference(QuaternionStream(QuaternionStream(quaternions).toQuaternions()), quaternions)});
+    });
+
+    suite.add("Vector3Stream (arithmetic)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Vector3f> vectorsA = randomVectors(generator, STREAM_SIZE);
+        std::vector<Vector3f> vectorsB = randomVectors(generator, STREAM_SIZE);
+        std::vector<float> factors(STREAM_SIZE);
+        for (float& factor : factors)
+            factor = unit(generator);
+        const float factor = 0.3f;
+
+        Vector3Stream added(vectorsA), addedScaled(vectorsA), subtracted(vectorsA), scaled(vectorsA), scaledEach(vectorsA), lerped;
+        added.add(Vector3Stream(vectorsB));
+        addedScaled.addScaled(Vector3Stream(vectorsB), factor);
+        subtracted.subtract(Vector3Stream(vectorsB));
+        scaled.scale(factor);
+        scaledEach.scale(factors.data());
+        Vector3Stream::lerp(Vector3Stream(vectorsA), Vector3Stream(vectorsB), factor, lerped);
+
+        std::vector<Vector3f> expectedAdded, expectedAddedScaled, expectedSubtracted, expectedScaled, expectedScaledEach, expectedLerped;
+        for (size_t i = 0; i < STREAM_SIZE; ++i) {
+            expectedAdded.push_back(vectorsA[i] + vectorsB[i]);
+            expectedAddedScaled.push_back(vectorsA[i] + vectorsB[i] * factor);
+            expectedSubtracted.push_back(vectorsA[i] - vectorsB[i]);
+            expectedScaled.push_back(vectorsA[i] * factor);
+            expectedScaledEach.push_back(vectorsA[i] * factors[i]);
+            expectedLerped.push_back(Vector3f::lerp(vectorsA[i], vectorsB[i], factor));
+        }
+        return std::max({streamDifference(added, expectedAdded), streamDifference(addedScaled, expectedAddedScaled), streamDifference(subtracted, expectedSubtracted), streamDifference(scaled, expectedScaled),
+                         streamDifference(scaledEach, expectedScaledEach), streamDifference(lerped, expectedLerped)});
+    });
+    suite.add("Vector3Stream (dot, lengths and cross)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Vector3f> vectorsA = randomVectors(generator, STREAM_SIZE);
+        std::vector<Vector3f> vectorsB = randomVectors(generator, STREAM_SIZE);
+
+        std::vector<float> dots(STREAM_SIZE), lengths(STREAM_SIZE);
+        Vector3Stream crossed;
+        Vector3Stream(vectorsA).dot(Vector3Stream(vectorsB), dots.data());
+        Vector3Stream(vectorsA).lengths(lengths.data());
+        Vector3Stream(vectorsA).cross(Vector3Stream(vectorsB), crossed);
+
+        std::vector<float> expectedDots, expectedLengths;
+        std::vector<Vector3f> expectedCrossed;
+        for (size_t i = 0; i < STREAM_SIZE; ++i) {
+            expectedDots.push_back(vectorsA[i].dot(vectorsB[i]));
+            expectedLengths.push_back(vectorsA[i].length());
+            expectedCrossed.push_back(vectorsA[i].cross(vectorsB[i]));
+        }
+        return std::max({arrayDifference(dots, expectedDots), arrayDifference(lengths, expectedLengths), streamDifference(crossed, expectedCrossed)});
+    });
+    // Zero length vectors should stay zero rather than becoming NaN
+    suite.add("Vector3Stream::normalise", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Vector3f> vectors = randomVectors(generator, STREAM_SIZE);
+        vectors[STREAM_SIZE / 2] = Vector3f(0.0f, 0.0f, 0.0f);
+
+        Vector3Stream normalised(vectors);
+        normalised.normalise();
+
+        std::vector<Vector3f> expected;
+        for (const Vector3f& vector : vectors)
+            expected.push_back(vector.length() > 0.0f ? Vector3f(vector.normalised()) : vector);
+        return streamDifference(normalised, expected);
+    });
+
+    suite.add("QuaternionStream (dot and normalise)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::normal_distribution<float> normal;
+        std::vector<Quaternion> quaternionsA = randomQuaternions(generator, STREAM_SIZE);
+        std::vector<Quaternion> quaternionsB = randomQuaternions(generator, STREAM_SIZE);
+        // Lengths from 0.5 to 1.5 for normalising
+        std::vector<Quaternion> scaled;
+        for (const Quaternion& quaternion : quaternionsA)
+            scaled.push_back(Quaternion(Vector4f(quaternion) * (1.0f + normal(generator) * 0.1f)));
+
+        std::vector<float> dots(STREAM_SIZE);
+        QuaternionStream(quaternionsA).dot(QuaternionStream(quaternionsB), dots.data());
+        QuaternionStream normalised(scaled);
+        normalised.normalise();
+
+        std::vector<float> expectedDots;
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            expectedDots.push_back(quaternionsA[i].dot(quaternionsB[i]));
+        return std::max(arrayDifference(dots, expectedDots), streamDifference(normalised, quaternionsA));
+    });
+    suite.add("QuaternionStream::multiply", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternionsA = randomQuaternions(generator, STREAM_SIZE);
+        std::vector<Quaternion> quaternionsB = randomQuaternions(generator, STREAM_SIZE);
+
+        QuaternionStream multiplied;
+        QuaternionStream(quaternionsA).multiply(QuaternionStream(quaternionsB), multiplied);
+
+        std::vector<Quaternion> expected;
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            expected.push_back(quaternionsA[i] * quaternionsB[i]);
+        return streamDifference(multiplied, expected);
+    });
+    suite.add("QuaternionStream::rotate", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternions = randomQuaternions(generator, STREAM_SIZE);
+        std::vector<Vector3f> vectors       = randomVectors(generator, STREAM_SIZE);
+
+        Vector3Stream rotated;
+        QuaternionStream(quaternions).rotate(Vector3Stream(vectors), rotated);
+
+        std::vector<Vector3f> expected;
+        for (size_t i = 0; i < STREAM_SIZE; ++i)
+            expected.push_back(Quaternion::rotate(vectors[i], quaternions[i]));
+        return streamDifference(rotated, expected);
+    });
+    // Half of the pairs are more than 90 degrees apart so need the second
+    // quaternion flipping
+    suite.add("QuaternionStream::nlerp", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternionsA = randomQuaternions(generator, STREAM_SIZE);
+        std::vector<Quaternion> quaternionsB = randomQuaternions(generator, STREAM_SIZE);
+        const float factor                   = 0.3f;
+
+        QuaternionStream interpolated;
+        QuaternionStream::nlerp(QuaternionStream(quaternionsA), QuaternionStream(quaternionsB), factor, interpolated);
+
+        std::vector<Quaternion> expected;
+        for (size_t i = 0; i < STREAM_SIZE; ++i) {
+            float factorB = quaternionsA[i].dot(quaternionsB[i]) < 0.0f ? -factor : factor;
+            expected.push_back(Quaternion(Vector4f::linearCombination(quaternionsA[i], 1.0f - factor, quaternionsB[i], factorB).normalised()));
+        }
+        return streamDifference(interpolated, expected);
+    });
+}
+
+/*****************************************************************************
+ * Engine checks
+ *****************************************************************************/
+
+void addEngineChecks(CheckSuite& suite) {
+    addMeshOptimiserChecks(suite);
+    addMeshTransformChecks(suite);
+    addBVHChecks(suite);
+    addStreamChecks(suite);
+}
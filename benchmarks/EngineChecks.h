@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Benchmark.h"
+
+/*****************************************************************************
+ * Engine checks - Checks the results of the engine code timed by the
+ *                 benchmarks that needs more than the maths classes
+ *****************************************************************************/
+
+/* Adds the checks to a suite */
+void addEngineChecks(CheckSuite& suite);
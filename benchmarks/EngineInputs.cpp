@@ -0,0 +1,94 @@
+#include "EngineInputs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/* Appends the vertices and triangles of a UV sphere (indices start at
+   firstVertex) */
+static void addSphere(float radius, unsigned int segments, uint32_t firstVertex, std::vector<float>& positions, std::vector<uint32_t>& indices) {
+    const float pi = 3.14159265358979323846f;
+    for (unsigned int i = 0; i <= segments; ++i) {
+        float theta = pi * i / segments;
+        for (unsigned int j = 0; j <= segments * 2; ++j) {
+            float phi = pi * j / segments;
+            positions.push_back(radius * std::sin(theta) * std::cos(phi));
+            positions.push_back(radius * std::cos(theta));
+            positions.push_back(radius * std::sin(theta) * std::sin(phi));
+        }
+    }
+
+    uint32_t rowLength = segments * 2 + 1;
+    for (unsigned int i = 0; i < segments; ++i) {
+        for (unsigned int j = 0; j < segments * 2; ++j) {
+            uint32_t a = firstVertex + i * rowLength + j;
+            uint32_t b = a + rowLength;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+}
+
+/* Shuffles the triangles given by indices */
+static void shuffleTriangles(std::vector<uint32_t>& indices, std::mt19937& generator) {
+    std::vector<uint32_t> order(indices.size() / 3);
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<uint32_t>(i);
+    std::shuffle(order.begin(), order.end(), generator);
+
+    std::vector<uint32_t> shuffled;
+    shuffled.reserve(indices.size());
+    for (uint32_t triangle : order)
+        shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+    indices.swap(shuffled);
+}
+
+MeshData* createSpheres(unsigned int segments, unsigned int seed) {
+    std::mt19937 generator(seed);
+    const float radii[] = {1.0f, 0.8f, 0.6f, 0.4f};
+
+    // Each sub data has two spheres, with its indices relative to its own
+    // first vertex
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> firstIndices;
+    std::vector<uint32_t> vertexOffsets;
+    for (unsigned int part = 0; part < 2; ++part) {
+        uint32_t vertexOffset = static_cast<uint32_t>(positions.size() / 3);
+        std::vector<uint32_t> partIndices;
+        for (unsigned int sphere = 0; sphere < 2; ++sphere)
+            addSphere(radii[part * 2 + sphere], segments, static_cast<uint32_t>(positions.size() / 3) - vertexOffset, positions, partIndices);
+        shuffleTriangles(partIndices, generator);
+
+        firstIndices.push_back(static_cast<uint32_t>(indices.size()));
+        vertexOffsets.push_back(vertexOffset);
+        indices.insert(indices.end(), partIndices.begin(), partIndices.end());
+    }
+
+    // The remaining data only needs to be unique to each vertex
+    size_t vertexCount = positions.size() / 3;
+    std::vector<float> textureCoords(vertexCount * 2);
+    std::vector<uint32_t> boneIndices(vertexCount * 4);
+    std::vector<float> boneWeights(vertexCount * 4);
+    std::vector<uint32_t> materialIndices(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        textureCoords[vertex * 2]     = static_cast<float>(vertex);
+        textureCoords[vertex * 2 + 1] = -static_cast<float>(vertex);
+        for (unsigned int bone = 0; bone < 4; ++bone) {
+            boneIndices[vertex * 4 + bone] = static_cast<uint32_t>(vertex * 4 + bone);
+            boneWeights[vertex * 4 + bone] = static_cast<float>(vertex) + bone * 0.25f;
+        }
+        materialIndices[vertex] = static_cast<uint32_t>(vertex);
+    }
+
+    MeshDataBuilder builder(MeshData::DIMENSIONS_3D, MeshData::SEPARATE_NORMALS);
+    builder.reserve(vertexCount, indices.size());
+    builder.addPositions(positions.data(), vertexCount);
+    builder.addNormals(positions.data(), vertexCount);
+    builder.addTextureCoords(textureCoords.data(), vertexCount);
+    builder.addBoneData(boneIndices.data(), boneWeights.data(), boneIndices.size());
+    builder.addMaterialIndices(materialIndices.data(), vertexCount);
+    builder.addIndices(indices.data(), indices.size());
+    for (unsigned int part = 0; part < 2; ++part)
+        builder.addSubData(part, firstIndices[part], vertexOffsets[part]);
+    return builder.build({MeshData::POSITION, MeshData::TEXTURE_COORD});
+}
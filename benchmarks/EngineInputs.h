@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../src/core/render/Mesh.h"
+
+/*****************************************************************************
+ * Engine inputs - Generates the data shared by the engine checks and
+ *                 benchmarks
+ *****************************************************************************/
+
+/* Number of segments around half of each sphere in the mesh the checks and
+   benchmarks use (giving 322k vertices and 640k triangles) */
+static const unsigned int SPHERES_SEGMENTS = 200;
+
+/* Creates a mesh of four concentric UV spheres (of radius 1, 0.8, 0.6 and
+   0.4) with the triangles of each sub data shuffled. The first two spheres
+   are the first sub data and the last two are the second, which has its own
+   vertex offset. Positions and texture coordinates are interleaved in
+   'others' with the normals separated, and every vertex has its own texture
+   coordinates, bone data and material index so any reordering can be
+   traced. */
+MeshData* createSpheres(unsigned int segments, unsigned int seed);
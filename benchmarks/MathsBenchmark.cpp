@@ -0,0 +1,333 @@
+#include <random>
+
+#include "../src/core/AABB.h"
+#include "../src/core/Frustum.h"
+#include "../src/core/Sphere.h"
+#include "../src/core/maths/Batch.h"
+#include "../src/core/maths/Matrix.h"
+#include "../src/core/maths/Packing.h"
+#include "../src/core/maths/Quaternion.h"
+#include "Benchmark.h"
+#include "MathsChecks.h"
+
+/*****************************************************************************
+ * Maths benchmarks - Measures the performance of the maths classes without
+ *                    needing a window or GPU
+ *****************************************************************************/
+
+// See utils_benchmark::run for the usage (the baseline is normally
+// benchmarks/baseline.json). Before anything is timed the accuracy checks
+// (see MathsChecks.h) matching the filter are run.
+
+/* Number of inputs each benchmark iterates over per call (small enough for
+   the data to stay in cache) */
+static const size_t COUNT = 1024;
+
+/* Seed for generating inputs so every run measures the same data */
+static const unsigned int SEED = 12345;
+
+/* Generates the inputs for the benchmarks */
+class Inputs {
+private:
+    std::mt19937 generator;
+    std::uniform_real_distribution<float> unit;
+
+public:
+    std::vector<Vector3f> vectors3;
+    std::vector<Vector4f> vectors4;
+    std::vector<Quaternion> quaternions1;
+    std::vector<Quaternion> quaternions2;
+    std::vector<Matrix4f> matrices1;
+    std::vector<Matrix4f> matrices2;
+    std::vector<Matrix4f> transforms;
+    std::vector<Sphere> spheres;
+    std::vector<Vector3f> points;
+    std::vector<Vector3d> origins;
+
+    // Volumes scattered around a camera at the origin (most of them
+    // outside its frustum) so culling gives mixed results
+    Frustum frustum;
+    std::vector<Sphere> cullSpheres;
+    std::vector<AABB> cullBoxes;
+
+    Inputs() : generator(SEED), unit(-1.0f, 1.0f) {
+        for (size_t i = 0; i < COUNT; ++i) {
+            vectors3.push_back(randomVector3(10.0f));
+            vectors4.push_back(Vector4f(randomVector3(10.0f), unit(generator) * 10.0f));
+            quaternions1.push_back(randomRotation());
+            quaternions2.push_back(randomRotation());
+
+            Matrix4f matrix;
+            for (unsigned int row = 0; row < 4; ++row) {
+                for (unsigned int col = 0; col < 4; ++col)
+                    matrix.set(row, col, unit(generator));
+            }
+            // Keep the matrices well conditioned so inverse doesn't hit
+            // singular cases
+            for (unsigned int d = 0; d < 4; ++d)
+                matrix.set(d, d, matrix.get(d, d) + 4.0f);
+            matrices1.push_back(matrix);
+            matrices2.push_back(matrix.transpose());
+
+            Matrix4f translation;
+            translation.initTranslation(randomVector3(100.0f));
+            transforms.push_back(translation * quaternions1.back().toMatrix());
+
+            spheres.push_back(Sphere(randomVector3(20.0f), 1.0f + unit(generator) * 0.5f));
+            points.push_back(randomVector3(20.0f));
+            origins.push_back(Vector3d(unit(generator) * 20000.0, unit(generator) * 100.0, unit(generator) * 20000.0));
+        }
+
+        for (size_t i = 0; i < COUNT; ++i) {
+            Sphere sphere(randomVector3(100.0f), 1.5f + unit(generator) * 1.4f);
+            Vector3f extents(sphere.radius, sphere.radius, sphere.radius);
+            cullSpheres.push_back(sphere);
+            cullBoxes.push_back(AABB(sphere.centre - extents, sphere.centre + extents));
+        }
+
+        Matrix4f projection;
+        projection.initPerspective(70.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+        frustum.update(projection);
+    }
+
+    inline Vector3f randomVector3(float scale) { return Vector3f(unit(generator), unit(generator), unit(generator)) * scale; }
+
+    inline Quaternion randomRotation() {
+        Vector3f axis = randomVector3(1.0f) + Vector3f(0.0f, 0.0f, 2.0f);
+        return Quaternion().initFromAxisAngle(axis.normalised(), unit(generator) * 3.14159265f);
+    }
+};
+
+/* Adds the benchmarks to a suite (the inputs and outputs must remain valid
+   while it is run) */
+static void addBenchmarks(BenchmarkSuite& suite, Inputs& in) {
+    static std::vector<Vector3f> vectors3(COUNT);
+    static std::vector<Vector4f> vectors4(COUNT);
+    static std::vector<Quaternion> quaternions(COUNT);
+    static std::vector<Matrix4f> matrices(COUNT);
+    static std::vector<uint8_t> results(COUNT);
+
+    // Matrices
+    suite.add("Matrix4f::operator* (Matrix4f)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            matrices[i] = in.matrices1[i] * in.matrices2[i];
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("Matrix4f::operator* (Vector4f)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = in.transforms[i] * in.vectors4[i];
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+    suite.add("Matrix4f::inverse", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            matrices[i] = in.matrices1[i].inverse();
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("Matrix4f::inverseAffine", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            matrices[i] = in.transforms[i].inverseAffine();
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("utils_batch::inverse", COUNT, [&]() {
+        utils_batch::inverse(in.matrices1.data(), matrices.data(), COUNT);
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("utils_batch::cameraRelativeModelViews", COUNT, [&]() {
+        utils_batch::cameraRelativeModelViews(in.transforms[0], Vector3d(1000.0, 10.0, -1000.0), in.origins.data(), in.transforms.data(), matrices.data(), COUNT);
+        utils_benchmark::doNotOptimise(matrices);
+    });
+
+    // Vectors
+    suite.add("Vector3f::normalise", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = in.vectors3[i].normalised<utils_maths::Precise>();
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+    suite.add("Vector3f::normalise<Fast>", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = in.vectors3[i].normalised<utils_maths::Fast>();
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+    suite.add("Vector4f::normalise", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = in.vectors4[i].normalised<utils_maths::Precise>();
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+    suite.add("Vector4f::normalise<Fast>", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = in.vectors4[i].normalised<utils_maths::Fast>();
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+    suite.add("Vector3f::cross", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = in.vectors3[i].cross(in.points[i]);
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+
+    // Compound expressions written with separate operators (each creating a
+    // temporary vector) compared to the fused versions
+    suite.add("Vector3f lerp (separate operators)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = in.vectors3[i] + (in.points[i] - in.vectors3[i]) * 0.3f;
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+    suite.add("Vector3f::lerp", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = Vector3f::lerp(in.vectors3[i], in.points[i], 0.3f);
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+    suite.add("Vector4f lerp (separate operators)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = in.vectors4[i] + (in.quaternions1[i] - in.vectors4[i]) * 0.3f;
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+    suite.add("Vector4f::lerp", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = Vector4f::lerp(in.vectors4[i], in.quaternions1[i], 0.3f);
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+    suite.add("Vector4f::slerp", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors4[i] = Vector4f::slerp(in.quaternions1[i], in.quaternions2[i], 0.3f);
+        utils_benchmark::doNotOptimise(vectors4);
+    });
+
+    // Quaternions
+    suite.add("Quaternion::slerp", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            quaternions[i] = Quaternion::slerp<utils_maths::Precise>(in.quaternions1[i], in.quaternions2[i], 0.3f);
+        utils_benchmark::doNotOptimise(quaternions);
+    });
+    suite.add("Quaternion::slerp<Fast>", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            quaternions[i] = Quaternion::slerp<utils_maths::Fast>(in.quaternions1[i], in.quaternions2[i], 0.3f);
+        utils_benchmark::doNotOptimise(quaternions);
+    });
+    suite.add("utils_batch::slerp", COUNT, [&]() {
+        utils_batch::slerp(in.quaternions1.data(), in.quaternions2.data(), 0.3f, quaternions.data(), COUNT);
+        utils_benchmark::doNotOptimise(quaternions);
+    });
+    suite.add("utils_batch::nlerp", COUNT, [&]() {
+        utils_batch::nlerp(in.quaternions1.data(), in.quaternions2.data(), 0.3f, quaternions.data(), COUNT);
+        utils_benchmark::doNotOptimise(quaternions);
+    });
+    suite.add("Quaternion::toMatrix", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            matrices[i] = in.quaternions1[i].toMatrix();
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("utils_batch::toMatrices", COUNT, [&]() {
+        utils_batch::toMatrices(in.quaternions1.data(), matrices.data(), COUNT);
+        utils_benchmark::doNotOptimise(matrices);
+    });
+    suite.add("Quaternion::rotate", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            vectors3[i] = Quaternion::rotate(in.vectors3[i], in.quaternions1[i]);
+        utils_benchmark::doNotOptimise(vectors3);
+    });
+
+    // Spheres
+    suite.add("Sphere::intersects (Sphere)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            results[i] = in.spheres[i].intersects(in.spheres[(i + 1) % COUNT]);
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("Sphere::contains (Vector3f)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            results[i] = in.spheres[i].contains(in.points[i]);
+        utils_benchmark::doNotOptimise(results);
+    });
+
+    // Frustum culling (one operation tests a single volume)
+    suite.add("Frustum::intersects (Sphere)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            results[i] = in.frustum.intersects(in.cullSpheres[i]);
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("Frustum::intersects (AABB)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; ++i)
+            results[i] = in.frustum.intersects(in.cullBoxes[i]);
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("Frustum::cull (Sphere)", COUNT, [&]() {
+        in.frustum.cull(in.cullSpheres.data(), COUNT, results.data());
+        utils_benchmark::doNotOptimise(results);
+    });
+    suite.add("Frustum::cull (AABB)", COUNT, [&]() {
+        in.frustum.cull(in.cullBoxes.data(), COUNT, results.data());
+        utils_benchmark::doNotOptimise(results);
+    });
+
+    // Packing (one operation converts a single value or direction)
+    static std::vector<uint16_t> halfs(COUNT * 4);
+    static std::vector<int16_t> snorms(COUNT * 4);
+    static std::vector<uint8_t> unorms(COUNT * 4);
+    static std::vector<float> floats(COUNT * 4);
+    const float* values     = &in.vectors4[0][0];
+    const float* directions = &in.vectors3[0][0];
+    suite.add("utils_packing::toHalf", COUNT * 4, [&, values]() {
+        utils_packing::toHalf(values, halfs.data(), COUNT * 4);
+        utils_benchmark::doNotOptimise(halfs);
+    });
+    suite.add("utils_packing::fromHalf", COUNT * 4, [&]() {
+        utils_packing::fromHalf(halfs.data(), floats.data(), COUNT * 4);
+        utils_benchmark::doNotOptimise(floats);
+    });
+    suite.add("utils_packing::toSnorm16", COUNT * 4, [&, values]() {
+        utils_packing::toSnorm16(values, snorms.data(), COUNT * 4);
+        utils_benchmark::doNotOptimise(snorms);
+    });
+    suite.add("utils_packing::toUnorm8", COUNT * 4, [&, values]() {
+        utils_packing::toUnorm8(values, unorms.data(), COUNT * 4);
+        utils_benchmark::doNotOptimise(unorms);
+    });
+    suite.add("utils_packing::encodeOctahedral", COUNT, [&, directions]() {
+        utils_packing::encodeOctahedral(directions, snorms.data(), COUNT, sizeof(Vector3f) / sizeof(float));
+        utils_benchmark::doNotOptimise(snorms);
+    });
+    suite.add("utils_packing::decodeOctahedral", COUNT, [&]() {
+        utils_packing::decodeOctahedral(snorms.data(), floats.data(), COUNT);
+        utils_benchmark::doNotOptimise(floats);
+    });
+
+    // Bounds (one operation computes the bounds of every point)
+    const size_t pointStride = sizeof(Vector3f) / sizeof(float);
+    suite.add("Sphere::fromPoints (1024 points)", 1, [&]() {
+        Sphere sphere = Sphere::fromPoints(&in.points[0][0], COUNT, pointStride);
+        utils_benchmark::doNotOptimise(sphere);
+    });
+    suite.add("AABB::fromPoints (1024 points)", 1, [&]() {
+        AABB box = AABB::fromPoints(&in.points[0][0], COUNT, pointStride);
+        utils_benchmark::doNotOptimise(box);
+    });
+}
+
+/* Returns a description of the SIMD instructions the maths was compiled
+   with */
+static std::string getSIMDName() {
+#if defined(UE_SIMD_AVX)
+    return "AVX";
+#elif defined(UE_SIMD_SSE)
+    return "SSE";
+#else
+    return "none";
+#endif
+}
+
+int main(int argc, char** argv) {
+    CheckSuite checks;
+    addMathsChecks(checks);
+
+    Inputs inputs;
+    BenchmarkSuite suite;
+    addBenchmarks(suite, inputs);
+
+    std::map<std::string, std::string> properties;
+    properties["simd"] = getSIMDName();
+#ifdef UE_FAST_MATHS
+    properties["precision"] = "fast";
+#else
+    properties["precision"] = "precise";
+#endif
+    return utils_benchmark::run(argc, argv, checks, suite, properties);
+}
@@ -0,0 +1,723 @@
+#include "MathsChecks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "../src/core/maths/Batch.h"
+#include "../src/core/maths/Packing.h"
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+/* Number of random inputs each check uses */
+static const size_t SAMPLES = 100000;
+
+/* Seed for generating inputs so every run checks the same data */
+static const unsigned int SEED = 54321;
+
+/* Returns the angle between two directions in degrees (using atan2 so
+   small angles are still accurate) */
+static double angleBetween(const Vector3f& a, const Vector3f& b) {
+    double ax = a.getX(), ay = a.getY(), az = a.getZ();
+    double bx = b.getX(), by = b.getY(), bz = b.getZ();
+    double cx = ay * bz - az * by;
+    double cy = az * bx - ax * bz;
+    double cz = ax * by - ay * bx;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz) * 180.0 / 3.14159265358979323846;
+}
+
+/* Returns the angle in degrees between the rotations given by two
+   quaternions (which needn't be normalised) */
+static double angleBetween(const Quaternion& a, const Quaternion& b) {
+    double dot     = 0.0;
+    double lengthA = 0.0;
+    double lengthB = 0.0;
+    for (unsigned int i = 0; i < 4; ++i) {
+        dot += static_cast<double>(a[i]) * b[i];
+        lengthA += static_cast<double>(a[i]) * a[i];
+        lengthB += static_cast<double>(b[i]) * b[i];
+    }
+    return 2.0 * std::acos(std::min(std::fabs(dot) / std::sqrt(lengthA * lengthB), 1.0)) * 180.0 / 3.14159265358979323846;
+}
+
+/* Returns the largest difference between the values of two arrays */
+static double maxDifference(const float* a, const float* b, size_t count) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i)
+        result = std::max(result, std::fabs(static_cast<double>(a[i]) - b[i]));
+    return result;
+}
+
+/* Returns random values between min and max */
+static std::vector<float> randomValues(std::mt19937& generator, float min, float max, size_t count) {
+    std::uniform_real_distribution<float> distribution(min, max);
+    std::vector<float> values(count);
+    for (float& value : values)
+        value = distribution(generator);
+    return values;
+}
+
+/*****************************************************************************
+ * Packing
+ *****************************************************************************/
+
+// Each value goes through both the single value and array conversions, and
+// the error is the largest of either compared to the original (clamped to
+// the range of the format)
+
+/* Returns the largest round trip error of the snorm16 or unorm8 conversions
+   for values between min and max */
+template <typename Packed>
+static double normalisedRoundTripError(float min, float max, Packed (*pack)(float), float (*unpack)(Packed), void (*packArray)(const float*, Packed*, size_t), void (*unpackArray)(const Packed*, float*, size_t),
+                                       float clampMin) {
+    std::mt19937 generator(SEED);
+    std::vector<float> values = randomValues(generator, min, max, SAMPLES);
+    // Include the ends of the range exactly
+    values[0] = clampMin;
+    values[1] = 1.0f;
+
+    std::vector<float> expected(SAMPLES);
+    std::vector<float> single(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        expected[i] = std::min(std::max(values[i], clampMin), 1.0f);
+        single[i]   = unpack(pack(values[i]));
+    }
+
+    std::vector<Packed> packed(SAMPLES);
+    std::vector<float> array(SAMPLES);
+    packArray(values.data(), packed.data(), SAMPLES);
+    unpackArray(packed.data(), array.data(), SAMPLES);
+    return std::max(maxDifference(single.data(), expected.data(), SAMPLES), maxDifference(array.data(), expected.data(), SAMPLES));
+}
+
+/* Returns the largest round trip error of the half conversions for values
+   with exponents between minExponent and maxExponent, relative to the values
+   when relative is true */
+static double halfRoundTripError(int minExponent, int maxExponent, bool relative) {
+    std::mt19937 generator(SEED);
+    std::uniform_int_distribution<int> exponents(minExponent, maxExponent);
+    std::uniform_real_distribution<float> mantissas(1.0f, 2.0f);
+    std::vector<float> values(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i)
+        values[i] = std::ldexp(mantissas(generator), exponents(generator)) * (i % 2 == 0 ? 1.0f : -1.0f);
+
+    std::vector<float> single(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i)
+        single[i] = utils_packing::fromHalf(utils_packing::toHalf(values[i]));
+    std::vector<uint16_t> packed(SAMPLES);
+    std::vector<float> array(SAMPLES);
+    utils_packing::toHalf(values.data(), packed.data(), SAMPLES);
+    utils_packing::fromHalf(packed.data(), array.data(), SAMPLES);
+
+    double result = 0.0;
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        double scale = relative ? std::fabs(values[i]) : 1.0;
+        result       = std::max(result, std::max(std::fabs(static_cast<double>(single[i]) - values[i]), std::fabs(static_cast<double>(array[i]) - values[i])) / scale);
+    }
+    return result;
+}
+
+static void addPackingChecks(CheckSuite& suite) {
+    // Normal values (with exponents up to 14 so none overflow) and denormal
+    // values
+    suite.add("utils_packing half (relative, normal)", std::ldexp(1.0, -11), []() { return halfRoundTripError(-14, 14, true); });
+    suite.add("utils_packing half (absolute, denormal)", std::ldexp(1.0, -25), []() { return halfRoundTripError(-24, -15, false); });
+
+    // Including values outside the range, which are clamped
+    suite.add("utils_packing snorm16", 1.6e-5, []() { return normalisedRoundTripError<int16_t>(-1.5f, 1.5f, utils_packing::toSnorm16, utils_packing::fromSnorm16, utils_packing::toSnorm16, utils_packing::fromSnorm16, -1.0f); });
+    suite.add("utils_packing unorm8", 2e-3, []() { return normalisedRoundTripError<uint8_t>(-0.5f, 1.5f, utils_packing::toUnorm8, utils_packing::fromUnorm8, utils_packing::toUnorm8, utils_packing::fromUnorm8, 0.0f); });
+
+    // Error in degrees, including the axes and the diagonals between the
+    // faces of the octahedron where the encoding folds
+    suite.add("utils_packing octahedral (degrees)", 0.004, []() {
+        std::mt19937 generator(SEED);
+        std::vector<float> components = randomValues(generator, -1.0f, 1.0f, SAMPLES * 3);
+        std::vector<Vector3f> directions;
+        for (size_t i = 0; i < SAMPLES; ++i)
+            directions.push_back(Vector3f(components[i * 3], components[i * 3 + 1], components[i * 3 + 2]) + Vector3f(1e-3f, 0.0f, 0.0f));
+        for (int x = -1; x <= 1; ++x) {
+            for (int y = -1; y <= 1; ++y) {
+                for (int z = -1; z <= 1; ++z) {
+                    if (x != 0 || y != 0 || z != 0)
+                        directions.push_back(Vector3f(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)));
+                }
+            }
+        }
+        size_t count = directions.size();
+
+        std::vector<int16_t> packed(count * 2);
+        std::vector<Vector3f> decoded(count);
+        utils_packing::encodeOctahedral(&directions[0][0], packed.data(), count);
+        utils_packing::decodeOctahedral(packed.data(), &decoded[0][0], count);
+
+        double result = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            Vector2f encoded = utils_packing::encodeOctahedral(directions[i]);
+            Vector2f stored(utils_packing::fromSnorm16(utils_packing::toSnorm16(encoded.getX())), utils_packing::fromSnorm16(utils_packing::toSnorm16(encoded.getY())));
+            result = std::max(result, angleBetween(utils_packing::decodeOctahedral(stored), directions[i]));
+            result = std::max(result, angleBetween(decoded[i], directions[i]));
+        }
+        return result;
+    });
+
+    suite.add("utils_packing colours", 2e-3, []() {
+        std::mt19937 generator(SEED);
+        std::vector<float> colours = randomValues(generator, 0.0f, 1.0f, SAMPLES * 4);
+
+        std::vector<float> single(SAMPLES * 4);
+        for (size_t i = 0; i < SAMPLES; ++i) {
+            Vector4f colour = utils_packing::unpackColour(utils_packing::packColour(Vector4f(colours[i * 4], colours[i * 4 + 1], colours[i * 4 + 2], colours[i * 4 + 3])));
+            for (unsigned int j = 0; j < 4; ++j)
+                single[i * 4 + j] = colour[j];
+        }
+        std::vector<uint32_t> packed(SAMPLES);
+        std::vector<float> array(SAMPLES * 4);
+        utils_packing::packColours(colours.data(), packed.data(), SAMPLES);
+        utils_packing::unpackColours(packed.data(), array.data(), SAMPLES);
+        return std::max(maxDifference(single.data(), colours.data(), SAMPLES * 4), maxDifference(array.data(), colours.data(), SAMPLES * 4));
+    });
+}
+
+/*****************************************************************************
+ * Fast maths
+ *****************************************************************************/
+
+/* PI in double precision for the references */
+static const double PI = 3.14159265358979323846;
+
+/* Returns the largest error of a utils_maths function at count evenly spaced
+   values between min and max (both included) compared to a double precision
+   reference, relative to the reference if relative is true */
+template <typename Function, typename Reference>
+static double functionError(Function function, Reference reference, double min, double max, size_t count, bool relative) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        float value     = static_cast<float>(min + (max - min) * static_cast<double>(i) / static_cast<double>(count - 1));
+        double expected = reference(static_cast<double>(value));
+        double error    = std::abs(static_cast<double>(function(value)) - expected);
+        result          = std::max(result, relative ? error / std::abs(expected) : error);
+    }
+    return result;
+}
+
+/* Returns the largest absolute error of sincos<Fast> over both outputs for
+   count values evenly spaced in [-2 PI, 2 PI] and as many random ones up to
+   the documented limit of 10^4 */
+static double sincosError(size_t count) {
+    std::mt19937 generator(SEED);
+    std::uniform_real_distribution<float> distribution(-1e4f, 1e4f);
+
+    double result = 0.0;
+    for (size_t i = 0; i < count * 2; ++i) {
+        float angle = i < count ? static_cast<float>(4.0 * PI * (static_cast<double>(i) / static_cast<double>(count - 1) - 0.5)) : distribution(generator);
+        float sine, cosine;
+        utils_maths::sincos<utils_maths::Fast>(angle, sine, cosine);
+        result = std::max(result, std::abs(static_cast<double>(sine) - std::sin(static_cast<double>(angle))));
+        result = std::max(result, std::abs(static_cast<double>(cosine) - std::cos(static_cast<double>(angle))));
+    }
+    return result;
+}
+
+/* Returns the largest absolute error of atan2<Fast> for count directions
+   evenly spaced around the circle (so every octant and the axes are
+   included) at random distances, and for the origin */
+static double atan2Error(size_t count) {
+    std::mt19937 generator(SEED);
+    std::uniform_real_distribution<double> exponent(-20.0, 20.0);
+
+    double result = utils_maths::atan2<utils_maths::Fast>(0.0f, 0.0f) == 0.0f ? 0.0 : std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < count; ++i) {
+        double angle    = 2.0 * PI * static_cast<double>(i) / static_cast<double>(count);
+        double distance = std::exp2(exponent(generator));
+        float x         = static_cast<float>(distance * std::cos(angle));
+        float y         = static_cast<float>(distance * std::sin(angle));
+        double expected = std::atan2(static_cast<double>(y), static_cast<double>(x));
+        double error    = std::abs(static_cast<double>(utils_maths::atan2<utils_maths::Fast>(y, x)) - expected);
+        // -PI and PI are the same angle
+        result = std::max(result, std::min(error, 2.0 * PI - error));
+    }
+    return result;
+}
+
+static void addFastMathsChecks(CheckSuite& suite) {
+    // The bounds are those documented in Utils.h. The relative errors repeat
+    // for every power of 4, so checking every float in [1, 4) covers all of
+    // them.
+    const size_t FUNCTION_SAMPLES = 1 << 22;
+    suite.add("utils_maths::reciprocalSqrt<Fast> (relative)", 5e-7, []() {
+        double result = 0.0;
+        for (float value = 1.0f; value < 4.0f; value = std::nextafter(value, 4.0f))
+            result = std::max(result, std::abs(utils_maths::reciprocalSqrt<utils_maths::Fast>(value) * std::sqrt(static_cast<double>(value)) - 1.0));
+        return result;
+    });
+    suite.add("utils_maths::sqrt<Fast> (relative)", 5e-7, []() {
+        double result = utils_maths::sqrt<utils_maths::Fast>(0.0f) == 0.0f ? 0.0 : std::numeric_limits<double>::infinity();
+        for (float value = 1.0f; value < 4.0f; value = std::nextafter(value, 4.0f))
+            result = std::max(result, std::abs(utils_maths::sqrt<utils_maths::Fast>(value) / std::sqrt(static_cast<double>(value)) - 1.0));
+        return result;
+    });
+    suite.add("utils_maths::sincos<Fast>", 2e-7, [=]() { return sincosError(FUNCTION_SAMPLES); });
+    suite.add("utils_maths::acos<Fast>", 5e-7, [=]() {
+        return functionError([](float value) { return utils_maths::acos<utils_maths::Fast>(value); }, [](double value) { return std::acos(value); }, -1.0, 1.0, FUNCTION_SAMPLES, false);
+    });
+    suite.add("utils_maths::atan2<Fast>", 2.5e-6, [=]() { return atan2Error(FUNCTION_SAMPLES); });
+}
+
+/*****************************************************************************
+ * Quaternions
+ *****************************************************************************/
+
+/* Interpolates between pairs of quaternions using a single factor or one
+   per pair (as utils_batch::slerp and nlerp) */
+using Interpolate        = void (*)(const Quaternion*, const Quaternion*, float, Quaternion*, size_t);
+using InterpolateFactors  = void (*)(const Quaternion*, const Quaternion*, const float*, Quaternion*, size_t);
+
+/* Returns the largest angle in degrees between the results of interpolating
+   pairs of rotations that are between minAngle and maxAngle degrees apart
+   and those of Quaternion::slerp. Every eighth pair is nearly parallel
+   (under 0.001 degrees apart) and every eighth is nearly opposite (the
+   negation of a nearly parallel one, so the same rotation but the shortest
+   path has to be found), while half of the rest have their second
+   quaternion negated. Both overloads are used. */
+static double interpolationError(Interpolate interpolate, InterpolateFactors interpolateFactors, float minAngle, float maxAngle) {
+    std::mt19937 generator(SEED);
+    std::normal_distribution<float> normal;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Quaternion> quaternions1(SAMPLES);
+    std::vector<Quaternion> quaternions2(SAMPLES);
+    std::vector<float> factors(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        Quaternion rotation(normal(generator), normal(generator), normal(generator), normal(generator));
+        Vector3f axis(normal(generator), normal(generator), normal(generator));
+        unsigned int type = i % 8;
+        float angle       = type < 2 ? unit(generator) * 0.001f : minAngle + unit(generator) * (maxAngle - minAngle);
+
+        quaternions1[i] = rotation.normalised();
+        quaternions2[i] = quaternions1[i] * Quaternion().initFromAxisAngle(axis.normalised(), angle);
+        if (type == 1 || (type >= 2 && unit(generator) < 0.5f))
+            quaternions2[i] = Quaternion(-quaternions2[i].getX(), -quaternions2[i].getY(), -quaternions2[i].getZ(), -quaternions2[i].getW());
+        factors[i] = unit(generator);
+    }
+    // Include the ends of the interpolation
+    factors[0] = 0.0f;
+    factors[1] = 1.0f;
+
+    std::vector<Quaternion> results(SAMPLES);
+    std::vector<Quaternion> singleResults(SAMPLES);
+    const float singleFactor = 0.3f;
+    interpolateFactors(quaternions1.data(), quaternions2.data(), factors.data(), results.data(), SAMPLES);
+    interpolate(quaternions1.data(), quaternions2.data(), singleFactor, singleResults.data(), SAMPLES);
+
+    double result = 0.0;
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        result = std::max(result, angleBetween(results[i], Quaternion::slerp<utils_maths::Precise>(quaternions1[i], quaternions2[i], factors[i])));
+        result = std::max(result, angleBetween(singleResults[i], Quaternion::slerp<utils_maths::Precise>(quaternions1[i], quaternions2[i], singleFactor)));
+    }
+    return result;
+}
+
+/* Returns random unit quaternions (uniformly distributed rotations) */
+static std::vector<Quaternion> randomRotations(std::mt19937& generator, size_t count) {
+    std::normal_distribution<float> normal;
+    std::vector<Quaternion> quaternions(count);
+    for (Quaternion& quaternion : quaternions)
+        quaternion = Quaternion(normal(generator), normal(generator), normal(generator), normal(generator)).normalised();
+    return quaternions;
+}
+
+static void addQuaternionChecks(CheckSuite& suite) {
+    // Errors in degrees (see Batch.h for the bounds) - the angles are those
+    // between the rotations, which is twice the angle between the
+    // quaternions
+    suite.add("utils_batch::slerp (up to 120 degrees)", 0.005, []() { return interpolationError(utils_batch::slerp, utils_batch::slerp, 0.0f, 120.0f); });
+    suite.add("utils_batch::slerp (any angle)", 0.05, []() { return interpolationError(utils_batch::slerp, utils_batch::slerp, 0.0f, 179.9f); });
+    suite.add("utils_batch::nlerp (up to 30 degrees)", 0.04, []() { return interpolationError(utils_batch::nlerp, utils_batch::nlerp, 0.0f, 30.0f); });
+    suite.add("utils_batch::nlerp (up to 90 degrees)", 0.93, []() { return interpolationError(utils_batch::nlerp, utils_batch::nlerp, 0.0f, 90.0f); });
+    suite.add("utils_batch::nlerp (any angle)", 8.16, []() { return interpolationError(utils_batch::nlerp, utils_batch::nlerp, 0.0f, 179.9f); });
+
+    // The fast scalar slerp only differs from the precise one by the errors
+    // of the utils_maths approximations
+    suite.add("Quaternion::slerp<Fast>", 1e-4, []() {
+        return interpolationError(
+            [](const Quaternion* quaternions1, const Quaternion* quaternions2, float factor, Quaternion* results, size_t count) {
+                for (size_t i = 0; i < count; ++i)
+                    results[i] = Quaternion::slerp<utils_maths::Fast>(quaternions1[i], quaternions2[i], factor);
+            },
+            [](const Quaternion* quaternions1, const Quaternion* quaternions2, const float* factors, Quaternion* results, size_t count) {
+                for (size_t i = 0; i < count; ++i)
+                    results[i] = Quaternion::slerp<utils_maths::Fast>(quaternions1[i], quaternions2[i], factors[i]);
+            },
+            0.0f, 179.9f);
+    });
+
+    // The batch versions use the same formulas as the scalar ones, so only
+    // rounding differs (the vectors are between -1 and 1, so absolute errors
+    // suffice). The count isn't a multiple of 4 so the remainder is checked
+    // too, and rotate is also checked in place.
+    suite.add("utils_batch::rotate", 1e-5, []() {
+        const size_t count = SAMPLES - 1;
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternions = randomRotations(generator, count);
+        std::vector<float> components       = randomValues(generator, -1.0f, 1.0f, count * 3);
+        std::vector<Vector3f> vectors;
+        for (size_t i = 0; i < count; ++i)
+            vectors.push_back(Vector3f(components[i * 3], components[i * 3 + 1], components[i * 3 + 2]));
+
+        std::vector<Vector3f> results(count);
+        std::vector<Vector3f> inPlace = vectors;
+        utils_batch::rotate(quaternions.data(), vectors.data(), results.data(), count);
+        utils_batch::rotate(quaternions.data(), inPlace.data(), inPlace.data(), count);
+
+        double result = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            Vector3f expected = Quaternion::rotate(vectors[i], quaternions[i]);
+            result            = std::max(result, std::max(maxDifference(&results[i][0], &expected[0], 3), maxDifference(&inPlace[i][0], &expected[0], 3)));
+        }
+        return result;
+    });
+    suite.add("utils_batch::toMatrices", 1e-5, []() {
+        const size_t count = SAMPLES - 1;
+        std::mt19937 generator(SEED);
+        std::vector<Quaternion> quaternions = randomRotations(generator, count);
+
+        std::vector<Matrix4f> matrices(count);
+        utils_batch::toMatrices(quaternions.data(), matrices.data(), count);
+
+        double result = 0.0;
+        for (size_t i = 0; i < count; ++i)
+            result = std::max(result, maxDifference(matrices[i].data(), quaternions[i].toMatrix().data(), 16));
+        return result;
+    });
+}
+
+/*****************************************************************************
+ * Matrices and vectors
+ *****************************************************************************/
+
+// The SIMD paths of Matrix4f and Vector4f are skipped during constant
+// evaluation (intrinsics can't be evaluated at compile time), so results
+// computed in a constexpr context come from the generic code, which is also
+// what a build with UE_NO_SIMD uses. Calling the same function at run time
+// takes the SIMD paths instead (when they're enabled), so comparing the two
+// checks them against the generic code within a single build.
+
+/* Number of inputs compared (kept small as they're evaluated at compile
+   time) */
+static constexpr size_t GENERIC_SAMPLES = 64;
+
+/* Returns a pseudo random value between -1 and 1 from a linear congruential
+   generator (which unlike std::mt19937 can be used at compile time) */
+static constexpr float randomValue(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+}
+
+/* Inputs for the comparisons */
+struct MatrixInputs {
+    Matrix<float, 4> matrices1[GENERIC_SAMPLES];
+    Matrix<float, 4> matrices2[GENERIC_SAMPLES];
+    Vector<float, 4> vectors1[GENERIC_SAMPLES];
+    Vector<float, 4> vectors2[GENERIC_SAMPLES];
+};
+
+static constexpr MatrixInputs createMatrixInputs() {
+    MatrixInputs inputs;
+    uint32_t state = SEED;
+    for (size_t i = 0; i < GENERIC_SAMPLES; ++i) {
+        for (unsigned int col = 0; col < 4; ++col) {
+            for (unsigned int row = 0; row < 4; ++row) {
+                inputs.matrices1[i].set(row, col, randomValue(state));
+                inputs.matrices2[i].set(row, col, randomValue(state));
+            }
+            inputs.vectors1[i][col] = randomValue(state);
+            // Kept away from 0 as they are also divided by
+            inputs.vectors2[i][col] = 1.5f + randomValue(state);
+        }
+    }
+    return inputs;
+}
+
+/* Results of the operations with SIMD paths for each input */
+struct MatrixResults {
+    Matrix<float, 4> products[GENERIC_SAMPLES];
+    Vector<float, 4> transformed[GENERIC_SAMPLES];
+    Matrix<float, 4> transposes[GENERIC_SAMPLES];
+
+    // Element-wise operations that round the same on any path
+    Vector<float, 4> arithmetic[GENERIC_SAMPLES][6];
+
+    // Operations whose rounding may differ (e.g. when the SIMD path uses
+    // fused multiply adds or sums in a different order)
+    Vector<float, 4> fused[GENERIC_SAMPLES][4];
+    float dots[GENERIC_SAMPLES]{};
+};
+
+static constexpr MatrixResults computeMatrixResults(const MatrixInputs& in) {
+    MatrixResults results;
+    for (size_t i = 0; i < GENERIC_SAMPLES; ++i) {
+        const Vector<float, 4>& a = in.vectors1[i];
+        const Vector<float, 4>& b = in.vectors2[i];
+
+        results.products[i]      = in.matrices1[i] * in.matrices2[i];
+        results.transformed[i]   = in.matrices1[i] * a;
+        results.transposes[i]    = in.matrices1[i].transpose();
+        results.arithmetic[i][0] = a + b;
+        results.arithmetic[i][1] = a - b;
+        results.arithmetic[i][2] = a * b;
+        results.arithmetic[i][3] = a / b;
+        results.arithmetic[i][4] = a * 3.0f;
+        results.arithmetic[i][5] = a / 3.0f;
+        results.fused[i][0]      = Vector<float, 4>::multiplyAdd(a, b, a);
+        results.fused[i][1]      = Vector<float, 4>::multiplyAdd(a, 0.75f, b);
+        results.fused[i][2]      = Vector<float, 4>::linearCombination(a, 0.25f, b, -2.0f);
+        results.fused[i][3]      = Vector<float, 4>::lerp(a, b, 0.6f);
+        results.dots[i]          = a.dot(b);
+    }
+    return results;
+}
+
+/* Inputs and the results of the generic code */
+static constexpr MatrixInputs MATRIX_INPUTS     = createMatrixInputs();
+static constexpr MatrixResults GENERIC_RESULTS = computeMatrixResults(MATRIX_INPUTS);
+
+/* Returns the largest difference between the values of two arrays of
+   matrices or vectors */
+template <typename T>
+static double maxDifference(const T* a, const T* b, size_t count) {
+    static_assert(sizeof(T) % sizeof(float) == 0, "Only arrays of floats can be compared");
+    return maxDifference(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), count * sizeof(T) / sizeof(float));
+}
+
+/* Returns the results of the SIMD paths (this mustn't be used to initialise
+   a constant or static variable, as the compiler could then evaluate it at
+   compile time) */
+static MatrixResults computeSIMDResults() {
+    MatrixResults results = computeMatrixResults(MATRIX_INPUTS);
+    return results;
+}
+
+static void addMatrixChecks(CheckSuite& suite) {
+    // The inputs are between -1 and 1 (other than the vectors divided by,
+    // which are between 0.5 and 2.5), so absolute errors suffice
+    suite.add("Matrix4f::operator* (Matrix4f) SIMD", 1e-5, []() { return maxDifference(computeSIMDResults().products, GENERIC_RESULTS.products, GENERIC_SAMPLES); });
+    suite.add("Matrix4f::operator* (Vector4f) SIMD", 1e-5, []() { return maxDifference(computeSIMDResults().transformed, GENERIC_RESULTS.transformed, GENERIC_SAMPLES); });
+    suite.add("Matrix4f::transpose SIMD", 0.0, []() { return maxDifference(computeSIMDResults().transposes, GENERIC_RESULTS.transposes, GENERIC_SAMPLES); });
+    suite.add("Vector4f arithmetic SIMD", 0.0, []() { return maxDifference(computeSIMDResults().arithmetic, GENERIC_RESULTS.arithmetic, GENERIC_SAMPLES); });
+    suite.add("Vector4f fused operations SIMD", 1e-5, []() {
+        MatrixResults simd = computeSIMDResults();
+        return std::max(maxDifference(simd.fused, GENERIC_RESULTS.fused, GENERIC_SAMPLES), maxDifference(simd.dots, GENERIC_RESULTS.dots, GENERIC_SAMPLES));
+    });
+}
+
+/*****************************************************************************
+ * Inverses
+ *****************************************************************************/
+
+// Rather than comparing inverses with each other (which share a kernel),
+// each is multiplied by the matrix it came from in double precision and the
+// largest difference from the identity matrix is found, relative to the
+// sizes of the two matrices (the infinity norm of M * M^-1 - I divided by
+// those of M and M^-1). That stays near the precision of a float for a
+// stable inverse even when the matrix is poorly conditioned (as projections
+// with a distant far plane are).
+
+/* Returns random translation, rotation and scale matrices, with translations
+   between -10 and 10 and scales between 0.5 and 2 along each axis */
+static std::vector<Matrix4f> randomTransforms(std::mt19937& generator, size_t count) {
+    std::vector<Quaternion> rotations = randomRotations(generator, count);
+    std::vector<float> translations   = randomValues(generator, -10.0f, 10.0f, count * 3);
+    std::vector<float> scales         = randomValues(generator, 0.5f, 2.0f, count * 3);
+    std::vector<Matrix4f> matrices(count);
+    for (size_t i = 0; i < count; ++i)
+        matrices[i].initTransform(Vector3f(translations[i * 3], translations[i * 3 + 1], translations[i * 3 + 2]), rotations[i], Vector3f(scales[i * 3], scales[i * 3 + 1], scales[i * 3 + 2]));
+    return matrices;
+}
+
+/* Returns random perspective projections of random transforms (as a model
+   view projection matrix would be) */
+static std::vector<Matrix4f> randomProjections(std::mt19937& generator, size_t count) {
+    std::vector<Matrix4f> matrices = randomTransforms(generator, count);
+    std::vector<float> fovs        = randomValues(generator, 30.0f, 120.0f, count);
+    std::vector<float> aspects     = randomValues(generator, 0.5f, 2.0f, count);
+    std::vector<float> nears       = randomValues(generator, 0.01f, 1.0f, count);
+    std::vector<float> fars        = randomValues(generator, 10.0f, 1000.0f, count);
+    for (size_t i = 0; i < count; ++i)
+        matrices[i] = Matrix4f().initPerspective(fovs[i], aspects[i], nears[i], fars[i]) * matrices[i];
+    return matrices;
+}
+
+/* Returns the largest residual of inverses of matrices (see above) */
+static double inverseResidual(const std::vector<Matrix4f>& matrices, const std::vector<Matrix4f>& inverses) {
+    auto norm = [](const double (&values)[4][4]) {
+        double result = 0.0;
+        for (unsigned int row = 0; row < 4; ++row)
+            result = std::max(result, std::fabs(values[row][0]) + std::fabs(values[row][1]) + std::fabs(values[row][2]) + std::fabs(values[row][3]));
+        return result;
+    };
+
+    double result = 0.0;
+    for (size_t i = 0; i < matrices.size(); ++i) {
+        double matrix[4][4], inverse[4][4], residual[4][4];
+        for (unsigned int row = 0; row < 4; ++row) {
+            for (unsigned int col = 0; col < 4; ++col) {
+                matrix[row][col]  = matrices[i].get(row, col);
+                inverse[row][col] = inverses[i].get(row, col);
+            }
+        }
+        for (unsigned int row = 0; row < 4; ++row) {
+            for (unsigned int col = 0; col < 4; ++col) {
+                residual[row][col] = row == col ? -1.0 : 0.0;
+                for (unsigned int k = 0; k < 4; ++k)
+                    residual[row][col] += matrix[row][k] * inverse[k][col];
+            }
+        }
+        result = std::max(result, norm(residual) / (norm(matrix) * norm(inverse)));
+    }
+    return result;
+}
+
+/* Returns the largest residual of inverting matrices one at a time using
+   invert */
+static double singleInverseResidual(const std::vector<Matrix4f>& matrices, Matrix4f (Matrix4f::*invert)() const) {
+    std::vector<Matrix4f> inverses;
+    for (const Matrix4f& matrix : matrices)
+        inverses.push_back((matrix.*invert)());
+    return inverseResidual(matrices, inverses);
+}
+
+/* Returns the largest residual of inverting matrices with a batch function
+   (both separately and in place, the results of which must match) */
+static double batchInverseResidual(const std::vector<Matrix4f>& matrices, void (*invert)(const Matrix4f*, Matrix4f*, size_t)) {
+    std::vector<Matrix4f> inverses(matrices.size());
+    std::vector<Matrix4f> inPlace = matrices;
+    invert(matrices.data(), inverses.data(), matrices.size());
+    invert(inPlace.data(), inPlace.data(), inPlace.size());
+    for (size_t i = 0; i < matrices.size(); ++i) {
+        if (maxDifference(inverses[i].data(), inPlace[i].data(), 16) != 0.0)
+            return std::numeric_limits<double>::infinity();
+    }
+    return inverseResidual(matrices, inverses);
+}
+
+static void addInverseChecks(CheckSuite& suite) {
+    // The counts aren't multiples of 4 so the remainders of the batch
+    // functions are checked too
+    suite.add("Matrix4f::inverse (transforms)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return singleInverseResidual(randomTransforms(generator, SAMPLES - 1), &Matrix4f::inverse);
+    });
+    suite.add("Matrix4f::inverse (projections)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return singleInverseResidual(randomProjections(generator, SAMPLES - 1), &Matrix4f::inverse);
+    });
+    suite.add("Matrix4f::inverseAffine", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return singleInverseResidual(randomTransforms(generator, SAMPLES - 1), &Matrix4f::inverseAffine);
+    });
+    suite.add("utils_batch::inverse (transforms)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return batchInverseResidual(randomTransforms(generator, SAMPLES - 1), utils_batch::inverse);
+    });
+    suite.add("utils_batch::inverse (projections)", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return batchInverseResidual(randomProjections(generator, SAMPLES - 1), utils_batch::inverse);
+    });
+    suite.add("utils_batch::inverseAffine", 1e-6, []() {
+        std::mt19937 generator(SEED);
+        return batchInverseResidual(randomTransforms(generator, SAMPLES - 1), utils_batch::inverseAffine);
+    });
+}
+
+/*****************************************************************************
+ * Transforms
+ *****************************************************************************/
+
+// The batch transforms are compared to transforming each vector with the
+// scalar matrix operations, reading and writing with different strides (as
+// part of interleaved vertex data) and in place. The counts per matrix aren't
+// multiples of 4 so the remainders are checked too.
+
+/* Batch transform of 3D vectors (as utils_batch::transformPoints) */
+typedef void (*BatchTransform)(const Matrix4f&, const float*, float*, size_t, size_t, size_t);
+
+/* Returns the largest difference between the results of a batch transform
+   and a reference for one set of strides. Unless the results are
+   normalised this is relative to the size of the terms summed for each one
+   (the infinity norm of the matrix times that of the vector, or 1 if that
+   is larger) as their rounding errors don't cancel like the terms can.
+   Returns infinity if anything between the results is changed. */
+static double transformError(BatchTransform transform, Vector3f (*reference)(const Matrix4f&, const Vector3f&), bool normalised, size_t inStride, size_t outStride, bool inPlace) {
+    std::mt19937 generator(SEED);
+    std::vector<Matrix4f> matrices = randomTransforms(generator, 16);
+    const size_t count             = SAMPLES / matrices.size() - 1;
+
+    double error = 0.0;
+    for (const Matrix4f& matrix : matrices) {
+        double matrixNorm = 0.0;
+        for (unsigned int row = 0; row < 3; ++row)
+            matrixNorm = std::max(matrixNorm, static_cast<double>(std::fabs(matrix.get(row, 0)) + std::fabs(matrix.get(row, 1)) + std::fabs(matrix.get(row, 2)) + std::fabs(matrix.get(row, 3))));
+
+        std::vector<float> values  = randomValues(generator, -10.0f, 10.0f, count * inStride);
+        std::vector<float> initial = inPlace ? values : randomValues(generator, -10.0f, 10.0f, count * outStride);
+        std::vector<float> results = initial;
+        transform(matrix, inPlace ? results.data() : values.data(), results.data(), count, inStride, outStride);
+
+        for (size_t i = 0; i < count; ++i) {
+            const float* value = &values[i * inStride];
+            Vector3f expected  = reference(matrix, Vector3f(value[0], value[1], value[2]));
+            double scale       = normalised ? 1.0 : std::max(matrixNorm * std::max({std::fabs(value[0]), std::fabs(value[1]), std::fabs(value[2]), 1.0f}), 1.0);
+            error             = std::max(error, maxDifference(&results[i * outStride], &expected[0], 3) / scale);
+            if (maxDifference(&results[i * outStride + 3], &initial[i * outStride + 3], outStride - 3) != 0.0)
+                return std::numeric_limits<double>::infinity();
+        }
+    }
+    return error;
+}
+
+/* Returns the largest error of a batch transform (see above) over tightly
+   packed vectors, interleaved inputs, padded outputs and interleaved
+   vectors transformed in place */
+static double transformError(BatchTransform transform, Vector3f (*reference)(const Matrix4f&, const Vector3f&), bool normalised) {
+    return std::max({transformError(transform, reference, normalised, 3, 3, false), transformError(transform, reference, normalised, 8, 3, false), transformError(transform, reference, normalised, 3, 5, false),
+                     transformError(transform, reference, normalised, 8, 8, true)});
+}
+
+static void addTransformChecks(CheckSuite& suite) {
+    suite.add("utils_batch::transformPoints", 1e-6, []() {
+        return transformError(
+            [](const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) { utils_batch::transformPoints(matrix, in, out, count, inStride, outStride); },
+            [](const Matrix4f& matrix, const Vector3f& point) -> Vector3f { return Vector3f(matrix * Vector4f(point, 1.0f)); }, false);
+    });
+    suite.add("utils_batch::transformDirections", 1e-6, []() {
+        return transformError(
+            [](const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) { utils_batch::transformDirections(matrix, in, out, count, inStride, outStride); },
+            [](const Matrix4f& matrix, const Vector3f& direction) -> Vector3f { return Vector3f(matrix * Vector4f(direction, 0.0f)); }, false);
+    });
+    suite.add("utils_batch::transformDirections (normalised)", 1e-6, []() {
+        return transformError(
+            [](const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) { utils_batch::transformDirections(matrix, in, out, count, inStride, outStride, true); },
+            [](const Matrix4f& matrix, const Vector3f& direction) -> Vector3f { return Vector3f(matrix * Vector4f(direction, 0.0f)).normalised(); }, true);
+    });
+    suite.add("utils_batch::transformNormals", 1e-6, []() {
+        return transformError(
+            [](const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) { utils_batch::transformNormals(matrix, in, out, count, inStride, outStride); },
+            [](const Matrix4f& matrix, const Vector3f& normal) -> Vector3f { return (Matrix3f(matrix.to3x3()).inverse().transpose() * normal).normalised(); }, true);
+    });
+}
+
+/*****************************************************************************
+ * Maths checks
+ *****************************************************************************/
+
+void addMathsChecks(CheckSuite& suite) {
+    addFastMathsChecks(suite);
+    addPackingChecks(suite);
+    addQuaternionChecks(suite);
+    addMatrixChecks(suite);
+    addInverseChecks(suite);
+    addTransformChecks(suite);
+}
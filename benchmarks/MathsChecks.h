@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Benchmark.h"
+
+/*****************************************************************************
+ * Maths checks - Checks the accuracy of the maths classes timed by the
+ *                benchmarks
+ *****************************************************************************/
+
+/* Adds the checks to a suite */
+void addMathsChecks(CheckSuite& suite);
@@ -0,0 +1,43 @@
+#include "AABB.h"
+
+#include <cfloat>
+
+#include "maths/SIMD.h"
+
+using utils_simd::Float4;
+
+/*****************************************************************************
+ * AABB class
+ *****************************************************************************/
+
+/* Returns the box bounding the points at the positions given by
+   getIndex(i) for i from 0 to count */
+template <typename IndexFunction>
+static AABB boundPoints(const float* positions, size_t count, size_t stride, unsigned int dimensions, IndexFunction getIndex) {
+    if (count == 0)
+        return AABB();
+
+    // Each point is loaded as (x, y, z, 0) so a single min and max covers
+    // every axis, with two sets of results to halve the dependency chain
+    const bool is3D = dimensions == 3;
+    Float4 min[2]   = {Float4::set1(FLT_MAX), Float4::set1(FLT_MAX)};
+    Float4 max[2]   = {Float4::set1(-FLT_MAX), Float4::set1(-FLT_MAX)};
+    for (size_t i = 0; i < count; ++i) {
+        const float* position = positions + getIndex(i) * stride;
+        Float4 point          = Float4::set(position[0], position[1], is3D ? position[2] : 0.0f, 0.0f);
+        min[i & 1]            = utils_simd::min(min[i & 1], point);
+        max[i & 1]            = utils_simd::max(max[i & 1], point);
+    }
+    Float4 minimum = utils_simd::min(min[0], min[1]);
+    Float4 maximum = utils_simd::max(max[0], max[1]);
+
+    return AABB(Vector3f(minimum.get(0), minimum.get(1), minimum.get(2)), Vector3f(maximum.get(0), maximum.get(1), maximum.get(2)));
+}
+
+AABB AABB::fromPoints(const float* positions, size_t count, size_t stride, unsigned int dimensions) {
+    return boundPoints(positions, count, stride, dimensions, [](size_t i) { return i; });
+}
+
+AABB AABB::fromIndexedPoints(const float* positions, const uint32_t* indices, size_t count, uint32_t indexOffset, size_t stride, unsigned int dimensions) {
+    return boundPoints(positions, count, stride, dimensions, [indices, indexOffset](size_t i) { return static_cast<size_t>(indices[i] + indexOffset); });
+}
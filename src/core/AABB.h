@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "maths/Vector.h"
+
+/*****************************************************************************
+ * AABB class - Defines an axis aligned bounding box
+ *****************************************************************************/
+
+class AABB {
+public:
+    /* Corners of this box with the smallest and largest coordinates */
+    Vector3f min;
+    Vector3f max;
+
+    /* Constructors and destructor */
+    AABB() {}
+    AABB(Vector3f min, Vector3f max) : min(min), max(max) {}
+    virtual ~AABB() {}
+
+    /* Returns the centre of this box */
+    inline Vector3f getCentre() const { return (min + max) * 0.5f; }
+
+    /* Returns half the size of this box along each axis */
+    inline Vector3f getExtents() const { return (max - min) * 0.5f; }
+
+    /* Returns whether this box contains a point */
+    inline bool contains(const Vector3f& point) const {
+        return point.getX() >= min.getX() && point.getX() <= max.getX() &&
+               point.getY() >= min.getY() && point.getY() <= max.getY() &&
+               point.getZ() >= min.getZ() && point.getZ() <= max.getZ();
+    }
+
+    /* Returns whether this box intersects with another box */
+    inline bool intersects(const AABB& other) const {
+        return min.getX() <= other.max.getX() && max.getX() >= other.min.getX() &&
+               min.getY() <= other.max.getY() && max.getY() >= other.min.getY() &&
+               min.getZ() <= other.max.getZ() && max.getZ() >= other.min.getZ();
+    }
+
+    /* Returns the box bounding a set of points given by count positions with
+       stride floats between the start of each (the z component is taken as 0
+       when dimensions is 2) */
+    static AABB fromPoints(const float* positions, size_t count, size_t stride = 3, unsigned int dimensions = 3);
+
+    /* As above but for the points referenced by count indices (each having
+       indexOffset added before use) */
+    static AABB fromIndexedPoints(const float* positions, const uint32_t* indices, size_t count, uint32_t indexOffset = 0, size_t stride = 3, unsigned int dimensions = 3);
+};
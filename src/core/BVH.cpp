@@ -0,0 +1,726 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace utils_simd;
+
+/*****************************************************************************
+ * BVH class
+ *****************************************************************************/
+
+/* Number of bins used when evaluating splits */
+static const unsigned int NUM_BINS = 16;
+
+/* Largest leaf created when splitting would be more expensive */
+static const uint32_t MAX_LEAF_SIZE = 2 * BVH::SLOT_SIZE;
+
+/* Cost of traversing a node relative to testing a slot */
+static const float TRAVERSAL_COST = 1.0f;
+
+/* Depth after which splits are made at the median rather than using the
+   surface area heuristic - this bounds the depth of the tree (and so the
+   size of the traversal stack) */
+static const unsigned int MAX_SAH_DEPTH = 48;
+
+/* Size of the traversal stack (each level of the tree adds at most 3
+   entries and the tree can't be deeper than MAX_SAH_DEPTH + 32) */
+static const unsigned int STACK_SIZE = 256;
+
+/* Smallest number of primitives that will be built on a separate thread */
+static const uint32_t PARALLEL_THRESHOLD = 8192;
+
+/* Node of the binary tree used while building */
+struct BuildNode {
+    float min[3];
+    float max[3];
+    // Index of the left child (the right follows it) for nodes
+    uint32_t left;
+    // Range of primitive references for leaves (count is 0 for nodes)
+    uint32_t first;
+    uint32_t count;
+};
+
+/* Entry in a traversal stack */
+struct StackEntry {
+    // Index of a node or the first slot of a leaf
+    uint32_t index;
+    // Number of slots (0 for a node)
+    uint32_t slotCount;
+    // Distance at which the ray enters its bounds
+    float distance;
+};
+
+/* Returns half the surface area of a box */
+static inline float halfArea(const float* min, const float* max) {
+    float x = max[0] - min[0];
+    float y = max[1] - min[1];
+    float z = max[2] - min[2];
+    return x * y + y * z + z * x;
+}
+
+/* Returns the number of slots needed for a number of primitives */
+static inline uint32_t slotsFor(uint32_t count) {
+    return (count + BVH::SLOT_SIZE - 1) / BVH::SLOT_SIZE;
+}
+
+/* Builds the binary tree */
+class BVHBuilder {
+private:
+    /* Bounds accumulated using SIMD instructions (the 4th lane is unused) */
+    struct Bounds {
+        Float4 min = Float4::set1(FLT_MAX);
+        Float4 max = Float4::set1(-FLT_MAX);
+
+        inline void expand(const Float4& otherMin, const Float4& otherMax) {
+            min = utils_simd::min(min, otherMin);
+            max = utils_simd::max(max, otherMax);
+        }
+
+        inline float halfArea() const {
+            alignas(ALIGNMENT) float lower[4], upper[4];
+            min.store(lower);
+            max.store(upper);
+            return ::halfArea(lower, upper);
+        }
+    };
+
+    /* Bin used while evaluating splits */
+    struct Bin {
+        Bounds bounds;
+        uint32_t count = 0;
+    };
+
+    /* Primitive referenced by the tree (these are reordered while building
+       so each node's primitives are contiguous) */
+    struct alignas(ALIGNMENT) Reference {
+        // The 4th components are only there for loading into SIMD registers
+        float min[4];
+        float max[4];
+        uint32_t index;
+        // Centroid along the axis used for the last median split
+        float centroid;
+
+        inline Float4 getMin() const { return Float4::load(min); }
+        inline Float4 getMax() const { return Float4::load(max); }
+        inline Float4 getCentroid() const { return (getMin() + getMax()) * Float4::set1(0.5f); }
+    };
+
+    std::vector<Reference> references;
+    std::atomic<uint32_t> nodeCount;
+    unsigned int parallelDepth = 0;
+
+    /* Splits a range of primitives at their median along an axis, returns
+       the number on the left */
+    uint32_t splitMedian(uint32_t first, uint32_t count, unsigned int axis) {
+        uint32_t middle = count / 2;
+        for (uint32_t i = first; i < first + count; ++i)
+            references[i].centroid = (references[i].min[axis] + references[i].max[axis]) * 0.5f;
+        std::nth_element(references.begin() + first, references.begin() + first + middle, references.begin() + first + count, [](const Reference& a, const Reference& b) {
+            return a.centroid < b.centroid;
+        });
+        return middle;
+    }
+
+    /* Builds a node from a range of primitives */
+    void buildNode(uint32_t index, uint32_t first, uint32_t count, unsigned int depth) {
+        BuildNode& node = nodes[index];
+
+        // Bounds of the primitives and their centroids
+        Bounds nodeBounds, centroidBounds;
+        for (uint32_t i = first; i < first + count; ++i) {
+            Float4 centroid = references[i].getCentroid();
+            nodeBounds.expand(references[i].getMin(), references[i].getMax());
+            centroidBounds.expand(centroid, centroid);
+        }
+        alignas(ALIGNMENT) float bounds[4], centroidMin[4], centroidMax[4];
+        nodeBounds.min.store(bounds);
+        std::copy(bounds, bounds + 3, node.min);
+        nodeBounds.max.store(bounds);
+        std::copy(bounds, bounds + 3, node.max);
+        centroidBounds.min.store(centroidMin);
+        centroidBounds.max.store(centroidMax);
+
+        node.first = first;
+        node.count = count;
+        if (count <= BVH::SLOT_SIZE)
+            return;
+
+        unsigned int largestAxis = 0;
+        for (unsigned int axis = 1; axis < 3; ++axis) {
+            if (centroidMax[axis] - centroidMin[axis] > centroidMax[largestAxis] - centroidMin[largestAxis])
+                largestAxis = axis;
+        }
+
+        uint32_t leftCount = 0;
+        if (depth >= MAX_SAH_DEPTH)
+            leftCount = splitMedian(first, count, largestAxis);
+        else {
+            // Sort the primitives into bins along every axis in a single
+            // pass
+            float scales[3];
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                float extent = centroidMax[axis] - centroidMin[axis];
+                scales[axis] = extent > 0.0f ? NUM_BINS / extent : 0.0f;
+            }
+            Float4 offset = centroidBounds.min;
+            Float4 scale  = Float4::set(scales[0], scales[1], scales[2], 0.0f);
+            Bin bins[3][NUM_BINS];
+            for (uint32_t i = first; i < first + count; ++i) {
+                Float4 min = references[i].getMin();
+                Float4 max = references[i].getMax();
+
+                alignas(ALIGNMENT) float positions[4];
+                (((min + max) * Float4::set1(0.5f) - offset) * scale).store(positions);
+                for (unsigned int axis = 0; axis < 3; ++axis) {
+                    Bin& bin = bins[axis][utils_maths::min(static_cast<unsigned int>(positions[axis]), NUM_BINS - 1)];
+                    bin.bounds.expand(min, max);
+                    bin.count++;
+                }
+            }
+
+            // Evaluate the cost of splitting between each of the bins along
+            // each axis by sweeping from the right to find the costs of the
+            // right sides then from the left to combine them
+            float bestCost        = FLT_MAX;
+            unsigned int bestAxis = 0;
+            unsigned int bestBin  = 0;
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                if (scales[axis] == 0.0f)
+                    continue;
+
+                float rightCosts[NUM_BINS];
+                Bin right;
+                for (unsigned int bin = NUM_BINS - 1; bin > 0; --bin) {
+                    right.bounds.expand(bins[axis][bin].bounds.min, bins[axis][bin].bounds.max);
+                    right.count += bins[axis][bin].count;
+                    rightCosts[bin] = right.count > 0 ? slotsFor(right.count) * right.bounds.halfArea() : FLT_MAX;
+                }
+                Bin left;
+                for (unsigned int bin = 0; bin < NUM_BINS - 1; ++bin) {
+                    left.bounds.expand(bins[axis][bin].bounds.min, bins[axis][bin].bounds.max);
+                    left.count += bins[axis][bin].count;
+                    if (left.count == 0 || left.count == count)
+                        continue;
+                    float cost = slotsFor(left.count) * left.bounds.halfArea() + rightCosts[bin + 1];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin  = bin;
+                    }
+                }
+            }
+
+            float area     = halfArea(node.min, node.max);
+            float leafCost = slotsFor(count) * area;
+            if (bestCost == FLT_MAX || TRAVERSAL_COST * area + bestCost >= leafCost) {
+                // Leaves are cheaper but may only be so large
+                if (count <= MAX_LEAF_SIZE)
+                    return;
+                leftCount = splitMedian(first, count, largestAxis);
+            } else {
+                auto middle = std::partition(references.begin() + first, references.begin() + first + count, [&](const Reference& reference) {
+                    float centroid = (reference.min[bestAxis] + reference.max[bestAxis]) * 0.5f;
+                    return utils_maths::min(static_cast<unsigned int>((centroid - centroidMin[bestAxis]) * scales[bestAxis]), NUM_BINS - 1) <= bestBin;
+                });
+                leftCount = static_cast<uint32_t>(middle - (references.begin() + first));
+            }
+        }
+
+        // Children are allocated in pairs so they are next to each other
+        uint32_t left = nodeCount.fetch_add(2);
+        node.left     = left;
+        node.count    = 0;
+
+        if (count >= PARALLEL_THRESHOLD && depth < parallelDepth) {
+            auto task = std::async(std::launch::async, [=]() { buildNode(left, first, leftCount, depth + 1); });
+            buildNode(left + 1, first + leftCount, count - leftCount, depth + 1);
+            task.get();
+        } else {
+            buildNode(left, first, leftCount, depth + 1);
+            buildNode(left + 1, first + leftCount, count - leftCount, depth + 1);
+        }
+    }
+
+public:
+    /* Resulting nodes (the first being the root) */
+    std::vector<BuildNode> nodes;
+
+    /* Constructor */
+    BVHBuilder(const std::vector<BVH::PrimitiveBounds>& bounds) : nodeCount(1) {
+        uint32_t count = static_cast<uint32_t>(bounds.size());
+
+        references.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            std::copy(bounds[i].min, bounds[i].min + 3, references[i].min);
+            std::copy(bounds[i].max, bounds[i].max + 3, references[i].max);
+            references[i].min[3]   = 0.0f;
+            references[i].max[3]   = 0.0f;
+            references[i].index    = i;
+            references[i].centroid = 0.0f;
+        }
+
+        // A binary tree never has more than 2n - 1 nodes so this is allocated
+        // up front to allow the threads to refer to nodes safely
+        nodes.resize(count * 2);
+
+        // Allow roughly one task per hardware thread
+        unsigned int threads = std::thread::hardware_concurrency();
+        while ((1u << parallelDepth) < threads)
+            parallelDepth++;
+
+        buildNode(0, 0, count, 0);
+        nodes.resize(nodeCount);
+    }
+
+    /* Converts part of the binary tree into nodes of a hierarchy with up to
+       4 children, returns the index of the new node */
+    uint32_t collapse(BVH& bvh, uint32_t index) const {
+        // Gather up to 4 children by repeatedly replacing the one with the
+        // largest surface area by its own children
+        uint32_t children[4];
+        unsigned int numChildren = 0;
+        if (nodes[index].count > 0)
+            children[numChildren++] = index;
+        else {
+            children[numChildren++] = nodes[index].left;
+            children[numChildren++] = nodes[index].left + 1;
+        }
+        while (numChildren < 4) {
+            int largest        = -1;
+            float largestArea  = -1.0f;
+            for (unsigned int i = 0; i < numChildren; ++i) {
+                const BuildNode& child = nodes[children[i]];
+                float area             = halfArea(child.min, child.max);
+                if (child.count == 0 && area > largestArea) {
+                    largest     = i;
+                    largestArea = area;
+                }
+            }
+            if (largest == -1)
+                break;
+            uint32_t left             = nodes[children[largest]].left;
+            children[largest]         = left;
+            children[numChildren++]   = left + 1;
+        }
+
+        uint32_t nodeIndex = static_cast<uint32_t>(bvh.nodes.size());
+        bvh.nodes.emplace_back();
+        for (unsigned int i = 0; i < 4; ++i) {
+            // Missing children are given empty bounds (they are skipped when
+            // traversing)
+            uint32_t childIndex = BVH::INVALID_INDEX;
+            uint32_t slotCount  = 0;
+            float min[3]        = {0.0f, 0.0f, 0.0f};
+            float max[3]        = {0.0f, 0.0f, 0.0f};
+            if (i < numChildren) {
+                const BuildNode& child = nodes[children[i]];
+                std::copy(child.min, child.min + 3, min);
+                std::copy(child.max, child.max + 3, max);
+                if (child.count > 0) {
+                    // Add the primitives of the leaf to slots (padding the last)
+                    childIndex = static_cast<uint32_t>(bvh.slots.size() / BVH::SLOT_SIZE);
+                    slotCount  = slotsFor(child.count);
+                    for (uint32_t j = 0; j < slotCount * BVH::SLOT_SIZE; ++j)
+                        bvh.slots.push_back(j < child.count ? references[child.first + j].index : BVH::INVALID_INDEX);
+                } else
+                    childIndex = collapse(bvh, children[i]);
+            }
+
+            // Nodes may have been added so this can't be kept as a reference
+            BVH::Node& node      = bvh.nodes[nodeIndex];
+            node.minX[i]         = min[0];
+            node.minY[i]         = min[1];
+            node.minZ[i]         = min[2];
+            node.maxX[i]         = max[0];
+            node.maxY[i]         = max[1];
+            node.maxZ[i]         = max[2];
+            node.children[i]     = childIndex;
+            node.slotCounts[i]   = slotCount;
+        }
+        return nodeIndex;
+    }
+};
+
+BVH::RayLanes::RayLanes(const Ray& ray) {
+    originX    = Float4::set1(ray.origin.getX());
+    originY    = Float4::set1(ray.origin.getY());
+    originZ    = Float4::set1(ray.origin.getZ());
+    directionX = Float4::set1(ray.direction.getX());
+    directionY = Float4::set1(ray.direction.getY());
+    directionZ = Float4::set1(ray.direction.getZ());
+
+    // Avoid infinities (which could produce NaNs in the slab tests) for
+    // directions parallel to an axis
+    auto safeInverse = [](float value) { return 1.0f / (fabsf(value) > 1e-20f ? value : copysignf(1e-20f, value)); };
+    inverseDirectionX = Float4::set1(safeInverse(ray.direction.getX()));
+    inverseDirectionY = Float4::set1(safeInverse(ray.direction.getY()));
+    inverseDirectionZ = Float4::set1(safeInverse(ray.direction.getZ()));
+}
+
+void BVH::build(const std::vector<PrimitiveBounds>& bounds) {
+    nodes.clear();
+    slots.clear();
+    if (bounds.empty())
+        return;
+
+    BVHBuilder builder(bounds);
+    nodes.reserve(builder.nodes.size() / 2 + 1);
+    slots.reserve(bounds.size() + bounds.size() / 2);
+    builder.collapse(*this, 0);
+}
+
+AABB BVH::getBounds() const {
+    if (nodes.empty())
+        return AABB();
+
+    const Node& root = nodes[0];
+    Vector3f min(FLT_MAX);
+    Vector3f max(-FLT_MAX);
+    for (unsigned int i = 0; i < 4; ++i) {
+        if (root.children[i] == INVALID_INDEX)
+            continue;
+        min = Vector3f(utils_maths::min(min.getX(), root.minX[i]), utils_maths::min(min.getY(), root.minY[i]), utils_maths::min(min.getZ(), root.minZ[i]));
+        max = Vector3f(utils_maths::max(max.getX(), root.maxX[i]), utils_maths::max(max.getY(), root.maxY[i]), utils_maths::max(max.getZ(), root.maxZ[i]));
+    }
+    return AABB(min, max);
+}
+
+template <typename SlotTest>
+bool BVH::traverse(const RayLanes& ray, float& maxDistance, bool anyHit, SlotTest testSlot) const {
+    if (nodes.empty())
+        return false;
+
+    StackEntry stack[STACK_SIZE];
+    unsigned int stackSize = 0;
+    stack[stackSize++]     = {0, 0, 0.0f};
+
+    bool hit = false;
+    while (stackSize > 0) {
+        StackEntry entry = stack[--stackSize];
+        // Skip anything that has become further away than the closest hit
+        if (entry.distance > maxDistance)
+            continue;
+
+        if (entry.slotCount > 0) {
+            for (uint32_t slot = entry.index; slot < entry.index + entry.slotCount; ++slot) {
+                if (testSlot(slot, maxDistance)) {
+                    hit = true;
+                    if (anyHit)
+                        return true;
+                }
+            }
+            continue;
+        }
+
+        // Slab test against all 4 children at once
+        const Node& node = nodes[entry.index];
+        Float4 x1        = (Float4::load(node.minX) - ray.originX) * ray.inverseDirectionX;
+        Float4 x2        = (Float4::load(node.maxX) - ray.originX) * ray.inverseDirectionX;
+        Float4 y1        = (Float4::load(node.minY) - ray.originY) * ray.inverseDirectionY;
+        Float4 y2        = (Float4::load(node.maxY) - ray.originY) * ray.inverseDirectionY;
+        Float4 z1        = (Float4::load(node.minZ) - ray.originZ) * ray.inverseDirectionZ;
+        Float4 z2        = (Float4::load(node.maxZ) - ray.originZ) * ray.inverseDirectionZ;
+        Float4 near      = max(max(min(x1, x2), min(y1, y2)), max(min(z1, z2), Float4::set1(0.0f)));
+        Float4 far       = min(min(max(x1, x2), max(y1, y2)), min(max(z1, z2), Float4::set1(maxDistance)));
+        int mask         = moveMask(lessEqual(near, far));
+        if (mask == 0)
+            continue;
+
+        alignas(ALIGNMENT) float distances[4];
+        near.store(distances);
+
+        // Push the children that were hit so the nearest is visited first
+        StackEntry children[4];
+        unsigned int numChildren = 0;
+        for (unsigned int i = 0; i < 4; ++i) {
+            if ((mask & (1 << i)) && node.children[i] != INVALID_INDEX) {
+                StackEntry child = {node.children[i], node.slotCounts[i], distances[i]};
+                unsigned int j   = numChildren++;
+                for (; j > 0 && children[j - 1].distance < child.distance; --j)
+                    children[j] = children[j - 1];
+                children[j] = child;
+            }
+        }
+        for (unsigned int i = 0; i < numChildren; ++i)
+            stack[stackSize++] = children[i];
+    }
+    return hit;
+}
+
+template <typename SlotFunction>
+void BVH::traverse(const AABB& box, SlotFunction function) const {
+    if (nodes.empty())
+        return;
+
+    Float4 boxMinX = Float4::set1(box.min.getX());
+    Float4 boxMinY = Float4::set1(box.min.getY());
+    Float4 boxMinZ = Float4::set1(box.min.getZ());
+    Float4 boxMaxX = Float4::set1(box.max.getX());
+    Float4 boxMaxY = Float4::set1(box.max.getY());
+    Float4 boxMaxZ = Float4::set1(box.max.getZ());
+
+    uint32_t stack[STACK_SIZE];
+    unsigned int stackSize = 0;
+    stack[stackSize++]     = 0;
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        Float4 overlaps  = lessEqual(Float4::load(node.minX), boxMaxX) & greaterEqual(Float4::load(node.maxX), boxMinX) &
+                          lessEqual(Float4::load(node.minY), boxMaxY) & greaterEqual(Float4::load(node.maxY), boxMinY) &
+                          lessEqual(Float4::load(node.minZ), boxMaxZ) & greaterEqual(Float4::load(node.maxZ), boxMinZ);
+        int mask = moveMask(overlaps);
+        for (unsigned int i = 0; i < 4; ++i) {
+            if (! (mask & (1 << i)) || node.children[i] == INVALID_INDEX)
+                continue;
+            if (node.slotCounts[i] > 0) {
+                for (uint32_t slot = node.children[i]; slot < node.children[i] + node.slotCounts[i]; ++slot)
+                    function(slot);
+            } else
+                stack[stackSize++] = node.children[i];
+        }
+    }
+}
+
+/*****************************************************************************
+ * MeshBVH class
+ *****************************************************************************/
+
+void MeshBVH::build(MeshData* mesh) {
+    packets.clear();
+    triangleCount = 0;
+
+    size_t offset, stride;
+    std::vector<float>* positions = mesh->getStream(MeshData::POSITION, offset, stride);
+    if (! positions) {
+        BVH::build({});
+        return;
+    }
+    bool is3D = mesh->getNumComponents(MeshData::POSITION) == 3;
+
+    // Vertex indices of each triangle (the indices of sub data are relative
+    // to their vertex offsets)
+    std::vector<uint32_t> vertices;
+    if (mesh->hasIndices()) {
+        const std::vector<uint32_t>& indices = mesh->getIndices();
+        vertices.resize(indices.size());
+        if (mesh->hasSubData()) {
+            for (size_t i = 0; i < mesh->getSubDataCount(); ++i) {
+                const MeshData::SubData& subData = mesh->getSubData(static_cast<unsigned int>(i));
+                size_t last                      = i + 1 < mesh->getSubDataCount() ? mesh->getSubData(static_cast<unsigned int>(i + 1)).firstIndex : indices.size();
+                for (size_t j = subData.firstIndex; j < last; ++j)
+                    vertices[j] = indices[j] + subData.vertexOffset;
+            }
+        } else
+            vertices = indices;
+    } else {
+        vertices.resize(mesh->getVertexCount());
+        for (uint32_t i = 0; i < mesh->getVertexCount(); ++i)
+            vertices[i] = i;
+    }
+    triangleCount = vertices.size() / 3;
+
+    // Returns the position of a vertex
+    auto getPosition = [&](uint32_t vertex) {
+        const float* position = positions->data() + offset + vertex * stride;
+        return Vector3f(position[0], position[1], is3D ? position[2] : 0.0f);
+    };
+
+    std::vector<PrimitiveBounds> bounds(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        Vector3f a = getPosition(vertices[i * 3]);
+        Vector3f b = getPosition(vertices[i * 3 + 1]);
+        Vector3f c = getPosition(vertices[i * 3 + 2]);
+        for (unsigned int j = 0; j < 3; ++j) {
+            bounds[i].min[j] = utils_maths::min(utils_maths::min(a[j], b[j]), c[j]);
+            bounds[i].max[j] = utils_maths::max(utils_maths::max(a[j], b[j]), c[j]);
+        }
+    }
+    BVH::build(bounds);
+
+    // Store the triangles of each slot (padding is left as degenerate
+    // triangles which are never hit)
+    packets.resize(slots.size() / SLOT_SIZE);
+    for (size_t slot = 0; slot < packets.size(); ++slot) {
+        TrianglePacket& packet = packets[slot];
+        for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+            uint32_t triangle = slots[slot * SLOT_SIZE + lane];
+            Vector3f a, edge1, edge2;
+            if (triangle != INVALID_INDEX) {
+                a     = getPosition(vertices[triangle * 3]);
+                edge1 = getPosition(vertices[triangle * 3 + 1]) - a;
+                edge2 = getPosition(vertices[triangle * 3 + 2]) - a;
+            }
+            packet.vertexX[lane] = a.getX();
+            packet.vertexY[lane] = a.getY();
+            packet.vertexZ[lane] = a.getZ();
+            packet.edge1X[lane]  = edge1.getX();
+            packet.edge1Y[lane]  = edge1.getY();
+            packet.edge1Z[lane]  = edge1.getZ();
+            packet.edge2X[lane]  = edge2.getX();
+            packet.edge2Y[lane]  = edge2.getY();
+            packet.edge2Z[lane]  = edge2.getZ();
+        }
+    }
+}
+
+bool MeshBVH::intersectSlot(uint32_t slot, const RayLanes& ray, float& maxDistance, Hit& hit) const {
+    // Moller-Trumbore test against the 4 triangles at once
+    const TrianglePacket& packet = packets[slot];
+    Float4 edge1X                = Float4::load(packet.edge1X);
+    Float4 edge1Y                = Float4::load(packet.edge1Y);
+    Float4 edge1Z                = Float4::load(packet.edge1Z);
+    Float4 edge2X                = Float4::load(packet.edge2X);
+    Float4 edge2Y                = Float4::load(packet.edge2Y);
+    Float4 edge2Z                = Float4::load(packet.edge2Z);
+
+    Float4 pX          = ray.directionY * edge2Z - ray.directionZ * edge2Y;
+    Float4 pY          = ray.directionZ * edge2X - ray.directionX * edge2Z;
+    Float4 pZ          = ray.directionX * edge2Y - ray.directionY * edge2X;
+    Float4 determinant = edge1X * pX + edge1Y * pY + edge1Z * pZ;
+    Float4 inverse     = Float4::set1(1.0f) / determinant;
+
+    Float4 tX = ray.originX - Float4::load(packet.vertexX);
+    Float4 tY = ray.originY - Float4::load(packet.vertexY);
+    Float4 tZ = ray.originZ - Float4::load(packet.vertexZ);
+    Float4 u  = (tX * pX + tY * pY + tZ * pZ) * inverse;
+
+    Float4 qX       = tY * edge1Z - tZ * edge1Y;
+    Float4 qY       = tZ * edge1X - tX * edge1Z;
+    Float4 qZ       = tX * edge1Y - tY * edge1X;
+    Float4 v        = (ray.directionX * qX + ray.directionY * qY + ray.directionZ * qZ) * inverse;
+    Float4 distance = (edge2X * qX + edge2Y * qY + edge2Z * qZ) * inverse;
+
+    // Parallel and padding triangles have a determinant of 0 (giving
+    // infinities or NaNs which fail the other tests anyway)
+    Float4 zero = Float4::set1(0.0f);
+    Float4 hits = greaterThan(abs(determinant), zero) & greaterEqual(u, zero) & greaterEqual(v, zero) & lessEqual(u + v, Float4::set1(1.0f)) &
+                  greaterThan(distance, zero) & lessThan(distance, Float4::set1(maxDistance));
+    int mask = moveMask(hits);
+    if (mask == 0)
+        return false;
+
+    alignas(ALIGNMENT) float distances[4], us[4], vs[4];
+    distance.store(distances);
+    u.store(us);
+    v.store(vs);
+    for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+        if ((mask & (1 << lane)) && distances[lane] < maxDistance) {
+            maxDistance  = distances[lane];
+            hit.distance = distances[lane];
+            hit.triangle = slots[slot * SLOT_SIZE + lane];
+            hit.u        = us[lane];
+            hit.v        = vs[lane];
+        }
+    }
+    return true;
+}
+
+bool MeshBVH::intersect(const Ray& ray, Hit& hit, float maxDistance) const {
+    RayLanes lanes(ray);
+    return traverse(lanes, maxDistance, false, [&](uint32_t slot, float& distance) { return intersectSlot(slot, lanes, distance, hit); });
+}
+
+bool MeshBVH::intersectsAny(const Ray& ray, float maxDistance) const {
+    RayLanes lanes(ray);
+    Hit hit;
+    return traverse(lanes, maxDistance, true, [&](uint32_t slot, float& distance) { return intersectSlot(slot, lanes, distance, hit); });
+}
+
+void MeshBVH::query(const AABB& box, std::vector<uint32_t>& triangles) const {
+    traverse(box, [&](uint32_t slot) {
+        const TrianglePacket& packet = packets[slot];
+        for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+            uint32_t triangle = slots[slot * SLOT_SIZE + lane];
+            if (triangle == INVALID_INDEX)
+                continue;
+            Vector3f a(packet.vertexX[lane], packet.vertexY[lane], packet.vertexZ[lane]);
+            Vector3f b = a + Vector3f(packet.edge1X[lane], packet.edge1Y[lane], packet.edge1Z[lane]);
+            Vector3f c = a + Vector3f(packet.edge2X[lane], packet.edge2Y[lane], packet.edge2Z[lane]);
+            AABB bounds(Vector3f(utils_maths::min(utils_maths::min(a.getX(), b.getX()), c.getX()), utils_maths::min(utils_maths::min(a.getY(), b.getY()), c.getY()), utils_maths::min(utils_maths::min(a.getZ(), b.getZ()), c.getZ())),
+                        Vector3f(utils_maths::max(utils_maths::max(a.getX(), b.getX()), c.getX()), utils_maths::max(utils_maths::max(a.getY(), b.getY()), c.getY()), utils_maths::max(utils_maths::max(a.getZ(), b.getZ()), c.getZ())));
+            if (bounds.intersects(box))
+                triangles.push_back(triangle);
+        }
+    });
+}
+
+/*****************************************************************************
+ * SceneBVH class
+ *****************************************************************************/
+
+Ray SceneBVH::toInstanceSpace(const Ray& ray, uint32_t instance) const {
+    const Matrix4f& inverse = inverseTransforms[instance];
+    Vector4f origin         = inverse * Vector4f(ray.origin, 1.0f);
+    Vector4f direction      = inverse * Vector4f(ray.direction, 0.0f);
+    return Ray(Vector3f(origin), Vector3f(direction));
+}
+
+void SceneBVH::build(const std::vector<Instance>& instances) {
+    this->instances = instances;
+    inverseTransforms.resize(instances.size());
+    instanceBounds.resize(instances.size());
+
+    // Bound each instance by transforming the corners of its mesh's bounds
+    std::vector<PrimitiveBounds> bounds(instances.size());
+    for (size_t i = 0; i < instances.size(); ++i) {
+        inverseTransforms[i] = instances[i].transform.inverseAffine();
+
+        AABB meshBounds = instances[i].mesh->getBounds();
+        for (unsigned int j = 0; j < 3; ++j) {
+            bounds[i].min[j] = FLT_MAX;
+            bounds[i].max[j] = -FLT_MAX;
+        }
+        for (unsigned int corner = 0; corner < 8; ++corner) {
+            Vector4f point = instances[i].transform * Vector4f(corner & 1 ? meshBounds.max.getX() : meshBounds.min.getX(),
+                                                               corner & 2 ? meshBounds.max.getY() : meshBounds.min.getY(),
+                                                               corner & 4 ? meshBounds.max.getZ() : meshBounds.min.getZ(), 1.0f);
+            for (unsigned int j = 0; j < 3; ++j) {
+                bounds[i].min[j] = utils_maths::min(bounds[i].min[j], point[j]);
+                bounds[i].max[j] = utils_maths::max(bounds[i].max[j], point[j]);
+            }
+        }
+        instanceBounds[i] = AABB(Vector3f(bounds[i].min[0], bounds[i].min[1], bounds[i].min[2]), Vector3f(bounds[i].max[0], bounds[i].max[1], bounds[i].max[2]));
+    }
+    BVH::build(bounds);
+}
+
+bool SceneBVH::intersect(const Ray& ray, Hit& hit, float maxDistance) const {
+    RayLanes lanes(ray);
+    return traverse(lanes, maxDistance, false, [&](uint32_t slot, float& distance) {
+        bool found = false;
+        for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+            uint32_t instance = slots[slot * SLOT_SIZE + lane];
+            if (instance != INVALID_INDEX && instances[instance].mesh->intersect(toInstanceSpace(ray, instance), hit, distance)) {
+                distance     = hit.distance;
+                hit.instance = instance;
+                found        = true;
+            }
+        }
+        return found;
+    });
+}
+
+bool SceneBVH::intersectsAny(const Ray& ray, float maxDistance) const {
+    RayLanes lanes(ray);
+    return traverse(lanes, maxDistance, true, [&](uint32_t slot, float& distance) {
+        for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+            uint32_t instance = slots[slot * SLOT_SIZE + lane];
+            if (instance != INVALID_INDEX && instances[instance].mesh->intersectsAny(toInstanceSpace(ray, instance), distance))
+                return true;
+        }
+        return false;
+    });
+}
+
+void SceneBVH::query(const AABB& box, std::vector<uint32_t>& instances) const {
+    traverse(box, [&](uint32_t slot) {
+        for (unsigned int lane = 0; lane < SLOT_SIZE; ++lane) {
+            uint32_t instance = slots[slot * SLOT_SIZE + lane];
+            if (instance != INVALID_INDEX && instanceBounds[instance].intersects(box))
+                instances.push_back(instance);
+        }
+    });
+}
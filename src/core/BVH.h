@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+#include "Ray.h"
+#include "maths/Matrix.h"
+#include "maths/SIMD.h"
+#include "render/Mesh.h"
+
+/*****************************************************************************
+ * BVH class - Base class for a bounding volume hierarchy over a set of
+ *             primitives for accelerating ray and overlap queries
+ *****************************************************************************/
+
+// Hierarchies are built in two steps. First a binary tree is built by
+// choosing splits with the surface area heuristic evaluated over a fixed
+// number of bins (large subtrees being built on separate threads). This is
+// then collapsed into a tree where each node has up to 4 children so a ray
+// can be tested against all of their boxes with a single set of SIMD
+// instructions. The primitives in each leaf are stored in groups of 4
+// ('slots') so they can be tested together in the same way.
+
+class BVH {
+public:
+    /* Result of a ray query */
+    struct Hit {
+        // Distance along the ray (in multiples of its direction)
+        float distance;
+        // Index of the triangle hit (i.e. its vertices are given by indices
+        // 3 * triangle to 3 * triangle + 2 of the mesh)
+        uint32_t triangle;
+        // Barycentric coordinates of the hit point relative to the second
+        // and third vertices of the triangle
+        float u;
+        float v;
+        // Index of the instance hit (only assigned by SceneBVH)
+        uint32_t instance;
+    };
+
+    /* Number of primitives in a slot */
+    static constexpr unsigned int SLOT_SIZE = 4;
+
+    /* Value used for padding slots and for missing children */
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+protected:
+    /* Node with up to 4 children */
+    struct alignas(utils_simd::ARRAY_ALIGNMENT) Node {
+        // Bounds of each child
+        float minX[4];
+        float minY[4];
+        float minZ[4];
+        float maxX[4];
+        float maxY[4];
+        float maxZ[4];
+        // Index of each child node or the first slot of each leaf (or
+        // INVALID_INDEX if there are fewer than 4 children)
+        uint32_t children[4];
+        // Number of slots in each leaf (0 if the child is a node)
+        uint32_t slotCounts[4];
+    };
+
+    /* Bounds of a primitive (used while building) */
+    struct PrimitiveBounds {
+        float min[3];
+        float max[3];
+    };
+
+    /* Components of a ray broadcast to every lane */
+    struct RayLanes {
+        utils_simd::Float4 originX, originY, originZ;
+        utils_simd::Float4 directionX, directionY, directionZ;
+        utils_simd::Float4 inverseDirectionX, inverseDirectionY, inverseDirectionZ;
+
+        RayLanes(const Ray& ray);
+    };
+
+    /* Nodes of this hierarchy (the first being the root) */
+    utils_simd::AlignedVector<Node> nodes;
+
+    /* Indices of the primitives in each slot (SLOT_SIZE per slot) */
+    std::vector<uint32_t> slots;
+
+    /* Builds this hierarchy given the bounds of each primitive */
+    void build(const std::vector<PrimitiveBounds>& bounds);
+
+    /* Traverses this hierarchy with a ray visiting the nearest nodes first.
+       testSlot(slot, maxDistance) is called for each slot in the leaves the
+       ray reaches within maxDistance and should return whether it found a
+       hit (and reduce maxDistance to its distance). Returns whether anything
+       was hit (stopping at the first if anyHit is true). */
+    template <typename SlotTest>
+    bool traverse(const RayLanes& ray, float& maxDistance, bool anyHit, SlotTest testSlot) const;
+
+    /* Traverses this hierarchy calling function(slot) for each slot in the
+       leaves whose bounds overlap a box */
+    template <typename SlotFunction>
+    void traverse(const AABB& box, SlotFunction function) const;
+
+    friend class BVHBuilder;
+
+public:
+    /* Constructor and destructor */
+    BVH() {}
+    virtual ~BVH() {}
+
+    /* Returns the bounds of everything in this hierarchy */
+    AABB getBounds() const;
+
+    /* Returns whether this hierarchy contains anything */
+    inline bool isEmpty() const { return nodes.empty(); }
+
+    /* Returns the number of nodes in this hierarchy */
+    inline size_t getNodeCount() const { return nodes.size(); }
+};
+
+/*****************************************************************************
+ * MeshBVH class - Bounding volume hierarchy over the triangles of a mesh
+ *****************************************************************************/
+
+class MeshBVH : public BVH {
+private:
+    /* Vertices of the triangles in a slot stored as the first vertex and
+       the edges to the other two */
+    struct alignas(utils_simd::ALIGNMENT) TrianglePacket {
+        float vertexX[4];
+        float vertexY[4];
+        float vertexZ[4];
+        float edge1X[4];
+        float edge1Y[4];
+        float edge1Z[4];
+        float edge2X[4];
+        float edge2Y[4];
+        float edge2Z[4];
+    };
+
+    /* Triangles of each slot */
+    utils_simd::AlignedVector<TrianglePacket> packets;
+
+    /* Number of triangles in the mesh */
+    size_t triangleCount = 0;
+
+    /* Tests the triangles in a slot against a ray, updating hit and
+       maxDistance if a closer one is found */
+    bool intersectSlot(uint32_t slot, const RayLanes& ray, float& maxDistance, Hit& hit) const;
+
+public:
+    /* Constructors and destructor */
+    MeshBVH() {}
+    MeshBVH(MeshData* mesh) { build(mesh); }
+    virtual ~MeshBVH() {}
+
+    /* Builds this hierarchy from the triangles of a mesh (taking the vertex
+       offsets of any sub data into account) */
+    void build(MeshData* mesh);
+
+    /* Finds the closest triangle hit by a ray within maxDistance, returns
+       whether one was found */
+    bool intersect(const Ray& ray, Hit& hit, float maxDistance = FLT_MAX) const;
+
+    /* Returns whether a ray hits any triangle within maxDistance (e.g. for
+       line of sight checks) */
+    bool intersectsAny(const Ray& ray, float maxDistance = FLT_MAX) const;
+
+    /* Adds the indices of the triangles whose bounds overlap a box to a
+       list */
+    void query(const AABB& box, std::vector<uint32_t>& triangles) const;
+
+    /* Returns the number of triangles in this hierarchy */
+    inline size_t getTriangleCount() const { return triangleCount; }
+};
+
+/*****************************************************************************
+ * SceneBVH class - Bounding volume hierarchy over instances of meshes that
+ *                  each have their own MeshBVH
+ *****************************************************************************/
+
+class SceneBVH : public BVH {
+public:
+    /* Instance of a mesh (the hierarchy must remain valid while this one
+       is used) */
+    struct Instance {
+        const MeshBVH* mesh;
+        Matrix4f transform;
+    };
+
+private:
+    /* Instances, the inverses of their transforms (for transforming rays
+       into the space of each mesh) and their bounds */
+    std::vector<Instance> instances;
+    std::vector<Matrix4f> inverseTransforms;
+    std::vector<AABB> instanceBounds;
+
+    /* Transforms a ray into the space of an instance (without normalising
+       its direction so distances along it are unchanged) */
+    Ray toInstanceSpace(const Ray& ray, uint32_t instance) const;
+
+public:
+    /* Constructors and destructor */
+    SceneBVH() {}
+    SceneBVH(const std::vector<Instance>& instances) { build(instances); }
+    virtual ~SceneBVH() {}
+
+    /* Builds this hierarchy from a set of instances (this should be called
+       again if any of them move) */
+    void build(const std::vector<Instance>& instances);
+
+    /* Finds the closest triangle of any instance hit by a ray within
+       maxDistance, returns whether one was found */
+    bool intersect(const Ray& ray, Hit& hit, float maxDistance = FLT_MAX) const;
+
+    /* Returns whether a ray hits any instance within maxDistance */
+    bool intersectsAny(const Ray& ray, float maxDistance = FLT_MAX) const;
+
+    /* Adds the indices of the instances whose bounds overlap a box to a
+       list */
+    void query(const AABB& box, std::vector<uint32_t>& instances) const;
+
+    /* Returns an instance */
+    inline const Instance& getInstance(uint32_t index) const { return instances[index]; }
+    inline size_t getInstanceCount() const { return instances.size(); }
+};
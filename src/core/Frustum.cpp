@@ -0,0 +1,144 @@
+#include "Frustum.h"
+
+using namespace utils_simd;
+
+/*****************************************************************************
+ * Frustum class
+ *****************************************************************************/
+
+/* Returns the signed distances of 4 points from a plane */
+static inline Float4 distanceToPlane(float planeX, float planeY, float planeZ, float planeW, const Float4& x, const Float4& y, const Float4& z) {
+    return multiplyAdd(Float4::set1(planeX), x, multiplyAdd(Float4::set1(planeY), y, multiplyAdd(Float4::set1(planeZ), z, Float4::set1(planeW))));
+}
+
+/* Returns a bitmask with a bit set for each of 4 spheres that is at least
+   partially inside the given planes */
+static inline int testSpheres(const float* planeX, const float* planeY, const float* planeZ, const float* planeW, const Float4& x, const Float4& y, const Float4& z, const Float4& radius) {
+    // Testing all of the planes without exiting early avoids mispredicted
+    // branches when the results are mixed
+    Float4 minDistance = -radius;
+    Float4 visible     = greaterEqual(distanceToPlane(planeX[0], planeY[0], planeZ[0], planeW[0], x, y, z), minDistance);
+    for (unsigned int p = 1; p < 6; ++p)
+        visible = visible & greaterEqual(distanceToPlane(planeX[p], planeY[p], planeZ[p], planeW[p], x, y, z), minDistance);
+    return moveMask(visible);
+}
+
+/* Returns the distances from the centres of 4 boxes to their corners
+   furthest along a plane's normal */
+static inline Float4 extentsAlongPlane(float planeX, float planeY, float planeZ, const Float4& extentsX, const Float4& extentsY, const Float4& extentsZ) {
+    return multiplyAdd(Float4::set1(fabsf(planeX)), extentsX, multiplyAdd(Float4::set1(fabsf(planeY)), extentsY, Float4::set1(fabsf(planeZ)) * extentsZ));
+}
+
+/* Writes the result for 4 volumes to a visibility mask */
+static inline void storeMask(int visible, uint8_t* visibleMask) {
+    visibleMask[0] = static_cast<uint8_t>(visible & 1);
+    visibleMask[1] = static_cast<uint8_t>((visible >> 1) & 1);
+    visibleMask[2] = static_cast<uint8_t>((visible >> 2) & 1);
+    visibleMask[3] = static_cast<uint8_t>((visible >> 3) & 1);
+}
+
+void Frustum::update(const Matrix4f& viewProjection) {
+    // Rows of the matrix
+    Vector4f rows[4];
+    for (unsigned int i = 0; i < 4; ++i)
+        rows[i] = Vector4f(viewProjection.get(i, 0), viewProjection.get(i, 1), viewProjection.get(i, 2), viewProjection.get(i, 3));
+
+    // A point is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w in
+    // clip space
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[2];
+    planes[5] = rows[3] - rows[2];
+
+    for (unsigned int p = 0; p < 6; ++p) {
+        planes[p] /= Vector3f(planes[p]).length();
+
+        planeX[p] = planes[p].getX();
+        planeY[p] = planes[p].getY();
+        planeZ[p] = planes[p].getZ();
+        planeW[p] = planes[p].getW();
+    }
+}
+
+bool Frustum::intersects(const Sphere& sphere) const {
+    for (unsigned int p = 0; p < 6; ++p) {
+        if (planeX[p] * sphere.centre.getX() + planeY[p] * sphere.centre.getY() + planeZ[p] * sphere.centre.getZ() + planeW[p] < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const AABB& box) const {
+    Vector3f centre  = box.getCentre();
+    Vector3f extents = box.getExtents();
+    for (unsigned int p = 0; p < 6; ++p) {
+        // Distance from the centre to the corner furthest along the normal
+        float radius = fabsf(planeX[p]) * extents.getX() + fabsf(planeY[p]) * extents.getY() + fabsf(planeZ[p]) * extents.getZ();
+        if (planeX[p] * centre.getX() + planeY[p] * centre.getY() + planeZ[p] * centre.getZ() + planeW[p] < -radius)
+            return false;
+    }
+    return true;
+}
+
+void Frustum::cull(const Sphere* spheres, size_t count, uint8_t* visibleMask) const {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const Sphere* s = spheres + i;
+
+        Float4 x      = Float4::set(s[0].centre.getX(), s[1].centre.getX(), s[2].centre.getX(), s[3].centre.getX());
+        Float4 y      = Float4::set(s[0].centre.getY(), s[1].centre.getY(), s[2].centre.getY(), s[3].centre.getY());
+        Float4 z      = Float4::set(s[0].centre.getZ(), s[1].centre.getZ(), s[2].centre.getZ(), s[3].centre.getZ());
+        Float4 radius = Float4::set(s[0].radius, s[1].radius, s[2].radius, s[3].radius);
+
+        storeMask(testSpheres(planeX, planeY, planeZ, planeW, x, y, z, radius), visibleMask + i);
+    }
+    for (; i < count; ++i)
+        visibleMask[i] = intersects(spheres[i]) ? 1 : 0;
+}
+
+void Frustum::cull(const AABB* boxes, size_t count, uint8_t* visibleMask) const {
+    const Float4 half = Float4::set1(0.5f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const AABB* b = boxes + i;
+
+        Float4 minX = Float4::set(b[0].min.getX(), b[1].min.getX(), b[2].min.getX(), b[3].min.getX());
+        Float4 minY = Float4::set(b[0].min.getY(), b[1].min.getY(), b[2].min.getY(), b[3].min.getY());
+        Float4 minZ = Float4::set(b[0].min.getZ(), b[1].min.getZ(), b[2].min.getZ(), b[3].min.getZ());
+        Float4 maxX = Float4::set(b[0].max.getX(), b[1].max.getX(), b[2].max.getX(), b[3].max.getX());
+        Float4 maxY = Float4::set(b[0].max.getY(), b[1].max.getY(), b[2].max.getY(), b[3].max.getY());
+        Float4 maxZ = Float4::set(b[0].max.getZ(), b[1].max.getZ(), b[2].max.getZ(), b[3].max.getZ());
+
+        Float4 centreX  = (minX + maxX) * half;
+        Float4 centreY  = (minY + maxY) * half;
+        Float4 centreZ  = (minZ + maxZ) * half;
+        Float4 extentsX = (maxX - minX) * half;
+        Float4 extentsY = (maxY - minY) * half;
+        Float4 extentsZ = (maxZ - minZ) * half;
+
+        Float4 visible = greaterEqual(distanceToPlane(planeX[0], planeY[0], planeZ[0], planeW[0], centreX, centreY, centreZ), -extentsAlongPlane(planeX[0], planeY[0], planeZ[0], extentsX, extentsY, extentsZ));
+        for (unsigned int p = 1; p < 6; ++p)
+            visible = visible & greaterEqual(distanceToPlane(planeX[p], planeY[p], planeZ[p], planeW[p], centreX, centreY, centreZ), -extentsAlongPlane(planeX[p], planeY[p], planeZ[p], extentsX, extentsY, extentsZ));
+        storeMask(moveMask(visible), visibleMask + i);
+    }
+    for (; i < count; ++i)
+        visibleMask[i] = intersects(boxes[i]) ? 1 : 0;
+}
+
+void Frustum::cull(const Vector3Stream& centres, const float* radii, uint8_t* visibleMask) const {
+    const size_t count = centres.size();
+    const float* x     = centres.getX();
+    const float* y     = centres.getY();
+    const float* z     = centres.getZ();
+
+    // The stream's arrays are aligned so every group of 4 can use aligned
+    // loads (radii need not be)
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        storeMask(testSpheres(planeX, planeY, planeZ, planeW, Float4::load(x + i), Float4::load(y + i), Float4::load(z + i), Float4::loadUnaligned(radii + i)), visibleMask + i);
+    for (; i < count; ++i)
+        visibleMask[i] = intersects(Sphere(x[i], y[i], z[i], radii[i])) ? 1 : 0;
+}
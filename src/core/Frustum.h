@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "AABB.h"
+#include "Sphere.h"
+#include "maths/Matrix.h"
+#include "maths/Streams.h"
+
+/*****************************************************************************
+ * Frustum class - Stores the planes of a camera's view frustum and methods
+ *                 for testing bounding volumes against them
+ *****************************************************************************/
+
+// The planes are extracted from a view projection matrix (Gribb & Hartmann)
+// assuming Vulkan's 0 to 1 depth range and are normalised so that evaluating
+// one at a point gives the signed distance to it (positive inside). The
+// culling methods test 4 volumes at a time against all 6 planes and write one
+// byte per volume to visibleMask (1 if it is at least partially inside, 0 if
+// it is entirely outside). Like most frustum tests they are conservative, so
+// a volume near a corner of the frustum may be reported as visible.
+
+class Frustum {
+private:
+    /* Planes of this frustum (left, right, bottom, top, near, far) as
+       (normal, distance) */
+    Vector4f planes[6];
+
+    /* Components of each plane stored separately so they can be broadcast
+       quickly when culling */
+    float planeX[6];
+    float planeY[6];
+    float planeZ[6];
+    float planeW[6];
+
+public:
+    /* Constructors */
+    Frustum() {}
+    Frustum(const Matrix4f& viewProjection) { update(viewProjection); }
+
+    /* Destructor */
+    virtual ~Frustum() {}
+
+    /* Extracts the planes of this frustum from a view projection matrix (a
+       projection matrix alone gives them in view space) */
+    void update(const Matrix4f& viewProjection);
+
+    /* Returns whether a sphere is at least partially inside this frustum */
+    bool intersects(const Sphere& sphere) const;
+
+    /* Returns whether a box is at least partially inside this frustum */
+    bool intersects(const AABB& box) const;
+
+    /* Tests spheres against this frustum (visibleMask must have room for
+       count values) */
+    void cull(const Sphere* spheres, size_t count, uint8_t* visibleMask) const;
+
+    /* Tests boxes against this frustum (visibleMask must have room for count
+       values) */
+    void cull(const AABB* boxes, size_t count, uint8_t* visibleMask) const;
+
+    /* Tests spheres stored as a stream of centres and an array of radii
+       against this frustum (radii and visibleMask must have room for
+       centres.size() values) - this avoids gathering the components of each
+       sphere and so is the fastest way to cull a large number of objects */
+    void cull(const Vector3Stream& centres, const float* radii, uint8_t* visibleMask) const;
+
+    /* Returns one of the planes of this frustum */
+    inline const Vector4f& getPlane(unsigned int index) const { return planes[index]; }
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "maths/Vector.h"
+
+/*****************************************************************************
+ * Ray class - Defines a ray starting at an origin and extending along a
+ *             direction
+ *****************************************************************************/
+
+class Ray {
+public:
+    /* Start of this ray */
+    Vector3f origin;
+
+    /* Direction of this ray (distances along it are measured in multiples
+       of this, so it should normally be normalised) */
+    Vector3f direction;
+
+    /* Constructors and destructor */
+    Ray() {}
+    Ray(Vector3f origin, Vector3f direction) : origin(origin), direction(direction) {}
+    virtual ~Ray() {}
+
+    /* Returns the point a given distance along this ray */
+    inline Vector3f getPoint(float distance) const { return origin + direction * distance; }
+};
@@ -0,0 +1,292 @@
+#include "Sphere.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "maths/SIMD.h"
+
+using utils_simd::Float4;
+
+/*****************************************************************************
+ * Sphere class
+ *****************************************************************************/
+
+// Spheres are computed with the EPOS-14 algorithm (Larsson 2008). The first
+// pass finds the points furthest along 7 fixed directions (the 3 axes and
+// the 4 diagonals), the smallest sphere containing those few points is
+// found exactly (Welzl 1991) and then a second pass grows the sphere to
+// cover any points still outside it (Ritter 1990). Both passes test 4 points
+// at a time, and as the initial sphere is already close to the smallest
+// possible, very few points ever need to grow it. The result is typically
+// within a few percent of the optimal radius.
+
+/* Number of directions used to find extreme points */
+static const unsigned int NUM_DIRECTIONS = 7;
+
+/* Directions used to find extreme points (these needn't be normalised as
+   only the order of the points along each matters) */
+static const float DIRECTIONS[NUM_DIRECTIONS][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}};
+
+/* Indices are tracked in float lanes while searching for extreme points, so
+   points are processed in blocks small enough for them to be exact */
+static const size_t BLOCK_SIZE = 1 << 24;
+
+/* Relative amount added to the final radius to cover rounding errors (which
+   scale with both the radius and the distance of the points from the
+   origin) */
+static const float RADIUS_EPSILON = 1e-6f;
+
+/* Provides access to the points being bounded */
+template <typename IndexFunction>
+struct PointSource {
+    const float* positions;
+    size_t stride;
+    bool is3D;
+    IndexFunction getIndex;
+
+    /* Returns a point */
+    inline Vector3f get(size_t i) const {
+        const float* position = positions + getIndex(i) * stride;
+        return Vector3f(position[0], position[1], is3D ? position[2] : 0.0f);
+    }
+
+    /* Loads 4 points starting from i with the components of each in
+       separate registers */
+    inline void get4(size_t i, Float4& x, Float4& y, Float4& z) const {
+        const float* p0 = positions + getIndex(i) * stride;
+        const float* p1 = positions + getIndex(i + 1) * stride;
+        const float* p2 = positions + getIndex(i + 2) * stride;
+        const float* p3 = positions + getIndex(i + 3) * stride;
+        x               = Float4::set(p0[0], p1[0], p2[0], p3[0]);
+        y               = Float4::set(p0[1], p1[1], p2[1], p3[1]);
+        z               = is3D ? Float4::set(p0[2], p1[2], p2[2], p3[2]) : Float4::set1(0.0f);
+    }
+};
+
+/* Returns whether a sphere contains a point (allowing for rounding) */
+static inline bool containsPoint(const Vector3f& centre, float radius, const Vector3f& point) {
+    Vector3f offset = point - centre;
+    return offset.dot(offset) <= radius * radius * (1.0f + 4.0f * RADIUS_EPSILON) + FLT_MIN;
+}
+
+/* Returns the smallest sphere with up to 4 points on its surface */
+static Sphere fromSupport(const Vector3f* support, unsigned int count) {
+    if (count == 0)
+        return Sphere(Vector3f(), -1.0f);
+    if (count == 1)
+        return Sphere(support[0], 0.0f);
+    if (count == 2)
+        return Sphere((support[0] + support[1]) * 0.5f, (support[1] - support[0]).length() * 0.5f);
+
+    Vector3f a = support[1] - support[0];
+    Vector3f b = support[2] - support[0];
+    if (count == 3) {
+        // Circumcircle of the triangle
+        Vector3f normal      = a.cross(b);
+        float normalLengthSq = normal.dot(normal);
+        if (normalLengthSq > FLT_EPSILON * a.dot(a) * b.dot(b)) {
+            Vector3f offset = Vector3f(b * a.dot(a) - a * b.dot(b)).cross(normal) / (2.0f * normalLengthSq);
+            return Sphere(support[0] + offset, offset.length());
+        }
+    } else {
+        // Circumsphere of the tetrahedron
+        Vector3f c        = support[3] - support[0];
+        float determinant = 2.0f * a.dot(b.cross(c));
+        float scale       = a.length() * b.length() * c.length();
+        if (fabsf(determinant) > FLT_EPSILON * scale) {
+            Vector3f offset = (b.cross(c) * a.dot(a) + c.cross(a) * b.dot(b) + a.cross(b) * c.dot(c)) / determinant;
+            return Sphere(support[0] + offset, offset.length());
+        }
+    }
+
+    // The points are (almost) collinear or coplanar, so the sphere is given
+    // by a subset of them - choose the smallest one that contains the rest
+    Sphere best(Vector3f(), FLT_MAX);
+    for (unsigned int skip = 0; skip < count; ++skip) {
+        Vector3f subset[3];
+        unsigned int subsetCount = 0;
+        for (unsigned int i = 0; i < count; ++i) {
+            if (i != skip)
+                subset[subsetCount++] = support[i];
+        }
+        Sphere sphere = fromSupport(subset, subsetCount);
+        if (sphere.radius < best.radius && containsPoint(sphere.centre, sphere.radius, support[skip]))
+            best = sphere;
+    }
+    return best;
+}
+
+/* Returns the smallest sphere containing count points with the support
+   points on its surface (Welzl's algorithm - only used for a handful of
+   points) */
+static Sphere welzl(const Vector3f* points, unsigned int count, Vector3f* support, unsigned int supportCount) {
+    if (count == 0 || supportCount == 4)
+        return fromSupport(support, supportCount);
+
+    Sphere sphere = welzl(points, count - 1, support, supportCount);
+    if (sphere.radius >= 0.0f && containsPoint(sphere.centre, sphere.radius, points[count - 1]))
+        return sphere;
+
+    support[supportCount] = points[count - 1];
+    return welzl(points, count - 1, support, supportCount + 1);
+}
+
+/* Finds the indices (as given to the point source) of the points with the
+   smallest and largest projections onto each direction */
+template <typename Source>
+static void findExtremePoints(const Source& source, size_t count, size_t (&minIndices)[NUM_DIRECTIONS], size_t (&maxIndices)[NUM_DIRECTIONS]) {
+    float minValues[NUM_DIRECTIONS];
+    float maxValues[NUM_DIRECTIONS];
+    for (unsigned int d = 0; d < NUM_DIRECTIONS; ++d) {
+        minValues[d]  = FLT_MAX;
+        maxValues[d]  = -FLT_MAX;
+        minIndices[d] = maxIndices[d] = 0;
+    }
+
+    // Updates the results with a single point
+    auto addPoint = [&](size_t i) {
+        Vector3f point = source.get(i);
+        for (unsigned int d = 0; d < NUM_DIRECTIONS; ++d) {
+            float value = DIRECTIONS[d][0] * point.getX() + DIRECTIONS[d][1] * point.getY() + DIRECTIONS[d][2] * point.getZ();
+            if (value < minValues[d]) {
+                minValues[d]  = value;
+                minIndices[d] = i;
+            }
+            if (value > maxValues[d]) {
+                maxValues[d]  = value;
+                maxIndices[d] = i;
+            }
+        }
+    };
+
+    for (size_t blockStart = 0; blockStart < count; blockStart += BLOCK_SIZE) {
+        size_t blockEnd = std::min(count, blockStart + BLOCK_SIZE);
+
+        // Best values in each lane and the (block relative) index of the
+        // point they came from
+        Float4 laneMin[NUM_DIRECTIONS], laneMax[NUM_DIRECTIONS];
+        Float4 laneMinIndex[NUM_DIRECTIONS], laneMaxIndex[NUM_DIRECTIONS];
+        for (unsigned int d = 0; d < NUM_DIRECTIONS; ++d) {
+            laneMin[d]      = Float4::set1(FLT_MAX);
+            laneMax[d]      = Float4::set1(-FLT_MAX);
+            laneMinIndex[d] = laneMaxIndex[d] = Float4::set1(0.0f);
+        }
+
+        const Float4 four = Float4::set1(4.0f);
+        Float4 index      = Float4::set(0.0f, 1.0f, 2.0f, 3.0f);
+        size_t i          = blockStart;
+        for (; i + 4 <= blockEnd; i += 4, index = index + four) {
+            Float4 x, y, z;
+            source.get4(i, x, y, z);
+
+            // The projections onto each direction (the diagonals share their
+            // partial sums)
+            Float4 xPlusY                 = x + y;
+            Float4 xMinusY                = x - y;
+            Float4 values[NUM_DIRECTIONS] = {x, y, z, xPlusY + z, xPlusY - z, xMinusY + z, xMinusY - z};
+            for (unsigned int d = 0; d < NUM_DIRECTIONS; ++d) {
+                Float4 smaller  = utils_simd::lessThan(values[d], laneMin[d]);
+                Float4 larger   = utils_simd::greaterThan(values[d], laneMax[d]);
+                laneMin[d]      = utils_simd::select(smaller, values[d], laneMin[d]);
+                laneMinIndex[d] = utils_simd::select(smaller, index, laneMinIndex[d]);
+                laneMax[d]      = utils_simd::select(larger, values[d], laneMax[d]);
+                laneMaxIndex[d] = utils_simd::select(larger, index, laneMaxIndex[d]);
+            }
+        }
+
+        // Combine the lanes
+        for (unsigned int d = 0; d < NUM_DIRECTIONS; ++d) {
+            for (unsigned int lane = 0; lane < 4; ++lane) {
+                float value = laneMin[d].get(lane);
+                if (value < minValues[d]) {
+                    minValues[d]  = value;
+                    minIndices[d] = blockStart + static_cast<size_t>(laneMinIndex[d].get(lane));
+                }
+                value = laneMax[d].get(lane);
+                if (value > maxValues[d]) {
+                    maxValues[d]  = value;
+                    maxIndices[d] = blockStart + static_cast<size_t>(laneMaxIndex[d].get(lane));
+                }
+            }
+        }
+
+        for (; i < blockEnd; ++i)
+            addPoint(i);
+    }
+}
+
+/* Grows a sphere to contain a point (moving its centre towards the point
+   so the far side stays put) */
+static inline void grow(Vector3f& centre, float& radius, const Vector3f& point) {
+    Vector3f offset  = point - centre;
+    float distanceSq = offset.dot(offset);
+    if (distanceSq > radius * radius) {
+        float distance  = sqrtf(distanceSq);
+        float newRadius = (radius + distance) * 0.5f;
+        centre += offset * ((newRadius - radius) / distance);
+        radius = newRadius;
+    }
+}
+
+/* Returns a tight sphere bounding count points */
+template <typename Source>
+static Sphere boundPoints(const Source& source, size_t count) {
+    if (count == 0)
+        return Sphere();
+
+    // Initial sphere around the extreme points (ignoring repeats)
+    size_t minIndices[NUM_DIRECTIONS], maxIndices[NUM_DIRECTIONS];
+    findExtremePoints(source, count, minIndices, maxIndices);
+
+    size_t extremeIndices[2 * NUM_DIRECTIONS];
+    std::copy(minIndices, minIndices + NUM_DIRECTIONS, extremeIndices);
+    std::copy(maxIndices, maxIndices + NUM_DIRECTIONS, extremeIndices + NUM_DIRECTIONS);
+    std::sort(extremeIndices, extremeIndices + 2 * NUM_DIRECTIONS);
+    size_t* extremeEnd = std::unique(extremeIndices, extremeIndices + 2 * NUM_DIRECTIONS);
+
+    Vector3f extremePoints[2 * NUM_DIRECTIONS];
+    unsigned int extremeCount = 0;
+    for (size_t* index = extremeIndices; index != extremeEnd; ++index)
+        extremePoints[extremeCount++] = source.get(*index);
+
+    Vector3f support[4];
+    Sphere sphere = welzl(extremePoints, extremeCount, support, 0);
+
+    // Grow it to cover any remaining points
+    Vector3f centre = sphere.centre;
+    float radius    = sphere.radius;
+    size_t i        = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 x, y, z;
+        source.get4(i, x, y, z);
+        Float4 offsetX    = x - Float4::set1(centre.getX());
+        Float4 offsetY    = y - Float4::set1(centre.getY());
+        Float4 offsetZ    = z - Float4::set1(centre.getZ());
+        Float4 distanceSq = utils_simd::multiplyAdd(offsetX, offsetX, utils_simd::multiplyAdd(offsetY, offsetY, offsetZ * offsetZ));
+
+        // Only fall back to growing one point at a time when one is outside
+        int outside = utils_simd::moveMask(utils_simd::greaterThan(distanceSq, Float4::set1(radius * radius)));
+        if (outside) {
+            for (unsigned int lane = 0; lane < 4; ++lane) {
+                if (outside & (1 << lane))
+                    grow(centre, radius, source.get(i + lane));
+            }
+        }
+    }
+    for (; i < count; ++i)
+        grow(centre, radius, source.get(i));
+
+    float magnitude = std::max(std::max(fabsf(centre.getX()), fabsf(centre.getY())), fabsf(centre.getZ()));
+    return Sphere(centre, radius + (radius + magnitude) * RADIUS_EPSILON);
+}
+
+Sphere Sphere::fromPoints(const float* positions, size_t count, size_t stride, unsigned int dimensions) {
+    auto getIndex = [](size_t i) { return i; };
+    return boundPoints(PointSource<decltype(getIndex)>{positions, stride, dimensions == 3, getIndex}, count);
+}
+
+Sphere Sphere::fromIndexedPoints(const float* positions, const uint32_t* indices, size_t count, uint32_t indexOffset, size_t stride, unsigned int dimensions) {
+    auto getIndex = [indices, indexOffset](size_t i) { return static_cast<size_t>(indices[i] + indexOffset); };
+    return boundPoints(PointSource<decltype(getIndex)>{positions, stride, dimensions == 3, getIndex}, count);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "maths/Vector.h"
 
 /*****************************************************************************
@@ -34,4 +36,13 @@ public:
     inline bool intersects(Sphere& other) {
         return (centre - other.centre).length() <= (radius + other.radius);
     }
+
+    /* Returns a tight sphere bounding a set of points given by count
+       positions with stride floats between the start of each (the z
+       component is taken as 0 when dimensions is 2) */
+    static Sphere fromPoints(const float* positions, size_t count, size_t stride = 3, unsigned int dimensions = 3);
+
+    /* As above but for the points referenced by count indices (each having
+       indexOffset added before use) */
+    static Sphere fromIndexedPoints(const float* positions, const uint32_t* indices, size_t count, uint32_t indexOffset = 0, size_t stride = 3, unsigned int dimensions = 3);
 };
\ No newline at end of file
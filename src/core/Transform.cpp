@@ -0,0 +1,59 @@
+#include "Transform.h"
+
+#include <algorithm>
+
+/*****************************************************************************
+ * Transform class
+ *****************************************************************************/
+
+Transform::~Transform() {
+    if (parent)
+        parent->removeChild(this);
+    // Children keep their current local values
+    for (Transform* child : children) {
+        child->parent = nullptr;
+        child->markWorldDirty();
+    }
+}
+
+void Transform::markWorldDirty() {
+    if (worldDirty)
+        return;
+    worldDirty = true;
+    for (Transform* child : children)
+        child->markWorldDirty();
+}
+
+void Transform::removeChild(Transform* child) {
+    children.erase(std::remove(children.begin(), children.end(), child), children.end());
+}
+
+void Transform::setParent(Transform* parent) {
+    if (this->parent == parent)
+        return;
+    if (this->parent)
+        this->parent->removeChild(this);
+    this->parent = parent;
+    if (parent)
+        parent->children.push_back(this);
+    markWorldDirty();
+}
+
+const Matrix4f& Transform::getLocalMatrix() {
+    if (localDirty) {
+        localMatrix.initTransform(position, rotation, scale);
+        localDirty = false;
+    }
+    return localMatrix;
+}
+
+const Matrix4f& Transform::getWorldMatrix() {
+    if (worldDirty) {
+        if (parent)
+            worldMatrix = parent->getWorldMatrix() * getLocalMatrix();
+        else
+            worldMatrix = getLocalMatrix();
+        worldDirty = false;
+    }
+    return worldMatrix;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+
+#include "maths/Matrix.h"
+
+/*****************************************************************************
+ * Transform class - Stores a position, rotation and scale along with an
+ *                   optional parent and caches the resulting matrices so they
+ *                   are only recomputed after something has changed
+ *****************************************************************************/
+
+class Transform {
+private:
+    /* Components of this transform (relative to the parent if there is one) */
+    Vector3f position;
+    Quaternion rotation = Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+    Vector3f scale      = Vector3f(1.0f);
+
+    /* Parent of this transform (if any) and its children */
+    Transform* parent = nullptr;
+    std::vector<Transform*> children;
+
+    /* Cached matrices */
+    Matrix4f localMatrix;
+    Matrix4f worldMatrix;
+
+    /* States whether each matrix needs recomputing */
+    bool localDirty = true;
+    bool worldDirty = true;
+
+    /* Marks the local matrix as needing recomputing */
+    inline void markLocalDirty() {
+        localDirty = true;
+        markWorldDirty();
+    }
+
+    /* Marks the world matrix of this transform and of all its descendants as
+       needing recomputing (stops at any already marked as everything below
+       them will be too) */
+    void markWorldDirty();
+
+    /* Removes a child from this transform */
+    void removeChild(Transform* child);
+
+public:
+    /* Constructors */
+    Transform() {}
+    Transform(const Vector3f& position, const Quaternion& rotation = Quaternion(0.0f, 0.0f, 0.0f, 1.0f), const Vector3f& scale = Vector3f(1.0f)) : position(position), rotation(rotation), scale(scale) {}
+
+    /* Children keep a pointer to their parent so transforms can't be copied */
+    Transform(const Transform& other) = delete;
+    Transform& operator=(const Transform& other) = delete;
+
+    /* Destructor (detaches this transform from its parent and children) */
+    virtual ~Transform();
+
+    /* Sets the parent of this transform (can be nullptr) */
+    void setParent(Transform* parent);
+
+    /* Setters (these only mark the matrices as needing recomputing) */
+    inline void setPosition(const Vector3f& position) {
+        this->position = position;
+        markLocalDirty();
+    }
+    inline void setRotation(const Quaternion& rotation) {
+        this->rotation = rotation;
+        markLocalDirty();
+    }
+    inline void setScale(const Vector3f& scale) {
+        this->scale = scale;
+        markLocalDirty();
+    }
+
+    /* Moves this transform */
+    inline void translate(const Vector3f& amount) { setPosition(position + amount); }
+
+    /* Rotates this transform (applied after its current rotation) */
+    inline void rotate(const Quaternion& amount) { setRotation(amount * rotation); }
+
+    /* Getters */
+    inline const Vector3f& getPosition() const { return position; }
+    inline const Quaternion& getRotation() const { return rotation; }
+    inline const Vector3f& getScale() const { return scale; }
+    inline Transform* getParent() const { return parent; }
+    inline const std::vector<Transform*>& getChildren() const { return children; }
+
+    /* Returns the matrix of this transform relative to its parent */
+    const Matrix4f& getLocalMatrix();
+
+    /* Returns the matrix of this transform including those of all of its
+       ancestors */
+    const Matrix4f& getWorldMatrix();
+
+    /* Returns the position of this transform in world space */
+    inline Vector3f getWorldPosition() {
+        const Matrix4f& matrix = getWorldMatrix();
+        return Vector3f(matrix.get(0, 3), matrix.get(1, 3), matrix.get(2, 3));
+    }
+};
@@ -0,0 +1,312 @@
+#include "Batch.h"
+
+#include "Kernels.h"
+
+using utils_simd::Float4;
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+/* Transforms 3 component values by the columns of a matrix (c3 should be zero
+   for directions) */
+static inline void transform3(const Float4& c0, const Float4& c1, const Float4& c2, const Float4& c3, const float* in, float* out, size_t count, size_t inStride, size_t outStride, bool normalise) {
+    for (size_t i = 0; i < count; ++i, in += inStride, out += outStride) {
+        // All values are read before writing, so in place is fine
+        Float4 result = utils_simd::multiplyAdd(c2, Float4::set1(in[2]), utils_simd::multiplyAdd(c1, Float4::set1(in[1]), utils_simd::multiplyAdd(c0, Float4::set1(in[0]), c3)));
+
+        if (normalise) {
+            // w is always 0 here, so a 4 component dot product is fine
+            Float4 lengthSquared = utils_simd::dot4(result, result);
+            Float4 zero          = Float4::set1(0.0f);
+            result               = utils_simd::select(utils_simd::greaterThan(lengthSquared, zero), result / utils_simd::sqrt(lengthSquared), zero);
+        }
+        result.store3(out);
+    }
+}
+
+/* Loads the x, y and z components of the columns of a matrix (w is only
+   needed when projecting which these don't do) */
+static inline void loadColumns(const Matrix4f& matrix, Float4& c0, Float4& c1, Float4& c2, Float4& c3) {
+    // clang-format off
+    c0 = Float4::set(matrix.get(0, 0), matrix.get(1, 0), matrix.get(2, 0), 0.0f);
+    c1 = Float4::set(matrix.get(0, 1), matrix.get(1, 1), matrix.get(2, 1), 0.0f);
+    c2 = Float4::set(matrix.get(0, 2), matrix.get(1, 2), matrix.get(2, 2), 0.0f);
+    c3 = Float4::set(matrix.get(0, 3), matrix.get(1, 3), matrix.get(2, 3), 0.0f);
+    // clang-format on
+}
+
+/* Multiplies a column by a matrix given by its columns */
+static inline Float4 transformColumn(const Float4& c0, const Float4& c1, const Float4& c2, const Float4& c3, float x, float y, float z, float w) {
+    return utils_simd::multiplyAdd(c3, Float4::set1(w), utils_simd::multiplyAdd(c2, Float4::set1(z), utils_simd::multiplyAdd(c1, Float4::set1(y), c0 * Float4::set1(x))));
+}
+
+/* Loads four matrices so that each lane holds the values of one of them */
+static inline void loadLanes(const Matrix4f* matrices, Float4 (&lanes)[4][4]) {
+    for (unsigned int col = 0; col < 4; ++col) {
+        Float4 m0 = Float4::load(matrices[0].data() + col * 4);
+        Float4 m1 = Float4::load(matrices[1].data() + col * 4);
+        Float4 m2 = Float4::load(matrices[2].data() + col * 4);
+        Float4 m3 = Float4::load(matrices[3].data() + col * 4);
+        utils_simd::transpose(m0, m1, m2, m3);
+        lanes[col][0] = m0;
+        lanes[col][1] = m1;
+        lanes[col][2] = m2;
+        lanes[col][3] = m3;
+    }
+}
+
+/* Stores four matrices from lanes loaded using the above */
+static inline void storeLanes(const Float4 (&lanes)[4][4], Matrix4f* matrices) {
+    for (unsigned int col = 0; col < 4; ++col) {
+        Float4 m0 = lanes[col][0];
+        Float4 m1 = lanes[col][1];
+        Float4 m2 = lanes[col][2];
+        Float4 m3 = lanes[col][3];
+        utils_simd::transpose(m0, m1, m2, m3);
+        m0.store(matrices[0].data() + col * 4);
+        m1.store(matrices[1].data() + col * 4);
+        m2.store(matrices[2].data() + col * 4);
+        m3.store(matrices[3].data() + col * 4);
+    }
+}
+
+/* Loads four quaternions so that each lane holds the values of one of them */
+static inline void loadLanes(const Quaternion* quaternions, Float4 (&lanes)[4]) {
+    for (unsigned int i = 0; i < 4; ++i)
+        lanes[i] = Float4::load(&quaternions[i][0]);
+    utils_simd::transpose(lanes[0], lanes[1], lanes[2], lanes[3]);
+}
+
+/* Stores four quaternions from lanes loaded using the above */
+static inline void storeLanes(const Float4 (&lanes)[4], Quaternion* quaternions) {
+    Float4 values[4] = {lanes[0], lanes[1], lanes[2], lanes[3]};
+    utils_simd::transpose(values[0], values[1], values[2], values[3]);
+    for (unsigned int i = 0; i < 4; ++i)
+        values[i].store(&quaternions[i][0]);
+}
+
+/* Copies the values of a quaternion into an array for use with the kernels */
+static inline void toArray(const Quaternion& quaternion, float (&values)[4]) {
+    for (unsigned int i = 0; i < 4; ++i)
+        values[i] = quaternion[i];
+}
+
+/* Interpolates pairs of quaternions using either nlerp or slerp (factors
+   should be given with a stride of 0 to use the same one for all of them) */
+template <bool SLERP>
+static void interpolate(const Quaternion* in1, const Quaternion* in2, const float* factors, size_t factorStride, Quaternion* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 a[4], b[4], result[4];
+        loadLanes(in1 + i, a);
+        loadLanes(in2 + i, b);
+
+        Float4 factor = factorStride == 0 ? Float4::set1(factors[0]) : Float4::loadUnaligned(factors + i);
+        if constexpr (SLERP)
+            utils_kernels::slerpQuaternion(a, b, factor, result);
+        else
+            utils_kernels::nlerpQuaternion(a, b, factor, result);
+
+        storeLanes(result, out + i);
+    }
+    // Remainder
+    for (; i < count; ++i) {
+        float a[4], b[4], result[4];
+        toArray(in1[i], a);
+        toArray(in2[i], b);
+
+        if constexpr (SLERP)
+            utils_kernels::slerpQuaternion(a, b, factors[i * factorStride], result);
+        else
+            utils_kernels::nlerpQuaternion(a, b, factors[i * factorStride], result);
+
+        out[i] = Quaternion(result[0], result[1], result[2], result[3]);
+    }
+}
+
+/*****************************************************************************
+ * utils_batch namespace
+ *****************************************************************************/
+
+void utils_batch::transformPoints(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) {
+    Float4 c0, c1, c2, c3;
+    loadColumns(matrix, c0, c1, c2, c3);
+    transform3(c0, c1, c2, c3, in, out, count, inStride, outStride, false);
+}
+
+void utils_batch::transformPoints2D(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) {
+    Float4 c0, c1, c2, c3;
+    loadColumns(matrix, c0, c1, c2, c3);
+    for (size_t i = 0; i < count; ++i, in += inStride, out += outStride) {
+        Float4 result = utils_simd::multiplyAdd(c1, Float4::set1(in[1]), utils_simd::multiplyAdd(c0, Float4::set1(in[0]), c3));
+        out[0]        = result.first();
+        out[1]        = result.get(1);
+    }
+}
+
+void utils_batch::transformDirections(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride, bool normalise) {
+    Float4 c0, c1, c2, c3;
+    loadColumns(matrix, c0, c1, c2, c3);
+    transform3(c0, c1, c2, Float4::set1(0.0f), in, out, count, inStride, outStride, normalise);
+}
+
+void utils_batch::transformNormals(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride, size_t outStride) {
+    // Normal matrix is the inverse transpose of the upper 3x3 part
+    Matrix3f normalMatrix = Matrix3f(matrix.to3x3()).inverse().transpose();
+
+    // clang-format off
+    Float4 c0 = Float4::set(normalMatrix.get(0, 0), normalMatrix.get(1, 0), normalMatrix.get(2, 0), 0.0f);
+    Float4 c1 = Float4::set(normalMatrix.get(0, 1), normalMatrix.get(1, 1), normalMatrix.get(2, 1), 0.0f);
+    Float4 c2 = Float4::set(normalMatrix.get(0, 2), normalMatrix.get(1, 2), normalMatrix.get(2, 2), 0.0f);
+    // clang-format on
+
+    transform3(c0, c1, c2, Float4::set1(0.0f), in, out, count, inStride, outStride, true);
+}
+
+void utils_batch::inverse(const Matrix4f* in, Matrix4f* out, size_t count) {
+    // Invert four at a time with one matrix per lane
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 lanes[4][4];
+        Float4 result[4][4];
+        loadLanes(in + i, lanes);
+        utils_kernels::inverse4x4(lanes, result);
+        storeLanes(result, out + i);
+    }
+    // Remainder
+    for (; i < count; ++i)
+        out[i] = in[i].inverse();
+}
+
+void utils_batch::inverseAffine(const Matrix4f* in, Matrix4f* out, size_t count) {
+    Float4 zero = Float4::set1(0.0f);
+    Float4 one  = Float4::set1(1.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 lanes[4][4];
+        Float4 result[4][4];
+        loadLanes(in + i, lanes);
+        utils_kernels::inverseAffine(lanes, result, zero, one);
+        storeLanes(result, out + i);
+    }
+    for (; i < count; ++i)
+        out[i] = in[i].inverseAffine();
+}
+
+void utils_batch::normalMatrices(const Matrix4f* in, Matrix3f* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 lanes[4][4];
+        loadLanes(in + i, lanes);
+
+        // clang-format off
+        Float4 upper[3][3] = {{lanes[0][0], lanes[0][1], lanes[0][2]},
+                              {lanes[1][0], lanes[1][1], lanes[1][2]},
+                              {lanes[2][0], lanes[2][1], lanes[2][2]}};
+        // clang-format on
+        Float4 upperInverse[3][3];
+        utils_kernels::inverse3x3(upper, upperInverse);
+
+        // Matrix3f isn't aligned so write out each lane (transposing as
+        // they are assigned)
+        for (unsigned int col = 0; col < 3; ++col) {
+            for (unsigned int row = 0; row < 3; ++row) {
+                alignas(utils_simd::ALIGNMENT) float values[4];
+                upperInverse[col][row].store(values);
+                for (unsigned int lane = 0; lane < 4; ++lane)
+                    out[i + lane].set(col, row, values[lane]);
+            }
+        }
+    }
+    for (; i < count; ++i)
+        out[i] = Matrix3f(in[i].to3x3()).inverse().transpose();
+}
+
+void utils_batch::cameraRelativeModelViews(const Matrix4f& view, const Vector3d& cameraPosition, const Vector3d* origins, const Matrix4f* models, Matrix4f* out, size_t count) {
+    // Columns of the view matrix without its translation
+    Float4 v0 = Float4::load(view.data());
+    Float4 v1 = Float4::load(view.data() + 4);
+    Float4 v2 = Float4::load(view.data() + 8);
+    Float4 v3 = Float4::set(0.0f, 0.0f, 0.0f, view.get(3, 3));
+
+    for (size_t i = 0; i < count; ++i) {
+        // Only the offset from the camera is converted to float
+        float offsetX = static_cast<float>(origins[i].getX() - cameraPosition.getX());
+        float offsetY = static_cast<float>(origins[i].getY() - cameraPosition.getY());
+        float offsetZ = static_cast<float>(origins[i].getZ() - cameraPosition.getZ());
+
+        // Each column of the result is the view applied to a column of the
+        // model matrix (with the offset added to its translation), all
+        // computed before storing so in place is fine
+        const float* m = models[i].data();
+        Float4 c0      = transformColumn(v0, v1, v2, v3, m[0], m[1], m[2], m[3]);
+        Float4 c1      = transformColumn(v0, v1, v2, v3, m[4], m[5], m[6], m[7]);
+        Float4 c2      = transformColumn(v0, v1, v2, v3, m[8], m[9], m[10], m[11]);
+        Float4 c3      = transformColumn(v0, v1, v2, v3, m[12] + offsetX, m[13] + offsetY, m[14] + offsetZ, m[15]);
+
+        float* result = out[i].data();
+        c0.store(result);
+        c1.store(result + 4);
+        c2.store(result + 8);
+        c3.store(result + 12);
+    }
+}
+
+void utils_batch::nlerp(const Quaternion* in1, const Quaternion* in2, float factor, Quaternion* out, size_t count) {
+    interpolate<false>(in1, in2, &factor, 0, out, count);
+}
+
+void utils_batch::nlerp(const Quaternion* in1, const Quaternion* in2, const float* factors, Quaternion* out, size_t count) {
+    interpolate<false>(in1, in2, factors, 1, out, count);
+}
+
+void utils_batch::slerp(const Quaternion* in1, const Quaternion* in2, float factor, Quaternion* out, size_t count) {
+    interpolate<true>(in1, in2, &factor, 0, out, count);
+}
+
+void utils_batch::slerp(const Quaternion* in1, const Quaternion* in2, const float* factors, Quaternion* out, size_t count) {
+    interpolate<true>(in1, in2, factors, 1, out, count);
+}
+
+void utils_batch::rotate(const Quaternion* quaternions, const Vector3f* in, Vector3f* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 q[4], result[3];
+        loadLanes(quaternions + i, q);
+
+        // clang-format off
+        Float4 v[3] = {Float4::set(in[i].getX(), in[i + 1].getX(), in[i + 2].getX(), in[i + 3].getX()),
+                       Float4::set(in[i].getY(), in[i + 1].getY(), in[i + 2].getY(), in[i + 3].getY()),
+                       Float4::set(in[i].getZ(), in[i + 1].getZ(), in[i + 2].getZ(), in[i + 3].getZ())};
+        // clang-format on
+        utils_kernels::rotateByQuaternion(q, v, result);
+
+        // Vector3f isn't aligned so write out each lane
+        alignas(utils_simd::ALIGNMENT) float values[3][4];
+        for (unsigned int component = 0; component < 3; ++component)
+            result[component].store(values[component]);
+        for (unsigned int lane = 0; lane < 4; ++lane)
+            out[i + lane] = Vector3f(values[0][lane], values[1][lane], values[2][lane]);
+    }
+    for (; i < count; ++i) {
+        float q[4], result[3];
+        toArray(quaternions[i], q);
+        float v[3] = {in[i].getX(), in[i].getY(), in[i].getZ()};
+        utils_kernels::rotateByQuaternion(q, v, result);
+        out[i] = Vector3f(result[0], result[1], result[2]);
+    }
+}
+
+void utils_batch::toMatrices(const Quaternion* in, Matrix4f* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Float4 q[4], result[4][4];
+        loadLanes(in + i, q);
+        utils_kernels::quaternionToMatrix(q, result);
+        storeLanes(result, out + i);
+    }
+    for (; i < count; ++i)
+        out[i] = in[i].toMatrix();
+}
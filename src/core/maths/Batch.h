@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Matrix.h"
+
+/*****************************************************************************
+ * utils_batch namespace - Functions that apply maths operations to large
+ *                         arrays of values at once
+ *****************************************************************************/
+
+// Strides are always given in floats (not bytes) and allow the data to be
+// part of an interleaved vertex buffer. In all cases 'in' and 'out' may point
+// to the same data to work in place.
+
+namespace utils_batch {
+    /* Transforms 3D points by a matrix (treating them as having w = 1) */
+    void transformPoints(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride = 3, size_t outStride = 3);
+
+    /* Transforms 2D points by a matrix (treating them as having z = 0 and
+       w = 1) */
+    void transformPoints2D(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride = 2, size_t outStride = 2);
+
+    /* Transforms 3D directions by a matrix (treating them as having w = 0),
+       normalising the results if requested */
+    void transformDirections(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride = 3, size_t outStride = 3, bool normalise = false);
+
+    /* Transforms normals by the inverse transpose of the upper 3x3 part of a
+       matrix (so they stay perpendicular to surfaces under non-uniform
+       scaling) and renormalises them */
+    void transformNormals(const Matrix4f& matrix, const float* in, float* out, size_t count, size_t inStride = 3, size_t outStride = 3);
+
+    /* Inverts matrices (as Matrix4f::inverse) */
+    void inverse(const Matrix4f* in, Matrix4f* out, size_t count);
+
+    /* Inverts affine matrices (as Matrix4f::inverseAffine) */
+    void inverseAffine(const Matrix4f* in, Matrix4f* out, size_t count);
+
+    /* Computes normal matrices (the inverse transpose of the upper 3x3 part)
+       of model matrices */
+    void normalMatrices(const Matrix4f* in, Matrix3f* out, size_t count);
+
+    /* Computes camera relative model view matrices for large worlds, where
+       float positions lose too much precision far from the origin. Each
+       object is placed at a double precision origin with a model matrix
+       relative to it, and the camera at a double precision position. The
+       offset of each origin from the camera is found in double precision
+       before converting to float, so the error only depends on the distance
+       from the camera and the world never needs shifting back to the origin.
+       The translation of the view matrix is ignored (only its rotation is
+       used), so it can be built with the camera at the origin (e.g.
+       initLookAt(Vector3f(0.0f), forward, up)) */
+    void cameraRelativeModelViews(const Matrix4f& view, const Vector3d& cameraPosition, const Vector3d* origins, const Matrix4f* models, Matrix4f* out, size_t count);
+
+    // The quaternion functions below expect unit quaternions
+
+    /* Normalised linear interpolation between pairs of quaternions (taking
+       the shortest path) using either a single factor or one per pair. The
+       path is the same as Quaternion::slerp but the speed along it isn't
+       constant - measured against it the result is off by at most 0.04
+       degrees for rotations up to 30 degrees apart, 0.93 degrees at 90 and
+       8.16 degrees as they approach 180 (the exact maxima of nlerp are
+       0.0331, 0.919 and 8.149 degrees, the rest allows for rounding) */
+    void nlerp(const Quaternion* in1, const Quaternion* in2, float factor, Quaternion* out, size_t count);
+    void nlerp(const Quaternion* in1, const Quaternion* in2, const float* factors, Quaternion* out, size_t count);
+
+    /* Approximation of Quaternion::slerp for pairs of quaternions using
+       either a single factor or one per pair. This corrects the factor given
+       to nlerp - measured against Quaternion::slerp the result is off by at
+       most 0.005 degrees for rotations up to 120 degrees apart and 0.05
+       degrees at any angle (the exact maxima of the correction are 0.0044
+       and 0.0445 degrees, the rest allows for rounding) while being around
+       6x faster */
+    void slerp(const Quaternion* in1, const Quaternion* in2, float factor, Quaternion* out, size_t count);
+    void slerp(const Quaternion* in1, const Quaternion* in2, const float* factors, Quaternion* out, size_t count);
+
+    /* Rotates each vector by the corresponding quaternion (as
+       Quaternion::rotate) */
+    void rotate(const Quaternion* quaternions, const Vector3f* in, Vector3f* out, size_t count);
+
+    /* Converts quaternions into rotation matrices (as Quaternion::toMatrix) */
+    void toMatrices(const Quaternion* in, Matrix4f* out, size_t count);
+}  // namespace utils_batch
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "SIMD.h"
+
+/*****************************************************************************
+ * utils_kernels namespace - Maths routines written once in terms of a value
+ *                           type V, so they can run on a single float or on
+ *                           four independent problems at once using
+ *                           utils_simd::Float4
+ *****************************************************************************/
+
+// Matrices are given as arrays indexed [col][row] to match Matrix
+
+namespace utils_kernels {
+    /* Returns a value of type V with every element set to the given value */
+    template <typename V>
+    inline V constant(float value);
+
+    template <>
+    inline float constant<float>(float value) { return value; }
+
+    template <>
+    inline utils_simd::Float4 constant<utils_simd::Float4>(float value) { return utils_simd::Float4::set1(value); }
+
+    /* Absolute value (utils_simd::abs is found for Float4 by argument
+       dependent lookup) */
+    inline float abs(float value) { return fabsf(value); }
+
+    /* Returns -1 where value is negative and 1 otherwise */
+    inline float signOf(float value) { return value < 0.0f ? -1.0f : 1.0f; }
+    inline utils_simd::Float4 signOf(const utils_simd::Float4& value) {
+        return utils_simd::select(utils_simd::lessThan(value, utils_simd::Float4::set1(0.0f)), utils_simd::Float4::set1(-1.0f), utils_simd::Float4::set1(1.0f));
+    }
+
+    /* Returns 1 / sqrt(value) (the SIMD version is a refined estimate with a
+       relative error of around 1e-7) */
+    inline float reciprocalSqrt(float value) { return 1.0f / sqrtf(value); }
+    inline utils_simd::Float4 reciprocalSqrt(const utils_simd::Float4& value) { return utils_simd::rsqrt(value); }
+
+    /* Returns 1 / value, or 0 where value is 0 (to match the behaviour of
+       Matrix3f::inverse for singular matrices) */
+    inline float safeReciprocal(float value) { return value != 0.0f ? 1.0f / value : 0.0f; }
+
+    inline utils_simd::Float4 safeReciprocal(const utils_simd::Float4& value) {
+        utils_simd::Float4 zero = utils_simd::Float4::set1(0.0f);
+        utils_simd::Float4 one  = utils_simd::Float4::set1(1.0f);
+        return utils_simd::select(utils_simd::greaterThan(utils_simd::abs(value), zero), one / value, zero);
+    }
+
+    /* Computes the inverse of a 3x3 matrix using its matrix of cofactors */
+    template <typename V>
+    inline void inverse3x3(const V (&m)[3][3], V (&out)[3][3]) {
+        // clang-format off
+        V a = m[0][0]; V b = m[1][0]; V c = m[2][0];
+        V d = m[0][1]; V e = m[1][1]; V f = m[2][1];
+        V g = m[0][2]; V h = m[1][2]; V i = m[2][2];
+        // clang-format on
+
+        V A = (e * i - f * h);
+        V B = (f * g - d * i);
+        V C = (d * h - e * g);
+        V D = (h * c - i * b);
+        V E = (i * a - g * c);
+        V F = (g * b - h * a);
+        V G = (b * f - c * e);
+        V H = (c * d - a * f);
+        V I = (a * e - b * d);
+
+        V invDet = safeReciprocal(a * A + b * B + c * C);
+
+        // clang-format off
+        out[0][0] = invDet * A; out[1][0] = invDet * D; out[2][0] = invDet * G;
+        out[0][1] = invDet * B; out[1][1] = invDet * E; out[2][1] = invDet * H;
+        out[0][2] = invDet * C; out[1][2] = invDet * F; out[2][2] = invDet * I;
+        // clang-format on
+    }
+
+    /* Computes the inverse of a general 4x4 matrix by expanding it in terms
+       of its 2x2 sub-determinants (shared between the cofactors) */
+    template <typename V>
+    inline void inverse4x4(const V (&m)[4][4], V (&out)[4][4]) {
+        // Assign each value a name by its row and column
+        // clang-format off
+        V a00 = m[0][0]; V a01 = m[1][0]; V a02 = m[2][0]; V a03 = m[3][0];
+        V a10 = m[0][1]; V a11 = m[1][1]; V a12 = m[2][1]; V a13 = m[3][1];
+        V a20 = m[0][2]; V a21 = m[1][2]; V a22 = m[2][2]; V a23 = m[3][2];
+        V a30 = m[0][3]; V a31 = m[1][3]; V a32 = m[2][3]; V a33 = m[3][3];
+        // clang-format on
+
+        // Sub-determinants of the top two rows
+        V s0 = a00 * a11 - a10 * a01;
+        V s1 = a00 * a12 - a10 * a02;
+        V s2 = a00 * a13 - a10 * a03;
+        V s3 = a01 * a12 - a11 * a02;
+        V s4 = a01 * a13 - a11 * a03;
+        V s5 = a02 * a13 - a12 * a03;
+
+        // Sub-determinants of the bottom two rows
+        V c5 = a22 * a33 - a32 * a23;
+        V c4 = a21 * a33 - a31 * a23;
+        V c3 = a21 * a32 - a31 * a22;
+        V c2 = a20 * a33 - a30 * a23;
+        V c1 = a20 * a32 - a30 * a22;
+        V c0 = a20 * a31 - a30 * a21;
+
+        V invDet = safeReciprocal(s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+        // Assign the transpose of the matrix of cofactors divided by the
+        // determinant
+        out[0][0] = (a11 * c5 - a12 * c4 + a13 * c3) * invDet;
+        out[1][0] = (a02 * c4 - a01 * c5 - a03 * c3) * invDet;
+        out[2][0] = (a31 * s5 - a32 * s4 + a33 * s3) * invDet;
+        out[3][0] = (a22 * s4 - a21 * s5 - a23 * s3) * invDet;
+
+        out[0][1] = (a12 * c2 - a10 * c5 - a13 * c1) * invDet;
+        out[1][1] = (a00 * c5 - a02 * c2 + a03 * c1) * invDet;
+        out[2][1] = (a32 * s2 - a30 * s5 - a33 * s1) * invDet;
+        out[3][1] = (a20 * s5 - a22 * s2 + a23 * s1) * invDet;
+
+        out[0][2] = (a10 * c4 - a11 * c2 + a13 * c0) * invDet;
+        out[1][2] = (a01 * c2 - a00 * c4 - a03 * c0) * invDet;
+        out[2][2] = (a30 * s4 - a31 * s2 + a33 * s0) * invDet;
+        out[3][2] = (a21 * s2 - a20 * s4 - a23 * s0) * invDet;
+
+        out[0][3] = (a11 * c1 - a10 * c3 - a12 * c0) * invDet;
+        out[1][3] = (a00 * c3 - a01 * c1 + a02 * c0) * invDet;
+        out[2][3] = (a31 * s1 - a30 * s3 - a32 * s0) * invDet;
+        out[3][3] = (a20 * s3 - a21 * s1 + a22 * s0) * invDet;
+    }
+
+    /* Computes the inverse of an affine 4x4 matrix (one whose bottom row is
+       (0, 0, 0, 1) e.g. any combination of rotation, translation and
+       scale) - only requires inverting the upper 3x3 part */
+    template <typename V>
+    inline void inverseAffine(const V (&m)[4][4], V (&out)[4][4], const V& zero, const V& one) {
+        // clang-format off
+        V upper[3][3] = {{m[0][0], m[0][1], m[0][2]},
+                         {m[1][0], m[1][1], m[1][2]},
+                         {m[2][0], m[2][1], m[2][2]}};
+        // clang-format on
+        V upperInverse[3][3];
+        inverse3x3(upper, upperInverse);
+
+        for (unsigned int col = 0; col < 3; ++col) {
+            for (unsigned int row = 0; row < 3; ++row)
+                out[col][row] = upperInverse[col][row];
+            out[col][3] = zero;
+        }
+
+        // Translation is the negated translation transformed by the inverse
+        for (unsigned int row = 0; row < 3; ++row)
+            out[3][row] = zero - (upperInverse[0][row] * m[3][0] + upperInverse[1][row] * m[3][1] + upperInverse[2][row] * m[3][2]);
+        out[3][3] = one;
+    }
+
+    // Quaternions are given as arrays of x, y, z and w
+
+    /* Normalised linear interpolation between two unit quaternions (flipping
+       the second when needed to take the shortest path) */
+    template <typename V>
+    inline void nlerpQuaternion(const V (&a)[4], const V (&b)[4], const V& factor, V (&out)[4]) {
+        V dot     = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        V factorA = constant<V>(1.0f) - factor;
+        V factorB = factor * signOf(dot);
+
+        V result[4];
+        for (unsigned int i = 0; i < 4; ++i)
+            result[i] = a[i] * factorA + b[i] * factorB;
+
+        V scale = reciprocalSqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2] + result[3] * result[3]);
+        for (unsigned int i = 0; i < 4; ++i)
+            out[i] = result[i] * scale;
+    }
+
+    /* Approximates spherical linear interpolation between two unit
+       quaternions by adjusting the factor given to nlerpQuaternion so the
+       angle changes at a near constant rate (see
+       https://zeux.io/2015/07/23/approximating-slerp/) */
+    template <typename V>
+    inline void slerpQuaternion(const V (&a)[4], const V (&b)[4], const V& factor, V (&out)[4]) {
+        // Cosine of the angle between them
+        V d = abs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+
+        // Fitted polynomials for the amount of correction needed
+        V k1 = constant<V>(1.0904f) + d * (constant<V>(-3.2452f) + d * (constant<V>(3.55645f) - d * constant<V>(1.43519f)));
+        V k2 = constant<V>(0.848013f) + d * (constant<V>(-1.06021f) + d * constant<V>(0.215638f));
+
+        V offset = factor - constant<V>(0.5f);
+        V k      = k1 * offset * offset + k2;
+        V t      = factor + factor * offset * (factor - constant<V>(1.0f)) * k;
+
+        nlerpQuaternion(a, b, t, out);
+    }
+
+    /* Rotates a vector by a quaternion (as Quaternion::rotate) */
+    template <typename V>
+    inline void rotateByQuaternion(const V (&q)[4], const V (&v)[3], V (&out)[3]) {
+        V uDotV = q[0] * v[0] + q[1] * v[1] + q[2] * v[2];
+        V uDotU = q[0] * q[0] + q[1] * q[1] + q[2] * q[2];
+        V a     = constant<V>(2.0f) * uDotV;
+        V b     = q[3] * q[3] - uDotU;
+        V c     = constant<V>(2.0f) * q[3];
+
+        V cross[3] = {q[1] * v[2] - q[2] * v[1],
+                      q[2] * v[0] - q[0] * v[2],
+                      q[0] * v[1] - q[1] * v[0]};
+
+        for (unsigned int i = 0; i < 3; ++i)
+            out[i] = q[i] * a + v[i] * b + cross[i] * c;
+    }
+
+    /* Converts a unit quaternion into a rotation matrix (as
+       Quaternion::toMatrix) */
+    template <typename V>
+    inline void quaternionToMatrix(const V (&q)[4], V (&out)[4][4]) {
+        V two  = constant<V>(2.0f);
+        V one  = constant<V>(1.0f);
+        V zero = constant<V>(0.0f);
+
+        V ii = q[0] * q[0];
+        V ij = q[0] * q[1];
+        V ik = q[0] * q[2];
+        V ir = q[0] * q[3];
+        V jj = q[1] * q[1];
+        V jk = q[1] * q[2];
+        V jr = q[1] * q[3];
+        V kk = q[2] * q[2];
+        V kr = q[2] * q[3];
+
+        // clang-format off
+        out[0][0] = one - two * (jj + kk); out[1][0] = two * (ij - kr);       out[2][0] = two * (ik + jr);       out[3][0] = zero;
+        out[0][1] = two * (ij + kr);       out[1][1] = one - two * (ii + kk); out[2][1] = two * (jk - ir);       out[3][1] = zero;
+        out[0][2] = two * (ik - jr);       out[1][2] = two * (jk + ir);       out[2][2] = one - two * (ii + jj); out[3][2] = zero;
+        out[0][3] = zero;                  out[1][3] = zero;                  out[2][3] = zero;                  out[3][3] = one;
+        // clang-format on
+    }
+}  // namespace utils_kernels
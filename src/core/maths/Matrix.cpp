@@ -1,48 +1,14 @@
 #include "Matrix.h"
 
+#include "Kernels.h"
+
 /*****************************************************************************
  * Matrix3f
  *****************************************************************************/
 
 Matrix3f Matrix3f::inverse() const {
     Matrix3f result;
-
-    // Assign each value letters to make the calculation easier to follow
-    // clang-format off
-	float a = get(0, 0); float b = get(0, 1); float c = get(0, 2);
-	float d = get(1, 0); float e = get(1, 1); float f = get(1, 2);
-	float g = get(2, 0); float h = get(2, 1); float i = get(2, 2);
-    // clang-format on
-
-    // Now calculate the matrix of cofactors, using capital letters in the
-    // same order as the lower case ones
-    float A = (e * i - f * h);
-    float B = (f * g - d * i);
-    float C = (d * h - e * g);
-    float D = (h * c - i * b);
-    float E = (i * a - g * c);
-    float F = (g * b - h * a);
-    float G = (b * f - c * e);
-    float H = (c * d - a * f);
-    float I = (a * e - b * d);
-
-    // From this, the inverse of the determinant is calculated so it
-    // can be multiplied by the transpose of the matrix of cofactors
-    // to get the inverse
-    float det = (a * A + b * B + c * C);
-
-    // Prevent a divide by 0
-    if (det != 0.0f) {
-        float invDet = 1.0f / (a * A + b * B + c * C);
-
-        // Finally assign the result
-        // clang-format off
-		result.set(0, 0, invDet * A); result.set(0, 1, invDet * D); result.set(0, 2, invDet * G);
-		result.set(1, 0, invDet * B); result.set(1, 1, invDet * E); result.set(1, 2, invDet * H);
-		result.set(2, 0, invDet * C); result.set(2, 1, invDet * F); result.set(2, 2, invDet * I);
-        // clang-format on
-    }
-
+    utils_kernels::inverse3x3(values, result.values);
     return result;
 }
 
@@ -50,6 +16,18 @@ Matrix3f Matrix3f::inverse() const {
  * Matrix4f
  *****************************************************************************/
 
+Matrix4f Matrix4f::inverse() const {
+    Matrix4f result;
+    utils_kernels::inverse4x4(values, result.values);
+    return result;
+}
+
+Matrix4f Matrix4f::inverseAffine() const {
+    Matrix4f result;
+    utils_kernels::inverseAffine(values, result.values, 0.0f, 1.0f);
+    return result;
+}
+
 const Matrix4f& Matrix4f::initFromVectors(const Vector3f& forward, const Vector3f& up, const Vector3f& right) {
     // clang-format off
 	set(0, 0, right.getX());   set(0, 1, right.getY());    set(0, 2, right.getZ());   set(0, 3, 0);
@@ -74,7 +52,9 @@ const Matrix4f& Matrix4f::initOrthographic(float left, float right, float bottom
 }
 
 const Matrix4f& Matrix4f::initPerspective(float fovY, float aspect, float zNear, float zFar) {
-    float scale = tanf(utils_maths::toRadians(fovY / 2));
+    float sine, cosine;
+    utils_maths::sincos(utils_maths::toRadians(fovY / 2), sine, cosine);
+    float scale = sine / cosine;
 
     // Using Vulkan depth values are between 0 and 1 (Unlike OpenGL which is -1 to 1)
     // clang-format off
@@ -128,8 +108,8 @@ const Matrix4f& Matrix4f::initTranslation(const Vector3f& translation) {
 }
 
 const Matrix4f& Matrix4f::initRotation(float angle, bool x, bool y, bool z) {
-    float c = cosf(utils_maths::toRadians(angle));
-    float s = sinf(utils_maths::toRadians(angle));
+    float s, c;
+    utils_maths::sincos(utils_maths::toRadians(angle), s, c);
 
     // clang-format off
 	if (x) {
@@ -172,5 +152,37 @@ const Matrix4f& Matrix4f::initScale(const Vector3f& scale) {
 	set(3, 0, 0);            set(3, 1, 0);            set(3, 2, 0);            set(3, 3, 1);
     // clang-format on
 
+    return *this;
+}
+
+const Matrix4f& Matrix4f::initTransform(const Vector3f& translation, const Quaternion& rotation, const Vector3f& scale) {
+    // Rotation part is the same as Quaternion::toMatrix, with each column
+    // multiplied by the corresponding scale
+    float x = rotation.getX();
+    float y = rotation.getY();
+    float z = rotation.getZ();
+    float w = rotation.getW();
+
+    float xx = x * x;
+    float xy = x * y;
+    float xz = x * z;
+    float xw = x * w;
+    float yy = y * y;
+    float yz = y * z;
+    float yw = y * w;
+    float zz = z * z;
+    float zw = z * w;
+
+    float sx = scale.getX();
+    float sy = scale.getY();
+    float sz = scale.getZ();
+
+    // clang-format off
+	set(0, 0, (1 - 2 * (yy + zz)) * sx); set(0, 1, 2 * (xy - zw) * sy);       set(0, 2, 2 * (xz + yw) * sz);       set(0, 3, translation.getX());
+	set(1, 0, 2 * (xy + zw) * sx);       set(1, 1, (1 - 2 * (xx + zz)) * sy); set(1, 2, 2 * (yz - xw) * sz);       set(1, 3, translation.getY());
+	set(2, 0, 2 * (xz - yw) * sx);       set(2, 1, 2 * (yz + xw) * sy);       set(2, 2, (1 - 2 * (xx + yy)) * sz); set(2, 3, translation.getZ());
+	set(3, 0, 0);                        set(3, 1, 0);                        set(3, 2, 0);                        set(3, 3, 1);
+    // clang-format on
+
     return *this;
 }
\ No newline at end of file
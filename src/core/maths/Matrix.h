@@ -1,8 +1,7 @@
 #pragma once
 
-#include <initializer_list>
-
 #include "Quaternion.h"
+#include "SIMD.h"
 #include "Vector.h"
 
 /*****************************************************************************
@@ -13,34 +12,41 @@
 template <typename T, unsigned int N>
 class Matrix {
 protected:
-    /* Always initialise member variables */
-    T values[N][N]{};
+    /* Always initialise member variables (4x4 float matrices are aligned so
+       their columns can be loaded straight into SIMD registers) */
+    alignas(utils_simd::alignmentFor<T, N>()) T values[N][N]{};
+
+    /* Assigns the values of a column */
+    inline constexpr void setColumn(unsigned int col, const T (&values)[N]) {
+        for (unsigned int row = 0; row < N; ++row)
+            this->values[col][row] = values[row];
+    }
 
 public:
     /* Constructor */
-    Matrix() {}
-
-    /* Constructor taking an initial value (specefied in column major order) */
-    Matrix(const std::initializer_list<std::initializer_list<T>>& values) {
-        // Ensure correct size
-        if (values.size() != N)
-            throw std::invalid_argument("Incorrect number of elements");
-        // Go through columns and copy
-        unsigned int colIdx = 0;
-        for (auto& col : values)
-            std::copy(col.begin(), col.end(), this->values[colIdx++]);
+    constexpr Matrix() {}
+
+    /* Constructor taking an initial value (specefied in column major order -
+       the size is checked at compile time) */
+    constexpr Matrix(const T (&values)[N][N]) {
+        for (unsigned int col = 0; col < N; ++col)
+            setColumn(col, values[col]);
     }
 
-    /* Operations for obtaining/assigning values */
-    inline T& operator[](unsigned int col) { return this->values[col]; }
-    inline const T& operator[](unsigned int col) const { return this->values[col]; }
+    /* Operations for obtaining/assigning the values of a column */
+    inline constexpr T* operator[](unsigned int col) { return this->values[col]; }
+    inline constexpr const T* operator[](unsigned int col) const { return this->values[col]; }
+
+    /* Returns a pointer to the values (in column major order) */
+    inline T* data() { return &values[0][0]; }
+    inline const T* data() const { return &values[0][0]; }
 
     /* Get and set functions allow row major access */
-    inline void set(unsigned int row, unsigned int col, const T& value) { values[col][row] = value; }
-    inline const T get(unsigned int row, unsigned int col) const { return values[col][row]; }
+    inline constexpr void set(unsigned int row, unsigned int col, const T& value) { values[col][row] = value; }
+    inline constexpr T get(unsigned int row, unsigned int col) const { return values[col][row]; }
 
     /* Adds another matrix to this one and returns the result */
-    inline Matrix<T, N> operator+(const Matrix<T, N>& other) const {
+    inline constexpr Matrix<T, N> operator+(const Matrix<T, N>& other) const {
         Matrix<T, N> result;
         for (unsigned int col = 0; col < N; ++col)
             for (unsigned int row = 0; row < N; ++row)
@@ -49,7 +55,7 @@ public:
     }
 
     /* Subtracts a matrix from this one and returns the result */
-    inline Matrix<T, N> operator-(const Matrix<T, N>& other) const {
+    inline constexpr Matrix<T, N> operator-(const Matrix<T, N>& other) const {
         Matrix<T, N> result;
         for (unsigned int col = 0; col < N; ++col)
             for (unsigned int row = 0; row < N; ++row)
@@ -58,7 +64,7 @@ public:
     }
 
     /* Returns the result of element-wise multiplication by a scalar  */
-    inline Matrix<T, N> operator*(const T& value) const {
+    inline constexpr Matrix<T, N> operator*(const T& value) const {
         Matrix<T, N> result;
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
@@ -68,7 +74,7 @@ public:
     }
 
     /* Returns the result of element-wise division by a scalar  */
-    inline Matrix<T, N> operator/(const T& value) const {
+    inline constexpr Matrix<T, N> operator/(const T& value) const {
         Matrix<T, N> result;
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
@@ -78,7 +84,7 @@ public:
     }
 
     /* Adds another matrix to this one and returns the result */
-    inline Matrix<T, N>& operator+=(const Matrix<T, N>& other) {
+    inline constexpr Matrix<T, N>& operator+=(const Matrix<T, N>& other) {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
                 set(row, col, get(row, col) + other.get(row, col));
@@ -87,7 +93,7 @@ public:
     }
 
     /* Subtracts a matrix from this one and returns the result */
-    inline Matrix<T, N>& operator-=(const Matrix<T, N>& other) {
+    inline constexpr Matrix<T, N>& operator-=(const Matrix<T, N>& other) {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
                 set(row, col, get(row, col) - other.get(row, col));
@@ -96,7 +102,7 @@ public:
     }
 
     /* Element-wise multiplication by a scalar  */
-    inline Matrix<T, N>& operator*=(const T& value) {
+    inline constexpr Matrix<T, N>& operator*=(const T& value) {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
                 set(row, col, get(row, col) * value);
@@ -105,7 +111,7 @@ public:
     }
 
     /* Element-wise division by a scalar  */
-    inline Matrix<T, N>& operator/=(const T& value) {
+    inline constexpr Matrix<T, N>& operator/=(const T& value) {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
                 set(row, col, get(row, col) / value);
@@ -114,29 +120,50 @@ public:
     }
 
     /* Returns the result of multiplying this matrix by a vector */
-    inline Vector<T, N> operator*(const Vector<T, N>& other) const {
+    inline constexpr Vector<T, N> operator*(const Vector<T, N>& other) const {
         Vector<T, N> result;
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                utils_simd::multiplyMatrix4Vector4(&values[0][0], &other[0], &result[0]);
+                return result;
+            }
+        }
         for (unsigned int row = 0; row < N; ++row) {
             for (unsigned int col = 0; col < N; ++col)
-                result[row] += other[col] * get(row, col);
+                result[row] += other[col] * values[col][row];
         }
         return result;
     }
 
     /* Returns the result of multiplying this matrix by another */
-    inline Matrix<T, N> operator*(const Matrix<T, N>& other) const {
+    inline constexpr Matrix<T, N> operator*(const Matrix<T, N>& other) const {
         Matrix<T, N> result;
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                utils_simd::multiplyMatrix4(&values[0][0], &other.values[0][0], &result.values[0][0]);
+                return result;
+            }
+        }
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row) {
+                T total = 0;
                 for (unsigned int i = 0; i < N; ++i)
-                    result.set(row, col, result.get(row, col) + (get(row, i) * other.get(i, col)));
+                    total += values[i][row] * other.values[col][i];
+                result.values[col][row] = total;
             }
         }
         return result;
     }
 
     /* Multiplies this matrix by another */
-    inline Matrix<T, N>& operator*=(const Matrix<T, N>& other) {
+    inline constexpr Matrix<T, N>& operator*=(const Matrix<T, N>& other) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                // Kernel allows the output to alias either input
+                utils_simd::multiplyMatrix4(&values[0][0], &other.values[0][0], &values[0][0]);
+                return *this;
+            }
+        }
         Matrix<T, N> result = (*this) * other;
 
         for (unsigned int col = 0; col < N; ++col) {
@@ -148,7 +175,7 @@ public:
 
     /* Compares this vector to another one and returns whether they are equal
        or not */
-    inline bool operator==(const Matrix<T, N>& other) const {
+    inline constexpr bool operator==(const Matrix<T, N>& other) const {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row) {
                 if (other.get(row, col) != get(row, col))
@@ -159,8 +186,14 @@ public:
     }
 
     /* Returns the transpose of this matrix */
-    inline Matrix<T, N> transpose() const {
+    inline constexpr Matrix<T, N> transpose() const {
         Matrix<T, N> result;
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                utils_simd::transposeMatrix4(&values[0][0], &result.values[0][0]);
+                return result;
+            }
+        }
         // Flip rows and columns
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row)
@@ -170,7 +203,7 @@ public:
     }
 
     /* Makes this matrix the identity */
-    inline void setIdentity() {
+    inline constexpr void setIdentity() {
         for (unsigned int col = 0; col < N; ++col) {
             for (unsigned int row = 0; row < N; ++row) {
                 if (col == row)
@@ -182,7 +215,7 @@ public:
     }
 
     /* Intialises the identity and returns itself */
-    inline Matrix<T, N>& initIdentity() {
+    inline constexpr Matrix<T, N>& initIdentity() {
         setIdentity();
         return *this;
     }
@@ -203,10 +236,10 @@ public:
     }
 
     /* Returns the number of elements in this matrix */
-    inline int getNumElements() { return N * N; }
+    inline constexpr int getNumElements() const { return N * N; }
 
     /* Returns the size of this matrix in bytes */
-    inline int getSize() { return N * N * sizeof(T); }
+    inline constexpr int getSize() const { return N * N * sizeof(T); }
 };
 
 /*****************************************************************************
@@ -218,9 +251,12 @@ template <typename T>
 class Matrix2 : public Matrix<T, 2> {
 public:
     /* Various constructors */
-    Matrix2() {}
-    Matrix2(const std::initializer_list<std::initializer_list<T>>& values) : Matrix<T, 2>(values) {}
-    Matrix2(const Matrix<T, 2>& base) : Matrix<T, 2>(base) {}
+    constexpr Matrix2() {}
+    constexpr Matrix2(const T (&col0)[2], const T (&col1)[2]) {
+        this->setColumn(0, col0);
+        this->setColumn(1, col1);
+    }
+    constexpr Matrix2(const Matrix<T, 2>& base) : Matrix<T, 2>(base) {}
 };
 
 /* 3x3 matrix */
@@ -228,9 +264,13 @@ template <typename T>
 class Matrix3 : public Matrix<T, 3> {
 public:
     /* Various constructors */
-    Matrix3() {}
-    Matrix3(const std::initializer_list<std::initializer_list<T>>& values) : Matrix<T, 3>(values) {}
-    Matrix3(const Matrix<T, 3>& base) : Matrix<T, 3>(base) {}
+    constexpr Matrix3() {}
+    constexpr Matrix3(const T (&col0)[3], const T (&col1)[3], const T (&col2)[3]) {
+        this->setColumn(0, col0);
+        this->setColumn(1, col1);
+        this->setColumn(2, col2);
+    }
+    constexpr Matrix3(const Matrix<T, 3>& base) : Matrix<T, 3>(base) {}
 };
 
 /* 4x4 matrix */
@@ -238,12 +278,17 @@ template <typename T>
 class Matrix4 : public Matrix<T, 4> {
 public:
     /* Various constructors */
-    Matrix4() {}
-    Matrix4(const std::initializer_list<std::initializer_list<T>>& values) : Matrix<T, 4>(values) {}
-    Matrix4(const Matrix<T, 4>& base) : Matrix<T, 4>(base) {}
+    constexpr Matrix4() {}
+    constexpr Matrix4(const T (&col0)[4], const T (&col1)[4], const T (&col2)[4], const T (&col3)[4]) {
+        this->setColumn(0, col0);
+        this->setColumn(1, col1);
+        this->setColumn(2, col2);
+        this->setColumn(3, col3);
+    }
+    constexpr Matrix4(const Matrix<T, 4>& base) : Matrix<T, 4>(base) {}
 
     /* Converts to a 3x3 matrix (Ignores extra values) */
-    inline Matrix3<T> to3x3() {
+    inline constexpr Matrix3<T> to3x3() const {
         Matrix3<T> matrix;
 
         // clang-format off
@@ -268,11 +313,11 @@ using Matrix3i = Matrix3<int>;
 class Matrix3f : public Matrix3<float> {
 public:
     /* Various constructors */
-    Matrix3f() {}
-    Matrix3f(const std::initializer_list<std::initializer_list<float>>& values) : Matrix3<float>(values) {}
+    constexpr Matrix3f() {}
+    constexpr Matrix3f(const float (&col0)[3], const float (&col1)[3], const float (&col2)[3]) : Matrix3<float>(col0, col1, col2) {}
 
-    Matrix3f(const Matrix3<float>& base) : Matrix3<float>(base) {}
-    Matrix3f(const Matrix<float, 3>& base) : Matrix3<float>(base) {}
+    constexpr Matrix3f(const Matrix3<float>& base) : Matrix3<float>(base) {}
+    constexpr Matrix3f(const Matrix<float, 3>& base) : Matrix3<float>(base) {}
 
     /* Inverts this matrix - if singular returned matrix will be a matrix of zeros */
     Matrix3f inverse() const;
@@ -284,11 +329,19 @@ using Matrix4i = Matrix4<int>;
 class Matrix4f : public Matrix4<float> {
 public:
     /* Various constructors */
-    Matrix4f() {}
-    Matrix4f(const std::initializer_list<std::initializer_list<float>>& values) : Matrix4<float>(values) {}
+    constexpr Matrix4f() {}
+    constexpr Matrix4f(const float (&col0)[4], const float (&col1)[4], const float (&col2)[4], const float (&col3)[4]) : Matrix4<float>(col0, col1, col2, col3) {}
+
+    constexpr Matrix4f(const Matrix4<float>& base) : Matrix4<float>(base) {}
+    constexpr Matrix4f(const Matrix<float, 4>& base) : Matrix4<float>(base) {}
 
-    Matrix4f(const Matrix4<float>& base) : Matrix4<float>(base) {}
-    Matrix4f(const Matrix<float, 4>& base) : Matrix4<float>(base) {}
+    /* Inverts this matrix - if singular returned matrix will be a matrix of zeros */
+    Matrix4f inverse() const;
+
+    /* Inverts this matrix assuming it is affine i.e. its bottom row is
+       (0, 0, 0, 1) (true for any combination of translation, rotation and
+       scale) - much cheaper than inverse() */
+    Matrix4f inverseAffine() const;
 
     /* Initialises this matrix from 3 axis vectors */
     const Matrix4f& initFromVectors(const Vector3f& forward, const Vector3f& up, const Vector3f& right);
@@ -313,6 +366,11 @@ public:
     const Matrix4f& initScale(const Vector2f& scale);
     const Matrix4f& initScale(const Vector3f& scale);
 
+    /* Initialises this matrix as a translation, rotation and scale (the same
+       as multiplying the separate matrices in that order, but computed
+       directly) */
+    const Matrix4f& initTransform(const Vector3f& translation, const Quaternion& rotation, const Vector3f& scale);
+
     /* Translates this matrix */
     inline void translate(const Vector2f& translation) { (*this) *= Matrix4f().initTranslation(translation); }
     inline void translate(const Vector3f& translation) { (*this) *= Matrix4f().initTranslation(translation); }
@@ -0,0 +1,254 @@
+#include "Packing.h"
+
+#include "SIMD.h"
+
+using utils_simd::Float4;
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+#ifdef UE_SIMD_SSE
+
+/* Selects lanes from a where the mask is set, and from b otherwise */
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+/* Converts 4 floats to half precision (in the low 16 bits of each lane) -
+   the same as the scalar version, but evaluating every case and selecting
+   the right one */
+static inline __m128i toHalf4(__m128 value) {
+    __m128i bits = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+    bits         = _mm_xor_si128(bits, sign);
+
+    // With the sign removed, signed comparisons are fine
+    __m128i overflow = _mm_cmpgt_epi32(bits, _mm_set1_epi32((143 << 23) - 1));
+    __m128i nan      = _mm_cmpgt_epi32(bits, _mm_set1_epi32(255 << 23));
+    __m128i denormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), bits);
+
+    __m128i special        = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(nan, _mm_set1_epi32(0x0200)));
+    __m128 magic           = _mm_castsi128_ps(_mm_set1_epi32(126 << 23));
+    __m128i denormalResult = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), magic)), _mm_castps_si128(magic));
+    __m128i odd            = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+    __m128i normalResult   = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(0xC8000FFFu))), odd), 13);
+
+    __m128i result = select(overflow, special, select(denormal, denormalResult, normalResult));
+    return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+}
+
+/* Converts 4 half precision floats (in the low 16 bits of each lane) to
+   floats */
+static inline __m128 fromHalf4(__m128i value) {
+    const __m128i exponentMask = _mm_set1_epi32(0x7C00 << 13);
+
+    __m128i bits     = _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x7FFF)), 13);
+    __m128i exponent = _mm_and_si128(bits, exponentMask);
+    bits             = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+    __m128i special  = _mm_cmpeq_epi32(exponent, exponentMask);
+    __m128i denormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+
+    bits                   = _mm_add_epi32(bits, _mm_and_si128(special, _mm_set1_epi32((128 - 16) << 23)));
+    __m128 denormalResult  = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+    bits                   = select(denormal, _mm_castps_si128(denormalResult), bits);
+    return _mm_castsi128_ps(_mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x8000)), 16)));
+}
+
+/* Converts 4 floats to signed normalised integers (in 32 bit lanes) */
+static inline __m128i toSnorm4(__m128 value) {
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)), _mm_set1_ps(32767.0f)));
+}
+
+/* Converts 4 signed normalised integers (in 32 bit lanes) to floats */
+static inline __m128 fromSnorm4(__m128i value) {
+    return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(value), _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+}
+
+/* Converts 4 floats to unsigned normalised integers (in 32 bit lanes) */
+static inline __m128i toUnorm4(__m128 value) {
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f)));
+}
+
+/* Sign extends the lower and upper 4 16 bit values to 32 bits */
+static inline __m128i extendLow16(__m128i value) { return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16); }
+static inline __m128i extendHigh16(__m128i value) { return _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16); }
+
+#endif
+
+/*****************************************************************************
+ * utils_packing
+ *****************************************************************************/
+
+void utils_packing::toHalf(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+#if defined(UE_SIMD_F16C)
+    for (; i + 4 <= count; i += 4)
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(UE_SIMD_SSE)
+    for (; i + 8 <= count; i += 8) {
+        // Sign extending makes the saturating pack leave the values alone
+        __m128i low  = _mm_srai_epi32(_mm_slli_epi32(toHalf4(_mm_loadu_ps(in + i)), 16), 16);
+        __m128i high = _mm_srai_epi32(_mm_slli_epi32(toHalf4(_mm_loadu_ps(in + i + 4)), 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = toHalf(in[i]);
+}
+
+void utils_packing::fromHalf(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#if defined(UE_SIMD_F16C)
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))));
+#elif defined(UE_SIMD_SSE)
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_ps(out + i, fromHalf4(_mm_unpacklo_epi16(values, _mm_setzero_si128())));
+        _mm_storeu_ps(out + i + 4, fromHalf4(_mm_unpackhi_epi16(values, _mm_setzero_si128())));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = fromHalf(in[i]);
+}
+
+void utils_packing::toSnorm16(const float* in, int16_t* out, size_t count) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(toSnorm4(_mm_loadu_ps(in + i)), toSnorm4(_mm_loadu_ps(in + i + 4))));
+#endif
+    for (; i < count; ++i)
+        out[i] = toSnorm16(in[i]);
+}
+
+void utils_packing::fromSnorm16(const int16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_ps(out + i, fromSnorm4(extendLow16(values)));
+        _mm_storeu_ps(out + i + 4, fromSnorm4(extendHigh16(values)));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = fromSnorm16(in[i]);
+}
+
+void utils_packing::toUnorm8(const float* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    for (; i + 16 <= count; i += 16) {
+        __m128i low  = _mm_packs_epi32(toUnorm4(_mm_loadu_ps(in + i)), toUnorm4(_mm_loadu_ps(in + i + 4)));
+        __m128i high = _mm_packs_epi32(toUnorm4(_mm_loadu_ps(in + i + 8)), toUnorm4(_mm_loadu_ps(in + i + 12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = toUnorm8(in[i]);
+}
+
+void utils_packing::fromUnorm8(const uint8_t* in, float* out, size_t count) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i low    = _mm_unpacklo_epi8(values, zero);
+        __m128i high   = _mm_unpackhi_epi8(values, zero);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+        _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+        _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = fromUnorm8(in[i]);
+}
+
+void utils_packing::encodeOctahedral(const float* in, int16_t* out, size_t count, size_t inStride) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    const Float4 zero = Float4::set1(0.0f);
+    const Float4 one  = Float4::set1(1.0f);
+    for (; i + 4 <= count; i += 4, in += 4 * inStride) {
+        Float4 x = Float4::set(in[0], in[inStride], in[2 * inStride], in[3 * inStride]);
+        Float4 y = Float4::set(in[1], in[inStride + 1], in[2 * inStride + 1], in[3 * inStride + 1]);
+        Float4 z = Float4::set(in[2], in[inStride + 2], in[2 * inStride + 2], in[3 * inStride + 2]);
+
+        Float4 scale = one / (utils_simd::abs(x) + utils_simd::abs(y) + utils_simd::abs(z));
+        x            = x * scale;
+        y            = y * scale;
+
+        // Fold the lower half over the diagonals (copying the sign of x and
+        // y onto the folded values)
+        const Float4 signBit = Float4::set1(-0.0f);
+        Float4 foldedX       = (one - utils_simd::abs(y)) | (x & signBit);
+        Float4 foldedY       = (one - utils_simd::abs(x)) | (y & signBit);
+        Float4 lower         = utils_simd::lessThan(z, zero);
+        x                    = utils_simd::select(lower, foldedX, x);
+        y                    = utils_simd::select(lower, foldedY, y);
+
+        // Interleave the x and y values of each direction
+        __m128i encodedX = toSnorm4(x.v);
+        __m128i encodedY = toSnorm4(y.v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_packs_epi32(_mm_unpacklo_epi32(encodedX, encodedY), _mm_unpackhi_epi32(encodedX, encodedY)));
+    }
+#endif
+    for (; i < count; ++i, in += inStride) {
+        Vector2f encoded = encodeOctahedral(Vector3f(in[0], in[1], in[2]));
+        out[2 * i]       = toSnorm16(encoded.getX());
+        out[2 * i + 1]   = toSnorm16(encoded.getY());
+    }
+}
+
+void utils_packing::decodeOctahedral(const int16_t* in, float* out, size_t count, size_t outStride) {
+    size_t i = 0;
+#ifdef UE_SIMD_SSE
+    const Float4 zero = Float4::set1(0.0f);
+    const Float4 one  = Float4::set1(1.0f);
+    for (; i + 4 <= count; i += 4, out += 4 * outStride) {
+        // Each 32 bit lane holds the x and y values of one direction
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        Float4 x       = fromSnorm4(_mm_srai_epi32(_mm_slli_epi32(values, 16), 16));
+        Float4 y       = fromSnorm4(_mm_srai_epi32(values, 16));
+        Float4 z       = one - utils_simd::abs(x) - utils_simd::abs(y);
+
+        // Unfold the lower half (moving x and y towards 0)
+        Float4 fold = utils_simd::max(-z, zero);
+        x           = x - utils_simd::select(utils_simd::greaterEqual(x, zero), fold, -fold);
+        y           = y - utils_simd::select(utils_simd::greaterEqual(y, zero), fold, -fold);
+
+        Float4 scale = utils_simd::rsqrt(x * x + y * y + z * z);
+        x            = x * scale;
+        y            = y * scale;
+        z            = z * scale;
+
+        Float4 w = zero;
+        utils_simd::transpose(x, y, z, w);
+        x.store3(out);
+        y.store3(out + outStride);
+        z.store3(out + 2 * outStride);
+        w.store3(out + 3 * outStride);
+    }
+#endif
+    for (; i < count; ++i, out += outStride) {
+        Vector3f direction = decodeOctahedral(Vector2f(fromSnorm16(in[2 * i]), fromSnorm16(in[2 * i + 1])));
+        out[0]             = direction.getX();
+        out[1]             = direction.getY();
+        out[2]             = direction.getZ();
+    }
+}
+
+// The packed colours are stored as bytes in the order red, green, blue,
+// alpha which on the (little endian) platforms supported is the same as
+// converting each component separately
+
+void utils_packing::packColours(const float* in, uint32_t* out, size_t count) {
+    toUnorm8(in, reinterpret_cast<uint8_t*>(out), count * 4);
+}
+
+void utils_packing::unpackColours(const uint32_t* in, float* out, size_t count) {
+    fromUnorm8(reinterpret_cast<const uint8_t*>(in), out, count * 4);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Vector.h"
+
+/*****************************************************************************
+ * utils_packing namespace - Conversions between floats and the compact
+ *                           formats used for vertex and instance data
+ *****************************************************************************/
+
+// Each conversion is available for a single value (defined here) and for
+// arrays of values (vectorised with SSE where possible). The formats match
+// the equivalent Vulkan ones:
+//     half      VK_FORMAT_R16_SFLOAT (rounded to nearest even, NaN is kept,
+//               round trip error at most 2^-11 relative to normal values
+//               and 2^-25 for denormal ones)
+//     snorm16   VK_FORMAT_R16_SNORM  (clamped to [-1, 1], round trip error
+//               below 1.6e-5)
+//     unorm8    VK_FORMAT_R8_UNORM   (clamped to [0, 1], round trip error
+//               below 2e-3)
+// Octahedral normals are stored as 2 snorm16 values (VK_FORMAT_R16G16_SNORM)
+// and decode to within 0.004 degrees of the original direction. Colours are
+// stored as 4 unorm8 values (VK_FORMAT_R8G8B8A8_UNORM) so the red component
+// is in the lowest byte of the packed value. The error bounds above are
+// checked by benchmarks/MathsChecks.cpp.
+
+namespace utils_packing {
+    /* Returns the bits of a float and vice versa */
+    inline uint32_t toBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+        return bits;
+    }
+
+    inline float fromBits(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    /* Converts a float to a half precision float */
+    inline uint16_t toHalf(float value) {
+        uint32_t bits = toBits(value);
+        uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint32_t result;
+        if (bits >= (143u << 23))
+            // Too large (becomes infinity) or infinity/NaN
+            result = bits > (255u << 23) ? 0x7E00u : 0x7C00u;
+        else if (bits < (113u << 23)) {
+            // Denormal or zero - adding a value with an exponent that places
+            // the 10 bits of the mantissa at the bottom makes the FPU do the
+            // rounding
+            const uint32_t magic = 126u << 23;
+            result               = toBits(fromBits(bits) + fromBits(magic)) - magic;
+        } else {
+            // Adjust the exponent and round to nearest even
+            uint32_t odd = (bits >> 13) & 1u;
+            result       = (bits + (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu + odd) >> 13;
+        }
+        return static_cast<uint16_t>(result | (sign >> 16));
+    }
+
+    /* Converts a half precision float to a float */
+    inline float fromHalf(uint16_t value) {
+        const uint32_t exponentMask = 0x7C00u << 13;
+
+        uint32_t bits     = (value & 0x7FFFu) << 13;
+        uint32_t exponent = bits & exponentMask;
+        bits += (127u - 15u) << 23;
+
+        if (exponent == exponentMask)
+            // Infinity/NaN
+            bits += (128u - 16u) << 23;
+        else if (exponent == 0) {
+            // Denormal or zero
+            bits += 1u << 23;
+            bits = toBits(fromBits(bits) - fromBits(113u << 23));
+        }
+        return fromBits(bits | ((value & 0x8000u) << 16));
+    }
+
+    /* Converts a float to a signed normalised 16 bit integer (NaN becomes
+       -1) */
+    inline int16_t toSnorm16(float value) {
+        value = value > -1.0f ? (value < 1.0f ? value : 1.0f) : -1.0f;
+        return static_cast<int16_t>(lrintf(value * 32767.0f));
+    }
+
+    /* Converts a signed normalised 16 bit integer to a float */
+    inline float fromSnorm16(int16_t value) {
+        float result = static_cast<float>(value) * (1.0f / 32767.0f);
+        return result > -1.0f ? result : -1.0f;
+    }
+
+    /* Converts a float to an unsigned normalised 8 bit integer (NaN becomes
+       0) */
+    inline uint8_t toUnorm8(float value) {
+        value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+        return static_cast<uint8_t>(lrintf(value * 255.0f));
+    }
+
+    /* Converts an unsigned normalised 8 bit integer to a float */
+    inline float fromUnorm8(uint8_t value) { return static_cast<float>(value) * (1.0f / 255.0f); }
+
+    /* Maps a direction onto the faces of an octahedron unfolded into the
+       square [-1, 1] x [-1, 1] (the direction needn't be normalised but
+       mustn't be zero) */
+    inline Vector2f encodeOctahedral(const Vector3f& direction) {
+        float scale = 1.0f / (fabsf(direction.getX()) + fabsf(direction.getY()) + fabsf(direction.getZ()));
+        float x     = direction.getX() * scale;
+        float y     = direction.getY() * scale;
+        if (direction.getZ() < 0.0f) {
+            // Fold the lower half over the diagonals
+            float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x             = foldedX;
+            y             = foldedY;
+        }
+        return Vector2f(x, y);
+    }
+
+    /* Returns the normalised direction given by a point from
+       encodeOctahedral */
+    inline Vector3f decodeOctahedral(const Vector2f& encoded) {
+        float x = encoded.getX();
+        float y = encoded.getY();
+        float z = 1.0f - fabsf(x) - fabsf(y);
+        // Unfold the lower half
+        float fold = z < 0.0f ? -z : 0.0f;
+        x += x >= 0.0f ? -fold : fold;
+        y += y >= 0.0f ? -fold : fold;
+        return Vector3f(x, y, z).normalised();
+    }
+
+    /* Packs a colour into 4 unorm8 values (with red in the lowest byte) */
+    inline uint32_t packColour(const Vector4f& colour) {
+        return static_cast<uint32_t>(toUnorm8(colour.getX())) | (static_cast<uint32_t>(toUnorm8(colour.getY())) << 8) |
+               (static_cast<uint32_t>(toUnorm8(colour.getZ())) << 16) | (static_cast<uint32_t>(toUnorm8(colour.getW())) << 24);
+    }
+
+    /* Unpacks a colour from 4 unorm8 values */
+    inline Vector4f unpackColour(uint32_t packed) {
+        return Vector4f(fromUnorm8(packed & 0xFF), fromUnorm8((packed >> 8) & 0xFF), fromUnorm8((packed >> 16) & 0xFF), fromUnorm8(packed >> 24));
+    }
+
+    /* Converts arrays of values (the input and output must not overlap) */
+    void toHalf(const float* in, uint16_t* out, size_t count);
+    void fromHalf(const uint16_t* in, float* out, size_t count);
+    void toSnorm16(const float* in, int16_t* out, size_t count);
+    void fromSnorm16(const int16_t* in, float* out, size_t count);
+    void toUnorm8(const float* in, uint8_t* out, size_t count);
+    void fromUnorm8(const uint8_t* in, float* out, size_t count);
+
+    /* Encodes directions (with inStride floats between the start of each)
+       as octahedral snorm16 pairs, writing 2 values per direction */
+    void encodeOctahedral(const float* in, int16_t* out, size_t count, size_t inStride = 3);
+
+    /* Decodes octahedral snorm16 pairs into normalised directions (with
+       outStride floats between the start of each) */
+    void decodeOctahedral(const int16_t* in, float* out, size_t count, size_t outStride = 3);
+
+    /* Packs RGBA colours (4 floats each, e.g. from an array of Colour) into
+       4 unorm8 values each and vice versa */
+    void packColours(const float* in, uint32_t* out, size_t count);
+    void unpackColours(const uint32_t* in, float* out, size_t count);
+}  // namespace utils_packing
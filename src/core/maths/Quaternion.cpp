@@ -11,8 +11,8 @@ Quaternion& Quaternion::initFromAxisAngle(const Vector3f& axis, float angle) {
     // Calculate some needed constants for transforming it into the quaternion
     // representation
     float a = utils_maths::toRadians(angle / 2.0f);
-    float s = sinf(a);
-    float c = cosf(a);
+    float s, c;
+    utils_maths::sincos(a, s, c);
     // Assign the values
     setX(axis.getX() * s);
     setY(axis.getY() * s);
@@ -27,12 +27,10 @@ Quaternion& Quaternion::initFromEulerAngles(const Vector3f& angles) {
     float a = utils_maths::toRadians(angles.getZ());
     float b = utils_maths::toRadians(angles.getX());
 
-    float c1 = cosf(h / 2.0f);
-    float s1 = sinf(h / 2.0f);
-    float c2 = cosf(a / 2.0f);
-    float s2 = sinf(a / 2.0f);
-    float c3 = cosf(b / 2.0f);
-    float s3 = sinf(b / 2.0f);
+    float c1, s1, c2, s2, c3, s3;
+    utils_maths::sincos(h / 2.0f, s1, c1);
+    utils_maths::sincos(a / 2.0f, s2, c2);
+    utils_maths::sincos(b / 2.0f, s3, c3);
     float c1c2 = c1 * c2;
     float s1s2 = s1 * s2;
 
@@ -85,15 +83,15 @@ Quaternion& Quaternion::initLookAt(const Vector3f& eye, const Vector3f& centre,
     return initFromRotationMatrix(Matrix4f().initLookAt(eye, centre, up));
 }
 
+template <typename Precision>
 Quaternion Quaternion::slerp(const Quaternion& quatA, const Quaternion& quatB, float factor) {
     // https://en.wikipedia.org/wiki/Slerp
     Quaternion v0 = quatA;
     Quaternion v1 = quatB;
-    Quaternion result;
 
     float dot = v0.dot(v1);
     if (dot < 0.0f) {
-        v0 = v0 * -1.0f;
+        v0 = Quaternion(-v0.getX(), -v0.getY(), -v0.getZ(), -v0.getW());
         dot = -dot;
     }
 
@@ -102,21 +100,34 @@ Quaternion Quaternion::slerp(const Quaternion& quatA, const Quaternion& quatB, f
 
     const float THRESHOLD = 0.9995f;
     if (dot < THRESHOLD) {
-        float theta = acosf(dot);
-        float invSin = 1.0f / sinf(theta);
-
-        s0 = sinf(s0 * theta) * invSin;
-        s1 = sinf(s1 * theta) * invSin;
+        float theta = utils_maths::acos<Precision>(dot);
+        if constexpr (utils_maths::isFast<Precision>()) {
+            // Use a single sincos rather than three sines, with
+            // sin(theta) = sqrt((1 - dot)(1 + dot)) and
+            // sin((1 - t) theta) = sin(theta) cos(t theta) - dot sin(t theta)
+            // (the standard library's sincos is used as the polynomial one is
+            // slower for the small angles here)
+            float sine, cosine;
+            utils_maths::sincos<utils_maths::Precise>(factor * theta, sine, cosine);
+            float invSin = utils_maths::reciprocalSqrt<Precision>((1.0f - dot) * (1.0f + dot));
+
+            s0 = cosine - dot * sine * invSin;
+            s1 = sine * invSin;
+        } else {
+            float invSin = 1.0f / utils_maths::sin<Precision>(theta);
+
+            s0 = utils_maths::sin<Precision>(s0 * theta) * invSin;
+            s1 = utils_maths::sin<Precision>(s1 * theta) * invSin;
+        }
     }
 
-    result[0] = (s0 * v0[0]) + (s1 * v1[0]);
-    result[1] = (s0 * v0[1]) + (s1 * v1[1]);
-    result[2] = (s0 * v0[2]) + (s1 * v1[2]);
-    result[3] = (s0 * v0[3]) + (s1 * v1[3]);
-
-    return result.normalise();
+    Quaternion result = Vector<float, 4>::linearCombination(v0, s0, v1, s1);
+    return result.normalise<Precision>();
 }
 
+template Quaternion Quaternion::slerp<utils_maths::Precise>(const Quaternion& quatA, const Quaternion& quatB, float factor);
+template Quaternion Quaternion::slerp<utils_maths::Fast>(const Quaternion& quatA, const Quaternion& quatB, float factor);
+
 Matrix4f Quaternion::toMatrix() const {
     // https://en.wikipedia.org/wiki/Quaternions_and_spatial_rotation
     Matrix4f mat;
@@ -157,17 +168,17 @@ Vector3f Quaternion::toEulerAngles() {
     float h, a, b;
 
     if (test > 0.499f * unit) {
-        h = 2 * atan2f(getX(), getW());
+        h = 2 * utils_maths::atan2(getX(), getW());
         a = utils_maths::PI / 2.0f;
         b = 0;
     } else if (test < -0.499f * unit) {
-        h = -2 * atan2f(getX(), getW());
+        h = -2 * utils_maths::atan2(getX(), getW());
         a = -utils_maths::PI / 2.0f;
         b = 0;
     } else {
-        h = atan2f(2 * getY() * getW() - 2.0f * getX() * getZ(), sqx - sqy - sqz + sqw);
+        h = utils_maths::atan2(2 * getY() * getW() - 2.0f * getX() * getZ(), sqx - sqy - sqz + sqw);
         a = asinf(2 * test / unit);
-        b = atan2f(2 * getX() * getW() - 2.0f * getY() * getZ(), -sqx + sqy - sqz + sqw);
+        b = utils_maths::atan2(2 * getX() * getW() - 2.0f * getY() * getZ(), -sqx + sqy - sqz + sqw);
     }
 
     return Vector3f(utils_maths::toDegrees(b), utils_maths::toDegrees(h), utils_maths::toDegrees(a));
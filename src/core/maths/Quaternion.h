@@ -11,18 +11,17 @@ class Matrix4f;
 class Quaternion : public Vector4f {
 public:
     /* Various constructors */
-    Quaternion() {}
-    Quaternion(const std::initializer_list<float>& values) : Vector4f(values) {}
-    Quaternion(const float value) : Vector4f(value) {}
-    Quaternion(const float x, const float y, const float z, const float w) : Vector4f(x, y, z, w) {}
-    Quaternion(const Vector2<float>& base, const float z, const float w) : Vector4f(base, z, w) {}
-    Quaternion(const Vector3<float>& base, const float w) : Vector4f(base, w) {}
+    constexpr Quaternion() {}
+    constexpr Quaternion(const float value) : Vector4f(value) {}
+    constexpr Quaternion(const float x, const float y, const float z, const float w) : Vector4f(x, y, z, w) {}
+    constexpr Quaternion(const Vector2<float>& base, const float z, const float w) : Vector4f(base, z, w) {}
+    constexpr Quaternion(const Vector3<float>& base, const float w) : Vector4f(base, w) {}
 
-    Quaternion(const Vector<float, 4>& base) : Vector4f(base) {}
-    Quaternion(const Vector4<float>& base) : Vector4f(base) {}
+    constexpr Quaternion(const Vector<float, 4>& base) : Vector4f(base) {}
+    constexpr Quaternion(const Vector4<float>& base) : Vector4f(base) {}
 
     /* Multiplies this quaternion by another and returns the result */
-    inline Quaternion operator*(const Quaternion& other) const {
+    inline constexpr Quaternion operator*(const Quaternion& other) const {
         Quaternion result;
 
         result[0] = (getX() * other.getW()) + (getW() * other.getX()) + (getY() * other.getZ()) - (getZ() * other.getY());
@@ -34,7 +33,7 @@ public:
     }
 
     /* Multiplies this quaternion by another */
-    inline Quaternion operator*=(const Quaternion& other) {
+    inline constexpr Quaternion operator*=(const Quaternion& other) {
         Quaternion result = (*this) * other;
 
         setX(result.getX());
@@ -58,7 +57,7 @@ public:
     Quaternion& initLookAt(const Vector3f& eye, const Vector3f& centre, const Vector3f& up);
 
     /* Returns the conjugate of this quaternion */
-    inline Quaternion conjugate() const { return Quaternion(-getX(), -getY(), -getZ(), getW()); }
+    inline constexpr Quaternion conjugate() const { return Quaternion(-getX(), -getY(), -getZ(), getW()); }
 
     /* Converts this quaternion to a rotation matrix */
     Matrix4f toMatrix() const;
@@ -74,7 +73,9 @@ public:
     inline Vector3f getLeft() const { return rotate(Vector3f(-1.0f, 0.0f, 0.0f), (*this)); }
     inline Vector3f getRight() const { return rotate(Vector3f(1.0f, 0.0f, 0.0f), (*this)); }
 
-    /* Spherical linear interpolation between two quaternions */
+    /* Spherical linear interpolation between two quaternions (instantiated
+       for utils_maths::Precise and utils_maths::Fast) */
+    template <typename Precision = utils_maths::DefaultPrecision>
     static Quaternion slerp(const Quaternion& quatA, const Quaternion& quatB, float factor);
 
     /* Rotates a vector using a quaternion */
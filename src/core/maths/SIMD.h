@@ -0,0 +1,429 @@
+#pragma once
+
+/*****************************************************************************
+ * Various SIMD utilities - Thin wrappers around the SSE/AVX intrinsics used
+ * by the maths library. A scalar fallback is provided for when they are not
+ * available (or when UE_NO_SIMD is defined)
+ *****************************************************************************/
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if ! defined(UE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define UE_SIMD_SSE
+#include <immintrin.h>
+#if defined(__AVX__)
+#define UE_SIMD_AVX
+#endif
+#if defined(__FMA__) || defined(__AVX2__)
+#define UE_SIMD_FMA
+#endif
+#if defined(__F16C__) || defined(__AVX2__)
+#define UE_SIMD_F16C
+#endif
+#endif
+
+/* States that a pointer is the only way its data is accessed within a function
+   (lets the compiler vectorise loops without checking for overlap) */
+#define UE_RESTRICT __restrict
+
+namespace utils_simd {
+    /* States whether SIMD instructions are being used */
+#ifdef UE_SIMD_SSE
+    constexpr bool ENABLED = true;
+#else
+    constexpr bool ENABLED = false;
+#endif
+
+    /* Alignment (in bytes) required for aligned loads/stores */
+    constexpr size_t ALIGNMENT = 16;
+
+    /* Returns the alignment that should be used for an array of N values of
+       type T (Only over aligns when the array fills whole SIMD registers) */
+    template <typename T, unsigned int N>
+    constexpr size_t alignmentFor() { return (sizeof(T) * N) % ALIGNMENT == 0 ? ALIGNMENT : alignof(T); }
+
+    /* Alignment (in bytes) used for large arrays (a cache line, which also
+       suits the widest AVX-512 loads) */
+    constexpr size_t ARRAY_ALIGNMENT = 64;
+
+    /* Allocator for std::vector that aligns its data to ARRAY_ALIGNMENT */
+    template <typename T>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        AlignedAllocator() {}
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U>&) {}
+
+        inline T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(ARRAY_ALIGNMENT))); }
+        inline void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(ARRAY_ALIGNMENT)); }
+
+        template <typename U>
+        inline bool operator==(const AlignedAllocator<U>&) const { return true; }
+        template <typename U>
+        inline bool operator!=(const AlignedAllocator<U>&) const { return false; }
+    };
+
+    /* std::vector with aligned data */
+    template <typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+    /* States whether the SIMD kernels below should be used for a vector or
+       matrix with values of type T and dimension N */
+    template <typename T, unsigned int N>
+    constexpr bool usable() { return ENABLED && std::is_same<T, float>::value && N == 4; }
+
+    /* Returns whether the calling code is being evaluated at compile time
+       (intrinsics can't be, so code using them must check this first to
+       remain usable in constexpr contexts) */
+    constexpr bool isConstantEvaluated() {
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+        return __builtin_is_constant_evaluated();
+#else
+        return false;
+#endif
+    }
+
+    /*************************************************************************
+     * Float4 - Four packed floats (a single SSE register)
+     *************************************************************************/
+
+    struct Float4 {
+#ifdef UE_SIMD_SSE
+        __m128 v;
+
+        Float4() {}
+        Float4(__m128 v) : v(v) {}
+#else
+        float v[4];
+
+        Float4() {}
+#endif
+
+        /* Loads/stores from/to memory (the pointer must be 16 byte aligned
+           for the aligned versions) */
+        static inline Float4 load(const float* p) {
+#ifdef UE_SIMD_SSE
+            return _mm_load_ps(p);
+#else
+            Float4 result;
+            for (unsigned int i = 0; i < 4; ++i)
+                result.v[i] = p[i];
+            return result;
+#endif
+        }
+
+        static inline Float4 loadUnaligned(const float* p) {
+#ifdef UE_SIMD_SSE
+            return _mm_loadu_ps(p);
+#else
+            return load(p);
+#endif
+        }
+
+        inline void store(float* p) const {
+#ifdef UE_SIMD_SSE
+            _mm_store_ps(p, v);
+#else
+            for (unsigned int i = 0; i < 4; ++i)
+                p[i] = v[i];
+#endif
+        }
+
+        inline void storeUnaligned(float* p) const {
+#ifdef UE_SIMD_SSE
+            _mm_storeu_ps(p, v);
+#else
+            store(p);
+#endif
+        }
+
+        /* Loads/stores only the first 3 lanes (w is assigned 0 when loading)
+           - for packed 3 component data where touching a 4th value could
+           overwrite the next element */
+        static inline Float4 load3(const float* p) { return set(p[0], p[1], p[2], 0.0f); }
+
+        inline void store3(float* p) const {
+#ifdef UE_SIMD_SSE
+            _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+            _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+#else
+            for (unsigned int i = 0; i < 3; ++i)
+                p[i] = v[i];
+#endif
+        }
+
+        /* Returns a value with each lane assigned (x is the lowest lane) */
+        static inline Float4 set(float x, float y, float z, float w) {
+#ifdef UE_SIMD_SSE
+            return _mm_setr_ps(x, y, z, w);
+#else
+            Float4 result;
+            result.v[0] = x;
+            result.v[1] = y;
+            result.v[2] = z;
+            result.v[3] = w;
+            return result;
+#endif
+        }
+
+        /* Returns a value with all lanes assigned the same value */
+        static inline Float4 set1(float value) {
+#ifdef UE_SIMD_SSE
+            return _mm_set1_ps(value);
+#else
+            return set(value, value, value, value);
+#endif
+        }
+
+        /* Returns the value of the lowest lane */
+        inline float first() const {
+#ifdef UE_SIMD_SSE
+            return _mm_cvtss_f32(v);
+#else
+            return v[0];
+#endif
+        }
+
+        /* Returns the value of a particular lane */
+        inline float get(unsigned int lane) const {
+#ifdef UE_SIMD_SSE
+            alignas(ALIGNMENT) float values[4];
+            _mm_store_ps(values, v);
+            return values[lane];
+#else
+            return v[lane];
+#endif
+        }
+    };
+
+#ifdef UE_SIMD_SSE
+    /* Broadcasts a single lane to all lanes */
+    template <int Lane>
+    inline Float4 splat(const Float4& a) { return _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(Lane, Lane, Lane, Lane)); }
+
+    inline Float4 operator+(const Float4& a, const Float4& b) { return _mm_add_ps(a.v, b.v); }
+    inline Float4 operator-(const Float4& a, const Float4& b) { return _mm_sub_ps(a.v, b.v); }
+    inline Float4 operator*(const Float4& a, const Float4& b) { return _mm_mul_ps(a.v, b.v); }
+    inline Float4 operator/(const Float4& a, const Float4& b) { return _mm_div_ps(a.v, b.v); }
+    inline Float4 operator-(const Float4& a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+
+    /* Returns a * b + c (fused where supported) */
+    inline Float4 multiplyAdd(const Float4& a, const Float4& b, const Float4& c) {
+#ifdef UE_SIMD_FMA
+        return _mm_fmadd_ps(a.v, b.v, c.v);
+#else
+        return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v);
+#endif
+    }
+
+    /* Element-wise functions */
+    inline Float4 min(const Float4& a, const Float4& b) { return _mm_min_ps(a.v, b.v); }
+    inline Float4 max(const Float4& a, const Float4& b) { return _mm_max_ps(a.v, b.v); }
+    inline Float4 abs(const Float4& a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+    inline Float4 sqrt(const Float4& a) { return _mm_sqrt_ps(a.v); }
+
+    /* Approximate reciprocal square root (~12 bits) refined with a single
+       Newton-Raphson step (~22 bits) */
+    inline Float4 rsqrt(const Float4& a) {
+        __m128 estimate = _mm_rsqrt_ps(a.v);
+        __m128 muls     = _mm_mul_ps(_mm_mul_ps(a.v, estimate), estimate);
+        return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), muls));
+    }
+
+    /* Comparisons - each lane of the result is either all 1's or all 0's */
+    inline Float4 lessThan(const Float4& a, const Float4& b) { return _mm_cmplt_ps(a.v, b.v); }
+    inline Float4 lessEqual(const Float4& a, const Float4& b) { return _mm_cmple_ps(a.v, b.v); }
+    inline Float4 greaterThan(const Float4& a, const Float4& b) { return _mm_cmpgt_ps(a.v, b.v); }
+    inline Float4 greaterEqual(const Float4& a, const Float4& b) { return _mm_cmpge_ps(a.v, b.v); }
+
+    /* Bitwise operations (mainly for use with the above masks) */
+    inline Float4 operator&(const Float4& a, const Float4& b) { return _mm_and_ps(a.v, b.v); }
+    inline Float4 operator|(const Float4& a, const Float4& b) { return _mm_or_ps(a.v, b.v); }
+
+    /* Selects lanes from a where the mask is set, and from b otherwise */
+    inline Float4 select(const Float4& mask, const Float4& a, const Float4& b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+
+    /* Returns a bit for each lane of a mask (lane 0 is the lowest bit) */
+    inline int moveMask(const Float4& mask) { return _mm_movemask_ps(mask.v); }
+
+    /* Transposes four values as if they were the rows of a 4x4 matrix */
+    inline void transpose(Float4& a, Float4& b, Float4& c, Float4& d) { _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+#else
+    /* Helpers for the fallback implementation */
+    template <typename Function>
+    inline Float4 perLane(const Float4& a, const Float4& b, Function function) {
+        Float4 result;
+        for (unsigned int i = 0; i < 4; ++i)
+            result.v[i] = function(a.v[i], b.v[i]);
+        return result;
+    }
+
+    inline float fromBits(unsigned int bits) {
+        float result;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    inline unsigned int toBits(float value) {
+        unsigned int bits;
+        memcpy(&bits, &value, sizeof(float));
+        return bits;
+    }
+
+    inline float maskValue(bool value) { return fromBits(value ? 0xFFFFFFFFu : 0u); }
+
+    /* Broadcasts a single lane to all lanes */
+    template <int Lane>
+    inline Float4 splat(const Float4& a) { return Float4::set1(a.v[Lane]); }
+
+    inline Float4 operator+(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x + y; }); }
+    inline Float4 operator-(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x - y; }); }
+    inline Float4 operator*(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x * y; }); }
+    inline Float4 operator/(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x / y; }); }
+    inline Float4 operator-(const Float4& a) { return Float4::set(-a.v[0], -a.v[1], -a.v[2], -a.v[3]); }
+
+    /* Returns a * b + c */
+    inline Float4 multiplyAdd(const Float4& a, const Float4& b, const Float4& c) { return a * b + c; }
+
+    /* Element-wise functions */
+    inline Float4 min(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    inline Float4 max(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    inline Float4 abs(const Float4& a) { return perLane(a, a, [](float x, float) { return x < 0 ? -x : x; }); }
+    inline Float4 sqrt(const Float4& a) { return perLane(a, a, [](float x, float) { return sqrtf(x); }); }
+    inline Float4 rsqrt(const Float4& a) { return perLane(a, a, [](float x, float) { return 1.0f / sqrtf(x); }); }
+
+    /* Comparisons - each lane of the result is either all 1's or all 0's */
+    inline Float4 lessThan(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return maskValue(x < y); }); }
+    inline Float4 lessEqual(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return maskValue(x <= y); }); }
+    inline Float4 greaterThan(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return maskValue(x > y); }); }
+    inline Float4 greaterEqual(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return maskValue(x >= y); }); }
+
+    /* Bitwise operations (mainly for use with the above masks) */
+    inline Float4 operator&(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return fromBits(toBits(x) & toBits(y)); }); }
+    inline Float4 operator|(const Float4& a, const Float4& b) { return perLane(a, b, [](float x, float y) { return fromBits(toBits(x) | toBits(y)); }); }
+
+    /* Selects lanes from a where the mask is set, and from b otherwise */
+    inline Float4 select(const Float4& mask, const Float4& a, const Float4& b) {
+        Float4 result;
+        for (unsigned int i = 0; i < 4; ++i)
+            result.v[i] = toBits(mask.v[i]) ? a.v[i] : b.v[i];
+        return result;
+    }
+
+    /* Returns a bit for each lane of a mask (lane 0 is the lowest bit) */
+    inline int moveMask(const Float4& mask) {
+        int result = 0;
+        for (unsigned int i = 0; i < 4; ++i)
+            result |= (toBits(mask.v[i]) >> 31) << i;
+        return result;
+    }
+
+    /* Transposes four values as if they were the rows of a 4x4 matrix */
+    inline void transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+        Float4 rows[4] = {a, b, c, d};
+        a = Float4::set(rows[0].v[0], rows[1].v[0], rows[2].v[0], rows[3].v[0]);
+        b = Float4::set(rows[0].v[1], rows[1].v[1], rows[2].v[1], rows[3].v[1]);
+        c = Float4::set(rows[0].v[2], rows[1].v[2], rows[2].v[2], rows[3].v[2]);
+        d = Float4::set(rows[0].v[3], rows[1].v[3], rows[2].v[3], rows[3].v[3]);
+    }
+#endif
+
+    /* Returns the dot product of two values (result in every lane) */
+    inline Float4 dot4(const Float4& a, const Float4& b) {
+        Float4 product = a * b;
+#ifdef UE_SIMD_SSE
+        // Add the swapped pairs and then the swapped halves
+        __m128 sum = _mm_add_ps(product.v, _mm_shuffle_ps(product.v, product.v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+#else
+        return Float4::set1(product.v[0] + product.v[1] + product.v[2] + product.v[3]);
+#endif
+    }
+
+    /*************************************************************************
+     * 4x4 matrix kernels - All matrices are 16 floats stored in column major
+     * order and must be 16 byte aligned
+     *************************************************************************/
+
+    /* Computes a * b and stores it in out (out may alias a or b) */
+    inline void multiplyMatrix4(const float* a, const float* b, float* out) {
+#ifdef UE_SIMD_AVX
+        // Process two columns of the result at a time, with each 128 bit half
+        // holding one of them
+        __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+        __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+        __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+        __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+
+        __m256 b01 = _mm256_loadu_ps(b);
+        __m256 b23 = _mm256_loadu_ps(b + 8);
+
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0)));
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0)));
+#ifdef UE_SIMD_FMA
+        r01 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1)), r01);
+        r23 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1)), r23);
+        r01 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2)), r01);
+        r23 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2)), r23);
+        r01 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3)), r01);
+        r23 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3)), r23);
+#else
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3))));
+#endif
+        _mm256_storeu_ps(out, r01);
+        _mm256_storeu_ps(out + 8, r23);
+#else
+        // Each column of the result is a linear combination of the columns
+        // of a, weighted by the values in the same column of b (everything
+        // is loaded first so that out may alias a or b)
+        Float4 a0 = Float4::load(a);
+        Float4 a1 = Float4::load(a + 4);
+        Float4 a2 = Float4::load(a + 8);
+        Float4 a3 = Float4::load(a + 12);
+
+        Float4 b0 = Float4::load(b);
+        Float4 b1 = Float4::load(b + 4);
+        Float4 b2 = Float4::load(b + 8);
+        Float4 b3 = Float4::load(b + 12);
+
+        multiplyAdd(a3, splat<3>(b0), multiplyAdd(a2, splat<2>(b0), multiplyAdd(a1, splat<1>(b0), a0 * splat<0>(b0)))).store(out);
+        multiplyAdd(a3, splat<3>(b1), multiplyAdd(a2, splat<2>(b1), multiplyAdd(a1, splat<1>(b1), a0 * splat<0>(b1)))).store(out + 4);
+        multiplyAdd(a3, splat<3>(b2), multiplyAdd(a2, splat<2>(b2), multiplyAdd(a1, splat<1>(b2), a0 * splat<0>(b2)))).store(out + 8);
+        multiplyAdd(a3, splat<3>(b3), multiplyAdd(a2, splat<2>(b3), multiplyAdd(a1, splat<1>(b3), a0 * splat<0>(b3)))).store(out + 12);
+#endif
+    }
+
+    /* Computes m * v and stores it in out (out may alias v) */
+    inline void multiplyMatrix4Vector4(const float* m, const float* v, float* out) {
+        Float4 vector = Float4::load(v);
+        Float4 r      = Float4::load(m) * splat<0>(vector);
+        r             = multiplyAdd(Float4::load(m + 4), splat<1>(vector), r);
+        r             = multiplyAdd(Float4::load(m + 8), splat<2>(vector), r);
+        r             = multiplyAdd(Float4::load(m + 12), splat<3>(vector), r);
+        r.store(out);
+    }
+
+    /* Computes the transpose of m and stores it in out (out may alias m) */
+    inline void transposeMatrix4(const float* m, float* out) {
+        Float4 c0 = Float4::load(m);
+        Float4 c1 = Float4::load(m + 4);
+        Float4 c2 = Float4::load(m + 8);
+        Float4 c3 = Float4::load(m + 12);
+        transpose(c0, c1, c2, c3);
+        c0.store(out);
+        c1.store(out + 4);
+        c2.store(out + 8);
+        c3.store(out + 12);
+    }
+}  // namespace utils_simd
@@ -0,0 +1,333 @@
+#include "Streams.h"
+
+#include <cfloat>
+
+#include "../../utils/Logging.h"
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+// Each of these works on a single component array at a time so that the only
+// possible overlap is between 'values' and 'other' (which is fine as each
+// element is only read before being written)
+
+static inline void addArray(float* values, const float* other, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        values[i] += other[i];
+}
+
+static inline void addScaledArray(float* values, const float* other, float factor, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        values[i] += other[i] * factor;
+}
+
+static inline void subtractArray(float* values, const float* other, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        values[i] -= other[i];
+}
+
+static inline void scaleArray(float* values, float factor, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        values[i] *= factor;
+}
+
+static inline void scaleArray(float* values, const float* factors, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        values[i] *= factors[i];
+}
+
+static inline void lerpArray(const float* valuesA, const float* valuesB, float factor, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        out[i] = valuesA[i] + (valuesB[i] - valuesA[i]) * factor;
+}
+
+// The rest take every component at once - their arrays are marked as
+// restricted as otherwise the compiler gives up checking for overlaps and
+// won't vectorise them
+
+/* Returns 1 / length given the squared length (offset so zero length values
+   are still zero once multiplied rather than NaN - a comparison here would
+   stop the loops being vectorised) */
+static inline float invLength(float lengthSquared) {
+    return 1.0f / sqrtf(lengthSquared + FLT_MIN);
+}
+
+static void dotArrays(const float* UE_RESTRICT ax, const float* UE_RESTRICT ay, const float* UE_RESTRICT az, const float* UE_RESTRICT bx, const float* UE_RESTRICT by, const float* UE_RESTRICT bz, float* UE_RESTRICT out, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+}
+
+static void dotArrays(const float* UE_RESTRICT ax, const float* UE_RESTRICT ay, const float* UE_RESTRICT az, const float* UE_RESTRICT aw, const float* UE_RESTRICT bx, const float* UE_RESTRICT by, const float* UE_RESTRICT bz, const float* UE_RESTRICT bw, float* UE_RESTRICT out, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+}
+
+static void lengthArrays(const float* UE_RESTRICT x, const float* UE_RESTRICT y, const float* UE_RESTRICT z, float* UE_RESTRICT out, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        out[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+}
+
+static void crossArrays(const float* UE_RESTRICT ax, const float* UE_RESTRICT ay, const float* UE_RESTRICT az, const float* UE_RESTRICT bx, const float* UE_RESTRICT by, const float* UE_RESTRICT bz, float* UE_RESTRICT ox, float* UE_RESTRICT oy, float* UE_RESTRICT oz, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ox[i] = ay[i] * bz[i] - az[i] * by[i];
+        oy[i] = az[i] * bx[i] - ax[i] * bz[i];
+        oz[i] = ax[i] * by[i] - ay[i] * bx[i];
+    }
+}
+
+static void normaliseArrays(float* UE_RESTRICT x, float* UE_RESTRICT y, float* UE_RESTRICT z, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float scale = invLength(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        x[i] *= scale;
+        y[i] *= scale;
+        z[i] *= scale;
+    }
+}
+
+static void normaliseArrays(float* UE_RESTRICT x, float* UE_RESTRICT y, float* UE_RESTRICT z, float* UE_RESTRICT w, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float scale = invLength(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        x[i] *= scale;
+        y[i] *= scale;
+        z[i] *= scale;
+        w[i] *= scale;
+    }
+}
+
+static void multiplyQuaternionArrays(const float* UE_RESTRICT ax, const float* UE_RESTRICT ay, const float* UE_RESTRICT az, const float* UE_RESTRICT aw, const float* UE_RESTRICT bx, const float* UE_RESTRICT by, const float* UE_RESTRICT bz, const float* UE_RESTRICT bw, float* UE_RESTRICT ox, float* UE_RESTRICT oy, float* UE_RESTRICT oz, float* UE_RESTRICT ow, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ox[i] = ax[i] * bw[i] + aw[i] * bx[i] + ay[i] * bz[i] - az[i] * by[i];
+        oy[i] = ay[i] * bw[i] + aw[i] * by[i] + az[i] * bx[i] - ax[i] * bz[i];
+        oz[i] = az[i] * bw[i] + aw[i] * bz[i] + ax[i] * by[i] - ay[i] * bx[i];
+        ow[i] = aw[i] * bw[i] - ax[i] * bx[i] - ay[i] * by[i] - az[i] * bz[i];
+    }
+}
+
+static void rotateArrays(const float* UE_RESTRICT qx, const float* UE_RESTRICT qy, const float* UE_RESTRICT qz, const float* UE_RESTRICT qw, const float* UE_RESTRICT vx, const float* UE_RESTRICT vy, const float* UE_RESTRICT vz, float* UE_RESTRICT ox, float* UE_RESTRICT oy, float* UE_RESTRICT oz, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        // Same as Quaternion::rotate with u = (qx, qy, qz) and s = qw
+        float uDotV  = qx[i] * vx[i] + qy[i] * vy[i] + qz[i] * vz[i];
+        float uDotU  = qx[i] * qx[i] + qy[i] * qy[i] + qz[i] * qz[i];
+        float a      = 2.0f * uDotV;
+        float b      = qw[i] * qw[i] - uDotU;
+        float c      = 2.0f * qw[i];
+        float crossX = qy[i] * vz[i] - qz[i] * vy[i];
+        float crossY = qz[i] * vx[i] - qx[i] * vz[i];
+        float crossZ = qx[i] * vy[i] - qy[i] * vx[i];
+        ox[i]        = qx[i] * a + vx[i] * b + crossX * c;
+        oy[i]        = qy[i] * a + vy[i] * b + crossY * c;
+        oz[i]        = qz[i] * a + vz[i] * b + crossZ * c;
+    }
+}
+
+static void nlerpArrays(const float* UE_RESTRICT ax, const float* UE_RESTRICT ay, const float* UE_RESTRICT az, const float* UE_RESTRICT aw, const float* UE_RESTRICT bx, const float* UE_RESTRICT by, const float* UE_RESTRICT bz, const float* UE_RESTRICT bw, float factor, float* UE_RESTRICT ox, float* UE_RESTRICT oy, float* UE_RESTRICT oz, float* UE_RESTRICT ow, size_t count) {
+    float factorA = 1.0f - factor;
+    for (size_t i = 0; i < count; ++i) {
+        // Flip the second quaternion when needed to take the shortest path
+        float dot     = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+        float factorB = dot < 0.0f ? -factor : factor;
+
+        float resultX = ax[i] * factorA + bx[i] * factorB;
+        float resultY = ay[i] * factorA + by[i] * factorB;
+        float resultZ = az[i] * factorA + bz[i] * factorB;
+        float resultW = aw[i] * factorA + bw[i] * factorB;
+        float scale   = invLength(resultX * resultX + resultY * resultY + resultZ * resultZ + resultW * resultW);
+
+        ox[i] = resultX * scale;
+        oy[i] = resultY * scale;
+        oz[i] = resultZ * scale;
+        ow[i] = resultW * scale;
+    }
+}
+
+/*****************************************************************************
+ * Vector3Stream class
+ *****************************************************************************/
+
+void Vector3Stream::checkSize(const Vector3Stream& other, const std::string& operation) const {
+    if (other.size() != size())
+        Logger::logAndThrowError("Cannot " + operation + " streams of different sizes (" + utils_string::str(size()) + " and " + utils_string::str(other.size()) + ")", "Vector3Stream");
+}
+
+void Vector3Stream::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+}
+
+void Vector3Stream::reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+}
+
+void Vector3Stream::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+void Vector3Stream::append(const Vector3f& value) {
+    x.push_back(value.getX());
+    y.push_back(value.getY());
+    z.push_back(value.getZ());
+}
+
+void Vector3Stream::assign(const Vector3f* values, size_t count) {
+    resize(count);
+    for (size_t i = 0; i < count; ++i)
+        set(i, values[i]);
+}
+
+void Vector3Stream::copyTo(Vector3f* values) const {
+    for (size_t i = 0; i < size(); ++i)
+        values[i] = get(i);
+}
+
+std::vector<Vector3f> Vector3Stream::toVectors() const {
+    std::vector<Vector3f> values(size());
+    copyTo(values.data());
+    return values;
+}
+
+void Vector3Stream::add(const Vector3Stream& other) {
+    checkSize(other, "add");
+    addArray(x.data(), other.x.data(), size());
+    addArray(y.data(), other.y.data(), size());
+    addArray(z.data(), other.z.data(), size());
+}
+
+void Vector3Stream::addScaled(const Vector3Stream& other, float factor) {
+    checkSize(other, "add");
+    addScaledArray(x.data(), other.x.data(), factor, size());
+    addScaledArray(y.data(), other.y.data(), factor, size());
+    addScaledArray(z.data(), other.z.data(), factor, size());
+}
+
+void Vector3Stream::subtract(const Vector3Stream& other) {
+    checkSize(other, "subtract");
+    subtractArray(x.data(), other.x.data(), size());
+    subtractArray(y.data(), other.y.data(), size());
+    subtractArray(z.data(), other.z.data(), size());
+}
+
+void Vector3Stream::scale(float factor) {
+    scaleArray(x.data(), factor, size());
+    scaleArray(y.data(), factor, size());
+    scaleArray(z.data(), factor, size());
+}
+
+void Vector3Stream::scale(const float* factors) {
+    scaleArray(x.data(), factors, size());
+    scaleArray(y.data(), factors, size());
+    scaleArray(z.data(), factors, size());
+}
+
+void Vector3Stream::dot(const Vector3Stream& other, float* out) const {
+    checkSize(other, "dot");
+    dotArrays(x.data(), y.data(), z.data(), other.x.data(), other.y.data(), other.z.data(), out, size());
+}
+
+void Vector3Stream::lengths(float* out) const {
+    lengthArrays(x.data(), y.data(), z.data(), out, size());
+}
+
+void Vector3Stream::cross(const Vector3Stream& other, Vector3Stream& out) const {
+    checkSize(other, "cross");
+    out.resize(size());
+    crossArrays(x.data(), y.data(), z.data(), other.x.data(), other.y.data(), other.z.data(), out.x.data(), out.y.data(), out.z.data(), size());
+}
+
+void Vector3Stream::normalise() {
+    normaliseArrays(x.data(), y.data(), z.data(), size());
+}
+
+void Vector3Stream::lerp(const Vector3Stream& streamA, const Vector3Stream& streamB, float factor, Vector3Stream& out) {
+    streamA.checkSize(streamB, "lerp");
+    out.resize(streamA.size());
+    lerpArray(streamA.x.data(), streamB.x.data(), factor, out.x.data(), streamA.size());
+    lerpArray(streamA.y.data(), streamB.y.data(), factor, out.y.data(), streamA.size());
+    lerpArray(streamA.z.data(), streamB.z.data(), factor, out.z.data(), streamA.size());
+}
+
+/*****************************************************************************
+ * QuaternionStream class
+ *****************************************************************************/
+
+void QuaternionStream::checkSize(size_t otherSize, const std::string& operation) const {
+    if (otherSize != size())
+        Logger::logAndThrowError("Cannot " + operation + " streams of different sizes (" + utils_string::str(size()) + " and " + utils_string::str(otherSize) + ")", "QuaternionStream");
+}
+
+void QuaternionStream::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    w.resize(count);
+}
+
+void QuaternionStream::reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+    w.reserve(count);
+}
+
+void QuaternionStream::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    w.clear();
+}
+
+void QuaternionStream::append(const Quaternion& value) {
+    x.push_back(value.getX());
+    y.push_back(value.getY());
+    z.push_back(value.getZ());
+    w.push_back(value.getW());
+}
+
+void QuaternionStream::assign(const Quaternion* values, size_t count) {
+    resize(count);
+    for (size_t i = 0; i < count; ++i)
+        set(i, values[i]);
+}
+
+void QuaternionStream::copyTo(Quaternion* values) const {
+    for (size_t i = 0; i < size(); ++i)
+        values[i] = get(i);
+}
+
+std::vector<Quaternion> QuaternionStream::toQuaternions() const {
+    std::vector<Quaternion> values(size());
+    copyTo(values.data());
+    return values;
+}
+
+void QuaternionStream::dot(const QuaternionStream& other, float* out) const {
+    checkSize(other.size(), "dot");
+    dotArrays(x.data(), y.data(), z.data(), w.data(), other.x.data(), other.y.data(), other.z.data(), other.w.data(), out, size());
+}
+
+void QuaternionStream::normalise() {
+    normaliseArrays(x.data(), y.data(), z.data(), w.data(), size());
+}
+
+void QuaternionStream::multiply(const QuaternionStream& other, QuaternionStream& out) const {
+    checkSize(other.size(), "multiply");
+    out.resize(size());
+    multiplyQuaternionArrays(x.data(), y.data(), z.data(), w.data(), other.x.data(), other.y.data(), other.z.data(), other.w.data(), out.x.data(), out.y.data(), out.z.data(), out.w.data(), size());
+}
+
+void QuaternionStream::rotate(const Vector3Stream& vectors, Vector3Stream& out) const {
+    checkSize(vectors.size(), "rotate");
+    out.resize(size());
+    rotateArrays(x.data(), y.data(), z.data(), w.data(), vectors.getX(), vectors.getY(), vectors.getZ(), out.getX(), out.getY(), out.getZ(), size());
+}
+
+void QuaternionStream::nlerp(const QuaternionStream& streamA, const QuaternionStream& streamB, float factor, QuaternionStream& out) {
+    streamA.checkSize(streamB.size(), "nlerp");
+    out.resize(streamA.size());
+    nlerpArrays(streamA.x.data(), streamA.y.data(), streamA.z.data(), streamA.w.data(), streamB.x.data(), streamB.y.data(), streamB.z.data(), streamB.w.data(), factor, out.x.data(), out.y.data(), out.z.data(), out.w.data(), streamA.size());
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <vector>
+
+#include "Quaternion.h"
+#include "SIMD.h"
+
+/*****************************************************************************
+ * Vector3Stream class - Stores a large number of 3D vectors as a structure of
+ *                       arrays (the x, y and z components are each kept in
+ *                       their own aligned array) so that operations on all of
+ *                       them can be vectorised
+ *****************************************************************************/
+
+// The bulk operations are written as plain loops over the component arrays so
+// the compiler can use the widest SIMD instructions the build targets (8
+// floats per instruction with AVX, 16 with AVX-512 - those using square roots
+// also need -fno-math-errno on GCC/Clang, and GCC only vectorises any of them
+// from -O3 or with -fvect-cost-model=dynamic as its -O2 cost model skips
+// loops that need a remainder). Operations taking another stream require it
+// to have the same size.
+
+class Vector3Stream {
+private:
+    /* Components of each vector */
+    utils_simd::AlignedVector<float> x;
+    utils_simd::AlignedVector<float> y;
+    utils_simd::AlignedVector<float> z;
+
+    /* Ensures another stream is the same size as this one */
+    void checkSize(const Vector3Stream& other, const std::string& operation) const;
+
+public:
+    /* Constructors */
+    Vector3Stream() {}
+    explicit Vector3Stream(size_t count) { resize(count); }
+    Vector3Stream(const Vector3f* values, size_t count) { assign(values, count); }
+    Vector3Stream(const std::vector<Vector3f>& values) { assign(values.data(), values.size()); }
+
+    /* Destructor */
+    virtual ~Vector3Stream() {}
+
+    /* Methods to manage the number of vectors */
+    void resize(size_t count);
+    void reserve(size_t count);
+    void clear();
+    inline size_t size() const { return x.size(); }
+
+    /* Adds a vector to the end of this stream */
+    void append(const Vector3f& value);
+
+    /* Replaces the contents of this stream with the given vectors */
+    void assign(const Vector3f* values, size_t count);
+
+    /* Copies the contents of this stream into an array of vectors (which must
+       have room for size() values) */
+    void copyTo(Vector3f* values) const;
+
+    /* Returns the contents of this stream as vectors */
+    std::vector<Vector3f> toVectors() const;
+
+    /* Obtains/assigns a single vector */
+    inline Vector3f get(size_t index) const { return Vector3f(x[index], y[index], z[index]); }
+    inline void set(size_t index, const Vector3f& value) {
+        x[index] = value.getX();
+        y[index] = value.getY();
+        z[index] = value.getZ();
+    }
+
+    /* Adds another stream to this one */
+    void add(const Vector3Stream& other);
+
+    /* Adds another stream multiplied by a scalar to this one (e.g. to apply
+       velocities to positions) */
+    void addScaled(const Vector3Stream& other, float factor);
+
+    /* Subtracts another stream from this one */
+    void subtract(const Vector3Stream& other);
+
+    /* Multiplies every vector by a scalar */
+    void scale(float factor);
+
+    /* Multiplies each vector by a corresponding scalar (factors must have
+       size() values) */
+    void scale(const float* factors);
+
+    /* Computes the dot product of each vector with the corresponding one in
+       another stream (out must have room for size() values) */
+    void dot(const Vector3Stream& other, float* out) const;
+
+    /* Computes the length of each vector (out must have room for size()
+       values) */
+    void lengths(float* out) const;
+
+    /* Computes the cross product of each vector with the corresponding one in
+       another stream (out is resized if needed and may not be either input) */
+    void cross(const Vector3Stream& other, Vector3Stream& out) const;
+
+    /* Normalises every vector (zero length vectors are left as zero) */
+    void normalise();
+
+    /* Linear interpolation between corresponding vectors in two streams (out
+       is resized if needed) */
+    static void lerp(const Vector3Stream& streamA, const Vector3Stream& streamB, float factor, Vector3Stream& out);
+
+    /* Returns pointers to each component array */
+    inline float* getX() { return x.data(); }
+    inline float* getY() { return y.data(); }
+    inline float* getZ() { return z.data(); }
+    inline const float* getX() const { return x.data(); }
+    inline const float* getY() const { return y.data(); }
+    inline const float* getZ() const { return z.data(); }
+};
+
+/*****************************************************************************
+ * QuaternionStream class - Stores a large number of quaternions as a
+ *                          structure of arrays
+ *****************************************************************************/
+
+class QuaternionStream {
+private:
+    /* Components of each quaternion */
+    utils_simd::AlignedVector<float> x;
+    utils_simd::AlignedVector<float> y;
+    utils_simd::AlignedVector<float> z;
+    utils_simd::AlignedVector<float> w;
+
+    /* Ensures another stream is the same size as this one */
+    void checkSize(size_t otherSize, const std::string& operation) const;
+
+public:
+    /* Constructors */
+    QuaternionStream() {}
+    explicit QuaternionStream(size_t count) { resize(count); }
+    QuaternionStream(const Quaternion* values, size_t count) { assign(values, count); }
+    QuaternionStream(const std::vector<Quaternion>& values) { assign(values.data(), values.size()); }
+
+    /* Destructor */
+    virtual ~QuaternionStream() {}
+
+    /* Methods to manage the number of quaternions */
+    void resize(size_t count);
+    void reserve(size_t count);
+    void clear();
+    inline size_t size() const { return x.size(); }
+
+    /* Adds a quaternion to the end of this stream */
+    void append(const Quaternion& value);
+
+    /* Replaces the contents of this stream with the given quaternions */
+    void assign(const Quaternion* values, size_t count);
+
+    /* Copies the contents of this stream into an array of quaternions (which
+       must have room for size() values) */
+    void copyTo(Quaternion* values) const;
+
+    /* Returns the contents of this stream as quaternions */
+    std::vector<Quaternion> toQuaternions() const;
+
+    /* Obtains/assigns a single quaternion */
+    inline Quaternion get(size_t index) const { return Quaternion(x[index], y[index], z[index], w[index]); }
+    inline void set(size_t index, const Quaternion& value) {
+        x[index] = value.getX();
+        y[index] = value.getY();
+        z[index] = value.getZ();
+        w[index] = value.getW();
+    }
+
+    /* Computes the dot product of each quaternion with the corresponding one
+       in another stream (out must have room for size() values) */
+    void dot(const QuaternionStream& other, float* out) const;
+
+    /* Normalises every quaternion */
+    void normalise();
+
+    /* Multiplies each quaternion by the corresponding one in another stream
+       (as Quaternion::operator*, out is resized if needed and may not be
+       either input) */
+    void multiply(const QuaternionStream& other, QuaternionStream& out) const;
+
+    /* Rotates each vector by the corresponding quaternion (as
+       Quaternion::rotate, out is resized if needed and may not be
+       vectors) */
+    void rotate(const Vector3Stream& vectors, Vector3Stream& out) const;
+
+    /* Normalised linear interpolation between corresponding quaternions in
+       two streams, taking the shortest path (out is resized if needed and
+       may not be either input) */
+    static void nlerp(const QuaternionStream& streamA, const QuaternionStream& streamB, float factor, QuaternionStream& out);
+
+    /* Returns pointers to each component array */
+    inline float* getX() { return x.data(); }
+    inline float* getY() { return y.data(); }
+    inline float* getZ() { return z.data(); }
+    inline float* getW() { return w.data(); }
+    inline const float* getX() const { return x.data(); }
+    inline const float* getY() const { return y.data(); }
+    inline const float* getZ() const { return z.data(); }
+    inline const float* getW() const { return w.data(); }
+};
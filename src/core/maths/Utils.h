@@ -4,40 +4,181 @@
  * Various maths utilities
  *****************************************************************************/
 
+#include <cfloat>
 #include <cmath>
+#include <type_traits>
+
+#include "SIMD.h"
 
 namespace utils_maths {
-    const float PI = 3.14159265f;
+    constexpr float PI = 3.14159265f;
 
     /* Angle conversions */
-    inline float toRadians(float degrees) { return degrees * (PI / 180.0f); }
-    inline float toDegrees(float radians) { return radians * (180.0f / PI); }
+    inline constexpr float toRadians(float degrees) { return degrees * (PI / 180.0f); }
+    inline constexpr float toDegrees(float radians) { return radians * (180.0f / PI); }
 
     /* Clamp a value between a given minimum and maximum */
     template <typename T>
-    inline T clamp(T value, T min, T max) {
+    inline constexpr T clamp(T value, T min, T max) {
         return value < min ? min : value > max ? max
                                                : value;
     }
 
     /* Find min/max of two values */
     template <typename T>
-    inline T min(T value1, T value2) {
+    inline constexpr T min(T value1, T value2) {
         return value1 < value2 ? value1 : value2;
     }
 
     template <typename T>
-    inline T max(T value1, T value2) {
+    inline constexpr T max(T value1, T value2) {
         return value1 > value2 ? value1 : value2;
     }
 
     /* Absolute value of a value */
     template <typename T>
-    inline T abs(T value) {
+    inline constexpr T abs(T value) {
         return value < 0 ? -value : value;
     }
 
     /* Linear interpolation between two values */
     template <typename T>
-    inline T lerp(T valueA, T valueB, T factor) { return (valueA + ((valueB - valueA) * factor)); }
+    inline constexpr T lerp(T valueA, T valueB, T factor) { return (valueA + ((valueB - valueA) * factor)); }
+
+    /*************************************************************************
+     * Precision policies - Functions below take one of these as a template
+     *                      parameter to choose between the standard library
+     *                      and faster approximations. The default can be
+     *                      changed for the whole engine by defining
+     *                      UE_FAST_MATHS.
+     *************************************************************************/
+
+    /* Uses the standard library functions */
+    struct Precise {};
+
+    /* Uses approximations that are accurate to within the bounds given for
+       each function (and are only defined for floats) */
+    struct Fast {};
+
+#ifdef UE_FAST_MATHS
+    using DefaultPrecision = Fast;
+#else
+    using DefaultPrecision = Precise;
+#endif
+
+    /* States whether a precision policy uses the approximations */
+    template <typename Precision>
+    constexpr bool isFast() { return std::is_same_v<Precision, Fast>; }
+
+    /* Returns 1 / sqrt(value) - the fast version uses the hardware estimate
+       refined by Newton-Raphson and has a relative error below 5e-7 (without
+       SSE there is no estimate that beats a division so it is exact) */
+    template <typename Precision = DefaultPrecision>
+    inline float reciprocalSqrt(float value) {
+        if constexpr (isFast<Precision>()) {
+#ifdef UE_SIMD_SSE
+            float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(value)));
+            return estimate * (1.5f - 0.5f * value * estimate * estimate);
+#endif
+        }
+        return 1.0f / sqrtf(value);
+    }
+
+    /* Returns sqrt(value) - the fast version uses reciprocalSqrt (so has the
+       same relative error) and returns 0 for 0 */
+    template <typename Precision = DefaultPrecision>
+    inline float sqrt(float value) {
+        if constexpr (isFast<Precision>())
+            return value * reciprocalSqrt<Fast>(max(value, FLT_MIN));
+        else
+            return sqrtf(value);
+    }
+
+    /* Computes the sine and cosine of an angle (in radians) together - the
+       fast version reduces the angle to [-PI/4, PI/4] and evaluates minimax
+       polynomials for both, giving an absolute error below 2e-7 for angles
+       up to 10^4 in magnitude (beyond which the range reduction loses
+       precision) */
+    template <typename Precision = DefaultPrecision>
+    inline void sincos(float angle, float& sine, float& cosine) {
+        if constexpr (isFast<Precision>()) {
+            // Nearest multiple of PI/2 (subtracted in 3 parts to avoid losing
+            // precision)
+            int quadrant = static_cast<int>(angle * 0.636619772f + (angle < 0.0f ? -0.5f : 0.5f));
+            float q      = static_cast<float>(quadrant);
+            float x      = ((angle - q * 1.5703125f) - q * 4.837512969970703125e-4f) - q * 7.54978995489188216e-8f;
+            float x2     = x * x;
+
+            float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+            float c = 1.0f - 0.5f * x2 + x2 * x2 * (4.166664568298827e-2f + x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+
+            // Swap and negate the results depending on the quadrant (written
+            // as selects rather than a switch to avoid mispredicted branches)
+            bool swap = quadrant & 1;
+            sine      = swap ? c : s;
+            cosine    = swap ? s : c;
+            sine      = (quadrant & 2) ? -sine : sine;
+            cosine    = ((quadrant + 1) & 2) ? -cosine : cosine;
+        } else {
+            sine   = sinf(angle);
+            cosine = cosf(angle);
+        }
+    }
+
+    /* Returns the sine/cosine of an angle (in radians) - the fast versions
+       are as accurate as sincos */
+    template <typename Precision = DefaultPrecision>
+    inline float sin(float angle) {
+        if constexpr (isFast<Precision>()) {
+            float sine, cosine;
+            sincos<Fast>(angle, sine, cosine);
+            return sine;
+        } else
+            return sinf(angle);
+    }
+
+    template <typename Precision = DefaultPrecision>
+    inline float cos(float angle) {
+        if constexpr (isFast<Precision>()) {
+            float sine, cosine;
+            sincos<Fast>(angle, sine, cosine);
+            return cosine;
+        } else
+            return cosf(angle);
+    }
+
+    /* Returns the arc cosine of a value in [-1, 1] (in radians) - the fast
+       version uses a polynomial from Abramowitz and Stegun (4.4.46) and has
+       an absolute error below 5e-7 */
+    template <typename Precision = DefaultPrecision>
+    inline float acos(float value) {
+        if constexpr (isFast<Precision>()) {
+            float x      = abs(value);
+            float result = sqrtf(1.0f - x) * (1.5707963050f + x * (-0.2145988016f + x * (0.0889789874f + x * (-0.0501743046f + x * (0.0308918810f + x * (-0.0170881256f + x * (0.0066700901f + x * -0.0012624911f)))))));
+            return value < 0.0f ? PI - result : result;
+        } else
+            return acosf(value);
+    }
+
+    /* Returns the angle of the vector (x, y) from the x axis (in radians) -
+       the fast version evaluates a minimax polynomial for atan over [0, 1]
+       and has an absolute error below 2.5e-6 */
+    template <typename Precision = DefaultPrecision>
+    inline float atan2(float y, float x) {
+        if constexpr (isFast<Precision>()) {
+            float absX    = abs(x);
+            float absY    = abs(y);
+            float largest = max(absX, absY);
+            float t       = largest > 0.0f ? min(absX, absY) / largest : 0.0f;
+            float t2      = t * t;
+
+            float result = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+            if (absY > absX)
+                result = PI / 2.0f - result;
+            if (x < 0.0f)
+                result = PI - result;
+            return y < 0.0f ? -result : result;
+        } else
+            return atan2f(y, x);
+    }
 }  // namespace utils_maths
\ No newline at end of file
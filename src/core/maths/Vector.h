@@ -1,8 +1,10 @@
 #pragma once
 
-#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include "../../utils/StringUtils.h"
+#include "SIMD.h"
 #include "Utils.h"
 
 /*****************************************************************************
@@ -14,118 +16,179 @@
 template <typename T, unsigned int N>
 class Vector {
 protected:
-    /* Always initialise member variables */
-    T values[N]{};
+    /* Always initialise member variables (4 component float vectors are
+       aligned so they can be loaded straight into SIMD registers) */
+    alignas(utils_simd::alignmentFor<T, N>()) T values[N]{};
+
+    /* Loads/stores the values of this vector to/from a SIMD register (only
+       valid when utils_simd::usable<T, N>()) */
+    inline utils_simd::Float4 loadSIMD() const { return utils_simd::Float4::load(values); }
+    inline void storeSIMD(const utils_simd::Float4& value) { value.store(values); }
+
+    /* Returns a vector with each value given by function(i) (expanded at
+       compile time, so the values are computed straight into the result
+       without a loop) */
+    template <typename Function, size_t... I>
+    static inline constexpr Vector<T, N> generate(Function function, std::index_sequence<I...>) { return Vector<T, N>(function(I)...); }
+
+    template <typename Function>
+    static inline constexpr Vector<T, N> generate(Function function) { return generate(function, std::make_index_sequence<N>()); }
+
+    /* Returns a vector with the values in a SIMD register */
+    static inline Vector<T, N> fromSIMD(const utils_simd::Float4& value) {
+        Vector<T, N> result;
+        result.storeSIMD(value);
+        return result;
+    }
 
 public:
     /* Constructor */
-    Vector() {}
-
-    /* Constructor taking an initial value */
-    Vector(const std::initializer_list<T>& values) {
-        // Ensure correct size
-        if (values.size() != N)
-            throw std::invalid_argument("Incorrect number of elements");
-        std::copy(values.begin(), values.end(), this->values);
-    }
+    constexpr Vector() {}
+
+    /* Constructor taking an initial value for each element (the number of
+       values is checked at compile time) */
+    template <typename... Values, typename = std::enable_if_t<sizeof...(Values) == N && std::conjunction_v<std::is_convertible<Values, T>...>>>
+    constexpr Vector(const Values... components) : values{static_cast<T>(components)...} {}
 
     /* Operations for obtaining/assigning values */
-    inline T& operator[](unsigned int idx) { return this->values[idx]; }
-    inline const T& operator[](unsigned int idx) const { return this->values[idx]; }
+    inline constexpr T& operator[](unsigned int idx) { return this->values[idx]; }
+    inline constexpr const T& operator[](unsigned int idx) const { return this->values[idx]; }
 
     /* Adds another vector to this one and returns the result */
-    inline Vector<T, N> operator+(const Vector<T, N>& other) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] + other[i];
-        return result;
+    inline constexpr Vector<T, N> operator+(const Vector<T, N>& other) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() + other.loadSIMD());
+        }
+        return generate([&](size_t i) { return this->values[i] + other[i]; });
     }
 
     /* Subtracts another vector from this one and returns the result */
-    inline Vector<T, N> operator-(const Vector<T, N>& other) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] - other[i];
-        return result;
+    inline constexpr Vector<T, N> operator-(const Vector<T, N>& other) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() - other.loadSIMD());
+        }
+        return generate([&](size_t i) { return this->values[i] - other[i]; });
     }
 
     /* Returns the result of element-wise multiplication of this vector by another*/
-    inline Vector<T, N> operator*(const Vector<T, N>& other) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] * other[i];
-        return result;
+    inline constexpr Vector<T, N> operator*(const Vector<T, N>& other) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() * other.loadSIMD());
+        }
+        return generate([&](size_t i) { return this->values[i] * other[i]; });
     }
 
     /* Returns the result of element-wise division of this vector by another*/
-    inline Vector<T, N> operator/(const Vector<T, N>& other) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] / other[i];
-        return result;
+    inline constexpr Vector<T, N> operator/(const Vector<T, N>& other) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() / other.loadSIMD());
+        }
+        return generate([&](size_t i) { return this->values[i] / other[i]; });
     }
 
     /* Adds another vector to this one */
-    inline Vector<T, N>& operator+=(const Vector<T, N>& other) {
+    inline constexpr Vector<T, N>& operator+=(const Vector<T, N>& other) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() + other.loadSIMD());
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
             this->values[i] = this->values[i] + other[i];
         return *this;
     }
 
     /* Subtracts another vector from this one */
-    inline Vector<T, N>& operator-=(const Vector<T, N>& other) {
+    inline constexpr Vector<T, N>& operator-=(const Vector<T, N>& other) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() - other.loadSIMD());
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
             this->values[i] = this->values[i] - other[i];
         return *this;
     }
 
     /* Element-wise multiplication of this vector by another one */
-    inline Vector<T, N>& operator*=(const Vector<T, N>& other) {
+    inline constexpr Vector<T, N>& operator*=(const Vector<T, N>& other) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() * other.loadSIMD());
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
             this->values[i] = this->values[i] * other[i];
         return *this;
     }
 
     /* Element-wise division of this vector by another one */
-    inline Vector<T, N>& operator/=(const Vector<T, N>& other) {
+    inline constexpr Vector<T, N>& operator/=(const Vector<T, N>& other) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() / other.loadSIMD());
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
-            this->values[i] = this->values[i] * other[i];
+            this->values[i] = this->values[i] / other[i];
         return *this;
     }
 
     /* Multiplies this vector by a scalar and returns the result */
-    inline Vector<T, N> operator*(const T& scalar) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] * scalar;
-        return result;
+    inline constexpr Vector<T, N> operator*(const T& scalar) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() * utils_simd::Float4::set1(scalar));
+        }
+        return generate([&](size_t i) { return this->values[i] * scalar; });
     }
 
     /* Divides this vector by a scalar and returns the result */
-    inline Vector<T, N> operator/(const T& scalar) const {
-        Vector<T, N> result;
-        for (unsigned int i = 0; i < N; ++i)
-            result[i] = this->values[i] / scalar;
-        return result;
+    inline constexpr Vector<T, N> operator/(const T& scalar) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(loadSIMD() / utils_simd::Float4::set1(scalar));
+        }
+        return generate([&](size_t i) { return this->values[i] / scalar; });
     }
 
     /* Multiplies this vector by a scalar */
-    inline Vector<T, N>& operator*=(const T& scalar) {
+    inline constexpr Vector<T, N>& operator*=(const T& scalar) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() * utils_simd::Float4::set1(scalar));
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
             this->values[i] = this->values[i] * scalar;
         return *this;
     }
 
     /* Divides this vector by a scalar */
-    inline Vector<T, N>& operator/=(const T& scalar) {
+    inline constexpr Vector<T, N>& operator/=(const T& scalar) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated()) {
+                storeSIMD(loadSIMD() / utils_simd::Float4::set1(scalar));
+                return *this;
+            }
+        }
         for (unsigned int i = 0; i < N; ++i)
-            this->values[i] = this->values[i] * scalar;
+            this->values[i] = this->values[i] / scalar;
         return *this;
     }
 
     /* Compares this vector to another one and returns whether they are equal
        or not */
-    inline bool operator==(const Vector<T, N>& other) {
+    inline constexpr bool operator==(const Vector<T, N>& other) const {
         // Return false if any element isn't equal
         for (unsigned int i = 0; i < N; ++i) {
             if (other[i] != values[i])
@@ -134,47 +197,106 @@ public:
         return true;
     }
 
-    /* Returns the length of this vector */
+    /* Returns the length of this vector (the precision policy is only used
+       for floats - see utils_maths::Fast) */
+    template <typename Precision = utils_maths::DefaultPrecision>
     inline T length() const {
-        T total = 0;
-        // Add on square of each value to the total
-        for (unsigned int i = 0; i < N; ++i)
-            total += (this->values[i] * this->values[i]);
-        // Return length
-        return sqrt(total);
+        // Length is the square root of the sum of the squares of each value
+        if constexpr (std::is_same_v<T, float>)
+            return utils_maths::sqrt<Precision>(this->dot(*this));
+        else
+            return sqrt(this->dot(*this));
     }
 
     /* Other comparison operators */
-    inline bool operator!=(const Vector<T, N>& other) const { return ((*this) == other); }
+    inline constexpr bool operator!=(const Vector<T, N>& other) const { return ! ((*this) == other); }
     inline bool operator<(const Vector<T, N>& other) const { return this->length() < other.length(); }
     inline bool operator<=(const Vector<T, N>& other) const { return this->length() <= other.length(); }
     inline bool operator>(const Vector<T, N>& other) const { return this->length() > other.length(); }
     inline bool operator>=(const Vector<T, N>& other) const { return this->length() >= other.length(); }
 
     /* Returns the dot product of this and another vector */
-    inline T dot(const Vector<T, N>& other) const {
+    inline constexpr T dot(const Vector<T, N>& other) const {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return utils_simd::dot4(loadSIMD(), other.loadSIMD()).first();
+        }
         T result = 0;
         for (unsigned int i = 0; i < N; ++i)
             result += this->values[i] * other[i];
         return result;
     }
 
-    /* Normalises this vector */
+    /* Normalises this vector (when it fits in a SIMD register both precision
+       policies use the exact version, as a square root and division of
+       every lane at once are no slower than refining an estimate of the
+       reciprocal square root) */
+    template <typename Precision = utils_maths::DefaultPrecision>
     inline Vector<T, N>& normalise() {
-        T length = this->length();
-        for (unsigned int i = 0; i < N; ++i)
-            values[i] /= length;
+        if constexpr (utils_simd::usable<T, N>()) {
+            utils_simd::Float4 vector = loadSIMD();
+            storeSIMD(vector / utils_simd::sqrt(utils_simd::dot4(vector, vector)));
+        } else if constexpr (std::is_same_v<T, float> && utils_maths::isFast<Precision>()) {
+            // Multiply by the reciprocal rather than dividing each component
+            float scale = utils_maths::reciprocalSqrt<Precision>(this->dot(*this));
+            for (unsigned int i = 0; i < N; ++i)
+                values[i] *= scale;
+        } else {
+            T length = this->template length<Precision>();
+            for (unsigned int i = 0; i < N; ++i)
+                values[i] /= length;
+        }
         return (*this);
     }
 
     /* Returns this vector but normalised (without changing the result of this one) */
+    template <typename Precision = utils_maths::DefaultPrecision>
     inline Vector<T, N> normalised() const {
         Vector<T, N> result = (*this);
-        return result.normalise();
+        return result.template normalise<Precision>();
+    }
+
+    // Fused operations - each computes a compound expression in a single
+    // pass without creating a temporary vector for every step (as writing
+    // it with the operators above would)
+
+    /* Returns the element-wise result of a * b + c */
+    inline static constexpr Vector<T, N> multiplyAdd(const Vector<T, N>& a, const Vector<T, N>& b, const Vector<T, N>& c) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(utils_simd::multiplyAdd(a.loadSIMD(), b.loadSIMD(), c.loadSIMD()));
+        }
+        return generate([&](size_t i) { return a[i] * b[i] + c[i]; });
+    }
+
+    /* Returns the result of a * scalar + b */
+    inline static constexpr Vector<T, N> multiplyAdd(const Vector<T, N>& a, T scalar, const Vector<T, N>& b) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(utils_simd::multiplyAdd(a.loadSIMD(), utils_simd::Float4::set1(scalar), b.loadSIMD()));
+        }
+        return generate([&](size_t i) { return a[i] * scalar + b[i]; });
+    }
+
+    /* Returns the result of a * scaleA + b * scaleB */
+    inline static constexpr Vector<T, N> linearCombination(const Vector<T, N>& a, T scaleA, const Vector<T, N>& b, T scaleB) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(utils_simd::multiplyAdd(a.loadSIMD(), utils_simd::Float4::set1(scaleA), b.loadSIMD() * utils_simd::Float4::set1(scaleB)));
+        }
+        return generate([&](size_t i) { return a[i] * scaleA + b[i] * scaleB; });
     }
 
     /* Linear interpolation between two vectors */
-    inline static Vector<T, N> lerp(const Vector<T, N>& vectorA, const Vector<T, N>& vectorB, T factor) { return (vectorA + ((vectorB - vectorA) * factor)); }
+    inline static constexpr Vector<T, N> lerp(const Vector<T, N>& vectorA, const Vector<T, N>& vectorB, T factor) {
+        if constexpr (utils_simd::usable<T, N>()) {
+            // Written as a single expression (a local Float4 would stop this
+            // being usable in constant expressions)
+            if (!utils_simd::isConstantEvaluated())
+                return fromSIMD(utils_simd::multiplyAdd(vectorB.loadSIMD() - vectorA.loadSIMD(), utils_simd::Float4::set1(factor), vectorA.loadSIMD()));
+        }
+        return generate([&](size_t i) { return vectorA[i] + (vectorB[i] - vectorA[i]) * factor; });
+    }
 
     /* Converts this vector to a string format */
     std::string toString() {
@@ -188,10 +310,10 @@ public:
     }
 
     /* Returns the number of elements in this vector */
-    inline int getNumElements() { return N * N; }
+    inline constexpr int getNumElements() const { return N; }
 
     /* Returns the size of this vector in bytes */
-    inline int getSize() { return N * sizeof(T); }
+    inline constexpr int getSize() const { return N * sizeof(T); }
 };
 
 /*****************************************************************************
@@ -200,16 +322,21 @@ public:
 
 template <unsigned int N>
 class VectorFloat {
+public:
     /* Spherical linear interpolation between two vectors
        This function is very specific to using floats */
+    template <typename Precision = utils_maths::DefaultPrecision>
     inline static Vector<float, N> slerp(const Vector<float, N>& vectorA, const Vector<float, N>& vectorB, float factor) {
         // https://keithmaggio.wordpress.com/2011/02/15/math-magician-lerp-slerp-and-nlerp/
         float dot                 = vectorA.dot(vectorB);
         dot                       = utils_maths::clamp(dot, -1.0f, 1.0f);
-        float theta               = acosf(dot) * factor;
-        Vector<float, N> relative = vectorB - vectorA * dot;
-        relative.normalise();
-        return ((vectorA * cosf(theta)) + (relative * sinf(theta)));
+        float theta               = utils_maths::acos<Precision>(dot) * factor;
+        Vector<float, N> relative = Vector<float, N>::multiplyAdd(vectorA, -dot, vectorB);
+        relative.template normalise<Precision>();
+
+        float sine, cosine;
+        utils_maths::sincos<Precision>(theta, sine, cosine);
+        return Vector<float, N>::linearCombination(vectorA, cosine, relative, sine);
     }
 };
 
@@ -218,20 +345,19 @@ template <typename T>
 class Vector2 : public Vector<T, 2> {
 public:
     /* Various constructors */
-    Vector2() {}
-    Vector2(const std::initializer_list<T>& values) : Vector<T, 2>(values) {}
-    Vector2(const T value) : Vector<T, 2>({value, value}) {}
-    Vector2(const T x, const T y) : Vector<T, 2>({x, y}) {}
-    Vector2(const Vector<T, 3>& base) : Vector<T, 2>({base[0], base[1]}) {}
+    constexpr Vector2() {}
+    constexpr Vector2(const T value) : Vector<T, 2>(value, value) {}
+    constexpr Vector2(const T x, const T y) : Vector<T, 2>(x, y) {}
+    constexpr Vector2(const Vector<T, 3>& base) : Vector<T, 2>(base[0], base[1]) {}
 
-    Vector2(const Vector<T, 2>& base) : Vector<T, 2>(base) {}
+    constexpr Vector2(const Vector<T, 2>& base) : Vector<T, 2>(base) {}
 
     /* Setters and getters */
-    inline void setX(T x) { this->values[0] = x; }
-    inline void setY(T y) { this->values[1] = y; }
+    inline constexpr void setX(T x) { this->values[0] = x; }
+    inline constexpr void setY(T y) { this->values[1] = y; }
 
-    inline T getX() const { return this->values[0]; }
-    inline T getY() const { return this->values[1]; }
+    inline constexpr T getX() const { return this->values[0]; }
+    inline constexpr T getY() const { return this->values[1]; }
 };
 
 /* 3-dimensional vector */
@@ -239,16 +365,15 @@ template <typename T>
 class Vector3 : public Vector<T, 3> {
 public:
     /* Various constructors */
-    Vector3() {}
-    Vector3(const std::initializer_list<T>& values) : Vector<T, 3>(values) {}
-    Vector3(const T value) : Vector<T, 3>({value, value, value}) {}
-    Vector3(const T x, const T y, const T z) : Vector<T, 3>({x, y, z}) {}
-    Vector3(const Vector<T, 2>& base, const T z) : Vector<T, 3>({base[0], base[1], z}) {}
+    constexpr Vector3() {}
+    constexpr Vector3(const T value) : Vector<T, 3>(value, value, value) {}
+    constexpr Vector3(const T x, const T y, const T z) : Vector<T, 3>(x, y, z) {}
+    constexpr Vector3(const Vector<T, 2>& base, const T z) : Vector<T, 3>(base[0], base[1], z) {}
 
-    Vector3(const Vector<T, 3>& base) : Vector<T, 3>(base) {}
+    constexpr Vector3(const Vector<T, 3>& base) : Vector<T, 3>(base) {}
 
     /* Performs a cross product with another vector and returns the result */
-    inline Vector3<T> cross(const Vector3<T>& other) const {
+    inline constexpr Vector3<T> cross(const Vector3<T>& other) const {
         return Vector3<T>(
             this->getY() * other.getZ() - getZ() * other.getY(),
             this->getZ() * other.getX() - getX() * other.getZ(),
@@ -256,13 +381,13 @@ public:
     }
 
     /* Setters and getters */
-    inline void setX(T x) { this->values[0] = x; }
-    inline void setY(T y) { this->values[1] = y; }
-    inline void setZ(T z) { this->values[3] = z; }
+    inline constexpr void setX(T x) { this->values[0] = x; }
+    inline constexpr void setY(T y) { this->values[1] = y; }
+    inline constexpr void setZ(T z) { this->values[2] = z; }
 
-    inline T getX() const { return this->values[0]; }
-    inline T getY() const { return this->values[1]; }
-    inline T getZ() const { return this->values[2]; }
+    inline constexpr T getX() const { return this->values[0]; }
+    inline constexpr T getY() const { return this->values[1]; }
+    inline constexpr T getZ() const { return this->values[2]; }
 };
 
 /* 4-dimensional vector */
@@ -270,25 +395,24 @@ template <typename T>
 class Vector4 : public Vector<T, 4> {
 public:
     /* Various constructors */
-    Vector4() {}
-    Vector4(const std::initializer_list<T>& values) : Vector<T, 4>(values) {}
-    Vector4(const T value) : Vector<T, 4>({value, value, value, value}) {}
-    Vector4(const T x, const T y, const T z, const T w) : Vector<T, 4>({x, y, z, w}) {}
-    Vector4(const Vector<T, 2>& base, const T z, const T w) : Vector<T, 4>({base[0], base[1], z, w}) {}
-    Vector4(const Vector<T, 3>& base, const T w) : Vector<T, 4>({base[0], base[1], base[2], w}) {}
+    constexpr Vector4() {}
+    constexpr Vector4(const T value) : Vector<T, 4>(value, value, value, value) {}
+    constexpr Vector4(const T x, const T y, const T z, const T w) : Vector<T, 4>(x, y, z, w) {}
+    constexpr Vector4(const Vector<T, 2>& base, const T z, const T w) : Vector<T, 4>(base[0], base[1], z, w) {}
+    constexpr Vector4(const Vector<T, 3>& base, const T w) : Vector<T, 4>(base[0], base[1], base[2], w) {}
 
-    Vector4(const Vector<T, 4>& base) : Vector<T, 4>(base) {}
+    constexpr Vector4(const Vector<T, 4>& base) : Vector<T, 4>(base) {}
 
     /* Setters and getters */
-    inline void setX(T x) { this->values[0] = x; }
-    inline void setY(T y) { this->values[1] = y; }
-    inline void setZ(T z) { this->values[2] = z; }
-    inline void setW(T w) { this->values[3] = w; }
-
-    inline T getX() const { return this->values[0]; }
-    inline T getY() const { return this->values[1]; }
-    inline T getZ() const { return this->values[2]; }
-    inline T getW() const { return this->values[3]; }
+    inline constexpr void setX(T x) { this->values[0] = x; }
+    inline constexpr void setY(T y) { this->values[1] = y; }
+    inline constexpr void setZ(T z) { this->values[2] = z; }
+    inline constexpr void setW(T w) { this->values[3] = w; }
+
+    inline constexpr T getX() const { return this->values[0]; }
+    inline constexpr T getY() const { return this->values[1]; }
+    inline constexpr T getZ() const { return this->values[2]; }
+    inline constexpr T getW() const { return this->values[3]; }
 };
 
 /*****************************************************************************
@@ -300,15 +424,14 @@ using Vector2i = Vector2<int>;
 class Vector2f : public Vector2<float>, public VectorFloat<2> {
 public:
     /* Various constructors */
-    Vector2f() {}
-    Vector2f(const std::initializer_list<float>& values) : Vector2<float>(values) {}
-    Vector2f(const float value) : Vector2<float>(value) {}
-    Vector2f(const float x, const float y) : Vector2<float>(x, y) {}
-    Vector2f(const Vector3<float>& base) : Vector2<float>({base.getX(), base.getY()}) {}
-    Vector2f(const Vector4<float>& base) : Vector2<float>({base.getX(), base.getY(), base.getZ()}) {}
-
-    Vector2f(const Vector<float, 2>& base) : Vector2<float>(base) {}
-    Vector2f(const Vector2<float>& base) : Vector2<float>(base) {}
+    constexpr Vector2f() {}
+    constexpr Vector2f(const float value) : Vector2<float>(value) {}
+    constexpr Vector2f(const float x, const float y) : Vector2<float>(x, y) {}
+    constexpr Vector2f(const Vector3<float>& base) : Vector2<float>(base.getX(), base.getY()) {}
+    constexpr Vector2f(const Vector4<float>& base) : Vector2<float>(base.getX(), base.getY()) {}
+
+    constexpr Vector2f(const Vector<float, 2>& base) : Vector2<float>(base) {}
+    constexpr Vector2f(const Vector2<float>& base) : Vector2<float>(base) {}
 };
 
 using Vector2d = Vector2<double>;
@@ -318,15 +441,14 @@ using Vector3i = Vector3<int>;
 class Vector3f : public Vector3<float>, public VectorFloat<3> {
 public:
     /* Various constructors */
-    Vector3f() {}
-    Vector3f(const std::initializer_list<float>& values) : Vector3<float>(values) {}
-    Vector3f(const float value) : Vector3<float>(value) {}
-    Vector3f(const float x, const float y, const float z) : Vector3<float>(x, y, z) {}
-    Vector3f(const Vector2<float>& base, const float z) : Vector3<float>(base, z) {}
-    Vector3f(const Vector4<float>& base) : Vector3<float>({base.getX(), base.getY(), base.getZ()}) {}
-
-    Vector3f(const Vector<float, 3>& base) : Vector3<float>(base) {}
-    Vector3f(const Vector3<float>& base) : Vector3<float>(base) {}
+    constexpr Vector3f() {}
+    constexpr Vector3f(const float value) : Vector3<float>(value) {}
+    constexpr Vector3f(const float x, const float y, const float z) : Vector3<float>(x, y, z) {}
+    constexpr Vector3f(const Vector2<float>& base, const float z) : Vector3<float>(base, z) {}
+    constexpr Vector3f(const Vector4<float>& base) : Vector3<float>(base.getX(), base.getY(), base.getZ()) {}
+
+    constexpr Vector3f(const Vector<float, 3>& base) : Vector3<float>(base) {}
+    constexpr Vector3f(const Vector3<float>& base) : Vector3<float>(base) {}
 };
 
 using Vector3d = Vector3<double>;
@@ -336,15 +458,14 @@ using Vector4i = Vector4<int>;
 class Vector4f : public Vector4<float>, public VectorFloat<4> {
 public:
     /* Various constructors */
-    Vector4f() {}
-    Vector4f(const std::initializer_list<float>& values) : Vector4<float>(values) {}
-    Vector4f(const float value) : Vector4<float>(value) {}
-    Vector4f(const float x, const float y, const float z, const float w) : Vector4<float>(x, y, z, w) {}
-    Vector4f(const Vector2<float>& base, const float z, const float w) : Vector4<float>(base, z, w) {}
-    Vector4f(const Vector3<float>& base, const float w) : Vector4<float>(base, w) {}
-
-    Vector4f(const Vector<float, 4>& base) : Vector4<float>(base) {}
-    Vector4f(const Vector4<float>& base) : Vector4<float>(base) {}
+    constexpr Vector4f() {}
+    constexpr Vector4f(const float value) : Vector4<float>(value) {}
+    constexpr Vector4f(const float x, const float y, const float z, const float w) : Vector4<float>(x, y, z, w) {}
+    constexpr Vector4f(const Vector2<float>& base, const float z, const float w) : Vector4<float>(base, z, w) {}
+    constexpr Vector4f(const Vector3<float>& base, const float w) : Vector4<float>(base, w) {}
+
+    constexpr Vector4f(const Vector<float, 4>& base) : Vector4<float>(base) {}
+    constexpr Vector4f(const Vector4<float>& base) : Vector4<float>(base) {}
 };
 
 using Vector4d = Vector4<double>;
\ No newline at end of file
@@ -25,28 +25,27 @@ public:
     static const Colour WHITE;
 
     /* Various constructors */
-    Colour() : Vector4f() {}
-    Colour(const std::initializer_list<float>& values) : Vector4f(values) {}
-    Colour(const float value) : Vector4f(value) {}
-    Colour(const Vector2<float>& base, const float z, const float w) : Vector4f(base, z, w) {}
-    Colour(const Vector3<float>& base, const float w) : Vector4f(base, w) {}
+    constexpr Colour() : Vector4f() {}
+    constexpr Colour(const float value) : Vector4f(value) {}
+    constexpr Colour(const Vector2<float>& base, const float z, const float w) : Vector4f(base, z, w) {}
+    constexpr Colour(const Vector3<float>& base, const float w) : Vector4f(base, w) {}
 
-    Colour(const Colour colour, const float a) : Vector4f(colour.getR(), colour.getG(), colour.getB(), a) {}
-    Colour(const float grey, const float a = 1.0f) : Vector4f(grey, grey, grey, a) {}
-    Colour(const float r, const float g, const float b, const float a = 1.0f) : Vector4f(r, g, b, a) {}
+    constexpr Colour(const Colour colour, const float a) : Vector4f(colour.getR(), colour.getG(), colour.getB(), a) {}
+    constexpr Colour(const float grey, const float a = 1.0f) : Vector4f(grey, grey, grey, a) {}
+    constexpr Colour(const float r, const float g, const float b, const float a = 1.0f) : Vector4f(r, g, b, a) {}
 
-    Colour(const Vector<float, 4>& base) : Vector4f(base) {}
-    Colour(const Vector4<float>& base) : Vector4f(base) {}
-    Colour(const Vector4f& base) : Vector4f(base) {}
+    constexpr Colour(const Vector<float, 4>& base) : Vector4f(base) {}
+    constexpr Colour(const Vector4<float>& base) : Vector4f(base) {}
+    constexpr Colour(const Vector4f& base) : Vector4f(base) {}
 
     /* Various setters and getters */
-    void setR(float r) { setX(r); }
-    void setG(float g) { setY(g); }
-    void setB(float b) { setZ(b); }
-    void setA(float a) { setW(a); }
-
-    float getR() const { return getX(); }
-    float getG() const { return getY(); }
-    float getB() const { return getZ(); }
-    float getA() const { return getW(); }
+    constexpr void setR(float r) { setX(r); }
+    constexpr void setG(float g) { setY(g); }
+    constexpr void setB(float b) { setZ(b); }
+    constexpr void setA(float a) { setW(a); }
+
+    constexpr float getR() const { return getX(); }
+    constexpr float getG() const { return getY(); }
+    constexpr float getB() const { return getZ(); }
+    constexpr float getA() const { return getW(); }
 };
\ No newline at end of file
@@ -43,6 +43,7 @@ public:
     inline void addBinding(BindingInfo bindingInfo) { bindingInfos.push_back(bindingInfo); }
     inline void addBinding(uint32_t binding, VkDescriptorType descriptorType, uint32_t descriptorCount, VkShaderStageFlags stageFlags) { bindingInfos.push_back({binding, descriptorType, descriptorCount, stageFlags}); }
     inline void addUBO(uint32_t binding, VkShaderStageFlags stageFlags) { addBinding(binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stageFlags); }
+    inline void addSSBO(uint32_t binding, VkShaderStageFlags stageFlags) { addBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stageFlags); }
 
     /* Returns the Vulkan instance */
     inline VkDescriptorSetLayout getVkInstance() const { return instance; }
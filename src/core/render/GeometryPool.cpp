@@ -0,0 +1,267 @@
+#include "GeometryPool.h"
+
+#include <iterator>
+
+/*****************************************************************************
+ * FreeListAllocator class
+ *****************************************************************************/
+
+FreeListAllocator::FreeListAllocator(uint32_t capacity) : capacity(capacity) {
+    if (capacity > 0)
+        addFreeRange(0, capacity);
+}
+
+void FreeListAllocator::addFreeRange(uint32_t offset, uint32_t size) {
+    freeRanges.insert({offset, size});
+    freeRangesBySize.insert({size, offset});
+}
+
+void FreeListAllocator::removeFreeRange(std::map<uint32_t, uint32_t>::iterator range) {
+    freeRangesBySize.erase({range->second, range->first});
+    freeRanges.erase(range);
+}
+
+uint32_t FreeListAllocator::allocate(uint32_t size) {
+    // Find the smallest free range that fits (the one with the lowest
+    // offset when there are several)
+    auto best = freeRangesBySize.lower_bound({size, 0});
+    if (size == 0 || best == freeRangesBySize.end())
+        return INVALID_OFFSET;
+    uint32_t rangeSize = best->first;
+    uint32_t offset    = best->second;
+
+    // Use the start of it, leaving the rest free
+    removeFreeRange(freeRanges.find(offset));
+    if (rangeSize > size)
+        addFreeRange(offset + size, rangeSize - size);
+    allocated += size;
+    return offset;
+}
+
+void FreeListAllocator::free(uint32_t offset, uint32_t size) {
+    if (size == 0)
+        return;
+
+    // Ensure the range is allocated (it mustn't overlap a free range)
+    uint64_t end  = static_cast<uint64_t>(offset) + size;
+    auto next     = freeRanges.lower_bound(offset);
+    auto previous = next != freeRanges.begin() ? std::prev(next) : freeRanges.end();
+    if (end > capacity || (next != freeRanges.end() && next->first < end) || (previous != freeRanges.end() && previous->first + previous->second > offset))
+        Logger::logAndThrowError("Cannot free range at " + utils_string::str(offset) + " of size " + utils_string::str(size) + " as it isn't allocated", "FreeListAllocator");
+    allocated -= size;
+
+    // Merge with the free ranges either side
+    if (next != freeRanges.end() && next->first == end) {
+        size += next->second;
+        removeFreeRange(next);
+    }
+    if (previous != freeRanges.end() && previous->first + previous->second == offset) {
+        offset = previous->first;
+        size += previous->second;
+        removeFreeRange(previous);
+    }
+    addFreeRange(offset, size);
+}
+
+/*****************************************************************************
+ * GeometryPool class
+ *****************************************************************************/
+
+GeometryPool::GeometryPool(Renderer* renderer, uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType) : renderer(renderer), vertexCapacity(vertexCapacity), indexType(indexType), indexAllocator(indexCapacity) {
+    if (indexType != VK_INDEX_TYPE_UINT16 && indexType != VK_INDEX_TYPE_UINT32)
+        Logger::logAndThrowError("Unsupported index type " + utils_string::str(indexType), "GeometryPool");
+    VkDeviceSize indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    ibo                    = new IBO(renderer, indexCapacity * indexSize, nullptr, indexType, true, false, false);
+}
+
+GeometryPool::~GeometryPool() {
+    for (VertexLayout* layout : layouts) {
+        for (VBO* vbo : layout->vbos)
+            delete vbo;
+        delete layout;
+    }
+    delete ibo;
+}
+
+int GeometryPool::findLayout(MeshData* data, const uint32_t (&vertexSizes)[NUM_VERTEX_BUFFERS]) {
+    const MeshData::VertexFormats& formats = data->getVertexFormats();
+    for (unsigned int i = 0; i < layouts.size(); ++i) {
+        VertexLayout* layout = layouts[i];
+        bool matches         = layout->numDimensions == data->getNumDimensions() && layout->separateFlags == data->getSeparateFlags() && layout->othersLayout == data->getOthersLayout() && std::equal(vertexSizes, vertexSizes + NUM_VERTEX_BUFFERS, layout->vertexSizes);
+        for (MeshData::DataType dataType = MeshData::POSITION; matches && dataType <= MeshData::BITANGENT; dataType = static_cast<MeshData::DataType>(dataType + 1))
+            matches = layout->formats.get(dataType) == formats.get(dataType);
+        if (matches)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+unsigned int GeometryPool::createLayout(MeshData* data, const uint32_t (&vertexSizes)[NUM_VERTEX_BUFFERS]) {
+    VertexLayout* layout  = new VertexLayout(vertexCapacity);
+    layout->numDimensions = data->getNumDimensions();
+    layout->separateFlags = data->getSeparateFlags();
+    layout->othersLayout  = data->getOthersLayout();
+    layout->formats       = data->getVertexFormats();
+    for (unsigned int i = 0; i < NUM_VERTEX_BUFFERS; ++i) {
+        layout->vertexSizes[i] = vertexSizes[i];
+        if (vertexSizes[i] > 0) {
+            layout->vbos[i] = new VBO(renderer, static_cast<VkDeviceSize>(vertexCapacity) * vertexSizes[i], nullptr, true, false, false);
+            layout->vertexBufferInstances.push_back(layout->vbos[i]->getCurrentBuffer()->getVkInstance());
+        }
+    }
+    layout->vertexBufferOffsets.resize(layout->vertexBufferInstances.size(), 0);
+    layouts.push_back(layout);
+
+    Logger::log("Created vertex layout " + utils_string::str(layouts.size() - 1) + " with " + utils_string::str(layout->vertexBufferInstances.size()) + " vertex buffers", "GeometryPool", LogType::Debug);
+    return static_cast<unsigned int>(layouts.size() - 1);
+}
+
+GeometryPool::Mesh* GeometryPool::add(MeshData* data) {
+    uint32_t vertexCount = data->getVertexCount();
+    if (vertexCount == 0)
+        Logger::logAndThrowError("Cannot add a mesh without any vertices", "GeometryPool");
+
+    // Obtain the vertex data as it should be given to the GPU
+    MeshRenderData::BufferSource sources[MeshRenderData::NUM_BUFFERS];
+    std::vector<uint8_t> storage[MeshRenderData::NUM_BUFFERS];
+    MeshData::Dequantisation dequantisation = data->calculateDequantisation();
+    MeshRenderData::getBufferSources(data, sources, storage, dequantisation);
+
+    uint32_t vertexSizes[NUM_VERTEX_BUFFERS];
+    for (unsigned int i = 0; i < NUM_VERTEX_BUFFERS; ++i) {
+        vertexSizes[i] = static_cast<uint32_t>(sources[i].size / vertexCount);
+        if (sources[i].size % vertexCount != 0)
+            Logger::logAndThrowError("Size of vertex buffer " + utils_string::str(i) + " isn't a multiple of the number of vertices " + utils_string::str(vertexCount), "GeometryPool");
+    }
+
+    // The levels of detail need the range of each sub data to be drawn with
+    // its vertex offset
+    const std::vector<uint32_t>& lodSubDataFirstIndices = data->getLODSubDataFirstIndices();
+    if (data->hasSubData() && lodSubDataFirstIndices.size() != data->getLODs().size() * data->getSubDataCount())
+        Logger::logAndThrowError("Mesh has " + utils_string::str(lodSubDataFirstIndices.size()) + " sub data first indices for its levels of detail but needs " + utils_string::str(data->getLODs().size() * data->getSubDataCount()), "GeometryPool");
+
+    // Gather the indices followed by those of the levels of detail (as the
+    // type used by the pool)
+    const std::vector<uint32_t>& lodIndices = data->getLODIndices();
+    std::vector<uint32_t> indices;
+    if (data->hasIndices())
+        indices = data->getIndices();
+    else {
+        indices.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            indices[i] = i;
+    }
+    uint32_t count = static_cast<uint32_t>(indices.size());
+    indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+    std::vector<uint16_t> indices16;
+    const void* indexData = indices.data();
+    VkDeviceSize indexSize = sizeof(uint32_t);
+    if (indexType == VK_INDEX_TYPE_UINT16) {
+        indices16.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (indices[i] > 0xFFFF)
+                Logger::logAndThrowError("Index " + utils_string::str(indices[i]) + " is too large for a pool with 16 bit indices", "GeometryPool");
+            indices16[i] = static_cast<uint16_t>(indices[i]);
+        }
+        indexData = indices16.data();
+        indexSize = sizeof(uint16_t);
+    }
+
+    // Allocate the ranges - a new layout is only created (along with its
+    // buffers) once the mesh is known to fit, which it does whenever its
+    // vertices fit in the capacity of an empty layout
+    int existingLayout = findLayout(data, vertexSizes);
+    if (existingLayout < 0 && vertexCount > vertexCapacity)
+        return nullptr;
+    uint32_t firstIndex = indexAllocator.allocate(static_cast<uint32_t>(indices.size()));
+    if (firstIndex == FreeListAllocator::INVALID_OFFSET)
+        return nullptr;
+    unsigned int layout   = existingLayout >= 0 ? static_cast<unsigned int>(existingLayout) : createLayout(data, vertexSizes);
+    uint32_t vertexOffset = layouts[layout]->allocator.allocate(vertexCount);
+    if (vertexOffset == FreeListAllocator::INVALID_OFFSET) {
+        indexAllocator.free(firstIndex, static_cast<uint32_t>(indices.size()));
+        return nullptr;
+    }
+
+    // Copy the data into them
+    for (unsigned int i = 0; i < NUM_VERTEX_BUFFERS; ++i) {
+        if (vertexSizes[i] > 0)
+            layouts[layout]->vbos[i]->getCurrentBuffer()->copy(sources[i].data, sources[i].size, static_cast<VkDeviceSize>(vertexOffset) * vertexSizes[i]);
+    }
+    ibo->getCurrentBuffer()->copy(indexData, indices.size() * indexSize, firstIndex * indexSize);
+
+    Mesh* mesh           = new Mesh();
+    mesh->layout         = layout;
+    mesh->vertexOffset   = vertexOffset;
+    mesh->vertexCount    = vertexCount;
+    mesh->firstIndex     = firstIndex;
+    mesh->indexCount     = static_cast<uint32_t>(indices.size());
+    mesh->count          = count;
+    mesh->dequantisation = dequantisation;
+
+    // Offset the sub data and levels of detail into the ranges
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        MeshData::SubData subData = data->getSubData(i);
+        subData.firstIndex += firstIndex;
+        subData.vertexOffset += vertexOffset;
+        mesh->subData.push_back(subData);
+    }
+    for (MeshData::LOD lod : data->getLODs()) {
+        lod.firstIndex += firstIndex + count;
+        mesh->lods.push_back(lod);
+    }
+    for (uint32_t lodFirstIndex : lodSubDataFirstIndices)
+        mesh->lodSubDataFirstIndices.push_back(lodFirstIndex + firstIndex + count);
+    return mesh;
+}
+
+void GeometryPool::remove(Mesh* mesh) {
+    layouts[mesh->layout]->allocator.free(mesh->vertexOffset, mesh->vertexCount);
+    indexAllocator.free(mesh->firstIndex, mesh->indexCount);
+    delete mesh;
+}
+
+void GeometryPool::bind(VkCommandBuffer commandBuffer, unsigned int layout) {
+    VertexLayout* current = layouts[layout];
+    vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<uint32_t>(current->vertexBufferInstances.size()), current->vertexBufferInstances.data(), current->vertexBufferOffsets.data());
+    ibo->bind(commandBuffer);
+}
+
+void GeometryPool::render(VkCommandBuffer commandBuffer, const Mesh* mesh, unsigned int lod, uint32_t instanceCount) {
+    for (unsigned int i = 0; i < getDrawCount(mesh); ++i) {
+        VkDrawIndexedIndirectCommand command = getDrawCommand(mesh, i, lod, instanceCount);
+        if (command.indexCount > 0)
+            vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+    }
+}
+
+VkDrawIndexedIndirectCommand GeometryPool::getDrawCommand(const Mesh* mesh, unsigned int index, unsigned int lod, uint32_t instanceCount, uint32_t firstInstance) {
+    lod = std::min(lod, static_cast<unsigned int>(mesh->lods.size()));
+
+    // Find the range of indices to draw (as MeshData::getSubDataRange and
+    // getLODSubDataRange, but within the ranges of the mesh)
+    uint32_t first        = lod == 0 ? mesh->firstIndex : mesh->lods[lod - 1].firstIndex;
+    uint32_t last         = lod == 0 ? mesh->firstIndex + mesh->count : mesh->lods[lod - 1].firstIndex + mesh->lods[lod - 1].indexCount;
+    uint32_t vertexOffset = mesh->vertexOffset;
+    if (! mesh->subData.empty()) {
+        const uint32_t* firstIndices = lod == 0 ? nullptr : mesh->lodSubDataFirstIndices.data() + (lod - 1) * mesh->subData.size();
+        first                        = lod == 0 ? mesh->subData[index].firstIndex : firstIndices[index];
+        if (index + 1 < mesh->subData.size())
+            last = lod == 0 ? mesh->subData[index + 1].firstIndex : firstIndices[index + 1];
+        vertexOffset = mesh->subData[index].vertexOffset;
+    }
+
+    VkDrawIndexedIndirectCommand command;
+    command.indexCount    = last - first;
+    command.instanceCount = instanceCount;
+    command.firstIndex    = first;
+    command.vertexOffset  = static_cast<int32_t>(vertexOffset);
+    command.firstInstance = firstInstance;
+    return command;
+}
+
+void GeometryPool::getDrawCommands(const Mesh* mesh, std::vector<VkDrawIndexedIndirectCommand>& commands, unsigned int lod, uint32_t instanceCount, uint32_t firstInstance) {
+    for (unsigned int i = 0; i < getDrawCount(mesh); ++i)
+        commands.push_back(getDrawCommand(mesh, i, lod, instanceCount, firstInstance));
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <set>
+
+#include "Mesh.h"
+
+/*****************************************************************************
+ * FreeListAllocator class - Suballocates ranges of elements (e.g. vertices
+ *                           or indices) out of a fixed capacity, keeping
+ *                           track of the ranges that are free
+ *****************************************************************************/
+
+class FreeListAllocator {
+private:
+    /* Free ranges by their offset (to merge neighbours when freeing) and by
+       their size and then offset (to find the smallest that fits) */
+    std::map<uint32_t, uint32_t> freeRanges;
+    std::set<std::pair<uint32_t, uint32_t>> freeRangesBySize;
+
+    /* Total number of elements and the number allocated */
+    uint32_t capacity;
+    uint32_t allocated = 0;
+
+    /* Adds and removes free ranges */
+    void addFreeRange(uint32_t offset, uint32_t size);
+    void removeFreeRange(std::map<uint32_t, uint32_t>::iterator range);
+
+public:
+    /* Offset returned when there isn't a free range large enough */
+    static const uint32_t INVALID_OFFSET = 0xFFFFFFFF;
+
+    /* Constructor and destructor */
+    FreeListAllocator(uint32_t capacity);
+    virtual ~FreeListAllocator() {}
+
+    /* Allocates a range of size elements and returns its offset (or
+       INVALID_OFFSET) - the smallest free range that fits is used to limit
+       fragmentation */
+    uint32_t allocate(uint32_t size);
+
+    /* Frees a range returned by allocate, merging it with any free ranges
+       either side of it */
+    void free(uint32_t offset, uint32_t size);
+
+    /* Getters */
+    inline uint32_t getCapacity() { return capacity; }
+    inline uint32_t getAllocated() { return allocated; }
+    inline size_t getFreeRangeCount() { return freeRanges.size(); }
+    inline uint32_t getLargestFreeRange() { return freeRangesBySize.empty() ? 0 : freeRangesBySize.rbegin()->first; }
+};
+
+/*****************************************************************************
+ * GeometryPool class - Stores the vertices and indices of many meshes in
+ *                      shared buffers so they can be drawn after binding
+ *                      them once
+ *****************************************************************************/
+
+// Meshes whose vertex data has the same layout (dimensions, separated data,
+// interleaved data types, formats and bones - so they can use the same
+// pipelines) share a set of vertex buffers created the first time one is
+// added, while every mesh shares a single index buffer. Each mesh is given
+// a range of vertices and a range of indices (holding its indices followed
+// by those of its levels of detail) from a FreeListAllocator for each.
+// Meshes without indices are given them, so every draw is indexed.
+//
+// The indices of each sub data are relative to its own vertex offset (as
+// in MeshData), so a mesh is drawn with a command per sub data (or a
+// single one when it has none) using the first index and vertex offset of
+// that sub data within the ranges of the mesh. Once the buffers of a layout
+// are bound (see bind) any number of its meshes can be drawn with render,
+// or with vkCmdDrawIndexedIndirect using the commands returned by
+// getDrawCommands. Material and offset indices and meshlets aren't stored
+// in the pool (a MeshRenderData is needed for them). The buffers don't
+// grow - add returns nullptr when there isn't a free range large enough
+// for a mesh.
+
+class GeometryPool {
+public:
+    /* A mesh stored in the pool */
+    struct Mesh {
+        // Layout of the vertex data (see bind)
+        unsigned int layout;
+
+        // Ranges allocated for the mesh within the buffers
+        uint32_t vertexOffset;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+
+        // Number of indices of the full detail (from firstIndex)
+        uint32_t count;
+
+        // Sub data and levels of detail with their first indices and vertex
+        // offsets within the buffers of the pool (lodSubDataFirstIndices
+        // holds the first index of each sub data for every level in turn,
+        // as in MeshData)
+        std::vector<MeshData::SubData> subData;
+        std::vector<MeshData::LOD> lods;
+        std::vector<uint32_t> lodSubDataFirstIndices;
+
+        // Dequantisation of the positions (see MeshRenderData)
+        MeshData::Dequantisation dequantisation;
+    };
+
+private:
+    /* Number of buffers that can hold vertex data (those of MeshRenderData
+       from BUFFER_POSITIONS to BUFFER_BONE_WEIGHTS) */
+    static const unsigned int NUM_VERTEX_BUFFERS = MeshRenderData::BUFFER_BONE_WEIGHTS + 1;
+
+    /* Layout of the vertex data of some meshes along with the buffers they
+       share */
+    struct VertexLayout {
+        unsigned int numDimensions;
+        MeshData::SeparateFlags separateFlags;
+        std::vector<MeshData::DataType> othersLayout;
+        MeshData::VertexFormats formats;
+
+        // Size of a vertex within each vertex buffer (0 for those that
+        // aren't used) and the buffers that are
+        uint32_t vertexSizes[NUM_VERTEX_BUFFERS];
+        VBO* vbos[NUM_VERTEX_BUFFERS] = {};
+
+        // Vertex buffers to bind and the offsets to bind them at (all 0)
+        std::vector<VkBuffer> vertexBufferInstances;
+        std::vector<VkDeviceSize> vertexBufferOffsets;
+
+        // Allocates the vertices
+        FreeListAllocator allocator;
+
+        VertexLayout(uint32_t vertexCapacity) : allocator(vertexCapacity) {}
+    };
+
+    /* Renderer used to create the buffers */
+    Renderer* renderer;
+
+    /* Number of vertices of each layout */
+    uint32_t vertexCapacity;
+
+    /* Layouts created so far */
+    std::vector<VertexLayout*> layouts;
+
+    /* Index buffer shared by every mesh, the type of its indices and the
+       allocator of its indices */
+    IBO* ibo;
+    VkIndexType indexType;
+    FreeListAllocator indexAllocator;
+
+    /* Returns the layout of the vertex data of a mesh given the size of a
+       vertex in each vertex buffer, or -1 if it doesn't exist yet */
+    int findLayout(MeshData* data, const uint32_t (&vertexSizes)[NUM_VERTEX_BUFFERS]);
+
+    /* Creates a layout for the vertex data of a mesh along with its buffers
+       and returns it */
+    unsigned int createLayout(MeshData* data, const uint32_t (&vertexSizes)[NUM_VERTEX_BUFFERS]);
+
+public:
+    /* Constructor and destructor - vertexCapacity is the number of
+       vertices of each layout and indexCapacity the number of indices
+       (16 bit indices can be used when no mesh has more than 65536
+       vertices) */
+    GeometryPool(Renderer* renderer, uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+    virtual ~GeometryPool();
+
+    /* Copies a mesh into the pool (converting vertex data that isn't given
+       as floats as MeshRenderData would), returning nullptr when there
+       isn't room for it */
+    Mesh* add(MeshData* data);
+
+    /* Removes a mesh from the pool and deletes it - the GPU must no longer
+       be using it, as its ranges can be reused straight away */
+    void remove(Mesh* mesh);
+
+    /* Binds the vertex buffers of a layout and the index buffer */
+    void bind(VkCommandBuffer commandBuffer, unsigned int layout);
+
+    /* Issues the commands to render a mesh at a level of detail (0 is the
+       full detail - levels past the last use the last) - the buffers of its
+       layout must already be bound */
+    void render(VkCommandBuffer commandBuffer, const Mesh* mesh, unsigned int lod = 0, uint32_t instanceCount = 1);
+
+    /* Returns the number of commands needed to render a mesh (one for each
+       of its sub data, or 1 when it has none) */
+    static inline unsigned int getDrawCount(const Mesh* mesh) { return mesh->subData.empty() ? 1 : static_cast<unsigned int>(mesh->subData.size()); }
+
+    /* Returns the command to render one of the sub data of a mesh (index is
+       ignored when it has none) at a level of detail with
+       vkCmdDrawIndexedIndirect */
+    static VkDrawIndexedIndirectCommand getDrawCommand(const Mesh* mesh, unsigned int index, unsigned int lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+    /* Appends the commands to render every sub data of a mesh at a level of
+       detail to commands */
+    static void getDrawCommands(const Mesh* mesh, std::vector<VkDrawIndexedIndirectCommand>& commands, unsigned int lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+    /* Getters */
+    inline unsigned int getLayoutCount() { return static_cast<unsigned int>(layouts.size()); }
+    inline FreeListAllocator& getVertexAllocator(unsigned int layout) { return layouts[layout]->allocator; }
+    inline FreeListAllocator& getIndexAllocator() { return indexAllocator; }
+    inline VkIndexType getIndexType() { return indexType; }
+};
@@ -1,6 +1,12 @@
 #include "Mesh.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "../maths/Batch.h"
+#include "../maths/Packing.h"
 #include "../vulkan/VulkanUtils.h"
+#include "MeshOptimiser.h"
 #include "ShaderInterface.h"
 
 /*****************************************************************************
@@ -11,37 +17,193 @@ std::map<int, MeshData::DataTypeInfo> MeshData::datatypeInfoMaps = {
     {POSITION, {SEPARATE_POSITIONS, 3 * sizeof(float), VK_FORMAT_R32G32B32_SFLOAT}},
     {COLOUR, {SEPARATE_COLOURS, 4 * sizeof(float), VK_FORMAT_R32G32B32A32_SFLOAT}},
     {TEXTURE_COORD, {SEPARATE_TEXTURE_COORDS, 2 * sizeof(float), VK_FORMAT_R32G32_SFLOAT}},
+    {NORMAL, {SEPARATE_NORMALS, 3 * sizeof(float), VK_FORMAT_R32G32B32_SFLOAT}},
     {TANGENT, {SEPARATE_TANGENTS, 3 * sizeof(float), VK_FORMAT_R32G32B32_SFLOAT}},
     {BITANGENT, {SEPARATE_BITANGENTS, 3 * sizeof(float), VK_FORMAT_R32G32B32_SFLOAT}}};
 
-MeshData::DataTypeInfo MeshData::getDataTypeInfo(unsigned int numDimensions, MeshData::DataType dataType) {
+MeshData::DataTypeInfo MeshData::getDataTypeInfo(unsigned int numDimensions, MeshData::DataType dataType, VertexFormat format) {
     if (datatypeInfoMaps.count(dataType) == 0)
         Logger::logAndThrowError("Failed to obtain data type info for datatype " + utils_string::str(dataType), "MeshData");
 
     // Special case
+    DataTypeInfo info = datatypeInfoMaps.at(dataType);
     if (dataType == DataType::POSITION) {
-        DataTypeInfo info = datatypeInfoMaps.at(dataType);
-        info.size         = numDimensions == 3 ? 3 * sizeof(float) : 2 * sizeof(float);
-        return info;
-    } else
-        return datatypeInfoMaps.at(dataType);
+        info.size   = numDimensions == 3 ? 3 * sizeof(float) : 2 * sizeof(float);
+        info.format = numDimensions == 3 ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+    }
+
+    // Adjust for the format (16 bit values with 3 components are padded to
+    // 4)
+    bool direction          = dataType == NORMAL || dataType == TANGENT || dataType == BITANGENT;
+    unsigned int components = info.size / sizeof(float) == 3 ? 4 : info.size / sizeof(float);
+    bool supported          = true;
+    switch (format) {
+        case FORMAT_FLOAT:
+            break;
+        case FORMAT_HALF:
+            info.size   = components * sizeof(uint16_t);
+            info.format = components == 2 ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+            break;
+        case FORMAT_SNORM16:
+            supported   = dataType == POSITION || direction;
+            info.size   = components * sizeof(int16_t);
+            info.format = components == 2 ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R16G16B16A16_SNORM;
+            break;
+        case FORMAT_UNORM8:
+            supported   = dataType == COLOUR;
+            info.size   = 4 * sizeof(uint8_t);
+            info.format = VK_FORMAT_R8G8B8A8_UNORM;
+            break;
+        case FORMAT_OCTAHEDRAL:
+            supported   = direction;
+            info.size   = 2 * sizeof(int16_t);
+            info.format = VK_FORMAT_R16G16_SNORM;
+            break;
+        default:
+            supported = false;
+            break;
+    }
+    if (! supported)
+        Logger::logAndThrowError("Format " + utils_string::str(format) + " isn't supported for datatype " + utils_string::str(dataType), "MeshData");
+    return info;
 }
 
-Sphere MeshData::calculateBoundingSphere() {
-    // The bounding sphere
-    Sphere sphere;
-    // Calculate the find the lengths between the mesh, and also find the largest one
-    float lengthX       = maxX - minX;
-    float lengthY       = maxY - minY;
-    float lengthZ       = maxZ - minZ;
-    float largestLength = utils_maths::max(utils_maths::max(lengthX, lengthY), lengthZ);
+MeshData::VertexFormat MeshData::VertexFormats::get(DataType dataType) const {
+    switch (dataType) {
+        case POSITION:
+            return position;
+        case COLOUR:
+            return colour;
+        case TEXTURE_COORD:
+            return textureCoord;
+        case NORMAL:
+            return normal;
+        case TANGENT:
+            return tangent;
+        case BITANGENT:
+            return bitangent;
+        default:
+            return FORMAT_FLOAT;
+    }
+}
 
-    // Calculate the centre and radius of the bound sphere
-    sphere.centre = Vector3f((maxX + minX) / 2.0f, (maxY + minY) / 2.0f, (maxZ + minZ) / 2.0f);
-    sphere.radius = largestLength / 2.0f;
+MeshData::VertexFormats MeshData::VertexFormats::compact() {
+    VertexFormats formats;
+    formats.position     = FORMAT_SNORM16;
+    formats.colour       = FORMAT_UNORM8;
+    formats.textureCoord = FORMAT_HALF;
+    formats.normal       = FORMAT_OCTAHEDRAL;
+    formats.tangent      = FORMAT_OCTAHEDRAL;
+    formats.bitangent    = FORMAT_OCTAHEDRAL;
+    return formats;
+}
+
+Matrix4f MeshData::Dequantisation::getMatrix() const {
+    Matrix4f matrix = Matrix4f().initTranslation(Vector3f(offset[0], offset[1], offset[2]));
+    matrix.scale(Vector3f(scale[0], scale[1], scale[2]));
+    return matrix;
+}
+
+void MeshData::packVertexData(unsigned int numDimensions, DataType dataType, VertexFormat format, const Dequantisation& dequantisation, const float* in, size_t inStride, uint8_t* out, size_t outStride, size_t count) {
+    DataTypeInfo info       = getDataTypeInfo(numDimensions, dataType, format);
+    unsigned int components = getDataTypeInfo(numDimensions, dataType).size / sizeof(float);
+    bool normalise          = dataType == POSITION && (format == FORMAT_HALF || format == FORMAT_SNORM16);
+    bool tight              = inStride == components && outStride == info.size;
+
+    switch (format) {
+        case FORMAT_FLOAT:
+            for (size_t i = 0; i < count; ++i)
+                memcpy(out + i * outStride, in + i * inStride, components * sizeof(float));
+            break;
+        case FORMAT_UNORM8:
+            if (tight)
+                utils_packing::packColours(in, reinterpret_cast<uint32_t*>(out), count);
+            else {
+                for (size_t i = 0; i < count; ++i) {
+                    const float* value = in + i * inStride;
+                    uint32_t packed    = utils_packing::packColour(Vector4f(value[0], value[1], value[2], value[3]));
+                    memcpy(out + i * outStride, &packed, sizeof(uint32_t));
+                }
+            }
+            break;
+        case FORMAT_OCTAHEDRAL:
+            if (outStride == info.size)
+                utils_packing::encodeOctahedral(in, reinterpret_cast<int16_t*>(out), count, inStride);
+            else {
+                for (size_t i = 0; i < count; ++i) {
+                    const float* value = in + i * inStride;
+                    Vector2f encoded   = utils_packing::encodeOctahedral(Vector3f(value[0], value[1], value[2]));
+                    int16_t packed[2]  = {utils_packing::toSnorm16(encoded.getX()), utils_packing::toSnorm16(encoded.getY())};
+                    memcpy(out + i * outStride, packed, sizeof(packed));
+                }
+            }
+            break;
+        default:
+            // 16 bit formats - values that don't need normalising or padding
+            // can be converted all at once
+            unsigned int outComponents = info.size / sizeof(uint16_t);
+            if (tight && ! normalise && outComponents == components) {
+                if (format == FORMAT_HALF)
+                    utils_packing::toHalf(in, reinterpret_cast<uint16_t*>(out), count * components);
+                else
+                    utils_packing::toSnorm16(in, reinterpret_cast<int16_t*>(out), count * components);
+                break;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const float* value = in + i * inStride;
+                uint16_t packed[4];
+                for (unsigned int c = 0; c < outComponents; ++c) {
+                    float component = c < components ? value[c] : (dataType == POSITION ? 1.0f : 0.0f);
+                    if (normalise && c < components)
+                        component = (component - dequantisation.offset[c]) / dequantisation.scale[c];
+                    packed[c] = format == FORMAT_HALF ? utils_packing::toHalf(component) : static_cast<uint16_t>(utils_packing::toSnorm16(component));
+                }
+                memcpy(out + i * outStride, packed, outComponents * sizeof(uint16_t));
+            }
+            break;
+    }
+}
 
-    // Return the sphere
-    return sphere;
+void MeshData::unpackVertexData(unsigned int numDimensions, DataType dataType, VertexFormat format, const Dequantisation& dequantisation, const uint8_t* in, size_t inStride, float* out, size_t outStride, size_t count) {
+    DataTypeInfo info       = getDataTypeInfo(numDimensions, dataType, format);
+    unsigned int components = getDataTypeInfo(numDimensions, dataType).size / sizeof(float);
+    bool normalise          = dataType == POSITION && (format == FORMAT_HALF || format == FORMAT_SNORM16);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* value = in + i * inStride;
+        float* result        = out + i * outStride;
+        switch (format) {
+            case FORMAT_FLOAT:
+                memcpy(result, value, components * sizeof(float));
+                break;
+            case FORMAT_UNORM8: {
+                uint32_t packed;
+                memcpy(&packed, value, sizeof(uint32_t));
+                Vector4f colour = utils_packing::unpackColour(packed);
+                for (unsigned int c = 0; c < 4; ++c)
+                    result[c] = colour[c];
+                break;
+            }
+            case FORMAT_OCTAHEDRAL: {
+                int16_t packed[2];
+                memcpy(packed, value, sizeof(packed));
+                Vector3f direction = utils_packing::decodeOctahedral(Vector2f(utils_packing::fromSnorm16(packed[0]), utils_packing::fromSnorm16(packed[1])));
+                for (unsigned int c = 0; c < 3; ++c)
+                    result[c] = direction[c];
+                break;
+            }
+            default: {
+                uint16_t packed[4];
+                memcpy(packed, value, info.size);
+                for (unsigned int c = 0; c < components; ++c) {
+                    result[c] = format == FORMAT_HALF ? utils_packing::fromHalf(packed[c]) : utils_packing::fromSnorm16(static_cast<int16_t>(packed[c]));
+                    if (normalise)
+                        result[c] = result[c] * dequantisation.scale[c] + dequantisation.offset[c];
+                }
+                break;
+            }
+        }
+    }
 }
 
 void MeshData::addPosition(Vector2f position) {
@@ -50,6 +212,7 @@ void MeshData::addPosition(Vector2f position) {
         positions.push_back(position.getX());
         positions.push_back(position.getY());
     } else {
+        addToOthersLayout(POSITION, SEPARATE_POSITIONS);
         others.push_back(position.getX());
         others.push_back(position.getY());
     }
@@ -64,21 +227,12 @@ void MeshData::addPosition(Vector3f position) {
         positions.push_back(position.getY());
         positions.push_back(position.getZ());
     } else {
+        addToOthersLayout(POSITION, SEPARATE_POSITIONS);
         others.push_back(position.getX());
         others.push_back(position.getY());
         others.push_back(position.getZ());
     }
 
-    // Check whether data for a bounding sphere should be calculated
-    if (numDimensions == 3) {
-        minX = utils_maths::min(minX, position.getX());
-        maxX = utils_maths::max(maxX, position.getX());
-        minY = utils_maths::min(minY, position.getY());
-        maxY = utils_maths::max(maxY, position.getY());
-        minZ = utils_maths::min(minZ, position.getZ());
-        maxZ = utils_maths::max(maxZ, position.getZ());
-    }
-
     ++vertexCount;
 }
 
@@ -90,6 +244,7 @@ void MeshData::addColour(Colour colour) {
         colours.push_back(colour.getB());
         colours.push_back(colour.getA());
     } else {
+        addToOthersLayout(COLOUR, SEPARATE_COLOURS);
         others.push_back(colour.getR());
         others.push_back(colour.getG());
         others.push_back(colour.getB());
@@ -103,6 +258,7 @@ void MeshData::addTextureCoord(Vector2f textureCoord) {
         textureCoords.push_back(textureCoord.getX());
         textureCoords.push_back(textureCoord.getY());
     } else {
+        addToOthersLayout(TEXTURE_COORD, SEPARATE_TEXTURE_COORDS);
         others.push_back(textureCoord.getX());
         others.push_back(textureCoord.getY());
     }
@@ -115,6 +271,7 @@ void MeshData::addNormal(Vector3f normal) {
         normals.push_back(normal.getY());
         normals.push_back(normal.getZ());
     } else {
+        addToOthersLayout(NORMAL, SEPARATE_NORMALS);
         others.push_back(normal.getX());
         others.push_back(normal.getY());
         others.push_back(normal.getZ());
@@ -128,6 +285,7 @@ void MeshData::addTangent(Vector3f tangent) {
         tangents.push_back(tangent.getY());
         tangents.push_back(tangent.getZ());
     } else {
+        addToOthersLayout(TANGENT, SEPARATE_TANGENTS);
         others.push_back(tangent.getX());
         others.push_back(tangent.getY());
         others.push_back(tangent.getZ());
@@ -141,13 +299,186 @@ void MeshData::addBitangent(Vector3f bitangent) {
         bitangents.push_back(bitangent.getY());
         bitangents.push_back(bitangent.getZ());
     } else {
+        addToOthersLayout(BITANGENT, SEPARATE_BITANGENTS);
         others.push_back(bitangent.getX());
         others.push_back(bitangent.getY());
         others.push_back(bitangent.getZ());
     }
 }
 
+std::vector<float>* MeshData::getStream(DataType dataType, size_t& offset, size_t& stride) {
+    // Check whether the data is separated
+    std::vector<float>* separated = nullptr;
+    switch (dataType) {
+        case POSITION:
+            separated = separatePositions() ? &positions : nullptr;
+            break;
+        case COLOUR:
+            separated = separateColours() ? &colours : nullptr;
+            break;
+        case TEXTURE_COORD:
+            separated = separateTextureCoords() ? &textureCoords : nullptr;
+            break;
+        case NORMAL:
+            separated = separateNormals() ? &normals : nullptr;
+            break;
+        case TANGENT:
+            separated = separateTangents() ? &tangents : nullptr;
+            break;
+        case BITANGENT:
+            separated = separateBitangents() ? &bitangents : nullptr;
+            break;
+        default:
+            Logger::logAndThrowError("Cannot locate the stream for datatype " + utils_string::str(dataType), "MeshData");
+    }
+    if (separated) {
+        offset = 0;
+        stride = getNumComponents(dataType);
+        return separated->size() > 0 ? separated : nullptr;
+    }
+
+    // Otherwise it will be interleaved in 'others' so find its position
+    // within a vertex
+    bool found = false;
+    offset     = 0;
+    stride     = 0;
+    for (DataType current : othersLayout) {
+        if (current == dataType)
+            found = true;
+        else if (! found)
+            offset += getNumComponents(current);
+        stride += getNumComponents(current);
+    }
+    return found ? &others : nullptr;
+}
+
+VkIndexType MeshData::getIndexType() {
+    auto fits = [](const std::vector<uint32_t>& values) {
+        return std::all_of(values.begin(), values.end(), [](uint32_t value) { return value <= 0xFFFF; });
+    };
+    return fits(indices) && fits(lodIndices) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+void MeshData::getSubDataRange(unsigned int index, size_t& first, size_t& last) {
+    first = subData[index].firstIndex;
+    if (index + 1 < subData.size())
+        last = subData[index + 1].firstIndex;
+    else
+        last = hasIndices() ? indices.size() : vertexCount;
+}
+
+void MeshData::getLODSubDataRange(unsigned int lod, unsigned int index, size_t& first, size_t& last) {
+    const LOD& level = lods[lod];
+    if (subData.empty()) {
+        first = level.firstIndex;
+        last  = level.firstIndex + level.indexCount;
+        return;
+    }
+    const uint32_t* firstIndices = lodSubDataFirstIndices.data() + lod * subData.size();
+    first                        = firstIndices[index];
+    last                         = index + 1 < subData.size() ? firstIndices[index + 1] : level.firstIndex + level.indexCount;
+}
+
+unsigned int MeshData::selectLOD(const std::vector<LOD>& lods, float distance, float projectionScale, float maxScreenError) {
+    // The errors only increase from one level to the next so use the last
+    // level whose error would still be too small to see
+    unsigned int lod = 0;
+    while (lod < lods.size() && lods[lod].error * projectionScale <= maxScreenError * distance)
+        ++lod;
+    return lod;
+}
+
+void MeshData::setVertexFormats(const VertexFormats& formats) {
+    for (DataType dataType : {POSITION, COLOUR, TEXTURE_COORD, NORMAL, TANGENT, BITANGENT})
+        getDataTypeInfo(numDimensions, dataType, formats.get(dataType));
+    vertexFormats = formats;
+}
+
+MeshData::Dequantisation MeshData::calculateDequantisation() {
+    Dequantisation dequantisation;
+    if (vertexFormats.position != FORMAT_HALF && vertexFormats.position != FORMAT_SNORM16)
+        return dequantisation;
+
+    // Keep the scale above 0 so flat meshes still divide safely
+    AABB box         = calculateBoundingBox();
+    Vector3f centre  = box.getCentre();
+    Vector3f extents = box.getExtents();
+    for (unsigned int i = 0; i < numDimensions; ++i) {
+        dequantisation.scale[i]  = utils_maths::max(extents[i], 1e-6f);
+        dequantisation.offset[i] = centre[i];
+    }
+    return dequantisation;
+}
+
+Sphere MeshData::calculateBoundingSphere() {
+    size_t offset, stride;
+    std::vector<float>* stream = getStream(POSITION, offset, stride);
+    return stream ? Sphere::fromPoints(stream->data() + offset, vertexCount, stride, numDimensions) : Sphere();
+}
+
+AABB MeshData::calculateBoundingBox() {
+    size_t offset, stride;
+    std::vector<float>* stream = getStream(POSITION, offset, stride);
+    return stream ? AABB::fromPoints(stream->data() + offset, vertexCount, stride, numDimensions) : AABB();
+}
+
+Sphere MeshData::calculateBoundingSphere(unsigned int subDataIndex) {
+    size_t offset, stride, first, last;
+    std::vector<float>* stream = getStream(POSITION, offset, stride);
+    if (! stream)
+        return Sphere();
+    getSubDataRange(subDataIndex, first, last);
+
+    // Indices are relative to the sub data's vertex offset
+    const float* positions = stream->data() + offset;
+    if (hasIndices())
+        return Sphere::fromIndexedPoints(positions, indices.data() + first, last - first, subData[subDataIndex].vertexOffset, stride, numDimensions);
+    else
+        return Sphere::fromPoints(positions + (first + subData[subDataIndex].vertexOffset) * stride, last - first, stride, numDimensions);
+}
+
+AABB MeshData::calculateBoundingBox(unsigned int subDataIndex) {
+    size_t offset, stride, first, last;
+    std::vector<float>* stream = getStream(POSITION, offset, stride);
+    if (! stream)
+        return AABB();
+    getSubDataRange(subDataIndex, first, last);
+
+    const float* positions = stream->data() + offset;
+    if (hasIndices())
+        return AABB::fromIndexedPoints(positions, indices.data() + first, last - first, subData[subDataIndex].vertexOffset, stride, numDimensions);
+    else
+        return AABB::fromPoints(positions + (first + subData[subDataIndex].vertexOffset) * stride, last - first, stride, numDimensions);
+}
+
+void MeshData::transform(const Matrix4f& matrix) {
+    size_t offset, stride;
+    std::vector<float>* stream;
+
+    // Positions
+    if ((stream = getStream(POSITION, offset, stride))) {
+        float* data = stream->data() + offset;
+        if (numDimensions == DIMENSIONS_3D)
+            utils_batch::transformPoints(matrix, data, data, vertexCount, stride, stride);
+        else
+            utils_batch::transformPoints2D(matrix, data, data, vertexCount, stride, stride);
+    }
+
+    // Normals need the inverse transpose, while tangents and bitangents
+    // follow the surface so are transformed as normal directions
+    if ((stream = getStream(NORMAL, offset, stride)))
+        utils_batch::transformNormals(matrix, stream->data() + offset, stream->data() + offset, stream->size() / stride, stride, stride);
+    if ((stream = getStream(TANGENT, offset, stride)))
+        utils_batch::transformDirections(matrix, stream->data() + offset, stream->data() + offset, stream->size() / stride, stride, stride, true);
+    if ((stream = getStream(BITANGENT, offset, stride)))
+        utils_batch::transformDirections(matrix, stream->data() + offset, stream->data() + offset, stream->size() / stride, stride, stride, true);
+}
+
 GraphicsPipeline::VertexInputDescription MeshData::computeVertexInputDescription(unsigned int numDimensions, std::vector<DataType> requiredData, SeparateFlags flags, ShaderInterface shaderInterface) {
+    return computeVertexInputDescription(numDimensions, requiredData, flags, shaderInterface, VertexFormats());
+}
+
+GraphicsPipeline::VertexInputDescription MeshData::computeVertexInputDescription(unsigned int numDimensions, std::vector<DataType> requiredData, SeparateFlags flags, ShaderInterface shaderInterface, const VertexFormats& formats) {
     // The output data
     GraphicsPipeline::VertexInputDescription description;
     description.primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -159,7 +490,7 @@ GraphicsPipeline::VertexInputDescription MeshData::computeVertexInputDescription
     // Go through the required data
     for (DataType current : requiredData) {
         // Obtain the datatype info
-        DataTypeInfo typeInfo = getDataTypeInfo(numDimensions, current);
+        DataTypeInfo typeInfo = getDataTypeInfo(numDimensions, current, formats.get(current));
 
         if ((flags & typeInfo.separateFlag)) {
             description.attributes.push_back(utils_vulkan::initVertexAttributeDescription(shaderInterface.getAttributeLocation(current), currentBinding, typeInfo.format, 0));
@@ -182,7 +513,7 @@ GraphicsPipeline::VertexInputDescription MeshData::computeVertexInputDescription
                     hasBones = true;
                     break;
                 default:
-                    DataTypeInfo typeInfo = getDataTypeInfo(numDimensions, current);
+                    DataTypeInfo typeInfo = getDataTypeInfo(numDimensions, current, formats.get(current));
                     description.attributes.push_back(utils_vulkan::initVertexAttributeDescription(shaderInterface.getAttributeLocation(current), currentBinding, typeInfo.format, currentOffset));
                     currentOffset += typeInfo.size;
                     break;
@@ -205,11 +536,180 @@ GraphicsPipeline::VertexInputDescription MeshData::computeVertexInputDescription
     return description;
 }
 
+/*****************************************************************************
+ * MeshDataBuilder class
+ *****************************************************************************/
+
+/* Vertex data that build() handles along with the flag used to separate
+   each */
+static const MeshData::DataType BUILDER_DATA_TYPES[]          = {MeshData::POSITION, MeshData::COLOUR, MeshData::TEXTURE_COORD, MeshData::NORMAL, MeshData::TANGENT, MeshData::BITANGENT};
+static const MeshData::SeparateFlags BUILDER_SEPARATE_FLAGS[] = {MeshData::SEPARATE_POSITIONS, MeshData::SEPARATE_COLOURS, MeshData::SEPARATE_TEXTURE_COORDS, MeshData::SEPARATE_NORMALS, MeshData::SEPARATE_TANGENTS, MeshData::SEPARATE_BITANGENTS};
+
+/* Copies the components of a single value (with fixed sizes for the common
+   cases so the copies are inlined) */
+static inline void copyComponents(const float* in, float* out, unsigned int count) {
+    switch (count) {
+        case 2:
+            memcpy(out, in, 2 * sizeof(float));
+            break;
+        case 3:
+            memcpy(out, in, 3 * sizeof(float));
+            break;
+        case 4:
+            memcpy(out, in, 4 * sizeof(float));
+            break;
+        default:
+            memcpy(out, in, count * sizeof(float));
+            break;
+    }
+}
+
+unsigned int MeshDataBuilder::getNumComponents(MeshData::DataType dataType) {
+    return dataType == MeshData::POSITION ? numDimensions : MeshData::getDataTypeInfo(numDimensions, dataType).size / sizeof(float);
+}
+
+void MeshDataBuilder::addVertexData(MeshData::DataType dataType, const float* values, size_t count) {
+    std::vector<float>& data = vertexData[dataType];
+    size_t numComponents     = getNumComponents(dataType);
+    if (data.empty())
+        data.reserve(utils_maths::max(reservedVertices, count) * numComponents);
+    data.insert(data.end(), values, values + count * numComponents);
+}
+
+void MeshDataBuilder::reserve(size_t vertexCount, size_t indexCount) {
+    reservedVertices = vertexCount;
+    indices.reserve(indexCount);
+}
+
+MeshData* MeshDataBuilder::build(const std::vector<MeshData::DataType>& layout) {
+    size_t vertexCount = getVertexCount();
+    MeshData* data     = new MeshData(numDimensions, separateFlags);
+
+    // Order the data types to interleave (those in the layout first)
+    std::vector<MeshData::DataType> order;
+    for (MeshData::DataType dataType : layout) {
+        if (dataType >= MeshData::POSITION && dataType <= MeshData::BITANGENT)
+            order.push_back(dataType);
+    }
+    for (MeshData::DataType dataType : BUILDER_DATA_TYPES) {
+        if (std::find(order.begin(), order.end(), dataType) == order.end())
+            order.push_back(dataType);
+    }
+
+    // Move the separated data and find the sources of the interleaved data
+    struct Source {
+        const float* values;
+        unsigned int numComponents;
+    };
+    std::vector<Source> sources;
+    unsigned int stride = 0;
+    for (MeshData::DataType dataType : order) {
+        std::vector<float>& values = vertexData[dataType];
+        unsigned int numComponents = getNumComponents(dataType);
+        if (values.empty())
+            continue;
+        if (values.size() != vertexCount * numComponents)
+            Logger::logAndThrowError("Data for datatype " + utils_string::str(dataType) + " has " + utils_string::str(values.size() / numComponents) + " vertices but there are " + utils_string::str(vertexCount), "MeshDataBuilder");
+
+        MeshData::SeparateFlags flag = BUILDER_SEPARATE_FLAGS[dataType - MeshData::POSITION];
+        if (separateFlags & flag) {
+            switch (dataType) {
+                case MeshData::POSITION:
+                    data->positions = std::move(values);
+                    break;
+                case MeshData::COLOUR:
+                    data->colours = std::move(values);
+                    break;
+                case MeshData::TEXTURE_COORD:
+                    data->textureCoords = std::move(values);
+                    break;
+                case MeshData::NORMAL:
+                    data->normals = std::move(values);
+                    break;
+                case MeshData::TANGENT:
+                    data->tangents = std::move(values);
+                    break;
+                default:
+                    data->bitangents = std::move(values);
+                    break;
+            }
+        } else {
+            data->addToOthersLayout(dataType, flag);
+            sources.push_back({values.data(), numComponents});
+            stride += numComponents;
+        }
+    }
+
+    // Interleave the rest one vertex at a time (reading each source and
+    // writing the output sequentially)
+    if (! sources.empty()) {
+        data->others.resize(vertexCount * stride);
+        float* out = data->others.data();
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+            for (Source& source : sources) {
+                copyComponents(source.values, out, source.numComponents);
+                source.values += source.numComponents;
+                out += source.numComponents;
+            }
+        }
+    }
+
+    data->vertexCount     = static_cast<unsigned int>(vertexCount);
+    data->indices         = std::move(indices);
+    data->boneIndices     = std::move(boneIndices);
+    data->boneWeights     = std::move(boneWeights);
+    data->materialIndices = std::move(materialIndices);
+    data->offsetIndices   = std::move(offsetIndices);
+    data->subData         = std::move(subData);
+
+    // Leave this builder empty
+    for (std::vector<float>& values : vertexData)
+        std::vector<float>().swap(values);
+    reservedVertices = 0;
+
+    return data;
+}
+
 /*****************************************************************************
  * MeshRenderData class
  *****************************************************************************/
 
-MeshRenderData::MeshRenderData(Renderer* renderer, MeshData* data) {
+/* Assigns the source of an index buffer, converting the indices into
+   storage when they are given to the GPU as 16 bit values */
+static void assignIndices(MeshRenderData::BufferSource& source, std::vector<uint8_t>& storage, const std::vector<uint32_t>& indices, VkIndexType indexType) {
+    if (indexType == VK_INDEX_TYPE_UINT32) {
+        source = {indices.data(), indices.size() * sizeof(uint32_t)};
+        return;
+    }
+    storage.resize(indices.size() * sizeof(uint16_t));
+    uint16_t* values = reinterpret_cast<uint16_t*>(storage.data());
+    for (size_t i = 0; i < indices.size(); ++i)
+        values[i] = static_cast<uint16_t>(indices[i]);
+    source = {storage.data(), storage.size()};
+}
+
+MeshRenderData::MeshRenderData(Renderer* renderer, MeshData* data, bool optimiseVertexCache) {
+    BufferSource sources[NUM_BUFFERS];
+    std::vector<uint8_t> storage[NUM_BUFFERS];
+    MeshData::Dequantisation dequantisation = data->calculateDequantisation();
+    VkIndexType indexType                   = getBufferSources(data, sources, storage, dequantisation);
+
+    std::vector<uint32_t> optimisedIndices;
+    if (optimiseVertexCache && data->hasIndices()) {
+        MeshOptimiser::optimiseVertexCache(data, optimisedIndices);
+        assignIndices(sources[BUFFER_INDICES], storage[BUFFER_INDICES], optimisedIndices, indexType);
+    }
+
+    setup(renderer, sources, data->getCount(), data->getLODs(), dequantisation, indexType);
+}
+
+MeshRenderData::MeshRenderData(Renderer* renderer, const BufferSource (&sources)[NUM_BUFFERS], uint32_t count, const std::vector<MeshData::LOD>& lods, const MeshData::Dequantisation& dequantisation, VkIndexType indexType) {
+    setup(renderer, sources, count, lods, dequantisation, indexType);
+}
+
+void MeshRenderData::setup(Renderer* renderer, const BufferSource (&sources)[NUM_BUFFERS], uint32_t count, const std::vector<MeshData::LOD>& lods, const MeshData::Dequantisation& dequantisation, VkIndexType indexType) {
+    this->dequantisation = dequantisation;
+
     // TODO: Don't hard code this
     bool deviceLocal       = true;
     bool persistentMapping = false;
@@ -218,69 +718,152 @@ MeshRenderData::MeshRenderData(Renderer* renderer, MeshData* data) {
     // as this is main reason you might want to separate them
     // TODO: ^ Don't assume this?
 
+    // Creates a vertex buffer if there is data for it (the data is only read
+    // while copying it to the GPU)
+    auto createVBO = [&](Buffer buffer, bool updatable) -> VBO* {
+        const BufferSource& source = sources[buffer];
+        return source.size > 0 ? new VBO(renderer, source.size, const_cast<void*>(source.data), deviceLocal, persistentMapping, updatable) : nullptr;
+    };
+
+    vboPositions     = createVBO(BUFFER_POSITIONS, true);
+    vboColours       = createVBO(BUFFER_COLOURS, true);
+    vboTextureCoords = createVBO(BUFFER_TEXTURE_COORDS, true);
+    vboNormals       = createVBO(BUFFER_NORMALS, true);
+    vboTangents      = createVBO(BUFFER_TANGENTS, true);
+    vboBitangents    = createVBO(BUFFER_BITANGENTS, true);
+    vboOthers        = createVBO(BUFFER_OTHERS, false);
+    vboBoneIndices   = createVBO(BUFFER_BONE_INDICES, false);
+    vboBoneWeights   = createVBO(BUFFER_BONE_WEIGHTS, false);
+
     // Vertex buffers
     std::vector<VBO*> vertexBuffers;
-
-    // Create the buffers as needed
-    if (data->hasPositions() && data->separatePositions()) {
-        vboPositions = new VBO(renderer, data->getPositions().size() * sizeof(data->getPositions()[0]), data->getPositions().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboPositions);
+    for (VBO* vbo : {vboPositions, vboColours, vboTextureCoords, vboNormals, vboTangents, vboBitangents, vboOthers, vboBoneIndices, vboBoneWeights}) {
+        if (vbo)
+            vertexBuffers.push_back(vbo);
     }
 
-    if (data->hasColours() && data->separateColours()) {
-        vboColours = new VBO(renderer, data->getColours().size() * sizeof(data->getColours()[0]), data->getColours().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboColours);
-    }
+    // Setup material and offset indices only if assigned
+    bufferMaterialIndices = createVBO(BUFFER_MATERIAL_INDICES, false);
+    bufferOffsetIndices   = createVBO(BUFFER_OFFSET_INDICES, false);
 
-    if (data->hasTextureCoords() && data->separateTextureCoords()) {
-        vboTextureCoords = new VBO(renderer, data->getTextureCoords().size() * sizeof(data->getTextureCoords()[0]), data->getTextureCoords().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboTextureCoords);
-    }
+    // Setup indices
+    if (sources[BUFFER_INDICES].size > 0)
+        ibo = new IBO(renderer, sources[BUFFER_INDICES].size, const_cast<void*>(sources[BUFFER_INDICES].data), indexType, deviceLocal, persistentMapping, false);
 
-    if (data->hasNormals() && data->separateNormals()) {
-        vboNormals = new VBO(renderer, data->getNormals().size() * sizeof(data->getNormals()[0]), data->getNormals().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboNormals);
+    // Setup levels of detail only if assigned
+    if (sources[BUFFER_LOD_INDICES].size > 0 && ! lods.empty()) {
+        iboLODs    = new IBO(renderer, sources[BUFFER_LOD_INDICES].size, const_cast<void*>(sources[BUFFER_LOD_INDICES].data), indexType, deviceLocal, persistentMapping, false);
+        this->lods = lods;
     }
 
-    if (data->hasTangents() && data->separateTangents()) {
-        vboTangents = new VBO(renderer, data->getTangents().size() * sizeof(data->getTangents()[0]), data->getTangents().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboTangents);
-    }
+    // Setup meshlets only if assigned
+    auto createSSBO = [&](Buffer buffer) -> SSBO* {
+        const BufferSource& source = sources[buffer];
+        return source.size > 0 ? new SSBO(renderer, source.size, const_cast<void*>(source.data), deviceLocal, persistentMapping, false) : nullptr;
+    };
 
-    if (data->hasBitangents() && data->separateBitangents()) {
-        vboBitangents = new VBO(renderer, data->getBitangents().size() * sizeof(data->getBitangents()[0]), data->getBitangents().data(), deviceLocal, persistentMapping, true);
-        vertexBuffers.push_back(vboBitangents);
-    }
+    ssboMeshlets         = createSSBO(BUFFER_MESHLETS);
+    ssboMeshletBounds    = createSSBO(BUFFER_MESHLET_BOUNDS);
+    ssboMeshletVertices  = createSSBO(BUFFER_MESHLET_VERTICES);
+    ssboMeshletTriangles = createSSBO(BUFFER_MESHLET_TRIANGLES);
 
-    if (data->hasOthers()) {
-        vboOthers = new VBO(renderer, data->getOthers().size() * sizeof(data->getOthers()[0]), data->getOthers().data(), deviceLocal, persistentMapping, false);
-        vertexBuffers.push_back(vboOthers);
-    }
+    renderData = new RenderData(vertexBuffers, ibo, count);
+}
 
-    // Setup bones
-    if (data->hasBones()) {
-        vboBoneIndices = new VBO(renderer, data->getBoneIndices().size() * sizeof(data->getBoneIndices()[0]), data->getBoneIndices().data(), deviceLocal, persistentMapping, false);
-        vertexBuffers.push_back(vboBoneIndices);
+VkIndexType MeshRenderData::getBufferSources(MeshData* data, BufferSource (&sources)[NUM_BUFFERS], std::vector<uint8_t> (&storage)[NUM_BUFFERS], const MeshData::Dequantisation& dequantisation) {
+    // Assigns the source of a buffer from a vector
+    auto assign = [&](Buffer buffer, const auto& values) {
+        sources[buffer] = {values.data(), values.size() * sizeof(values[0])};
+    };
+
+    // Assigns the source of a buffer of separated vertex data, converting it
+    // when it isn't given as floats
+    const MeshData::VertexFormats& formats = data->getVertexFormats();
+    unsigned int numDimensions             = data->getNumDimensions();
+    auto assignVertexData = [&](Buffer buffer, MeshData::DataType dataType, const std::vector<float>& values) {
+        MeshData::VertexFormat format = formats.get(dataType);
+        if (format == MeshData::FORMAT_FLOAT || values.empty()) {
+            assign(buffer, values);
+            return;
+        }
+        unsigned int components = data->getNumComponents(dataType);
+        uint32_t size           = MeshData::getDataTypeInfo(numDimensions, dataType, format).size;
+        size_t count            = values.size() / components;
+        storage[buffer].resize(count * size);
+        MeshData::packVertexData(numDimensions, dataType, format, dequantisation, values.data(), components, storage[buffer].data(), size, count);
+        assign(buffer, storage[buffer]);
+    };
+
+    // Only separated data has its own buffer
+    if (data->separatePositions())
+        assignVertexData(BUFFER_POSITIONS, MeshData::POSITION, data->getPositions());
+    if (data->separateColours())
+        assignVertexData(BUFFER_COLOURS, MeshData::COLOUR, data->getColours());
+    if (data->separateTextureCoords())
+        assignVertexData(BUFFER_TEXTURE_COORDS, MeshData::TEXTURE_COORD, data->getTextureCoords());
+    if (data->separateNormals())
+        assignVertexData(BUFFER_NORMALS, MeshData::NORMAL, data->getNormals());
+    if (data->separateTangents())
+        assignVertexData(BUFFER_TANGENTS, MeshData::TANGENT, data->getTangents());
+    if (data->separateBitangents())
+        assignVertexData(BUFFER_BITANGENTS, MeshData::BITANGENT, data->getBitangents());
+
+    // Interleaved data is converted one data type at a time into its place
+    // within each vertex
+    const std::vector<MeshData::DataType>& layout = data->getOthersLayout();
+    bool quantised                                = std::any_of(layout.begin(), layout.end(), [&](MeshData::DataType dataType) { return formats.get(dataType) != MeshData::FORMAT_FLOAT; });
+    if (quantised && data->hasOthers()) {
+        size_t inStride = 0;
+        size_t stride   = 0;
+        for (MeshData::DataType dataType : layout) {
+            inStride += data->getNumComponents(dataType);
+            stride += MeshData::getDataTypeInfo(numDimensions, dataType, formats.get(dataType)).size;
+        }
+        size_t count = data->getOthers().size() / inStride;
+        storage[BUFFER_OTHERS].resize(count * stride);
+
+        size_t inOffset = 0;
+        size_t offset   = 0;
+        for (MeshData::DataType dataType : layout) {
+            MeshData::VertexFormat format = formats.get(dataType);
+            MeshData::packVertexData(numDimensions, dataType, format, dequantisation, data->getOthers().data() + inOffset, inStride, storage[BUFFER_OTHERS].data() + offset, stride, count);
+            inOffset += data->getNumComponents(dataType);
+            offset += MeshData::getDataTypeInfo(numDimensions, dataType, format).size;
+        }
+        assign(BUFFER_OTHERS, storage[BUFFER_OTHERS]);
+    } else
+        assign(BUFFER_OTHERS, data->getOthers());
 
-        vboBoneWeights = new VBO(renderer, data->getBoneWeights().size() * sizeof(data->getBoneWeights()[0]), data->getOthers().data(), deviceLocal, persistentMapping, false);
-        vertexBuffers.push_back(vboBoneWeights);
+    if (data->hasBones()) {
+        assign(BUFFER_BONE_INDICES, data->getBoneIndices());
+        assign(BUFFER_BONE_WEIGHTS, data->getBoneWeights());
     }
 
-    // Setup material and offset indices only if assigned
-    if (data->hasMaterialIndices())
-        bufferMaterialIndices = new VBO(renderer, data->getMaterialIndices().size() * sizeof(data->getMaterialIndices()[0]), data->getMaterialIndices().data(), deviceLocal, persistentMapping, false);
-    if (data->hasOffsetIndices())
-        bufferOffsetIndices = new VBO(renderer, data->getOffsetIndices().size() * sizeof(data->getOffsetIndices()[0]), data->getOffsetIndices().data(), deviceLocal, persistentMapping, false);
+    assign(BUFFER_MATERIAL_INDICES, data->getMaterialIndices());
+    assign(BUFFER_OFFSET_INDICES, data->getOffsetIndices());
 
-    // Setup indices
-    if (data->hasIndices())
-        ibo = new IBO(renderer, data->getIndices().size() * sizeof(data->getIndices()[0]), data->getIndices().data(), VK_INDEX_TYPE_UINT32, deviceLocal, persistentMapping, false);
+    VkIndexType indexType = data->getIndexType();
+    assignIndices(sources[BUFFER_INDICES], storage[BUFFER_INDICES], data->getIndices(), indexType);
+    assignIndices(sources[BUFFER_LOD_INDICES], storage[BUFFER_LOD_INDICES], data->getLODIndices(), indexType);
 
-    renderData = new RenderData(vertexBuffers, ibo, data->getCount());
+    assign(BUFFER_MESHLETS, data->getMeshlets());
+    assign(BUFFER_MESHLET_BOUNDS, data->getMeshletBounds());
+    assign(BUFFER_MESHLET_VERTICES, data->getMeshletVertices());
+    assign(BUFFER_MESHLET_TRIANGLES, data->getMeshletTriangles());
+    return indexType;
 }
 
 MeshRenderData::~MeshRenderData() {
     delete renderData;
+
+    // Buffers that aren't deleted by the render data
+    delete bufferMaterialIndices;
+    delete bufferOffsetIndices;
+    delete ssboMeshlets;
+    delete ssboMeshletBounds;
+    delete ssboMeshletVertices;
+    delete ssboMeshletTriangles;
+    delete iboLODs;
 }
 
 /*****************************************************************************
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
 
+#include "../AABB.h"
 #include "../Sphere.h"
+#include "../maths/Matrix.h"
 #include "Colour.h"
 #include "GraphicsPipeline.h"
 #include "RenderData.h"
+#include "SSBO.h"
 #include "VBO.h"
 
 // Forward declaration
@@ -16,9 +20,9 @@ class ShaderInterface;
  *                  during construction
  *****************************************************************************/
 
-// TODO: Avoid using push_back where possible - Custom engine format would
-//       is one way to do this while still allowing data to be kept
-//       separate/interleaved and keeping bounding sphere information
+// Data can be added here a vertex at a time, but large meshes should be
+// created with MeshDataBuilder which appends whole arrays of each attribute
+// and interleaves them in a single pass
 // TODO: Allow 3 colour components instead of 4?
 
 class MeshData {
@@ -38,10 +42,47 @@ public:
         uint32_t vertexOffset;
     };
 
-    /* Data for a bounding sphere (for frustum culling) */
-    struct BoundingSphere {
-        Vector3f center;
+    /* Group of triangles that can be culled and rendered on their own (e.g.
+       by a mesh shader) - matches the layout of a uvec4 */
+    struct Meshlet {
+        // Index of the first vertex in meshletVertices and the byte offset
+        // of the first triangle in meshletTriangles (each meshlet's
+        // triangles are padded so this is always a multiple of 4)
+        uint32_t vertexOffset;
+        uint32_t triangleOffset;
+
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+    };
+
+    /* Data for culling a meshlet - matches the layout of 2 vec4s */
+    struct MeshletBounds {
+        // Bounding sphere
+        float centre[3];
         float radius;
+
+        // Cone containing the normals of every triangle
+        float coneAxis[3];
+        float coneCutoff;
+
+        /* Returns whether every triangle faces away from a camera at the
+           given position (the cutoff is 1 when this can never be true) */
+        inline bool isBackFacing(const Vector3f& cameraPosition) const {
+            Vector3f direction = Vector3f(centre[0], centre[1], centre[2]) - cameraPosition;
+            return direction.dot(Vector3f(coneAxis[0], coneAxis[1], coneAxis[2])) >= coneCutoff * direction.length() + radius;
+        }
+    };
+
+    /* Simplified version of a mesh that uses the same vertices (see
+       MeshOptimiser::generateLODs) */
+    struct LOD {
+        // Range of the indices of this level within lodIndices
+        uint32_t firstIndex;
+        uint32_t indexCount;
+
+        // Largest distance the simplified surface is estimated to be from
+        // the original (in the same units as the positions)
+        float error;
     };
 
     /* Various types of data this can store */
@@ -84,6 +125,59 @@ public:
         VkFormat format;
     };
 
+    /* Formats vertex data can be given to the GPU in (see utils_packing) */
+    enum VertexFormat {
+        // 32 bit floats (as the data is stored here)
+        FORMAT_FLOAT,
+        // 16 bit floats
+        FORMAT_HALF,
+        // Signed normalised 16 bit integers (for directions, or positions
+        // once normalised using a Dequantisation)
+        FORMAT_SNORM16,
+        // Unsigned normalised 8 bit integers (for colours)
+        FORMAT_UNORM8,
+        // Directions encoded as 2 snorm16 values that the shader decodes
+        // (see utils_packing::decodeOctahedral)
+        FORMAT_OCTAHEDRAL,
+    };
+
+    /* Format of each type of vertex data when given to the GPU - 16 bit
+       formats with 3 components are padded to 4 (with a w of 1 for
+       positions) as not every GPU supports them in vertex buffers */
+    struct VertexFormats {
+        VertexFormat position     = FORMAT_FLOAT;
+        VertexFormat colour       = FORMAT_FLOAT;
+        VertexFormat textureCoord = FORMAT_FLOAT;
+        VertexFormat normal       = FORMAT_FLOAT;
+        VertexFormat tangent      = FORMAT_FLOAT;
+        VertexFormat bitangent    = FORMAT_FLOAT;
+
+        /* Returns the format of a data type (FORMAT_FLOAT for those that
+           don't have one) */
+        VertexFormat get(DataType dataType) const;
+
+        /* Returns whether any data isn't given as floats */
+        inline bool isQuantised() const {
+            return position != FORMAT_FLOAT || colour != FORMAT_FLOAT || textureCoord != FORMAT_FLOAT || normal != FORMAT_FLOAT || tangent != FORMAT_FLOAT || bitangent != FORMAT_FLOAT;
+        }
+
+        /* Returns the most compact formats - snorm16 positions, unorm8
+           colours, half texture coordinates and octahedral directions (a
+           vertex with all of these takes 28 bytes rather than 72) */
+        static VertexFormats compact();
+    };
+
+    /* Values that positions given to the GPU in a 16 bit format are
+       multiplied by and then added to (per axis) to give the originals */
+    struct Dequantisation {
+        float scale[3]  = {1.0f, 1.0f, 1.0f};
+        float offset[3] = {0.0f, 0.0f, 0.0f};
+
+        /* Returns a matrix that applies this (to be combined with the model
+           matrix) */
+        Matrix4f getMatrix() const;
+    };
+
     /* Numbers of dimensions */
     static const unsigned int DIMENSIONS_2D = 2;
     static const unsigned int DIMENSIONS_3D = 3;
@@ -92,9 +186,6 @@ private:
     /* Known datatypes and their info */
     static std::map<int, DataTypeInfo> datatypeInfoMaps;
 
-    /* Returns info about a known datatype or errors if not found */
-    static DataTypeInfo getDataTypeInfo(unsigned int numDimensions, DataType dataType);
-
     /* Number of dimensions data will be stored for (effects vertex input
        bindings) */
     unsigned int numDimensions;
@@ -127,27 +218,76 @@ private:
     // SubData instances for any parts with different materials
     std::vector<SubData> subData;
 
-    /* For computing the max/min extents of added vertices (when computing a
-       bounding sphere) */
-    float minX = 1000000000;
-    float maxX = -1000000000;
-    float minY = 1000000000;
-    float maxY = -1000000000;
-    float minZ = 1000000000;
-    float maxZ = -1000000000;
+    // Meshlets (see MeshOptimiser::buildMeshlets) - meshletVertices contains
+    // the index of each vertex (with the vertex offset of its sub data
+    // added) and meshletTriangles contains 3 indices into the vertices of
+    // a meshlet for each triangle
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> meshletBounds;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+
+    // Levels of detail from the most to the least detailed - lodIndices
+    // contains the indices of every level, each laid out like 'indices'
+    // (relative to the vertex offset of each sub data), and
+    // lodSubDataFirstIndices contains the first index of each sub data
+    // within lodIndices for every level in turn
+    std::vector<LOD> lods;
+    std::vector<uint32_t> lodIndices;
+    std::vector<uint32_t> lodSubDataFirstIndices;
+
+    /* Data types stored in 'others' in the order they were first added (i.e.
+       the layout of a single vertex within it) along with flags for quickly
+       checking what has been added */
+    std::vector<DataType> othersLayout;
+    unsigned int othersLayoutFlags = SEPARATE_NONE;
 
     /* Flags specifying whether certain data should be separated */
     SeparateFlags separateFlags;
 
+    /* Formats the vertex data is given to the GPU in */
+    VertexFormats vertexFormats;
+
+    /* Records that a data type is being stored in 'others' */
+    inline void addToOthersLayout(DataType dataType, SeparateFlags flag) {
+        if (! (othersLayoutFlags & flag)) {
+            othersLayoutFlags |= flag;
+            othersLayout.push_back(dataType);
+        }
+    }
+
+    friend class MeshDataBuilder;
+    friend class MeshCacheFile;
+    friend class MeshOptimiser;
+    friend class MeshLoader;
+
 public:
     /* Constructor and destructor  */
     MeshData(unsigned int numDimensions, SeparateFlags separateFlags = SEPARATE_NONE) : numDimensions(numDimensions), separateFlags(separateFlags) {}
     virtual ~MeshData() {}
 
-    /* Calculates and returns a sphere bounding this mesh */
-    // TODO: Allow computation for sub mesh's
+    /* Returns info about a known datatype given to the GPU in a format or
+       errors if not found (or the format isn't supported for it) */
+    static DataTypeInfo getDataTypeInfo(unsigned int numDimensions, DataType dataType, VertexFormat format = FORMAT_FLOAT);
+
+    /* Converts count values of a data type from floats (inStride floats
+       apart) into a format (outStride bytes apart) and back again -
+       positions in a 16 bit format are normalised using dequantisation */
+    static void packVertexData(unsigned int numDimensions, DataType dataType, VertexFormat format, const Dequantisation& dequantisation, const float* in, size_t inStride, uint8_t* out, size_t outStride, size_t count);
+    static void unpackVertexData(unsigned int numDimensions, DataType dataType, VertexFormat format, const Dequantisation& dequantisation, const uint8_t* in, size_t inStride, float* out, size_t outStride, size_t count);
+
+    /* Calculates and returns a tight sphere bounding this mesh (see
+       Sphere::fromPoints) */
     Sphere calculateBoundingSphere();
 
+    /* Calculates and returns the box bounding this mesh */
+    AABB calculateBoundingBox();
+
+    /* Calculates and returns the sphere/box bounding the vertices used by a
+       sub data (e.g. for culling parts of a mesh separately) */
+    Sphere calculateBoundingSphere(unsigned int subDataIndex);
+    AABB calculateBoundingBox(unsigned int subDataIndex);
+
     /* Methods to add data */
     void addPosition(Vector2f position);
     void addPosition(Vector3f position);
@@ -182,6 +322,23 @@ public:
     inline bool separateTangents() { return separateFlags & SeparateFlags::SEPARATE_TANGENTS; }
     inline bool separateBitangents() { return separateFlags & SeparateFlags::SEPARATE_BITANGENTS; }
 
+    /* Assigns the formats the vertex data is given to the GPU in (errors
+       if any aren't supported for their data type) */
+    void setVertexFormats(const VertexFormats& formats);
+    inline const VertexFormats& getVertexFormats() { return vertexFormats; }
+
+    /* Calculates and returns the dequantisation of the positions - this
+       fits the bounding box of the mesh into [-1, 1] when they use a 16 bit
+       format, and is the identity otherwise */
+    Dequantisation calculateDequantisation();
+
+    /* Returns the data types stored in 'others' in the order they are
+       interleaved */
+    inline const std::vector<DataType>& getOthersLayout() { return othersLayout; }
+
+    /* Returns the flags specifying which data is separated */
+    inline SeparateFlags getSeparateFlags() { return separateFlags; }
+
     /* Methods to check whether data has been provided */
     inline bool hasPositions() { return positions.size() > 0; }
     inline bool hasColours() { return colours.size() > 0; }
@@ -194,6 +351,8 @@ public:
     inline bool hasBones() { return boneIndices.size() > 0; }
     inline bool hasMaterialIndices() { return materialIndices.size() > 0; }
     inline bool hasOffsetIndices() { return offsetIndices.size() > 0; }
+    inline bool hasMeshlets() { return meshlets.size() > 0; }
+    inline bool hasLODs() { return lods.size() > 0; }
 
     std::vector<float>& getPositions() { return positions; }
     std::vector<float>& getColours() { return colours; }
@@ -207,10 +366,49 @@ public:
     std::vector<float>& getBoneWeights() { return boneWeights; }
     std::vector<uint32_t>& getMaterialIndices() { return materialIndices; }
     std::vector<uint32_t>& getOffsetIndices() { return offsetIndices; }
+    std::vector<Meshlet>& getMeshlets() { return meshlets; }
+    std::vector<MeshletBounds>& getMeshletBounds() { return meshletBounds; }
+    std::vector<uint32_t>& getMeshletVertices() { return meshletVertices; }
+    std::vector<uint8_t>& getMeshletTriangles() { return meshletTriangles; }
+    std::vector<LOD>& getLODs() { return lods; }
+    std::vector<uint32_t>& getLODIndices() { return lodIndices; }
+    std::vector<uint32_t>& getLODSubDataFirstIndices() { return lodSubDataFirstIndices; }
     inline bool hasSubData() { return subData.size() > 0; }
     inline size_t getSubDataCount() { return subData.size(); }
     inline SubData& getSubData(unsigned int index) { return subData[index]; }
 
+    /* Assigns the range of indices (or vertices when there are no indices)
+       used by a sub data */
+    void getSubDataRange(unsigned int index, size_t& first, size_t& last);
+
+    /* Assigns the range of lodIndices used by a sub data (or the whole
+       level when there are no sub data) at a level of detail */
+    void getLODSubDataRange(unsigned int lod, unsigned int index, size_t& first, size_t& last);
+
+    /* Returns the level of detail to render given the distance to the
+       camera, the projection scale (the height of the screen in pixels
+       divided by 2 * tan(fovY / 2)) and the largest error in pixels that
+       can be seen - 0 is the full detail and i + 1 is lods[i] */
+    static unsigned int selectLOD(const std::vector<LOD>& lods, float distance, float projectionScale, float maxScreenError);
+
+    /* Returns the number of vertices added */
+    inline unsigned int getVertexCount() { return vertexCount; }
+
+    /* Returns the number of dimensions of the positions */
+    inline unsigned int getNumDimensions() { return numDimensions; }
+
+    /* Returns the number of floats a data type uses per vertex */
+    inline unsigned int getNumComponents(DataType dataType) { return dataType == POSITION ? numDimensions : getDataTypeInfo(numDimensions, dataType).size / sizeof(float); }
+
+    /* Locates the data for a given data type - returns the vector it is
+       stored in (or nullptr if it hasn't been added) and assigns the offset
+       to its first value and the stride between vertices (both in floats) */
+    std::vector<float>* getStream(DataType dataType, size_t& offset, size_t& stride);
+
+    /* Transforms the positions, normals, tangents and bitangents of this
+       mesh in place (e.g. to pre-transform static geometry at load time) */
+    void transform(const Matrix4f& matrix);
+
     /* Returns the number of positions or indices depending on whether this
        data has indices or not */
     inline uint32_t getCount() {
@@ -220,11 +418,110 @@ public:
             return vertexCount;
     }
 
+    /* Returns the smallest type that can hold every index (including those
+       of the levels of detail) - indices are relative to the vertex offset
+       of their sub data so 16 bit indices can be used whenever each sub
+       data uses fewer than 65536 vertices, however many there are in
+       total */
+    VkIndexType getIndexType();
+
     /* Static method to construct vertex input bindings and attributes given the
-       required data and whether they should be separated from the others */
+       required data, whether they should be separated from the others and
+       the formats they are given in (which should match those of the mesh
+       data, all floats when not given) */
+    static GraphicsPipeline::VertexInputDescription computeVertexInputDescription(unsigned int numDimensions, std::vector<DataType> requiredData, SeparateFlags flags, ShaderInterface shaderInterface, const VertexFormats& formats);
     static GraphicsPipeline::VertexInputDescription computeVertexInputDescription(unsigned int numDimensions, std::vector<DataType> requiredData, SeparateFlags flags, ShaderInterface shaderInterface);
 };
 
+/*****************************************************************************
+ * MeshDataBuilder class - Creates a MeshData instance from whole arrays of
+ *                         each type of data
+ *****************************************************************************/
+
+// Each type of data is kept in its own array until build() is called,
+// which moves any separated data straight into the MeshData and
+// interleaves the rest into 'others' in a single pass over the vertices
+// (in the order given, which should match the required data given to
+// MeshData::computeVertexInputDescription). Data can be appended in any
+// order and in as many parts as needed, and reserve() allows arrays to be
+// allocated once when the final counts are known (e.g. from a file header).
+
+class MeshDataBuilder {
+private:
+    /* Number of dimensions of the positions */
+    unsigned int numDimensions;
+
+    /* Flags specifying which data should be separated */
+    MeshData::SeparateFlags separateFlags;
+
+    /* Number of vertices to reserve space for in each array of vertex data
+       when it is first added to */
+    size_t reservedVertices = 0;
+
+    /* Vertex data indexed by its data type (only POSITION to BITANGENT
+       are used) */
+    std::vector<float> vertexData[MeshData::BITANGENT + 1];
+
+    /* Remaining data (as in MeshData) */
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> boneIndices;
+    std::vector<float> boneWeights;
+    std::vector<uint32_t> materialIndices;
+    std::vector<uint32_t> offsetIndices;
+    std::vector<MeshData::SubData> subData;
+
+    /* Returns the number of floats a data type uses per vertex */
+    unsigned int getNumComponents(MeshData::DataType dataType);
+
+    /* Appends the values of count vertices to the array for a data type */
+    void addVertexData(MeshData::DataType dataType, const float* values, size_t count);
+
+public:
+    /* Constructor and destructor */
+    MeshDataBuilder(unsigned int numDimensions, MeshData::SeparateFlags separateFlags = MeshData::SEPARATE_NONE) : numDimensions(numDimensions), separateFlags(separateFlags) {}
+    virtual ~MeshDataBuilder() {}
+
+    /* Reserves space for the given total numbers of vertices and indices */
+    void reserve(size_t vertexCount, size_t indexCount);
+
+    /* Methods to add data for count vertices at once (each array holds the
+       components of every vertex in turn e.g. x, y, z, x, y, z...) */
+    inline void addPositions(const float* positions, size_t count) { addVertexData(MeshData::POSITION, positions, count); }
+    inline void addColours(const float* colours, size_t count) { addVertexData(MeshData::COLOUR, colours, count); }
+    inline void addTextureCoords(const float* textureCoords, size_t count) { addVertexData(MeshData::TEXTURE_COORD, textureCoords, count); }
+    inline void addNormals(const float* normals, size_t count) { addVertexData(MeshData::NORMAL, normals, count); }
+    inline void addTangents(const float* tangents, size_t count) { addVertexData(MeshData::TANGENT, tangents, count); }
+    inline void addBitangents(const float* bitangents, size_t count) { addVertexData(MeshData::BITANGENT, bitangents, count); }
+
+    /* Methods to add count values of the remaining data at once */
+    inline void addIndices(const uint32_t* indices, size_t count) { this->indices.insert(this->indices.end(), indices, indices + count); }
+
+    inline void addBoneData(const uint32_t* boneIndices, const float* boneWeights, size_t count) {
+        this->boneIndices.insert(this->boneIndices.end(), boneIndices, boneIndices + count);
+        this->boneWeights.insert(this->boneWeights.end(), boneWeights, boneWeights + count);
+    }
+
+    inline void addMaterialIndices(const uint32_t* materialIndices, size_t count) { this->materialIndices.insert(this->materialIndices.end(), materialIndices, materialIndices + count); }
+
+    inline void addOffsetIndex(uint32_t indexOffset, uint32_t vertexOffset) {
+        // Stored in primitives as in MeshData
+        offsetIndices.push_back(indexOffset / 3);
+        offsetIndices.push_back(vertexOffset);
+    }
+
+    inline void addSubData(uint32_t materialIndex, uint32_t firstIndex, uint32_t vertexOffset) { subData.push_back({materialIndex, firstIndex, vertexOffset}); }
+
+    /* Returns the number of vertices added (given by the positions) */
+    inline size_t getVertexCount() { return vertexData[MeshData::POSITION].size() / numDimensions; }
+
+    /* Creates a MeshData instance from the added data, with any data that
+       isn't separated interleaved in the order given by layout (followed by
+       any other data added in the order of MeshData::DataType). Errors if
+       the data added for a type doesn't cover every vertex. The data is
+       moved out of this builder, leaving it empty. */
+    MeshData* build(const std::vector<MeshData::DataType>& layout = {});
+};
+
 /*****************************************************************************
  * MeshRenderData class - Stores the buffers required for rendering a Mesh
  *****************************************************************************/
@@ -250,18 +547,107 @@ private:
     VBO* bufferOffsetIndices   = nullptr;
 
     /* Index buffer (May be nullptr) */
-    IBO* ibo;
+    IBO* ibo = nullptr;
+
+    /* Storage buffers for the meshlets and their bounds (only assigned when
+       the data has meshlets) */
+    SSBO* ssboMeshlets         = nullptr;
+    SSBO* ssboMeshletBounds    = nullptr;
+    SSBO* ssboMeshletVertices  = nullptr;
+    SSBO* ssboMeshletTriangles = nullptr;
+
+    /* Index buffer for the levels of detail and the range of each level
+       within it (only assigned when the data has levels of detail) */
+    IBO* iboLODs = nullptr;
+    std::vector<MeshData::LOD> lods;
+
+    /* Dequantisation of the positions */
+    MeshData::Dequantisation dequantisation;
 
 public:
-    /* Constructor and destructor */
-    MeshRenderData(Renderer* renderer, MeshData* data);
+    /* Buffers that can be created (vertex buffers are bound in this order) */
+    enum Buffer {
+        BUFFER_POSITIONS,
+        BUFFER_COLOURS,
+        BUFFER_TEXTURE_COORDS,
+        BUFFER_NORMALS,
+        BUFFER_TANGENTS,
+        BUFFER_BITANGENTS,
+        BUFFER_OTHERS,
+        BUFFER_BONE_INDICES,
+        BUFFER_BONE_WEIGHTS,
+        BUFFER_MATERIAL_INDICES,
+        BUFFER_OFFSET_INDICES,
+        BUFFER_INDICES,
+        BUFFER_LOD_INDICES,
+        BUFFER_MESHLETS,
+        BUFFER_MESHLET_BOUNDS,
+        BUFFER_MESHLET_VERTICES,
+        BUFFER_MESHLET_TRIANGLES,
+        NUM_BUFFERS
+    };
+
+    /* Data to copy into a buffer (buffers without data aren't created) */
+    struct BufferSource {
+        const void* data = nullptr;
+        size_t size      = 0;
+    };
+
+private:
+    /* Creates the buffers and render data */
+    void setup(Renderer* renderer, const BufferSource (&sources)[NUM_BUFFERS], uint32_t count, const std::vector<MeshData::LOD>& lods, const MeshData::Dequantisation& dequantisation, VkIndexType indexType);
+
+public:
+    /* Constructors and destructor - the indices can optionally be reordered
+       for the vertex cache while uploading them (see MeshOptimiser, the
+       data itself is left unchanged) */
+    MeshRenderData(Renderer* renderer, MeshData* data, bool optimiseVertexCache = false);
+
+    /* Creates the buffers straight from the data for each (count is the
+       number of indices, or vertices when there are none, lods gives the
+       range of each level of detail within BUFFER_LOD_INDICES,
+       dequantisation is that of the positions and indexType is the type of
+       both index buffers) */
+    MeshRenderData(Renderer* renderer, const BufferSource (&sources)[NUM_BUFFERS], uint32_t count, const std::vector<MeshData::LOD>& lods = {}, const MeshData::Dequantisation& dequantisation = MeshData::Dequantisation(), VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+
     virtual ~MeshRenderData();
 
-    /* Method to render using the data */
-    inline void render(VkCommandBuffer commandBuffer) {
-        renderData->render(commandBuffer);
+    /* Assigns the data for each buffer of a MeshData instance and returns
+       the type of the indices - vertex data that isn't given as floats, and
+       indices that fit in 16 bits (see MeshData::getIndexType), are
+       converted into storage (which must outlive the sources) using the
+       dequantisation of the positions */
+    static VkIndexType getBufferSources(MeshData* data, BufferSource (&sources)[NUM_BUFFERS], std::vector<uint8_t> (&storage)[NUM_BUFFERS], const MeshData::Dequantisation& dequantisation);
+
+    /* Method to render using the data at a level of detail (0 is the full
+       detail, see selectLOD - levels past the last use the last) */
+    inline void render(VkCommandBuffer commandBuffer, unsigned int lod = 0) {
+        lod = std::min(lod, static_cast<unsigned int>(lods.size()));
+        if (lod == 0)
+            renderData->render(commandBuffer);
+        else
+            renderData->render(commandBuffer, iboLODs, lods[lod - 1].firstIndex, lods[lod - 1].indexCount);
     }
 
+    /* Returns the number of levels of detail (not including the full
+       detail) */
+    inline unsigned int getLODCount() { return static_cast<unsigned int>(lods.size()); }
+
+    /* Returns the dequantisation of the positions (to be combined with the
+       model matrix when they use a 16 bit format) */
+    inline const MeshData::Dequantisation& getDequantisation() { return dequantisation; }
+
+    /* Returns the level of detail to render (see MeshData::selectLOD) */
+    inline unsigned int selectLOD(float distance, float projectionScale, float maxScreenError) { return MeshData::selectLOD(lods, distance, projectionScale, maxScreenError); }
+
+    /* Returns the storage buffers of the meshlets (nullptr when there are
+       none) - these can be added to a descriptor set for culling or mesh
+       shaders */
+    inline SSBO* getMeshletsBuffer() { return ssboMeshlets; }
+    inline SSBO* getMeshletBoundsBuffer() { return ssboMeshletBounds; }
+    inline SSBO* getMeshletVerticesBuffer() { return ssboMeshletVertices; }
+    inline SSBO* getMeshletTrianglesBuffer() { return ssboMeshletTriangles; }
+
     // TODO: Add methods to update buffers that are separated
 };
 
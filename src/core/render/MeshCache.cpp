@@ -0,0 +1,386 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+#include "MeshLoader.h"
+
+/*****************************************************************************
+ * MeshCacheFile class
+ *****************************************************************************/
+
+/* Returns an offset rounded up to the alignment of the sections */
+static inline uint64_t alignOffset(uint64_t offset) {
+    return (offset + MeshCacheFile::ALIGNMENT - 1) & ~(MeshCacheFile::ALIGNMENT - 1);
+}
+
+/* Returns the formats in a header as used for the data types in
+   MeshData::DataType order */
+static MeshData::VertexFormats getVertexFormats(const MeshCacheFile::Header& header) {
+    MeshData::VertexFormats formats;
+    MeshData::VertexFormat* values[] = {&formats.position, &formats.colour, &formats.textureCoord, &formats.normal, &formats.tangent, &formats.bitangent};
+    for (unsigned int i = 0; i < 6; ++i)
+        *values[i] = static_cast<MeshData::VertexFormat>(header.vertexFormats[i]);
+    return formats;
+}
+
+/* Copies the values in a section into a vector */
+template <typename T>
+static void copySection(const MeshCacheFile& file, unsigned int section, std::vector<T>& values) {
+    size_t size;
+    const T* data = static_cast<const T*>(file.getSection(section, size));
+    if (data)
+        values.assign(data, data + size / sizeof(T));
+}
+
+/* Copies the indices in a section into a vector (converting them when
+   they are stored as 16 bit values) */
+static void copyIndices(const MeshCacheFile& file, unsigned int section, std::vector<uint32_t>& indices) {
+    if (file.getIndexSize() == sizeof(uint32_t)) {
+        copySection(file, section, indices);
+        return;
+    }
+    size_t size;
+    const uint16_t* data = static_cast<const uint16_t*>(file.getSection(section, size));
+    if (data)
+        indices.assign(data, data + size / sizeof(uint16_t));
+}
+
+bool MeshCacheFile::open(const std::string& path, uint64_t sourceHash) {
+    header = nullptr;
+    if (! file.open(path))
+        return false;
+
+    // Check the header before trusting any of its values (the mapping is
+    // page aligned so the header can be read in place)
+    const Header* fileHeader = reinterpret_cast<const Header*>(file.getData());
+    uint64_t fileSize        = file.getSize();
+    bool valid               = fileSize >= sizeof(Header) && fileHeader->magic == MAGIC && fileHeader->version == VERSION && fileHeader->sourceHash == sourceHash &&
+                 (fileHeader->numDimensions == MeshData::DIMENSIONS_2D || fileHeader->numDimensions == MeshData::DIMENSIONS_3D) && fileHeader->othersLayoutCount <= 8;
+    for (unsigned int i = 0; valid && i < 6; ++i)
+        valid = fileHeader->vertexFormats[i] <= MeshData::FORMAT_OCTAHEDRAL;
+    for (unsigned int i = 0; valid && i < fileHeader->othersLayoutCount; ++i)
+        valid = fileHeader->othersLayout[i] >= MeshData::POSITION && fileHeader->othersLayout[i] <= MeshData::BITANGENT;
+    valid = valid && (fileHeader->indexType == VK_INDEX_TYPE_UINT16 || fileHeader->indexType == VK_INDEX_TYPE_UINT32);
+
+    // Every section must lie within the file
+    for (unsigned int i = 0; valid && i < NUM_SECTIONS; ++i) {
+        const SectionInfo& section = fileHeader->sections[i];
+        valid                      = section.offset % ALIGNMENT == 0 && section.size <= fileSize && section.offset <= fileSize - section.size;
+    }
+    if (valid) {
+        uint64_t subDataCount = fileHeader->sections[SECTION_SUB_DATA].size / sizeof(MeshData::SubData);
+        valid                 = fileHeader->sections[SECTION_SUB_DATA_SPHERES].size == subDataCount * 4 * sizeof(float);
+
+        // Each level of detail must lie within the indices for them
+        uint64_t lodCount         = fileHeader->sections[SECTION_LODS].size / sizeof(MeshData::LOD);
+        uint64_t lodIndexCount    = fileHeader->sections[MeshRenderData::BUFFER_LOD_INDICES].size / (fileHeader->indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+        const MeshData::LOD* lods = reinterpret_cast<const MeshData::LOD*>(file.getData() + fileHeader->sections[SECTION_LODS].offset);
+        valid                     = valid && fileHeader->sections[SECTION_LOD_SUB_DATA].size == lodCount * subDataCount * sizeof(uint32_t);
+        for (uint64_t i = 0; valid && i < lodCount; ++i)
+            valid = static_cast<uint64_t>(lods[i].firstIndex) + lods[i].indexCount <= lodIndexCount;
+    }
+    if (valid) {
+        // Each section of vertex data must be empty or hold exactly
+        // vertexCount vertices, as reading them back relies on it (the
+        // separated sections are in the same order as the data types, and
+        // getDataTypeInfo throws for formats a data type doesn't support)
+        MeshData::VertexFormats formats = getVertexFormats(*fileHeader);
+        auto checkVertexSection         = [&](unsigned int section, uint64_t stride) {
+            uint64_t size = fileHeader->sections[section].size;
+            return size == 0 || size == fileHeader->vertexCount * stride;
+        };
+        try {
+            for (unsigned int i = MeshData::POSITION; valid && i <= MeshData::BITANGENT; ++i) {
+                MeshData::DataType dataType = static_cast<MeshData::DataType>(i);
+                valid                       = checkVertexSection(MeshRenderData::BUFFER_POSITIONS + i - MeshData::POSITION, MeshData::getDataTypeInfo(fileHeader->numDimensions, dataType, formats.get(dataType)).size);
+            }
+            uint64_t othersStride = 0;
+            for (unsigned int i = 0; i < fileHeader->othersLayoutCount; ++i) {
+                MeshData::DataType dataType = static_cast<MeshData::DataType>(fileHeader->othersLayout[i]);
+                othersStride += MeshData::getDataTypeInfo(fileHeader->numDimensions, dataType, formats.get(dataType)).size;
+            }
+            valid = valid && checkVertexSection(MeshRenderData::BUFFER_OTHERS, othersStride);
+        } catch (const std::runtime_error&) {
+            valid = false;
+        }
+    }
+
+    if (! valid) {
+        Logger::log("Ignoring invalid or outdated mesh cache file '" + path + "'", "MeshCacheFile", LogType::Debug);
+        file.close();
+        return false;
+    }
+    header = fileHeader;
+    return true;
+}
+
+void MeshCacheFile::write(const std::string& path, MeshData* data, uint64_t sourceHash) {
+    Header header = {};
+    header.magic         = MAGIC;
+    header.version       = VERSION;
+    header.sourceHash    = sourceHash;
+    header.numDimensions = data->numDimensions;
+    header.separateFlags = data->separateFlags;
+    header.vertexCount   = data->vertexCount;
+
+    header.othersLayoutCount = static_cast<uint32_t>(data->othersLayout.size());
+    for (unsigned int i = 0; i < header.othersLayoutCount; ++i)
+        header.othersLayout[i] = data->othersLayout[i];
+
+    Sphere sphere = data->calculateBoundingSphere();
+    for (unsigned int i = 0; i < 3; ++i)
+        header.boundingSphere[i] = sphere.centre[i];
+    header.boundingSphere[3] = sphere.radius;
+
+    const MeshData::VertexFormats& formats = data->vertexFormats;
+    MeshData::DataType dataTypes[]         = {MeshData::POSITION, MeshData::COLOUR, MeshData::TEXTURE_COORD, MeshData::NORMAL, MeshData::TANGENT, MeshData::BITANGENT};
+    for (unsigned int i = 0; i < 6; ++i)
+        header.vertexFormats[i] = formats.get(dataTypes[i]);
+
+    MeshData::Dequantisation dequantisation = data->calculateDequantisation();
+    for (unsigned int i = 0; i < 3; ++i) {
+        header.dequantisation[i]     = dequantisation.scale[i];
+        header.dequantisation[i + 3] = dequantisation.offset[i];
+    }
+
+    // Gather the sections
+    MeshRenderData::BufferSource buffers[MeshRenderData::NUM_BUFFERS];
+    std::vector<uint8_t> storage[MeshRenderData::NUM_BUFFERS];
+    header.indexType = MeshRenderData::getBufferSources(data, buffers, storage, dequantisation);
+
+    MeshRenderData::BufferSource sources[NUM_SECTIONS];
+    std::copy(buffers, buffers + MeshRenderData::NUM_BUFFERS, sources);
+
+    std::vector<float> subDataSpheres;
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        sphere = data->calculateBoundingSphere(i);
+        subDataSpheres.insert(subDataSpheres.end(), {sphere.centre.getX(), sphere.centre.getY(), sphere.centre.getZ(), sphere.radius});
+    }
+    sources[SECTION_SUB_DATA]         = {data->subData.data(), data->subData.size() * sizeof(MeshData::SubData)};
+    sources[SECTION_SUB_DATA_SPHERES] = {subDataSpheres.data(), subDataSpheres.size() * sizeof(float)};
+    sources[SECTION_LODS]             = {data->lods.data(), data->lods.size() * sizeof(MeshData::LOD)};
+    sources[SECTION_LOD_SUB_DATA]     = {data->lodSubDataFirstIndices.data(), data->lodSubDataFirstIndices.size() * sizeof(uint32_t)};
+
+    // Assign the location of each
+    uint64_t offset = alignOffset(sizeof(Header));
+    for (unsigned int i = 0; i < NUM_SECTIONS; ++i) {
+        header.sections[i] = {offset, sources[i].size};
+        offset             = alignOffset(offset + sources[i].size);
+    }
+
+    // Write to a temporary file first so an interrupted write never leaves
+    // a partial file in place
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (! output.is_open())
+        Logger::logAndThrowError("Failed to open file '" + temporaryPath + "' for writing", "MeshCacheFile");
+
+    const char padding[ALIGNMENT] = {};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    uint64_t position = sizeof(Header);
+    for (unsigned int i = 0; i < NUM_SECTIONS; ++i) {
+        output.write(padding, static_cast<std::streamsize>(header.sections[i].offset - position));
+        output.write(static_cast<const char*>(sources[i].data), static_cast<std::streamsize>(sources[i].size));
+        position = header.sections[i].offset + sources[i].size;
+    }
+    output.close();
+    if (! output)
+        Logger::logAndThrowError("Failed to write file '" + temporaryPath + "'", "MeshCacheFile");
+
+    std::remove(path.c_str());
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        Logger::logAndThrowError("Failed to rename file '" + temporaryPath + "' to '" + path + "'", "MeshCacheFile");
+}
+
+const void* MeshCacheFile::getSection(unsigned int section, size_t& size) const {
+    size = static_cast<size_t>(header->sections[section].size);
+    return size > 0 ? file.getData() + header->sections[section].offset : nullptr;
+}
+
+uint32_t MeshCacheFile::getCount() const {
+    uint64_t indicesSize = header->sections[MeshRenderData::BUFFER_INDICES].size;
+    return indicesSize > 0 ? static_cast<uint32_t>(indicesSize / getIndexSize()) : header->vertexCount;
+}
+
+uint32_t MeshCacheFile::getSubDataCount() const {
+    return static_cast<uint32_t>(header->sections[SECTION_SUB_DATA].size / sizeof(MeshData::SubData));
+}
+
+Sphere MeshCacheFile::getBoundingSphere() const {
+    const float* values = header->boundingSphere;
+    return Sphere(values[0], values[1], values[2], values[3]);
+}
+
+Sphere MeshCacheFile::getBoundingSphere(unsigned int subDataIndex) const {
+    size_t size;
+    const float* values = static_cast<const float*>(getSection(SECTION_SUB_DATA_SPHERES, size)) + subDataIndex * 4;
+    return Sphere(values[0], values[1], values[2], values[3]);
+}
+
+MeshData::Dequantisation MeshCacheFile::getDequantisation() const {
+    MeshData::Dequantisation dequantisation;
+    for (unsigned int i = 0; i < 3; ++i) {
+        dequantisation.scale[i]  = header->dequantisation[i];
+        dequantisation.offset[i] = header->dequantisation[i + 3];
+    }
+    return dequantisation;
+}
+
+MeshData* MeshCacheFile::createMeshData() const {
+    MeshData* data      = new MeshData(header->numDimensions, static_cast<MeshData::SeparateFlags>(header->separateFlags));
+    data->vertexCount   = header->vertexCount;
+    data->vertexFormats = getVertexFormats(*header);
+    for (unsigned int i = 0; i < header->othersLayoutCount; ++i) {
+        MeshData::DataType dataType = static_cast<MeshData::DataType>(header->othersLayout[i]);
+        data->addToOthersLayout(dataType, MeshData::getDataTypeInfo(header->numDimensions, dataType).separateFlag);
+    }
+
+    const MeshData::VertexFormats& formats  = data->vertexFormats;
+    MeshData::Dequantisation dequantisation = getDequantisation();
+
+    // Copies a section of separated vertex data, converting it back to
+    // floats when it was stored in another format
+    auto copyVertexData = [&](unsigned int section, MeshData::DataType dataType, std::vector<float>& values) {
+        MeshData::VertexFormat format = formats.get(dataType);
+        if (format == MeshData::FORMAT_FLOAT) {
+            copySection(*this, section, values);
+            return;
+        }
+        size_t size;
+        const uint8_t* source   = static_cast<const uint8_t*>(getSection(section, size));
+        unsigned int components = data->getNumComponents(dataType);
+        uint32_t stride         = MeshData::getDataTypeInfo(header->numDimensions, dataType, format).size;
+        size_t count            = size / stride;
+        values.resize(count * components);
+        if (source)
+            MeshData::unpackVertexData(header->numDimensions, dataType, format, dequantisation, source, stride, values.data(), components, count);
+    };
+
+    copyVertexData(MeshRenderData::BUFFER_POSITIONS, MeshData::POSITION, data->positions);
+    copyVertexData(MeshRenderData::BUFFER_COLOURS, MeshData::COLOUR, data->colours);
+    copyVertexData(MeshRenderData::BUFFER_TEXTURE_COORDS, MeshData::TEXTURE_COORD, data->textureCoords);
+    copyVertexData(MeshRenderData::BUFFER_NORMALS, MeshData::NORMAL, data->normals);
+    copyVertexData(MeshRenderData::BUFFER_TANGENTS, MeshData::TANGENT, data->tangents);
+    copyVertexData(MeshRenderData::BUFFER_BITANGENTS, MeshData::BITANGENT, data->bitangents);
+
+    // Interleaved data is converted one data type at a time from its place
+    // within each vertex
+    const std::vector<MeshData::DataType>& layout = data->othersLayout;
+    if (formats.isQuantised() && ! layout.empty()) {
+        size_t size;
+        const uint8_t* source = static_cast<const uint8_t*>(getSection(MeshRenderData::BUFFER_OTHERS, size));
+        size_t outStride      = 0;
+        size_t stride         = 0;
+        for (MeshData::DataType dataType : layout) {
+            outStride += data->getNumComponents(dataType);
+            stride += MeshData::getDataTypeInfo(header->numDimensions, dataType, formats.get(dataType)).size;
+        }
+        size_t count = size / stride;
+        data->others.resize(count * outStride);
+
+        size_t outOffset = 0;
+        size_t offset    = 0;
+        for (MeshData::DataType dataType : layout) {
+            MeshData::VertexFormat format = formats.get(dataType);
+            if (source)
+                MeshData::unpackVertexData(header->numDimensions, dataType, format, dequantisation, source + offset, stride, data->others.data() + outOffset, outStride, count);
+            outOffset += data->getNumComponents(dataType);
+            offset += MeshData::getDataTypeInfo(header->numDimensions, dataType, format).size;
+        }
+    } else
+        copySection(*this, MeshRenderData::BUFFER_OTHERS, data->others);
+    copySection(*this, MeshRenderData::BUFFER_BONE_INDICES, data->boneIndices);
+    copySection(*this, MeshRenderData::BUFFER_BONE_WEIGHTS, data->boneWeights);
+    copySection(*this, MeshRenderData::BUFFER_MATERIAL_INDICES, data->materialIndices);
+    copySection(*this, MeshRenderData::BUFFER_OFFSET_INDICES, data->offsetIndices);
+    copyIndices(*this, MeshRenderData::BUFFER_INDICES, data->indices);
+    copyIndices(*this, MeshRenderData::BUFFER_LOD_INDICES, data->lodIndices);
+    copySection(*this, MeshRenderData::BUFFER_MESHLETS, data->meshlets);
+    copySection(*this, MeshRenderData::BUFFER_MESHLET_BOUNDS, data->meshletBounds);
+    copySection(*this, MeshRenderData::BUFFER_MESHLET_VERTICES, data->meshletVertices);
+    copySection(*this, MeshRenderData::BUFFER_MESHLET_TRIANGLES, data->meshletTriangles);
+    copySection(*this, SECTION_SUB_DATA, data->subData);
+    copySection(*this, SECTION_LODS, data->lods);
+    copySection(*this, SECTION_LOD_SUB_DATA, data->lodSubDataFirstIndices);
+    return data;
+}
+
+MeshRenderData* MeshCacheFile::createRenderData(Renderer* renderer) const {
+    MeshRenderData::BufferSource sources[MeshRenderData::NUM_BUFFERS];
+    for (unsigned int i = 0; i < MeshRenderData::NUM_BUFFERS; ++i)
+        sources[i].data = getSection(i, sources[i].size);
+
+    std::vector<MeshData::LOD> lods;
+    copySection(*this, SECTION_LODS, lods);
+    return new MeshRenderData(renderer, sources, getCount(), lods, getDequantisation(), static_cast<VkIndexType>(header->indexType));
+}
+
+/*****************************************************************************
+ * MeshCache class
+ *****************************************************************************/
+
+const std::string MeshCache::EXTENSION = ".uemesh";
+
+uint64_t MeshCache::hashSource(const std::string& path, const Settings& settings) {
+    // Each value is hashed on its own so any padding within Settings can't
+    // affect the result
+    std::vector<std::string> files = MeshLoader::getSourceFiles(path);
+    uint64_t hash                  = utils_file::hashFile(files[0]);
+    auto add                       = [&hash](const auto& value) { hash = utils_file::hash(&value, sizeof(value), hash); };
+
+    // Any other files the asset refers to (so editing the external buffers
+    // of a .gltf file rebuilds it)
+    for (size_t i = 1; i < files.size(); ++i)
+        add(utils_file::hashFile(files[i]));
+
+    add(static_cast<uint32_t>(settings.separateFlags));
+    for (unsigned int i = MeshData::POSITION; i <= MeshData::BITANGENT; ++i)
+        add(static_cast<uint32_t>(settings.vertexFormats.get(static_cast<MeshData::DataType>(i))));
+
+    // Parameters of the passes that aren't used are ignored, so changing
+    // them doesn't needlessly rebuild meshes
+    add(static_cast<uint8_t>(settings.weldVertices));
+    if (settings.weldVertices)
+        add(settings.weldEpsilon);
+    add(static_cast<uint32_t>(settings.lodCount));
+    if (settings.lodCount > 0) {
+        add(settings.lodRatio);
+        add(settings.lodMaxError);
+    }
+    add(static_cast<uint8_t>(settings.optimiseVertexCache));
+    add(static_cast<uint8_t>(settings.optimiseOverdraw));
+    add(static_cast<uint8_t>(settings.optimiseVertexFetch));
+    if (settings.optimiseVertexCache || settings.optimiseOverdraw)
+        add(static_cast<uint32_t>(settings.cacheSize));
+    if (settings.optimiseOverdraw)
+        add(settings.overdrawThreshold);
+    add(static_cast<uint8_t>(settings.buildMeshlets));
+    if (settings.buildMeshlets) {
+        add(static_cast<uint32_t>(settings.maxMeshletVertices));
+        add(static_cast<uint32_t>(settings.maxMeshletTriangles));
+    }
+    add(settings.custom);
+    return hash;
+}
+
+std::string MeshCache::getPath(uint64_t sourceHash) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016" PRIx64, sourceHash);
+    return directory + "/" + name + EXTENSION;
+}
+
+MeshCacheFile* MeshCache::load(uint64_t sourceHash) const {
+    MeshCacheFile* file = new MeshCacheFile();
+    if (file->open(getPath(sourceHash), sourceHash))
+        return file;
+    delete file;
+    return nullptr;
+}
+
+void MeshCache::save(uint64_t sourceHash, MeshData* data) const {
+    utils_file::createDirectories(directory);
+    MeshCacheFile::write(getPath(sourceHash), data, sourceHash);
+}
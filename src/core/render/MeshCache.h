@@ -0,0 +1,219 @@
+#pragma once
+
+#include "../../utils/FileUtils.h"
+#include "Mesh.h"
+#include "MeshOptimiser.h"
+
+/*****************************************************************************
+ * MeshCacheFile class - A mesh stored in the binary cache format and mapped
+ *                       into memory
+ *****************************************************************************/
+
+// A file starts with a fixed size header followed by each buffer of a
+// MeshData exactly as it is given to the GPU (already interleaved or
+// separated, and converted to the vertex formats and index type of the mesh,
+// as it was when written), then the sub data, the bounding sphere of each sub data and the
+// ranges of the levels of detail. Every section starts on an ALIGNMENT byte
+// boundary and is located by its offset and size in the header, so once the
+// file is mapped the buffers can be used in place without any parsing (e.g.
+// copied straight into staging memory by createRenderData). Values are
+// stored in the byte order of the machine that wrote them (a mismatch shows
+// up as a bad magic number) and VERSION changes whenever the layout does, so
+// outdated files are simply rebuilt.
+
+class MeshCacheFile {
+public:
+    /* Identifies the format ("UEMC" when read as bytes on a little endian
+       machine) and the version of its layout */
+    static const uint32_t MAGIC   = 0x434D4555;
+    static const uint32_t VERSION = 5;
+
+    /* Alignment of each section in bytes */
+    static const uint64_t ALIGNMENT = 64;
+
+    /* Sections of a file - the buffers come first (in the order of
+       MeshRenderData::Buffer) followed by these */
+    enum Section {
+        SECTION_SUB_DATA = MeshRenderData::NUM_BUFFERS,
+        SECTION_SUB_DATA_SPHERES,
+        SECTION_LODS,
+        SECTION_LOD_SUB_DATA,
+        NUM_SECTIONS
+    };
+
+    /* Location of a section within a file (in bytes) */
+    struct SectionInfo {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /* Header at the start of a file */
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        // Key the mesh was cached under (see MeshCache::hashSource)
+        uint64_t sourceHash;
+
+        // Values needed to recreate the MeshData
+        uint32_t numDimensions;
+        uint32_t separateFlags;
+        uint32_t vertexCount;
+        uint32_t othersLayoutCount;
+        uint32_t othersLayout[8];
+
+        // Format of each data type (in the order of MeshData::DataType) and
+        // the dequantisation of the positions (scale followed by offset)
+        uint32_t vertexFormats[6];
+        float dequantisation[6];
+
+        // Type of the indices and levels of detail indices (a VkIndexType)
+        uint32_t indexType;
+
+        // Bounding sphere of the whole mesh (centre followed by radius)
+        float boundingSphere[4];
+
+        // Unused (always 0) - keeps the sections 8 byte aligned without
+        // implicit padding, so nothing uninitialised is written
+        uint32_t reserved;
+
+        SectionInfo sections[NUM_SECTIONS];
+    };
+
+private:
+    /* The mapped file and its header */
+    MappedFile file;
+    const Header* header = nullptr;
+
+public:
+    /* Constructor and destructor */
+    MeshCacheFile() {}
+    virtual ~MeshCacheFile() {}
+
+    /* Maps a file - returns whether it is a valid file of the current
+       version created from a source with the given hash */
+    bool open(const std::string& path, uint64_t sourceHash);
+
+    /* Writes a mesh to a file (replacing any existing one only once it has
+       been written completely) */
+    static void write(const std::string& path, MeshData* data, uint64_t sourceHash);
+
+    /* Returns a pointer to the start of a section within the mapped file
+       (nullptr if it is empty) and assigns its size in bytes */
+    const void* getSection(unsigned int section, size_t& size) const;
+
+    /* Returns the header of this file */
+    inline const Header& getHeader() const { return *header; }
+
+    /* Returns the number of indices, or vertices when there are none (as
+       MeshData::getCount) */
+    uint32_t getCount() const;
+
+    /* Returns the number of sub data */
+    uint32_t getSubDataCount() const;
+
+    /* Returns the bounding sphere of the whole mesh or of a sub data */
+    Sphere getBoundingSphere() const;
+    Sphere getBoundingSphere(unsigned int subDataIndex) const;
+
+    /* Returns the dequantisation of the positions in this file */
+    MeshData::Dequantisation getDequantisation() const;
+
+    /* Returns the size of each index in this file in bytes */
+    inline size_t getIndexSize() const { return header->indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+    /* Creates a MeshData instance containing the data in this file (with a
+       single copy for each buffer, other than those stored in a quantised
+       format which are converted back to floats so are only approximately
+       the same as when written) */
+    MeshData* createMeshData() const;
+
+    /* Creates render data with buffers copied straight from this file */
+    MeshRenderData* createRenderData(Renderer* renderer) const;
+};
+
+/*****************************************************************************
+ * MeshCache class - Stores meshes in a directory using the binary cache
+ *                   format, keyed by a hash of the asset they came from and
+ *                   the settings it was processed with
+ *****************************************************************************/
+
+// Typical use is
+//     MeshCache::Settings settings;
+//     settings.separateFlags = ... (along with anything else that differs
+//                                   from the defaults)
+//     uint64_t hash       = MeshCache::hashSource(path, settings);
+//     MeshCacheFile* file = cache.load(hash);
+//     if (! file) {
+//         MeshData* data = ... (load and process the asset as the settings
+//                               describe)
+//         cache.save(hash, data);
+//     }
+// Keying on the contents of the asset (rather than its path or time stamp),
+// including any files it refers to such as the external buffers of a glTF
+// file, means edited assets are rebuilt while copies of the same asset share
+// a single cache file. As the settings are part of the key, loading the same
+// asset with different settings uses a different file rather than returning
+// a mesh with the wrong layout.
+
+class MeshCache {
+private:
+    /* Directory the cache files are stored in */
+    std::string directory;
+
+public:
+    /* File extension of the cache files */
+    static const std::string EXTENSION;
+
+    /* Settings that affect the contents of a cached mesh - those of the
+       MeshOptimiser passes are only used when the pass is */
+    struct Settings {
+        // Layout of the vertex data
+        MeshData::SeparateFlags separateFlags = MeshData::SEPARATE_NONE;
+        MeshData::VertexFormats vertexFormats;
+
+        // MeshOptimiser::weldVertices
+        bool weldVertices = false;
+        float weldEpsilon = 0.0f;
+
+        // MeshOptimiser::generateLODs (when lodCount isn't 0)
+        unsigned int lodCount = 0;
+        float lodRatio        = MeshOptimiser::DEFAULT_LOD_RATIO;
+        float lodMaxError     = std::numeric_limits<float>::max();
+
+        // MeshOptimiser::optimiseVertexCache, optimiseOverdraw and
+        // optimiseVertexFetch
+        bool optimiseVertexCache = false;
+        bool optimiseOverdraw    = false;
+        bool optimiseVertexFetch = false;
+        unsigned int cacheSize   = MeshOptimiser::DEFAULT_CACHE_SIZE;
+        float overdrawThreshold  = MeshOptimiser::DEFAULT_OVERDRAW_THRESHOLD;
+
+        // MeshOptimiser::buildMeshlets
+        bool buildMeshlets               = false;
+        unsigned int maxMeshletVertices  = MeshOptimiser::DEFAULT_MESHLET_VERTICES;
+        unsigned int maxMeshletTriangles = MeshOptimiser::DEFAULT_MESHLET_TRIANGLES;
+
+        // Anything else the application does to its meshes (e.g. a version
+        // number to change when its own processing does)
+        uint64_t custom = 0;
+    };
+
+    /* Constructor and destructor */
+    MeshCache(const std::string& directory) : directory(directory) {}
+    virtual ~MeshCache() {}
+
+    /* Returns the hash of a source asset (along with any files it refers
+       to, see MeshLoader::getSourceFiles) and the settings it is processed
+       with used to look it up */
+    static uint64_t hashSource(const std::string& path, const Settings& settings);
+
+    /* Returns the path of the cache file for a source hash */
+    std::string getPath(uint64_t sourceHash) const;
+
+    /* Returns the cached mesh for a source hash (which should be deleted
+       when no longer needed), or nullptr if there isn't a valid one */
+    MeshCacheFile* load(uint64_t sourceHash) const;
+
+    /* Adds a mesh to the cache (replacing any existing version) */
+    void save(uint64_t sourceHash, MeshData* data) const;
+};
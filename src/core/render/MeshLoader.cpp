@@ -0,0 +1,1420 @@
+#include "MeshLoader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "../../utils/FileUtils.h"
+#include "../../utils/Logging.h"
+#include "../maths/Batch.h"
+#include "../maths/Quaternion.h"
+
+/*****************************************************************************
+ * Parsing
+ *****************************************************************************/
+
+/* Powers of 10 that are exactly representable as doubles */
+static const double POWERS_OF_10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* Calls function(i) for each i in [0, count) using a thread per hardware
+   thread (rethrowing any exception thrown) */
+template <typename Function>
+static void parallelFor(size_t count, Function function) {
+    std::atomic<size_t> next(0);
+    auto run = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+            function(i);
+    };
+    size_t threads = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), count);
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 1; i < threads; ++i)
+        tasks.push_back(std::async(std::launch::async, run));
+    run();
+    for (std::future<void>& task : tasks)
+        task.get();
+}
+
+/* Returns whether a character separates tokens on a line */
+static inline bool isSpace(char character) {
+    return character == ' ' || character == '\t' || character == '\r';
+}
+
+static inline bool isDigit(char character) {
+    return character >= '0' && character <= '9';
+}
+
+/* Returns the start of the line after the one text is in */
+static inline const char* nextLine(const char* text, const char* end) {
+    const char* newline = static_cast<const char*>(std::memchr(text, '\n', static_cast<size_t>(end - text)));
+    return newline ? newline + 1 : end;
+}
+
+/* Returns text after any spaces */
+static inline const char* skipSpaces(const char* text, const char* end) {
+    while (text < end && isSpace(*text))
+        ++text;
+    return text;
+}
+
+/* Parses a number that isn't a plain decimal one (e.g. "nan" or "inf")
+   using strtod */
+static bool parseSpecialNumber(const char*& text, const char* end, double& value) {
+    char buffer[64];
+    size_t length = 0;
+    while (text + length < end && length < sizeof(buffer) - 1 && ! isSpace(text[length]) && text[length] != '\n' && text[length] != '/' && text[length] != ',')
+        ++length;
+    std::memcpy(buffer, text, length);
+    buffer[length] = '\0';
+
+    char* numberEnd;
+    value = std::strtod(buffer, &numberEnd);
+    if (numberEnd == buffer)
+        return false;
+    text += numberEnd - buffer;
+    return true;
+}
+
+/* Parses a number at text (after any spaces), advancing text past it and
+   returning whether there was one. At most 19 significant digits are used
+   (far more than a float needs). */
+static bool parseNumber(const char*& text, const char* end, double& value) {
+    const char* current = skipSpaces(text, end);
+    const char* start   = current;
+    bool negative       = false;
+    if (current < end && (*current == '-' || *current == '+')) {
+        negative = *current == '-';
+        ++current;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent      = 0;
+    int digits        = 0;
+    bool found        = false;
+    for (; current < end && isDigit(*current); ++current) {
+        found = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+            digits += mantissa != 0;
+        } else
+            ++exponent;
+    }
+    if (current < end && *current == '.') {
+        for (++current; current < end && isDigit(*current); ++current) {
+            found = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (! found) {
+        if (! parseSpecialNumber(current = start, end, value))
+            return false;
+        text = current;
+        return true;
+    }
+
+    if (current < end && (*current == 'e' || *current == 'E')) {
+        const char* exponentText = current + 1;
+        bool negativeExponent    = false;
+        if (exponentText < end && (*exponentText == '-' || *exponentText == '+')) {
+            negativeExponent = *exponentText == '-';
+            ++exponentText;
+        }
+        if (exponentText < end && isDigit(*exponentText)) {
+            int exponentValue = 0;
+            for (; exponentText < end && isDigit(*exponentText); ++exponentText)
+                exponentValue = std::min(exponentValue * 10 + (*exponentText - '0'), 100000);
+            exponent += negativeExponent ? -exponentValue : exponentValue;
+            current = exponentText;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0) {
+        for (; exponent > 22; exponent -= 22)
+            result *= POWERS_OF_10[22];
+        for (; exponent < -22; exponent += 22)
+            result /= POWERS_OF_10[22];
+        result = exponent >= 0 ? result * POWERS_OF_10[exponent] : result / POWERS_OF_10[-exponent];
+    }
+    value = negative ? -result : result;
+    text  = current;
+    return true;
+}
+
+static inline bool parseFloat(const char*& text, const char* end, float& value) {
+    double number;
+    if (! parseNumber(text, end, number))
+        return false;
+    value = static_cast<float>(number);
+    return true;
+}
+
+/* Parses an integer at text (after any spaces), advancing text past it and
+   returning whether there was one */
+static bool parseInt(const char*& text, const char* end, int64_t& value) {
+    const char* current = skipSpaces(text, end);
+    bool negative       = false;
+    if (current < end && (*current == '-' || *current == '+')) {
+        negative = *current == '-';
+        ++current;
+    }
+    if (current >= end || ! isDigit(*current))
+        return false;
+    int64_t result = 0;
+    for (; current < end && isDigit(*current); ++current)
+        result = std::min(result * 10 + (*current - '0'), static_cast<int64_t>(INT32_MAX));
+    value = negative ? -result : result;
+    text  = current;
+    return true;
+}
+
+/* Returns whether a line starts with a keyword followed by a space */
+static inline bool isKeyword(const char* text, const char* end, const char* keyword, size_t length) {
+    return static_cast<size_t>(end - text) > length && std::memcmp(text, keyword, length) == 0 && isSpace(text[length]);
+}
+
+/* Returns the start of some text for errors */
+static inline std::string getExcerpt(const char* text, const char* end) {
+    return std::string(text, std::min(static_cast<size_t>(nextLine(text, end) - text), static_cast<size_t>(40)));
+}
+
+/* Moves the values of one vector onto the end of another */
+template <typename T>
+static void append(std::vector<T>& values, std::vector<T>& other) {
+    values.insert(values.end(), other.begin(), other.end());
+    std::vector<T>().swap(other);
+}
+
+/* Returns the extension of a path in lower case (including the '.') */
+static std::string getExtension(const std::string& path) {
+    std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char character) { return static_cast<char>(std::tolower(static_cast<unsigned char>(character))); });
+    return extension;
+}
+
+/*****************************************************************************
+ * OBJ files
+ *****************************************************************************/
+
+/* Value used when an index isn't given */
+static const int32_t NO_INDEX = INT32_MIN;
+
+/* Value used before a material is assigned */
+static const uint32_t NO_MATERIAL = 0xFFFFFFFF;
+
+/* Size of the chunks an OBJ file is split into to parse in parallel (each
+   continues to the end of the line it finishes in) */
+static const size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+/* Data parsed from a chunk of an OBJ file */
+struct OBJChunk {
+    const char* begin;
+    const char* end;
+
+    std::vector<float> positions;
+    std::vector<float> colours;
+    std::vector<float> textureCoords;
+    std::vector<float> normals;
+
+    // Indices of the position, texture coordinate and normal (from 0, or
+    // NO_INDEX) of each corner of each triangle - negative indices are
+    // stored relative to the first value of this chunk and their locations
+    // added to relativeIndices
+    std::vector<int32_t> corners;
+    std::vector<size_t> relativeIndices;
+
+    // Materials used from a triangle onwards
+    std::vector<std::pair<size_t, std::string_view>> materials;
+};
+
+/* A corner of a face before it is triangulated */
+struct OBJCorner {
+    int32_t indices[3];
+    // Bit i is set when indices[i] is relative
+    unsigned int relative;
+};
+
+/* Parses a chunk of an OBJ file */
+static void parseOBJChunk(OBJChunk& chunk) {
+    std::vector<OBJCorner> face;
+    const char* end = chunk.end;
+    for (const char* text = chunk.begin; text < end;) {
+        const char* lineEnd = nextLine(text, end);
+        text                = skipSpaces(text, lineEnd);
+
+        if (isKeyword(text, lineEnd, "v", 1)) {
+            // x, y and z optionally followed by w, or r, g and b
+            float values[6];
+            unsigned int count = 0;
+            for (text += 1; count < 6 && parseFloat(text, lineEnd, values[count]); ++count)
+                ;
+            if (count < 3)
+                Logger::logAndThrowError("Invalid position '" + getExcerpt(text, lineEnd) + "'", "MeshLoader");
+            chunk.positions.insert(chunk.positions.end(), values, values + 3);
+
+            // Colours are only stored once one is given, for every position
+            // from the start of the chunk
+            if (count == 6 && chunk.colours.empty())
+                chunk.colours.resize(chunk.positions.size() - 3, 1.0f);
+            if (count == 6)
+                chunk.colours.insert(chunk.colours.end(), values + 3, values + 6);
+            else if (! chunk.colours.empty())
+                chunk.colours.insert(chunk.colours.end(), {1.0f, 1.0f, 1.0f});
+        } else if (isKeyword(text, lineEnd, "vt", 2)) {
+            float values[2] = {0.0f, 0.0f};
+            text += 2;
+            if (! parseFloat(text, lineEnd, values[0]))
+                Logger::logAndThrowError("Invalid texture coordinate '" + getExcerpt(text, lineEnd) + "'", "MeshLoader");
+            parseFloat(text, lineEnd, values[1]);
+            chunk.textureCoords.insert(chunk.textureCoords.end(), {values[0], 1.0f - values[1]});
+        } else if (isKeyword(text, lineEnd, "vn", 2)) {
+            float values[3];
+            text += 2;
+            if (! parseFloat(text, lineEnd, values[0]) || ! parseFloat(text, lineEnd, values[1]) || ! parseFloat(text, lineEnd, values[2]))
+                Logger::logAndThrowError("Invalid normal '" + getExcerpt(text, lineEnd) + "'", "MeshLoader");
+            chunk.normals.insert(chunk.normals.end(), values, values + 3);
+        } else if (isKeyword(text, lineEnd, "f", 1)) {
+            // Each corner is v, v/vt, v//vn or v/vt/vn
+            size_t counts[3] = {chunk.positions.size() / 3, chunk.textureCoords.size() / 2, chunk.normals.size() / 3};
+            face.clear();
+            for (text = skipSpaces(text + 1, lineEnd); text < lineEnd && *text != '\n' && *text != '#';) {
+                OBJCorner corner = {{NO_INDEX, NO_INDEX, NO_INDEX}, 0};
+                for (unsigned int i = 0; i < 3; ++i) {
+                    int64_t index;
+                    if (parseInt(text, lineEnd, index)) {
+                        if (index == 0)
+                            Logger::logAndThrowError("Invalid index 0 in face '" + getExcerpt(text, lineEnd) + "'", "MeshLoader");
+                        if (index < 0) {
+                            corner.indices[i] = static_cast<int32_t>(static_cast<int64_t>(counts[i]) + index);
+                            corner.relative |= 1u << i;
+                        } else
+                            corner.indices[i] = static_cast<int32_t>(index - 1);
+                    } else if (i == 0)
+                        Logger::logAndThrowError("Invalid face '" + getExcerpt(text, lineEnd) + "'", "MeshLoader");
+                    if (i == 2 || text >= lineEnd || *text != '/')
+                        break;
+                    ++text;
+                }
+                face.push_back(corner);
+                text = skipSpaces(text, lineEnd);
+            }
+
+            // Split into a fan of triangles
+            for (size_t i = 2; i < face.size(); ++i) {
+                for (const OBJCorner* corner : {&face[0], &face[i - 1], &face[i]}) {
+                    for (unsigned int j = 0; j < 3; ++j) {
+                        if (corner->relative & (1u << j))
+                            chunk.relativeIndices.push_back(chunk.corners.size());
+                        chunk.corners.push_back(corner->indices[j]);
+                    }
+                }
+            }
+        } else if (isKeyword(text, lineEnd, "usemtl", 6)) {
+            const char* name    = skipSpaces(text + 6, lineEnd);
+            const char* nameEnd = lineEnd;
+            while (nameEnd > name && (isSpace(nameEnd[-1]) || nameEnd[-1] == '\n'))
+                --nameEnd;
+            chunk.materials.push_back({chunk.corners.size() / 9, std::string_view(name, static_cast<size_t>(nameEnd - name))});
+        }
+        text = lineEnd;
+    }
+}
+
+/* Vertices and indices of the triangles using a material */
+struct OBJSubData {
+    uint32_t materialIndex;
+    // Triangles using this material (indices into the corners)
+    std::vector<uint32_t> triangles;
+    // Position, texture coordinate and normal indices of each vertex
+    std::vector<int32_t> vertices;
+    // Indices relative to the first vertex
+    std::vector<uint32_t> indices;
+    bool hasTextureCoords = false;
+    bool hasNormals       = false;
+};
+
+/* Finds the distinct combinations of indices used by a sub data, checking
+   that they are in range */
+static void buildOBJSubData(OBJSubData& subData, const std::vector<int32_t>& corners, const size_t (&counts)[3]) {
+    size_t cornerCount = subData.triangles.size() * 3;
+    size_t tableSize   = 1;
+    while (tableSize < cornerCount * 2)
+        tableSize *= 2;
+    std::vector<uint32_t> table(tableSize, 0xFFFFFFFF);
+
+    subData.indices.reserve(cornerCount);
+    for (uint32_t triangle : subData.triangles) {
+        for (unsigned int i = 0; i < 3; ++i) {
+            const int32_t* corner = corners.data() + (static_cast<size_t>(triangle) * 3 + i) * 3;
+            if (corner[0] < 0 || static_cast<size_t>(corner[0]) >= counts[0] || (corner[1] != NO_INDEX && (corner[1] < 0 || static_cast<size_t>(corner[1]) >= counts[1])) ||
+                (corner[2] != NO_INDEX && (corner[2] < 0 || static_cast<size_t>(corner[2]) >= counts[2])))
+                Logger::logAndThrowError("Face index is out of range", "MeshLoader");
+            subData.hasTextureCoords |= corner[1] != NO_INDEX;
+            subData.hasNormals |= corner[2] != NO_INDEX;
+
+            uint64_t hash = (static_cast<uint64_t>(static_cast<uint32_t>(corner[0])) * 0x9E3779B97F4A7C15ull) ^ (static_cast<uint64_t>(static_cast<uint32_t>(corner[1])) * 0xC2B2AE3D27D4EB4Full) ^
+                            (static_cast<uint64_t>(static_cast<uint32_t>(corner[2])) * 0x165667B19E3779F9ull);
+            size_t slot = static_cast<size_t>(hash ^ (hash >> 32)) & (tableSize - 1);
+            while (table[slot] != 0xFFFFFFFF && ! std::equal(corner, corner + 3, subData.vertices.data() + table[slot] * 3))
+                slot = (slot + 1) & (tableSize - 1);
+            if (table[slot] == 0xFFFFFFFF) {
+                table[slot] = static_cast<uint32_t>(subData.vertices.size() / 3);
+                subData.vertices.insert(subData.vertices.end(), corner, corner + 3);
+            }
+            subData.indices.push_back(table[slot]);
+        }
+    }
+}
+
+MeshData* MeshLoader::loadOBJ(const std::string& path, MeshData::SeparateFlags flags, std::vector<std::string>* materialNames) {
+    MappedFile file;
+    if (! file.open(path))
+        Logger::logAndThrowError("Failed to open file '" + path + "'", "MeshLoader");
+
+    // Parse the chunks
+    std::vector<OBJChunk> chunks;
+    const char* end = file.getData() + file.getSize();
+    for (const char* text = file.getData(); text < end;) {
+        OBJChunk chunk;
+        chunk.begin = text;
+        chunk.end   = static_cast<size_t>(end - text) > OBJ_CHUNK_SIZE ? nextLine(text + OBJ_CHUNK_SIZE, end) : end;
+        chunks.push_back(std::move(chunk));
+        text = chunks.back().end;
+    }
+    parallelFor(chunks.size(), [&](size_t i) { parseOBJChunk(chunks[i]); });
+
+    // Combine the chunks, making the relative indices absolute
+    bool hasColours = std::any_of(chunks.begin(), chunks.end(), [](const OBJChunk& chunk) { return ! chunk.colours.empty(); });
+    std::vector<float> positions, colours, textureCoords, normals;
+    std::vector<int32_t> corners;
+    std::vector<size_t> firstTriangles;
+    for (OBJChunk& chunk : chunks) {
+        int32_t starts[3] = {static_cast<int32_t>(positions.size() / 3), static_cast<int32_t>(textureCoords.size() / 2), static_cast<int32_t>(normals.size() / 3)};
+        for (size_t index : chunk.relativeIndices)
+            chunk.corners[index] += starts[index % 3];
+        firstTriangles.push_back(corners.size() / 9);
+
+        if (hasColours && chunk.colours.empty())
+            colours.resize(colours.size() + chunk.positions.size(), 1.0f);
+        append(colours, chunk.colours);
+        append(positions, chunk.positions);
+        append(textureCoords, chunk.textureCoords);
+        append(normals, chunk.normals);
+        append(corners, chunk.corners);
+    }
+    size_t counts[3]     = {positions.size() / 3, textureCoords.size() / 2, normals.size() / 3};
+    size_t triangleCount = corners.size() / 9;
+
+    // Assign the material of each triangle, numbering them in the order
+    // they are first used (triangles before any are given use an unnamed
+    // one added at the end)
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, uint32_t> nameIndices;
+    std::vector<uint32_t> triangleMaterials(triangleCount);
+    uint32_t material = NO_MATERIAL;
+    size_t triangle   = 0;
+    auto assignMaterial = [&](size_t last) {
+        std::fill(triangleMaterials.begin() + triangle, triangleMaterials.begin() + last, material);
+        triangle = last;
+    };
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        for (const std::pair<size_t, std::string_view>& change : chunks[i].materials) {
+            assignMaterial(firstTriangles[i] + change.first);
+            auto result = nameIndices.insert({change.second, static_cast<uint32_t>(names.size())});
+            if (result.second)
+                names.push_back(change.second);
+            material = result.first->second;
+        }
+    }
+    assignMaterial(triangleCount);
+
+    // Group the triangles by material
+    std::vector<OBJSubData> subData(names.size() + 1);
+    for (size_t i = 0; i < subData.size(); ++i)
+        subData[i].materialIndex = static_cast<uint32_t>(i);
+    for (size_t i = 0; i < triangleCount; ++i)
+        subData[triangleMaterials[i] == NO_MATERIAL ? names.size() : triangleMaterials[i]].triangles.push_back(static_cast<uint32_t>(i));
+    subData.erase(std::remove_if(subData.begin(), subData.end(), [](const OBJSubData& current) { return current.triangles.empty(); }), subData.end());
+    if (materialNames) {
+        for (std::string_view name : names)
+            materialNames->emplace_back(name);
+        if (! subData.empty() && subData.back().materialIndex == names.size())
+            materialNames->emplace_back();
+    }
+
+    // Build the vertices of each sub data
+    parallelFor(subData.size(), [&](size_t i) { buildOBJSubData(subData[i], corners, counts); });
+
+    bool hasTextureCoords = std::any_of(subData.begin(), subData.end(), [](const OBJSubData& current) { return current.hasTextureCoords; });
+    bool hasNormals       = std::any_of(subData.begin(), subData.end(), [](const OBJSubData& current) { return current.hasNormals; });
+    std::vector<MeshData::DataType> dataTypes = {MeshData::POSITION};
+    if (hasColours)
+        dataTypes.push_back(MeshData::COLOUR);
+    if (hasTextureCoords)
+        dataTypes.push_back(MeshData::TEXTURE_COORD);
+    if (hasNormals)
+        dataTypes.push_back(MeshData::NORMAL);
+
+    MeshData* data = new MeshData(MeshData::DIMENSIONS_3D, flags);
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
+    for (OBJSubData& current : subData) {
+        data->addSubData(current.materialIndex, static_cast<uint32_t>(indexCount), static_cast<uint32_t>(vertexCount));
+        vertexCount += current.vertices.size() / 3;
+        indexCount += current.indices.size();
+    }
+    VertexStreams streams = allocateVertices(data, dataTypes, vertexCount, false);
+    data->getIndices().resize(indexCount);
+
+    // Write the vertices and indices of each sub data
+    parallelFor(subData.size(), [&](size_t i) {
+        const OBJSubData& current = subData[i];
+        MeshData::SubData& range  = data->getSubData(static_cast<unsigned int>(i));
+        std::copy(current.indices.begin(), current.indices.end(), data->getIndices().begin() + range.firstIndex);
+
+        for (size_t vertex = 0; vertex < current.vertices.size() / 3; ++vertex) {
+            const int32_t* corner = current.vertices.data() + vertex * 3;
+            size_t index          = range.vertexOffset + vertex;
+            std::copy_n(positions.data() + static_cast<size_t>(corner[0]) * 3, 3, streams.get(MeshData::POSITION, index));
+            if (hasColours) {
+                float* colour = streams.get(MeshData::COLOUR, index);
+                std::copy_n(colours.data() + static_cast<size_t>(corner[0]) * 3, 3, colour);
+                colour[3] = 1.0f;
+            }
+            if (hasTextureCoords && corner[1] != NO_INDEX)
+                std::copy_n(textureCoords.data() + static_cast<size_t>(corner[1]) * 2, 2, streams.get(MeshData::TEXTURE_COORD, index));
+            if (hasNormals && corner[2] != NO_INDEX)
+                std::copy_n(normals.data() + static_cast<size_t>(corner[2]) * 3, 3, streams.get(MeshData::NORMAL, index));
+        }
+    });
+    return data;
+}
+
+/*****************************************************************************
+ * glTF files
+ *****************************************************************************/
+
+/* Identifiers within a .glb file ("glTF", "JSON" and "BIN" when read as
+   bytes) */
+static const uint32_t GLB_MAGIC      = 0x46546C67;
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+static const uint32_t GLB_CHUNK_BIN  = 0x004E4942;
+
+/* Deepest nesting of JSON values and nodes allowed (so a malformed file
+   can't overflow the stack) */
+static const unsigned int GLTF_MAX_DEPTH = 128;
+
+/* Component types of accessors */
+enum GLTFComponentType {
+    GLTF_BYTE           = 5120,
+    GLTF_UNSIGNED_BYTE  = 5121,
+    GLTF_SHORT          = 5122,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT   = 5125,
+    GLTF_FLOAT          = 5126
+};
+
+/* Modes of primitives that give triangles */
+enum GLTFMode {
+    GLTF_TRIANGLES      = 4,
+    GLTF_TRIANGLE_STRIP = 5,
+    GLTF_TRIANGLE_FAN   = 6
+};
+
+/* Value within a JSON document - strings refer to the source text (still
+   escaped, see unescapeJSON) so parsing doesn't copy any */
+struct JSONValue {
+    enum Type {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Type type     = NUL;
+    double number = 0.0;  // Also 0 or 1 for booleans
+    std::string_view string;
+
+    // Elements of an array, or the values of the members of an object
+    // along with their names
+    std::vector<JSONValue> elements;
+    std::vector<std::string_view> keys;
+
+    /* Returns the value of a member of an object (nullptr if it doesn't
+       have it) */
+    const JSONValue* find(std::string_view key) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key)
+                return &elements[i];
+        }
+        return nullptr;
+    }
+
+    /* Returns the value of a member if it has the given type (nullptr
+       otherwise) */
+    inline const JSONValue* find(std::string_view key, Type type) const {
+        const JSONValue* value = find(key);
+        return value && value->type == type ? value : nullptr;
+    }
+
+    inline size_t size() const { return elements.size(); }
+    inline const JSONValue& operator[](size_t index) const { return elements[index]; }
+};
+
+/* Parses a JSON value at text, advancing text past it */
+static void parseJSON(const char*& text, const char* end, JSONValue& value, unsigned int depth) {
+    auto skipWhitespace = [&]() {
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n'))
+            ++text;
+    };
+    auto fail = [&](const std::string& message) { Logger::logAndThrowError(message + " in JSON at '" + getExcerpt(text, end) + "'", "MeshLoader"); };
+    auto parseString = [&]() {
+        const char* start = ++text;
+        while (text < end && *text != '"')
+            text += *text == '\\' ? 2 : 1;
+        if (text >= end)
+            fail("Unterminated string");
+        return std::string_view(start, static_cast<size_t>(text++ - start));
+    };
+    auto expect = [&](char character) {
+        skipWhitespace();
+        if (text >= end || *text != character)
+            fail(std::string("Expected '") + character + "'");
+        ++text;
+    };
+
+    if (depth > GLTF_MAX_DEPTH)
+        fail("Too many nested values");
+    skipWhitespace();
+    if (text >= end)
+        fail("Missing value");
+
+    switch (*text) {
+        case '{':
+            value.type = JSONValue::OBJECT;
+            ++text;
+            skipWhitespace();
+            if (text < end && *text == '}') {
+                ++text;
+                break;
+            }
+            do {
+                skipWhitespace();
+                if (text >= end || *text != '"')
+                    fail("Expected a name");
+                value.keys.push_back(parseString());
+                expect(':');
+                value.elements.emplace_back();
+                parseJSON(text, end, value.elements.back(), depth + 1);
+                skipWhitespace();
+            } while (text < end && *text == ',' && ++text);
+            expect('}');
+            break;
+        case '[':
+            value.type = JSONValue::ARRAY;
+            ++text;
+            skipWhitespace();
+            if (text < end && *text == ']') {
+                ++text;
+                break;
+            }
+            do {
+                value.elements.emplace_back();
+                parseJSON(text, end, value.elements.back(), depth + 1);
+                skipWhitespace();
+            } while (text < end && *text == ',' && ++text);
+            expect(']');
+            break;
+        case '"':
+            value.type   = JSONValue::STRING;
+            value.string = parseString();
+            break;
+        default:
+            for (const char* literal : {"true", "false", "null"}) {
+                size_t length = std::strlen(literal);
+                if (static_cast<size_t>(end - text) >= length && std::memcmp(text, literal, length) == 0) {
+                    value.type   = literal[0] == 'n' ? JSONValue::NUL : JSONValue::BOOLEAN;
+                    value.number = literal[0] == 't' ? 1.0 : 0.0;
+                    text += length;
+                    return;
+                }
+            }
+            value.type = JSONValue::NUMBER;
+            if (! parseNumber(text, end, value.number))
+                fail("Invalid value");
+            break;
+    }
+}
+
+/* Appends a character given by its code point as UTF-8 */
+static void appendUTF8(std::string& text, uint32_t codePoint) {
+    if (codePoint < 0x80)
+        text += static_cast<char>(codePoint);
+    else if (codePoint < 0x800) {
+        text += static_cast<char>(0xC0 | (codePoint >> 6));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        text += static_cast<char>(0xE0 | (codePoint >> 12));
+        text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        text += static_cast<char>(0xF0 | (codePoint >> 18));
+        text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+/* Returns the value of a hexadecimal digit (or -1 if it isn't one) */
+static inline int getHexValue(char character) {
+    if (isDigit(character))
+        return character - '0';
+    if (character >= 'a' && character <= 'f')
+        return character - 'a' + 10;
+    if (character >= 'A' && character <= 'F')
+        return character - 'A' + 10;
+    return -1;
+}
+
+/* Returns a JSON string with its escape sequences replaced */
+static std::string unescapeJSON(std::string_view text) {
+    // Reads the 4 digits of a \u escape at text[index]
+    auto readCodeUnit = [&](size_t index) {
+        uint32_t value = 0;
+        for (size_t i = index; i < index + 4; ++i) {
+            int digit = i < text.size() ? getHexValue(text[i]) : -1;
+            if (digit < 0)
+                return 0xFFFFFFFF;
+            value = value << 4 | static_cast<uint32_t>(digit);
+        }
+        return value;
+    };
+
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 >= text.size()) {
+            result += text[i];
+            continue;
+        }
+        char character = text[++i];
+        switch (character) {
+            case 'b':
+                result += '\b';
+                break;
+            case 'f':
+                result += '\f';
+                break;
+            case 'n':
+                result += '\n';
+                break;
+            case 'r':
+                result += '\r';
+                break;
+            case 't':
+                result += '\t';
+                break;
+            case 'u': {
+                uint32_t codePoint = readCodeUnit(i + 1);
+                if (codePoint == 0xFFFFFFFF)
+                    Logger::logAndThrowError("Invalid escape sequence in JSON string '" + std::string(text) + "'", "MeshLoader");
+                i += 4;
+                // Combine surrogate pairs
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 6 < text.size() && text[i + 1] == '\\' && text[i + 2] == 'u') {
+                    uint32_t low = readCodeUnit(i + 3);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                appendUTF8(result, codePoint);
+                break;
+            }
+            default:
+                result += character;
+                break;
+        }
+    }
+    return result;
+}
+
+/* Returns a URI with its percent encoded characters replaced */
+static std::string decodeURI(const std::string& uri) {
+    std::string result;
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() && getHexValue(uri[i + 1]) >= 0 && getHexValue(uri[i + 2]) >= 0) {
+            result += static_cast<char>(getHexValue(uri[i + 1]) << 4 | getHexValue(uri[i + 2]));
+            i += 2;
+        } else
+            result += uri[i];
+    }
+    return result;
+}
+
+/* Decodes base64 data */
+static std::vector<uint8_t> decodeBase64(std::string_view text) {
+    std::vector<uint8_t> result;
+    result.reserve(text.size() / 4 * 3);
+    uint32_t bits         = 0;
+    unsigned int bitCount = 0;
+    for (char character : text) {
+        uint32_t value;
+        if (character >= 'A' && character <= 'Z')
+            value = static_cast<uint32_t>(character - 'A');
+        else if (character >= 'a' && character <= 'z')
+            value = static_cast<uint32_t>(character - 'a' + 26);
+        else if (isDigit(character))
+            value = static_cast<uint32_t>(character - '0' + 52);
+        else if (character == '+' || character == '-')
+            value = 62;
+        else if (character == '/' || character == '_')
+            value = 63;
+        else if (character == '=')
+            break;
+        else
+            Logger::logAndThrowError("Invalid character in base64 data", "MeshLoader");
+
+        bits = bits << 6 | value;
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            result.push_back(static_cast<uint8_t>(bits >> bitCount));
+        }
+    }
+    return result;
+}
+
+/* A glTF file being loaded */
+struct GLTFFile {
+    MappedFile file;
+    JSONValue json;
+
+    // Data of each buffer, along with the external files and decoded data
+    // URIs they come from
+    std::vector<std::pair<const uint8_t*, size_t>> buffers;
+    std::vector<std::unique_ptr<MappedFile>> bufferFiles;
+    std::vector<std::vector<uint8_t>> bufferData;
+};
+
+/* Returns an index or count given by a member (or defaultValue when it
+   isn't given), checking it is a whole number and less than limit */
+static size_t getGLTFIndex(const JSONValue& value, std::string_view key, size_t limit, size_t defaultValue = SIZE_MAX) {
+    const JSONValue* member = value.find(key);
+    if (! member)
+        return defaultValue;
+    if (member->type != JSONValue::NUMBER || member->number < 0.0 || member->number >= static_cast<double>(limit) || member->number != std::floor(member->number))
+        Logger::logAndThrowError("Invalid value for '" + std::string(key) + "' in glTF file", "MeshLoader");
+    return static_cast<size_t>(member->number);
+}
+
+/* Returns an index given as an element of an array (e.g. the children of a
+   node), checking it is a whole number */
+static size_t getGLTFElementIndex(const JSONValue& value) {
+    if (value.type != JSONValue::NUMBER || value.number < 0.0 || value.number != std::floor(value.number))
+        Logger::logAndThrowError("Invalid index in glTF file", "MeshLoader");
+    return static_cast<size_t>(value.number);
+}
+
+/* Returns an element of a top level array of a glTF file (e.g. a mesh) */
+static const JSONValue& getGLTFElement(const GLTFFile& gltf, std::string_view array, size_t index) {
+    const JSONValue* values = gltf.json.find(array, JSONValue::ARRAY);
+    if (! values || index >= values->size())
+        Logger::logAndThrowError("Invalid index " + utils_string::str(index) + " into '" + std::string(array) + "' in glTF file", "MeshLoader");
+    return (*values)[index];
+}
+
+/* Location and layout of the elements of an accessor */
+struct GLTFAccessor {
+    // nullptr when it doesn't have a buffer view (so every value is 0)
+    const uint8_t* data = nullptr;
+    size_t count        = 0;
+    size_t stride       = 0;
+
+    unsigned int components    = 0;
+    unsigned int componentType = 0;
+    unsigned int componentSize = 0;
+    bool normalised            = false;
+};
+
+/* Returns an accessor of a glTF file, checking it lies within its buffer */
+static GLTFAccessor getGLTFAccessor(const GLTFFile& gltf, size_t index) {
+    const JSONValue& json = getGLTFElement(gltf, "accessors", index);
+    if (json.find("sparse"))
+        Logger::logAndThrowError("Sparse accessors aren't supported", "MeshLoader");
+
+    GLTFAccessor accessor;
+    accessor.count         = getGLTFIndex(json, "count", UINT32_MAX, 0);
+    accessor.componentType = static_cast<unsigned int>(getGLTFIndex(json, "componentType", GLTF_FLOAT + 1, 0));
+    switch (accessor.componentType) {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE:
+            accessor.componentSize = 1;
+            break;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT:
+            accessor.componentSize = 2;
+            break;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT:
+            accessor.componentSize = 4;
+            break;
+        default:
+            Logger::logAndThrowError("Unknown component type " + utils_string::str(accessor.componentType) + " in glTF file", "MeshLoader");
+    }
+
+    const JSONValue* type = json.find("type", JSONValue::STRING);
+    std::string_view types[] = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+    unsigned int components[] = {1, 2, 3, 4, 4, 9, 16};
+    for (unsigned int i = 0; type && i < 7; ++i) {
+        if (type->string == types[i])
+            accessor.components = components[i];
+    }
+    if (accessor.components == 0)
+        Logger::logAndThrowError("Unknown accessor type in glTF file", "MeshLoader");
+    const JSONValue* normalised = json.find("normalized", JSONValue::BOOLEAN);
+    accessor.normalised         = normalised && normalised->number != 0.0;
+
+    size_t elementSize = accessor.components * accessor.componentSize;
+    accessor.stride    = elementSize;
+    if (! json.find("bufferView"))
+        return accessor;
+
+    const JSONValue& view = getGLTFElement(gltf, "bufferViews", getGLTFIndex(json, "bufferView", SIZE_MAX));
+    size_t buffer         = getGLTFIndex(view, "buffer", gltf.buffers.size());
+    if (buffer == SIZE_MAX)
+        Logger::logAndThrowError("Buffer view without a buffer in glTF file", "MeshLoader");
+    size_t bufferSize = gltf.buffers[buffer].second;
+    size_t viewOffset = getGLTFIndex(view, "byteOffset", bufferSize + 1, 0);
+    size_t viewLength = getGLTFIndex(view, "byteLength", bufferSize - viewOffset + 1, 0);
+    accessor.stride   = getGLTFIndex(view, "byteStride", 253, 0);
+    if (accessor.stride == 0)
+        accessor.stride = elementSize;
+
+    size_t offset = getGLTFIndex(json, "byteOffset", viewLength + 1, 0);
+    if (accessor.count > 0 && (accessor.count - 1) * accessor.stride + elementSize > viewLength - offset)
+        Logger::logAndThrowError("Accessor " + utils_string::str(index) + " extends past the end of its buffer view in glTF file", "MeshLoader");
+    accessor.data = gltf.buffers[buffer].first + viewOffset + offset;
+    return accessor;
+}
+
+/* Returns a component of an element of an accessor as a float */
+static inline float readGLTFComponent(const GLTFAccessor& accessor, const uint8_t* element, unsigned int component) {
+    const uint8_t* source = element + component * accessor.componentSize;
+    switch (accessor.componentType) {
+        case GLTF_BYTE: {
+            int8_t value = static_cast<int8_t>(*source);
+            return accessor.normalised ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case GLTF_UNSIGNED_BYTE:
+            return accessor.normalised ? *source / 255.0f : *source;
+        case GLTF_SHORT: {
+            int16_t value;
+            std::memcpy(&value, source, sizeof(value));
+            return accessor.normalised ? std::max(value / 32767.0f, -1.0f) : value;
+        }
+        case GLTF_UNSIGNED_SHORT: {
+            uint16_t value;
+            std::memcpy(&value, source, sizeof(value));
+            return accessor.normalised ? value / 65535.0f : value;
+        }
+        case GLTF_UNSIGNED_INT: {
+            uint32_t value;
+            std::memcpy(&value, source, sizeof(value));
+            return static_cast<float>(value);
+        }
+        default: {
+            float value;
+            std::memcpy(&value, source, sizeof(value));
+            return value;
+        }
+    }
+}
+
+/* Reads count elements of an accessor as floats, writing up to components
+   of each outStride floats apart (the rest are left as they are) */
+static void readGLTFFloats(const GLTFAccessor& accessor, size_t count, float* out, size_t outStride, unsigned int components) {
+    components = std::min(components, accessor.components);
+    for (size_t element = 0; element < count; ++element, out += outStride) {
+        if (! accessor.data)
+            std::fill_n(out, components, 0.0f);
+        else if (accessor.componentType == GLTF_FLOAT)
+            std::memcpy(out, accessor.data + element * accessor.stride, components * sizeof(float));
+        else {
+            for (unsigned int component = 0; component < components; ++component)
+                out[component] = readGLTFComponent(accessor, accessor.data + element * accessor.stride, component);
+        }
+    }
+}
+
+/* Reads count elements of an accessor of unsigned integers, writing up to
+   components of each outStride values apart */
+static void readGLTFIntegers(const GLTFAccessor& accessor, size_t count, uint32_t* out, size_t outStride, unsigned int components) {
+    if (accessor.componentType != GLTF_UNSIGNED_BYTE && accessor.componentType != GLTF_UNSIGNED_SHORT && accessor.componentType != GLTF_UNSIGNED_INT)
+        Logger::logAndThrowError("Expected unsigned integers in glTF accessor", "MeshLoader");
+    components = std::min(components, accessor.components);
+    for (size_t element = 0; element < count; ++element, out += outStride) {
+        for (unsigned int component = 0; component < components; ++component) {
+            uint32_t value = 0;
+            if (accessor.data)
+                std::memcpy(&value, accessor.data + element * accessor.stride + component * accessor.componentSize, accessor.componentSize);
+            out[component] = value;
+        }
+    }
+}
+
+/* Returns the transform of a glTF node relative to its parent */
+static Matrix4f getGLTFTransform(const JSONValue& node) {
+    Matrix4f transform;
+    transform.initIdentity();
+    if (const JSONValue* matrix = node.find("matrix", JSONValue::ARRAY)) {
+        for (unsigned int i = 0; i < 16 && i < matrix->size(); ++i)
+            transform.set(i % 4, i / 4, static_cast<float>((*matrix)[i].number));
+        return transform;
+    }
+
+    // Reads the elements of an array into values (if given)
+    auto read = [&](std::string_view key, float* values, unsigned int count) {
+        const JSONValue* array = node.find(key, JSONValue::ARRAY);
+        for (unsigned int i = 0; array && i < count && i < array->size(); ++i)
+            values[i] = static_cast<float>((*array)[i].number);
+    };
+    float translation[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[4]    = {0.0f, 0.0f, 0.0f, 1.0f};
+    float scale[3]       = {1.0f, 1.0f, 1.0f};
+    read("translation", translation, 3);
+    read("rotation", rotation, 4);
+    read("scale", scale, 3);
+    transform.initTransform(Vector3f(translation[0], translation[1], translation[2]), Quaternion(rotation[0], rotation[1], rotation[2], rotation[3]), Vector3f(scale[0], scale[1], scale[2]));
+    return transform;
+}
+
+/* A mesh of a glTF file placed in the scene */
+struct GLTFMeshInstance {
+    size_t mesh;
+    Matrix4f transform;
+    bool skinned;
+};
+
+/* Adds the meshes of a node and its children */
+static void addGLTFNode(const GLTFFile& gltf, size_t index, const Matrix4f& parentTransform, std::vector<GLTFMeshInstance>& instances, unsigned int depth) {
+    if (depth > GLTF_MAX_DEPTH)
+        Logger::logAndThrowError("Too many nested nodes in glTF file", "MeshLoader");
+    const JSONValue& node = getGLTFElement(gltf, "nodes", index);
+    Matrix4f transform    = parentTransform * getGLTFTransform(node);
+    if (node.find("mesh"))
+        instances.push_back({getGLTFIndex(node, "mesh", SIZE_MAX), transform, node.find("skin") != nullptr});
+    if (const JSONValue* children = node.find("children", JSONValue::ARRAY)) {
+        for (size_t i = 0; i < children->size(); ++i)
+            addGLTFNode(gltf, getGLTFElementIndex((*children)[i]), transform, instances, depth + 1);
+    }
+}
+
+/* A triangle primitive of a glTF mesh placed in the scene */
+struct GLTFPrimitive {
+    const JSONValue* json;
+    const GLTFMeshInstance* instance;
+
+    unsigned int mode;
+    uint32_t materialIndex;
+    size_t vertexCount;
+    size_t sourceIndexCount;  // Before converting to a triangle list
+    size_t indexCount;
+    uint32_t firstIndex;
+    uint32_t vertexOffset;
+};
+
+/* Reads the vertices and indices of a glTF primitive into a mesh */
+static void readGLTFPrimitive(const GLTFFile& gltf, const GLTFPrimitive& primitive, const MeshLoader::VertexStreams& streams, uint32_t* indices) {
+    const JSONValue& attributes = *primitive.json->find("attributes", JSONValue::OBJECT);
+    size_t count                = primitive.vertexCount;
+    size_t vertex               = primitive.vertexOffset;
+
+    // Returns whether the primitive has an attribute, assigning its accessor
+    auto getAttribute = [&](std::string_view name, GLTFAccessor& accessor) {
+        const JSONValue* index = attributes.find(name);
+        if (! index)
+            return false;
+        accessor = getGLTFAccessor(gltf, getGLTFElementIndex(*index));
+        if (accessor.count < count)
+            Logger::logAndThrowError("Attribute " + std::string(name) + " has fewer elements than POSITION in glTF file", "MeshLoader");
+        return true;
+    };
+    const Matrix4f& transform = primitive.instance->transform;
+    bool transformed          = ! primitive.instance->skinned;
+    GLTFAccessor accessor;
+
+    float* positions = streams.get(MeshData::POSITION, vertex);
+    size_t stride    = streams.strides[MeshData::POSITION];
+    getAttribute("POSITION", accessor);
+    readGLTFFloats(accessor, count, positions, stride, 3);
+    if (transformed)
+        utils_batch::transformPoints(transform, positions, positions, count, stride, stride);
+
+    float* normals  = streams.get(MeshData::NORMAL, vertex);
+    bool hasNormals = normals && getAttribute("NORMAL", accessor);
+    if (hasNormals) {
+        stride = streams.strides[MeshData::NORMAL];
+        readGLTFFloats(accessor, count, normals, stride, 3);
+        if (transformed)
+            utils_batch::transformNormals(transform, normals, normals, count, stride, stride);
+    }
+
+    float* tangents = streams.get(MeshData::TANGENT, vertex);
+    if (tangents && getAttribute("TANGENT", accessor)) {
+        std::vector<float> values(count * 4, 1.0f);
+        readGLTFFloats(accessor, count, values.data(), 4, 4);
+        stride = streams.strides[MeshData::TANGENT];
+        for (size_t i = 0; i < count; ++i)
+            std::copy_n(values.data() + i * 4, 3, tangents + i * stride);
+        if (transformed)
+            utils_batch::transformDirections(transform, tangents, tangents, count, stride, stride, true);
+
+        // The bitangents are given by the handedness in w (which is flipped
+        // by transforms that mirror)
+        float* bitangents = streams.get(MeshData::BITANGENT, vertex);
+        if (bitangents && hasNormals) {
+            Vector3f columns[3];
+            for (unsigned int i = 0; i < 3; ++i)
+                columns[i] = Vector3f(transform.get(0, i), transform.get(1, i), transform.get(2, i));
+            float mirrored = transformed && columns[0].cross(columns[1]).dot(columns[2]) < 0.0f ? -1.0f : 1.0f;
+
+            size_t normalStride    = streams.strides[MeshData::NORMAL];
+            size_t bitangentStride = streams.strides[MeshData::BITANGENT];
+            for (size_t i = 0; i < count; ++i) {
+                const float* normal  = normals + i * normalStride;
+                const float* tangent = tangents + i * stride;
+                Vector3f bitangent   = Vector3f(normal[0], normal[1], normal[2]).cross(Vector3f(tangent[0], tangent[1], tangent[2])) * (values[i * 4 + 3] < 0.0f ? -mirrored : mirrored);
+                std::copy_n(&bitangent[0], 3, bitangents + i * bitangentStride);
+            }
+        }
+    }
+
+    if (float* textureCoords = streams.get(MeshData::TEXTURE_COORD, vertex)) {
+        if (getAttribute("TEXCOORD_0", accessor))
+            readGLTFFloats(accessor, count, textureCoords, streams.strides[MeshData::TEXTURE_COORD], 2);
+    }
+
+    if (float* colours = streams.get(MeshData::COLOUR, vertex)) {
+        stride = streams.strides[MeshData::COLOUR];
+        for (size_t i = 0; i < count; ++i)
+            std::fill_n(colours + i * stride, 4, 1.0f);
+        if (getAttribute("COLOR_0", accessor))
+            readGLTFFloats(accessor, count, colours, stride, 4);
+    }
+
+    GLTFAccessor weights;
+    if (streams.boneIndices && getAttribute("JOINTS_0", accessor) && getAttribute("WEIGHTS_0", weights)) {
+        readGLTFIntegers(accessor, count, streams.boneIndices + vertex * 4, 4, 4);
+        readGLTFFloats(weights, count, streams.boneWeights + vertex * 4, 4, 4);
+    }
+
+    // Read the indices, converting strips and fans into lists
+    std::vector<uint32_t> source(primitive.sourceIndexCount);
+    if (primitive.json->find("indices")) {
+        readGLTFIntegers(getGLTFAccessor(gltf, getGLTFIndex(*primitive.json, "indices", SIZE_MAX)), source.size(), source.data(), 1, 1);
+        if (std::any_of(source.begin(), source.end(), [&](uint32_t index) { return index >= count; }))
+            Logger::logAndThrowError("Index out of range in glTF file", "MeshLoader");
+    } else {
+        for (size_t i = 0; i < source.size(); ++i)
+            source[i] = static_cast<uint32_t>(i);
+    }
+
+    switch (primitive.mode) {
+        case GLTF_TRIANGLES:
+            std::copy_n(source.data(), primitive.indexCount, indices);
+            break;
+        case GLTF_TRIANGLE_STRIP:
+            for (size_t i = 0; i + 2 < source.size(); ++i, indices += 3) {
+                // Every other triangle is reversed to keep the winding
+                indices[0] = source[i];
+                indices[1] = source[i + 1 + (i & 1)];
+                indices[2] = source[i + 2 - (i & 1)];
+            }
+            break;
+        default:
+            for (size_t i = 1; i + 1 < source.size(); ++i, indices += 3) {
+                indices[0] = source[0];
+                indices[1] = source[i];
+                indices[2] = source[i + 1];
+            }
+            break;
+    }
+}
+
+/* Opens a glTF file (.gltf or .glb) and parses its JSON, assigning the
+   binary chunk of a .glb file (which is left empty otherwise) */
+static void openGLTF(const std::string& path, GLTFFile& gltf, std::pair<const uint8_t*, size_t>& binaryChunk) {
+    if (! gltf.file.open(path))
+        Logger::logAndThrowError("Failed to open file '" + path + "'", "MeshLoader");
+
+    // Locate the JSON (and binary chunk of a .glb file)
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(gltf.file.getData());
+    size_t size          = gltf.file.getSize();
+    auto readUInt32      = [&](size_t offset) {
+        uint32_t value;
+        std::memcpy(&value, bytes + offset, sizeof(value));
+        return value;
+    };
+    const char* json    = gltf.file.getData();
+    const char* jsonEnd = json + size;
+    binaryChunk         = {nullptr, 0};
+    if (size >= 12 && readUInt32(0) == GLB_MAGIC) {
+        if (readUInt32(4) != 2)
+            Logger::logAndThrowError("Unsupported glTF version " + utils_string::str(readUInt32(4)) + " in '" + path + "'", "MeshLoader");
+        size_t length = std::min(static_cast<size_t>(readUInt32(8)), size);
+        jsonEnd       = json;
+        for (size_t offset = 12; offset + 8 <= length;) {
+            size_t chunkLength = readUInt32(offset);
+            uint32_t chunkType = readUInt32(offset + 4);
+            offset += 8;
+            if (chunkLength > length - offset)
+                Logger::logAndThrowError("Chunk extends past the end of '" + path + "'", "MeshLoader");
+            if (chunkType == GLB_CHUNK_JSON && jsonEnd == json) {
+                json    = gltf.file.getData() + offset;
+                jsonEnd = json + chunkLength;
+            } else if (chunkType == GLB_CHUNK_BIN && ! binaryChunk.first)
+                binaryChunk = {bytes + offset, chunkLength};
+            offset += chunkLength;
+        }
+        if (jsonEnd == json)
+            Logger::logAndThrowError("Missing JSON chunk in '" + path + "'", "MeshLoader");
+    }
+    parseJSON(json, jsonEnd, gltf.json, 0);
+}
+
+/* Returns whether a glTF buffer is read from an external file (rather than
+   the binary chunk or a data URI) */
+static bool isExternalGLTFBuffer(const JSONValue& buffer) {
+    const JSONValue* uri = buffer.find("uri", JSONValue::STRING);
+    return uri && uri->string.substr(0, 5) != "data:" && getGLTFIndex(buffer, "byteLength", SIZE_MAX, 0) > 0;
+}
+
+/* Returns the path of the external file of a glTF buffer */
+static std::string getGLTFBufferPath(const std::string& path, const JSONValue& buffer) {
+    return path.substr(0, path.find_last_of("/\\") + 1) + decodeURI(unescapeJSON(buffer.find("uri", JSONValue::STRING)->string));
+}
+
+MeshData* MeshLoader::loadGLTF(const std::string& path, MeshData::SeparateFlags flags, std::vector<std::string>* materialNames) {
+    GLTFFile gltf;
+    std::pair<const uint8_t*, size_t> binaryChunk;
+    openGLTF(path, gltf, binaryChunk);
+
+    if (const JSONValue* extensions = gltf.json.find("extensionsRequired", JSONValue::ARRAY)) {
+        if (extensions->size() > 0)
+            Logger::logAndThrowError("Extension " + unescapeJSON((*extensions)[0].string) + " required by '" + path + "' isn't supported", "MeshLoader");
+    }
+
+    // Locate the buffers
+    if (const JSONValue* buffers = gltf.json.find("buffers", JSONValue::ARRAY)) {
+        for (size_t i = 0; i < buffers->size(); ++i) {
+            const JSONValue& buffer = (*buffers)[i];
+            size_t length           = getGLTFIndex(buffer, "byteLength", SIZE_MAX, 0);
+            const JSONValue* uri    = buffer.find("uri", JSONValue::STRING);
+            std::pair<const uint8_t*, size_t> data(nullptr, 0);
+            if (! uri) {
+                if (i == 0)
+                    data = binaryChunk;
+            } else if (uri->string.substr(0, 5) == "data:") {
+                size_t start = uri->string.find(',');
+                if (start == std::string_view::npos || uri->string.substr(0, start).find(";base64") == std::string_view::npos)
+                    Logger::logAndThrowError("Unsupported data URI for buffer " + utils_string::str(i) + " in '" + path + "'", "MeshLoader");
+                gltf.bufferData.push_back(decodeBase64(uri->string.substr(start + 1)));
+                data = {gltf.bufferData.back().data(), gltf.bufferData.back().size()};
+            } else if (isExternalGLTFBuffer(buffer)) {
+                std::string bufferPath = getGLTFBufferPath(path, buffer);
+                gltf.bufferFiles.push_back(std::make_unique<MappedFile>());
+                if (! gltf.bufferFiles.back()->open(bufferPath))
+                    Logger::logAndThrowError("Failed to open file '" + bufferPath + "'", "MeshLoader");
+                data = {reinterpret_cast<const uint8_t*>(gltf.bufferFiles.back()->getData()), gltf.bufferFiles.back()->getSize()};
+            }
+            if (data.second < length)
+                Logger::logAndThrowError("Buffer " + utils_string::str(i) + " of '" + path + "' is missing data", "MeshLoader");
+            gltf.buffers.emplace_back(data.first, length);
+        }
+    }
+
+    // Find the meshes in the scene
+    std::vector<GLTFMeshInstance> instances;
+    Matrix4f identity;
+    identity.initIdentity();
+    const JSONValue* nodes  = gltf.json.find("nodes", JSONValue::ARRAY);
+    const JSONValue* scenes = gltf.json.find("scenes", JSONValue::ARRAY);
+    if (scenes && scenes->size() > 0) {
+        const JSONValue& scene = (*scenes)[getGLTFIndex(gltf.json, "scene", scenes->size(), 0)];
+        if (const JSONValue* roots = scene.find("nodes", JSONValue::ARRAY)) {
+            for (const JSONValue& root : roots->elements)
+                addGLTFNode(gltf, getGLTFElementIndex(root), identity, instances, 0);
+        }
+    } else if (nodes) {
+        std::vector<bool> isChild(nodes->size(), false);
+        for (const JSONValue& node : nodes->elements) {
+            if (const JSONValue* children = node.find("children", JSONValue::ARRAY)) {
+                for (const JSONValue& child : children->elements) {
+                    if (getGLTFElementIndex(child) < isChild.size())
+                        isChild[getGLTFElementIndex(child)] = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < nodes->size(); ++i) {
+            if (! isChild[i])
+                addGLTFNode(gltf, i, identity, instances, 0);
+        }
+    } else if (const JSONValue* meshes = gltf.json.find("meshes", JSONValue::ARRAY)) {
+        for (size_t i = 0; i < meshes->size(); ++i)
+            instances.push_back({i, identity, false});
+    }
+
+    // Find the triangle primitives of each mesh, and which data they have
+    const JSONValue* materials = gltf.json.find("materials", JSONValue::ARRAY);
+    size_t materialCount       = materials ? materials->size() : 0;
+    bool hasUnnamedMaterial    = false;
+    bool present[MeshData::BITANGENT + 1] = {};
+    bool hasBones              = false;
+    std::vector<GLTFPrimitive> primitives;
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
+    for (const GLTFMeshInstance& instance : instances) {
+        const JSONValue* meshPrimitives = getGLTFElement(gltf, "meshes", instance.mesh).find("primitives", JSONValue::ARRAY);
+        for (size_t i = 0; meshPrimitives && i < meshPrimitives->size(); ++i) {
+            const JSONValue& json       = (*meshPrimitives)[i];
+            const JSONValue* attributes = json.find("attributes", JSONValue::OBJECT);
+            GLTFPrimitive primitive;
+            primitive.json     = &json;
+            primitive.instance = &instance;
+            primitive.mode     = static_cast<unsigned int>(getGLTFIndex(json, "mode", 7, GLTF_TRIANGLES));
+            if (primitive.mode < GLTF_TRIANGLES || ! attributes || ! attributes->find("POSITION")) {
+                Logger::log("Skipping primitive " + utils_string::str(i) + " of mesh " + utils_string::str(instance.mesh) + " in '" + path + "' as it doesn't have triangles", "MeshLoader", LogType::Debug);
+                continue;
+            }
+            primitive.vertexCount      = getGLTFAccessor(gltf, getGLTFElementIndex(*attributes->find("POSITION"))).count;
+            primitive.sourceIndexCount = json.find("indices") ? getGLTFAccessor(gltf, getGLTFIndex(json, "indices", SIZE_MAX)).count : primitive.vertexCount;
+            if (primitive.mode == GLTF_TRIANGLES)
+                primitive.indexCount = primitive.sourceIndexCount - primitive.sourceIndexCount % 3;
+            else
+                primitive.indexCount = primitive.sourceIndexCount >= 3 ? (primitive.sourceIndexCount - 2) * 3 : 0;
+            if (primitive.indexCount == 0)
+                continue;
+
+            primitive.materialIndex = static_cast<uint32_t>(getGLTFIndex(json, "material", materialCount, materialCount));
+            hasUnnamedMaterial |= primitive.materialIndex == materialCount;
+            primitive.firstIndex   = static_cast<uint32_t>(indexCount);
+            primitive.vertexOffset = static_cast<uint32_t>(vertexCount);
+            indexCount += primitive.indexCount;
+            vertexCount += primitive.vertexCount;
+            if (indexCount > UINT32_MAX || vertexCount > UINT32_MAX)
+                Logger::logAndThrowError("Too many vertices in '" + path + "'", "MeshLoader");
+
+            present[MeshData::NORMAL] |= attributes->find("NORMAL") != nullptr;
+            present[MeshData::TANGENT] |= attributes->find("TANGENT") != nullptr;
+            present[MeshData::TEXTURE_COORD] |= attributes->find("TEXCOORD_0") != nullptr;
+            present[MeshData::COLOUR] |= attributes->find("COLOR_0") != nullptr;
+            hasBones |= attributes->find("JOINTS_0") && attributes->find("WEIGHTS_0");
+            primitives.push_back(primitive);
+        }
+    }
+    if (materialNames) {
+        for (size_t i = 0; i < materialCount; ++i) {
+            const JSONValue* name = (*materials)[i].find("name", JSONValue::STRING);
+            materialNames->push_back(name ? unescapeJSON(name->string) : "");
+        }
+        if (hasUnnamedMaterial)
+            materialNames->emplace_back();
+    }
+
+    std::vector<MeshData::DataType> dataTypes = {MeshData::POSITION};
+    for (MeshData::DataType dataType : {MeshData::COLOUR, MeshData::TEXTURE_COORD, MeshData::NORMAL, MeshData::TANGENT}) {
+        if (present[dataType])
+            dataTypes.push_back(dataType);
+    }
+    if (present[MeshData::NORMAL] && present[MeshData::TANGENT])
+        dataTypes.push_back(MeshData::BITANGENT);
+
+    MeshData* data = new MeshData(MeshData::DIMENSIONS_3D, flags);
+    for (const GLTFPrimitive& primitive : primitives)
+        data->addSubData(primitive.materialIndex, primitive.firstIndex, primitive.vertexOffset);
+    VertexStreams streams = allocateVertices(data, dataTypes, vertexCount, hasBones);
+    data->getIndices().resize(indexCount);
+
+    try {
+        parallelFor(primitives.size(), [&](size_t i) { readGLTFPrimitive(gltf, primitives[i], streams, data->getIndices().data() + primitives[i].firstIndex); });
+    } catch (...) {
+        delete data;
+        throw;
+    }
+    return data;
+}
+
+/*****************************************************************************
+ * MeshLoader class
+ *****************************************************************************/
+
+MeshLoader::VertexStreams MeshLoader::allocateVertices(MeshData* data, const std::vector<MeshData::DataType>& dataTypes, size_t vertexCount, bool hasBones) {
+    data->vertexCount = static_cast<unsigned int>(vertexCount);
+
+    // Size the separated data and lay out the rest
+    std::vector<float>* separated[] = {&data->positions, &data->colours, &data->textureCoords, &data->normals, &data->tangents, &data->bitangents};
+    for (MeshData::DataType dataType : dataTypes) {
+        MeshData::SeparateFlags flag = MeshData::getDataTypeInfo(data->numDimensions, dataType).separateFlag;
+        if (data->separateFlags & flag)
+            separated[dataType - MeshData::POSITION]->resize(vertexCount * data->getNumComponents(dataType));
+        else
+            data->addToOthersLayout(dataType, flag);
+    }
+    size_t othersStride = 0;
+    for (MeshData::DataType dataType : data->othersLayout)
+        othersStride += data->getNumComponents(dataType);
+    data->others.resize(vertexCount * othersStride);
+
+    VertexStreams streams;
+    for (MeshData::DataType dataType : dataTypes) {
+        size_t offset;
+        std::vector<float>* values = data->getStream(dataType, offset, streams.strides[dataType]);
+        streams.values[dataType]   = values ? values->data() + offset : nullptr;
+    }
+    if (hasBones) {
+        data->boneIndices.resize(vertexCount * 4);
+        data->boneWeights.resize(vertexCount * 4);
+        streams.boneIndices = data->boneIndices.data();
+        streams.boneWeights = data->boneWeights.data();
+    }
+    return streams;
+}
+
+std::vector<std::string> MeshLoader::getSourceFiles(const std::string& path) {
+    std::vector<std::string> files = {path};
+    std::string extension          = getExtension(path);
+    if (extension == ".gltf" || extension == ".glb") {
+        GLTFFile gltf;
+        std::pair<const uint8_t*, size_t> binaryChunk;
+        openGLTF(path, gltf, binaryChunk);
+        if (const JSONValue* buffers = gltf.json.find("buffers", JSONValue::ARRAY)) {
+            for (size_t i = 0; i < buffers->size(); ++i) {
+                if (isExternalGLTFBuffer((*buffers)[i]))
+                    files.push_back(getGLTFBufferPath(path, (*buffers)[i]));
+            }
+        }
+    }
+    return files;
+}
+
+MeshData* MeshLoader::load(const std::string& path, MeshData::SeparateFlags flags, std::vector<std::string>* materialNames) {
+    std::string extension = getExtension(path);
+    if (extension == ".obj")
+        return loadOBJ(path, flags, materialNames);
+    else if (extension == ".gltf" || extension == ".glb")
+        return loadGLTF(path, flags, materialNames);
+    Logger::logAndThrowError("Unsupported mesh format '" + extension + "' of '" + path + "'", "MeshLoader");
+    return nullptr;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*****************************************************************************
+ * MeshLoader class - Loads meshes from Wavefront OBJ and glTF 2.0 files
+ *****************************************************************************/
+
+// Files are mapped into memory and parsed in place - numbers are read
+// straight from the mapped characters rather than creating a std::string
+// for each token, and the results are written straight into the arrays of
+// the MeshData (interleaved or separated as requested) by the threads
+// producing them, using a thread per hardware thread.
+//
+// OBJ - the file is split into chunks at line ends which are parsed in
+// parallel. Positions (along with colours when given after them), texture
+// coordinates, normals and faces (with polygons split into fans of
+// triangles and negative indices relative to the end of the data so far)
+// are read, while groups, objects, smoothing groups, lines and the like are
+// ignored. The triangles of each material (usemtl) form a sub data, in the
+// order they are first used, with a separate range of vertices built in
+// parallel from the distinct combinations of indices it uses. Texture
+// coordinates are flipped vertically, as OBJ places the origin at the
+// bottom left of an image.
+//
+// glTF - both .gltf (with external, or base64 data URI, buffers) and binary
+// .glb files are read. The nodes of the default scene (or every node that
+// isn't a child of another when there isn't one) are traversed applying
+// their transforms, other than to skinned meshes whose joints place them.
+// Each triangle primitive (lists, strips and fans) becomes a sub data with
+// its own range of vertices, decoded in parallel. POSITION, NORMAL,
+// TANGENT (with bitangents calculated from its w), TEXCOORD_0, COLOR_0,
+// JOINTS_0 and WEIGHTS_0 are read in any of the component types allowed for
+// them. Data that some primitives have but others don't is 0 for the others
+// (other than colours which are white). Sparse accessors, morph targets and
+// compressed meshes aren't supported.
+//
+// In both cases materialNames receives the name of each material (the
+// materialIndex of a sub data is an index into it), including an unnamed
+// one at the end when some triangles don't have a material.
+
+class MeshLoader {
+public:
+    /* Where to write each type of vertex data within a MeshData (strides
+       are in floats) */
+    struct VertexStreams {
+        float* values[MeshData::BITANGENT + 1] = {};
+        size_t strides[MeshData::BITANGENT + 1] = {};
+        uint32_t* boneIndices                   = nullptr;
+        float* boneWeights                      = nullptr;
+
+        /* Returns where to write the data of a type for a vertex (nullptr
+           when the mesh doesn't have it) */
+        inline float* get(MeshData::DataType dataType, size_t vertex) const { return values[dataType] ? values[dataType] + vertex * strides[dataType] : nullptr; }
+    };
+
+private:
+    /* Sizes the vertex data of a mesh for the given data types (interleaving
+       those that aren't separated in the order given), and bone data with 4
+       bones per vertex if requested, returning where to write them */
+    static VertexStreams allocateVertices(MeshData* data, const std::vector<MeshData::DataType>& dataTypes, size_t vertexCount, bool hasBones);
+
+public:
+    /* Loads a mesh from a file, choosing the format from its extension
+       (.obj, .gltf or .glb) */
+    static MeshData* load(const std::string& path, MeshData::SeparateFlags flags = MeshData::SEPARATE_NONE, std::vector<std::string>* materialNames = nullptr);
+
+    /* Returns the files a mesh is loaded from - the file itself followed by
+       the external buffers of a glTF file (for hashing them, see
+       MeshCache::hashSource) */
+    static std::vector<std::string> getSourceFiles(const std::string& path);
+
+    /* Loads a mesh from a Wavefront OBJ file */
+    static MeshData* loadOBJ(const std::string& path, MeshData::SeparateFlags flags = MeshData::SEPARATE_NONE, std::vector<std::string>* materialNames = nullptr);
+
+    /* Loads a mesh from a glTF 2.0 file (.gltf or .glb) */
+    static MeshData* loadGLTF(const std::string& path, MeshData::SeparateFlags flags = MeshData::SEPARATE_NONE, std::vector<std::string>* materialNames = nullptr);
+};
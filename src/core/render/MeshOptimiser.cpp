@@ -0,0 +1,1455 @@
+#include "MeshOptimiser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+
+#include "../../utils/Logging.h"
+#include "../maths/Vector.h"
+
+/*****************************************************************************
+ * MeshOptimiser class
+ *****************************************************************************/
+
+/* Value used when there isn't a vertex */
+static const uint32_t NO_VERTEX = 0xFFFFFFFF;
+
+/* Number of triangles given to a thread at a time when building meshlets */
+static const size_t MESHLET_BLOCK_TRIANGLES = 16384;
+
+/* Assigns the smallest and largest index in a range */
+static void findIndexRange(const uint32_t* indices, size_t count, uint32_t& minimum, uint32_t& maximum) {
+    minimum = NO_VERTEX;
+    maximum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        minimum = std::min(minimum, indices[i]);
+        maximum = std::max(maximum, indices[i]);
+    }
+}
+
+/* Calls function(first, last, vertexOffset) with the range of indices (or
+   vertices when there are no indices) used by each sub data of a mesh (or
+   all of them when it has none) */
+template <typename Function>
+static void forEachSubDataRange(MeshData* data, Function function) {
+    if (! data->hasSubData()) {
+        function(static_cast<size_t>(0), static_cast<size_t>(data->getCount()), 0u);
+        return;
+    }
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i) {
+        size_t first, last;
+        data->getSubDataRange(i, first, last);
+        function(first, last, data->getSubData(i).vertexOffset);
+    }
+}
+
+/* Assigns the distinct vertex offsets of a mesh (along with 0) in ascending
+   order, and the index of the range starting at one of them that each
+   vertex is in */
+static void findVertexRanges(MeshData* data, std::vector<uint32_t>& rangeStarts, std::vector<uint32_t>& vertexRanges) {
+    size_t vertexCount = data->getVertexCount();
+    rangeStarts        = {0};
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i)
+        rangeStarts.push_back(data->getSubData(i).vertexOffset);
+    std::sort(rangeStarts.begin(), rangeStarts.end());
+    rangeStarts.erase(std::unique(rangeStarts.begin(), rangeStarts.end()), rangeStarts.end());
+
+    vertexRanges.resize(vertexCount);
+    for (size_t range = 0; range < rangeStarts.size(); ++range) {
+        size_t end = range + 1 < rangeStarts.size() ? std::min(static_cast<size_t>(rangeStarts[range + 1]), vertexCount) : vertexCount;
+        for (size_t vertex = rangeStarts[range]; vertex < end; ++vertex)
+            vertexRanges[vertex] = static_cast<uint32_t>(range);
+    }
+}
+
+/* Simulates a FIFO cache, adding the number of misses and distinct vertices
+   to the given totals */
+static void simulateVertexCache(const uint32_t* indices, size_t count, unsigned int cacheSize, size_t& misses, size_t& vertices) {
+    if (count == 0)
+        return;
+    uint32_t minimum, maximum;
+    findIndexRange(indices, count, minimum, maximum);
+
+    // A vertex is cached if fewer than cacheSize others have been added
+    // since it was (time starts high enough that nothing is cached)
+    std::vector<uint32_t> timeStamps(maximum - minimum + 1, 0);
+    uint32_t time = cacheSize + 1;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t& timeStamp = timeStamps[indices[i] - minimum];
+        if (time - timeStamp > cacheSize) {
+            if (timeStamp == 0)
+                ++vertices;
+            timeStamp = time++;
+            ++misses;
+        }
+    }
+}
+
+/* Returns the statistics given the totals from simulateVertexCache */
+static MeshOptimiser::VertexCacheStatistics toStatistics(size_t misses, size_t vertices, size_t indexCount) {
+    MeshOptimiser::VertexCacheStatistics statistics;
+    if (indexCount > 0) {
+        statistics.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+        statistics.atvr = static_cast<float>(misses) / static_cast<float>(vertices);
+    }
+    return statistics;
+}
+
+/* Returns the statistics of rendering each sub data of a mesh using the
+   given indices (in place of its own) */
+static MeshOptimiser::VertexCacheStatistics analyseSubData(MeshData* data, const uint32_t* indices, unsigned int cacheSize) {
+    if (! data->hasIndices())
+        return MeshOptimiser::VertexCacheStatistics();
+
+    size_t misses   = 0;
+    size_t vertices = 0;
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t) {
+        simulateVertexCache(indices + first, last - first, cacheSize, misses, vertices);
+    });
+    return toStatistics(misses, vertices, data->getIndices().size());
+}
+
+/* Assigns the triangles using each vertex given indices with values
+   between base and base + vertexCount (those of vertex v are found in
+   adjacency between offsets[v] and offsets[v + 1]) */
+static void findAdjacency(const uint32_t* indices, size_t count, uint32_t base, size_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacency) {
+    offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+        ++offsets[indices[i] - base + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    adjacency.resize(count);
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+        adjacency[next[indices[i] - base]++] = static_cast<uint32_t>(i / 3);
+}
+
+/* Reorders the triangles given by indices with values between base and
+   base + vertexCount using Tipsify (destination must not overlap indices) */
+static void tipsify(uint32_t* destination, const uint32_t* indices, size_t count, uint32_t base, size_t vertexCount, unsigned int cacheSize) {
+    std::vector<uint32_t> offsets, adjacency;
+    findAdjacency(indices, count, base, vertexCount, offsets, adjacency);
+
+    // Number of triangles still to be output using each vertex
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<uint32_t> timeStamps(vertexCount, 0);
+    std::vector<bool> emitted(count / 3, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    deadEnd.reserve(count);
+
+    uint32_t time     = cacheSize + 1;
+    size_t cursor     = 0;
+    uint32_t fanning  = 0;
+    uint32_t* current = destination;
+    while (fanning != NO_VERTEX) {
+        // Output every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; ++i) {
+            uint32_t triangle = adjacency[i];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = true;
+
+            for (unsigned int corner = 0; corner < 3; ++corner) {
+                uint32_t index  = indices[triangle * 3 + corner];
+                uint32_t vertex = index - base;
+                *current++      = index;
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (time - timeStamps[vertex] > cacheSize)
+                    timeStamps[vertex] = time++;
+            }
+        }
+
+        // Continue from the candidate that has been in the cache longest
+        // while still being cached once its own triangles are output
+        fanning           = NO_VERTEX;
+        int64_t bestScore = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0)
+                continue;
+            int64_t score = 0;
+            if (time - timeStamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                score = time - timeStamps[vertex];
+            if (score > bestScore) {
+                bestScore = score;
+                fanning   = vertex;
+            }
+        }
+
+        // At a dead end use the most recently output vertex with triangles
+        // left, or failing that the next one in order
+        while (fanning == NO_VERTEX && ! deadEnd.empty()) {
+            uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0)
+                fanning = vertex;
+        }
+        for (; fanning == NO_VERTEX && cursor < vertexCount; ++cursor) {
+            if (liveTriangles[cursor] > 0)
+                fanning = static_cast<uint32_t>(cursor);
+        }
+    }
+}
+
+/* Returns a position as a 3D vector */
+static inline Vector3f getPosition(const float* positions, size_t stride, uint32_t index) {
+    const float* position = positions + index * stride;
+    return Vector3f(position[0], position[1], position[2]);
+}
+
+/* Reorders the elements of a per vertex array given the new location of
+   each vertex (arrays that don't have a multiple of the number of vertices
+   are left alone) */
+template <typename T>
+static void remapVertices(std::vector<T>& values, const std::vector<uint32_t>& remap) {
+    if (values.empty() || values.size() % remap.size() != 0)
+        return;
+    size_t components = values.size() / remap.size();
+    std::vector<T> result(values.size());
+    for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+        std::copy_n(values.data() + vertex * components, components, result.data() + remap[vertex] * components);
+    values.swap(result);
+}
+
+/* Reduces a per vertex array to the given vertices in order (arrays that
+   don't have a multiple of the number of vertices are left alone) */
+template <typename T>
+static void compactVertices(std::vector<T>& values, const std::vector<uint32_t>& vertices, size_t vertexCount) {
+    if (values.empty() || values.size() % vertexCount != 0)
+        return;
+    size_t components = values.size() / vertexCount;
+    std::vector<T> result(vertices.size() * components);
+    for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+        std::copy_n(values.data() + vertices[vertex] * components, components, result.data() + vertex * components);
+    values.swap(result);
+}
+
+/* Hashes and compares vertices across every per vertex array of a mesh
+   for welding */
+class VertexHasher {
+private:
+    /* A per vertex array */
+    struct Stream {
+        const void* values;
+        size_t components;
+        bool isFloat;
+    };
+    std::vector<Stream> streams;
+
+    /* Range each vertex is in (vertices in different ranges never match) */
+    const uint32_t* vertexRanges;
+    size_t vertexCount;
+    float epsilon;
+
+    /* Returns the value compared for a component of a vertex - floats are
+       rounded to a multiple of epsilon (when given and in range) or
+       otherwise compared by their bits (with -0 the same as 0) */
+    inline uint64_t getKey(const Stream& stream, uint32_t vertex, size_t component) const {
+        size_t index = vertex * stream.components + component;
+        if (! stream.isFloat)
+            return static_cast<const uint32_t*>(stream.values)[index];
+
+        float value = static_cast<const float*>(stream.values)[index];
+        if (epsilon > 0.0f) {
+            double rounded = std::floor(static_cast<double>(value) / epsilon + 0.5);
+            if (std::abs(rounded) < 9.0e18)
+                return static_cast<uint64_t>(static_cast<int64_t>(rounded));
+        }
+        if (value == 0.0f)
+            return 0;
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+public:
+    VertexHasher(const uint32_t* vertexRanges, size_t vertexCount, float epsilon) : vertexRanges(vertexRanges), vertexCount(vertexCount), epsilon(epsilon) {}
+
+    /* Adds a per vertex array (arrays that don't have a multiple of the
+       number of vertices are ignored) */
+    template <typename T>
+    void add(const std::vector<T>& values) {
+        if (! values.empty() && values.size() % vertexCount == 0)
+            streams.push_back({values.data(), values.size() / vertexCount, std::is_same<T, float>::value});
+    }
+
+    /* Returns the hash of a vertex */
+    size_t hash(uint32_t vertex) const {
+        uint64_t result = vertexRanges[vertex];
+        for (const Stream& stream : streams) {
+            for (size_t component = 0; component < stream.components; ++component)
+                result = (result ^ getKey(stream, vertex, component)) * 0x100000001B3ull;
+        }
+        result ^= result >> 32;
+        return static_cast<size_t>(result * 0x9E3779B97F4A7C15ull >> 16);
+    }
+
+    /* Returns whether two vertices match */
+    bool equal(uint32_t a, uint32_t b) const {
+        if (vertexRanges[a] != vertexRanges[b])
+            return false;
+        for (const Stream& stream : streams) {
+            for (size_t component = 0; component < stream.components; ++component) {
+                if (getKey(stream, a, component) != getKey(stream, b, component))
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+/* Meshlets built from a block of triangles */
+struct MeshletBlock {
+    // Indices of the triangles (relative to vertexOffset)
+    const uint32_t* indices;
+    size_t triangleCount;
+    uint32_t vertexOffset;
+
+    // Results (with offsets relative to the start of this block)
+    std::vector<MeshData::Meshlet> meshlets;
+    std::vector<MeshData::MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+/* Computes the bounds of the last meshlet of a block */
+static MeshData::MeshletBounds calculateMeshletBounds(const MeshletBlock& block, const float* positions, size_t stride, unsigned int dimensions) {
+    const MeshData::Meshlet& meshlet = block.meshlets.back();
+    const uint32_t* vertices         = block.vertices.data() + meshlet.vertexOffset;
+
+    MeshData::MeshletBounds bounds;
+    Sphere sphere = Sphere::fromIndexedPoints(positions, vertices, meshlet.vertexCount, 0, stride, dimensions);
+    for (unsigned int i = 0; i < 3; ++i)
+        bounds.centre[i] = sphere.centre[i];
+    bounds.radius = sphere.radius;
+
+    // The cone axis is the average normal - its cutoff is the sine of the
+    // largest angle between it and any normal (giving a cutoff of 1, so it
+    // is never back facing, when that is too close to 90 degrees)
+    Vector3f axis;
+    std::vector<Vector3f> normals;
+    if (dimensions == MeshData::DIMENSIONS_3D) {
+        normals.reserve(meshlet.triangleCount);
+        const uint8_t* triangles = block.triangles.data() + meshlet.triangleOffset;
+        for (uint32_t triangle = 0; triangle < meshlet.triangleCount; ++triangle) {
+            Vector3f a = getPosition(positions, stride, vertices[triangles[triangle * 3]]);
+            Vector3f b = getPosition(positions, stride, vertices[triangles[triangle * 3 + 1]]);
+            Vector3f c = getPosition(positions, stride, vertices[triangles[triangle * 3 + 2]]);
+
+            Vector3f normal = Vector3f(b - a).cross(c - a);
+            float length    = normal.length();
+            if (length > 0.0f) {
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+        }
+    }
+
+    float axisLength = axis.length();
+    float minimumDot = 1.0f;
+    if (axisLength > 0.0f) {
+        axis /= axisLength;
+        for (const Vector3f& normal : normals)
+            minimumDot = std::min(minimumDot, normal.dot(axis));
+    }
+    for (unsigned int i = 0; i < 3; ++i)
+        bounds.coneAxis[i] = axis[i];
+    bounds.coneCutoff = axisLength > 0.0f && minimumDot > 0.1f ? sqrtf(1.0f - minimumDot * minimumDot) : 1.0f;
+    return bounds;
+}
+
+/* Builds the meshlets of a block - vertexMap must have an element for every
+   vertex that is NO_VERTEX (and is left that way) */
+static void buildMeshletBlock(MeshletBlock& block, const float* positions, size_t stride, unsigned int dimensions, unsigned int maxVertices, unsigned int maxTriangles, std::vector<uint32_t>& vertexMap) {
+    size_t count = block.triangleCount * 3;
+
+    // Give the vertices used by this block consecutive indices so they can
+    // be tracked in arrays
+    std::vector<uint32_t> blockVertices;
+    std::vector<uint32_t> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t vertex = block.indices[i];
+        if (vertex >= vertexMap.size())
+            Logger::logAndThrowError("Index " + utils_string::str(vertex) + " is out of range of the " + utils_string::str(vertexMap.size()) + " vertices", "MeshOptimiser");
+        if (vertexMap[vertex] == NO_VERTEX) {
+            vertexMap[vertex] = static_cast<uint32_t>(blockVertices.size());
+            blockVertices.push_back(vertex);
+        }
+        indices[i] = vertexMap[vertex];
+    }
+    for (uint32_t vertex : blockVertices)
+        vertexMap[vertex] = NO_VERTEX;
+
+    std::vector<uint32_t> offsets, adjacency;
+    findAdjacency(indices.data(), count, 0, blockVertices.size(), offsets, adjacency);
+
+    // Index of each vertex within the current meshlet
+    std::vector<uint32_t> meshletIndices(blockVertices.size(), NO_VERTEX);
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> used(block.triangleCount, false);
+    std::vector<uint8_t> isCandidate(block.triangleCount, false);
+    std::vector<uint32_t> candidates;
+
+    MeshData::Meshlet meshlet = {0, 0, 0, 0};
+    size_t remaining          = block.triangleCount;
+    size_t cursor             = 0;
+
+    // Returns the number of vertices a triangle would add to the meshlet
+    auto countNewVertices = [&](uint32_t triangle) {
+        unsigned int newVertices = 0;
+        for (unsigned int corner = 0; corner < 3; ++corner)
+            newVertices += meshletIndices[indices[triangle * 3 + corner]] == NO_VERTEX;
+        return newVertices;
+    };
+
+    // Adds a triangle to the meshlet, along with the triangles sharing its
+    // vertices as candidates to be added next
+    auto addTriangle = [&](uint32_t triangle) {
+        used[triangle] = true;
+        --remaining;
+        for (unsigned int corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if (meshletIndices[vertex] == NO_VERTEX) {
+                meshletIndices[vertex] = meshlet.vertexCount++;
+                meshletVertices.push_back(vertex);
+                block.vertices.push_back(block.indices[triangle * 3 + corner] + block.vertexOffset);
+                for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                    uint32_t adjacent = adjacency[i];
+                    if (! used[adjacent] && ! isCandidate[adjacent]) {
+                        isCandidate[adjacent] = true;
+                        candidates.push_back(adjacent);
+                    }
+                }
+            }
+            block.triangles.push_back(static_cast<uint8_t>(meshletIndices[vertex]));
+        }
+        ++meshlet.triangleCount;
+    };
+
+    // Completes the meshlet, continuing from a triangle next to it
+    auto finishMeshlet = [&]() {
+        while (block.triangles.size() % 4 != 0)
+            block.triangles.push_back(0);
+        block.meshlets.push_back(meshlet);
+        block.bounds.push_back(calculateMeshletBounds(block, positions, stride, dimensions));
+
+        for (uint32_t triangle : candidates)
+            isCandidate[triangle] = false;
+        candidates.clear();
+        for (uint32_t vertex : meshletVertices) {
+            for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1] && candidates.empty(); ++i) {
+                if (! used[adjacency[i]]) {
+                    isCandidate[adjacency[i]] = true;
+                    candidates.push_back(adjacency[i]);
+                }
+            }
+            meshletIndices[vertex] = NO_VERTEX;
+        }
+        meshletVertices.clear();
+        meshlet = {static_cast<uint32_t>(block.vertices.size()), static_cast<uint32_t>(block.triangles.size()), 0, 0};
+    };
+
+    while (remaining > 0) {
+        // Choose the candidate adding the fewest vertices (removing any that
+        // have been used along the way)
+        uint32_t best             = NO_VERTEX;
+        unsigned int bestVertices = 4;
+        size_t kept               = 0;
+        for (uint32_t triangle : candidates) {
+            if (used[triangle])
+                continue;
+            candidates[kept++]       = triangle;
+            unsigned int newVertices = countNewVertices(triangle);
+            if (newVertices < bestVertices && meshlet.vertexCount + newVertices <= maxVertices) {
+                best         = triangle;
+                bestVertices = newVertices;
+            }
+        }
+        candidates.resize(kept);
+
+        if (best == NO_VERTEX) {
+            // None of the candidates fit so this meshlet is full
+            if (! candidates.empty()) {
+                finishMeshlet();
+                continue;
+            }
+            // Otherwise this part of the mesh is complete so continue with
+            // the next unused triangle
+            while (used[cursor])
+                ++cursor;
+            best = static_cast<uint32_t>(cursor);
+            if (meshlet.vertexCount + countNewVertices(best) > maxVertices)
+                finishMeshlet();
+        }
+
+        addTriangle(best);
+        if (meshlet.triangleCount == maxTriangles)
+            finishMeshlet();
+    }
+    if (meshlet.triangleCount > 0)
+        finishMeshlet();
+}
+
+/* Kinds of vertex when simplifying - these decide which edges a vertex can
+   be collapsed along */
+enum LODVertexKind : uint8_t {
+    // Surrounded by triangles so can move onto any neighbour
+    LOD_VERTEX_MANIFOLD,
+    // On an open edge so can only move along it
+    LOD_VERTEX_BORDER,
+    // Shares its position with one other vertex along an attribute seam so
+    // both move along it together
+    LOD_VERTEX_SEAM,
+    // Never moves (e.g. corners, where seams meet borders and vertices on
+    // the boundary between sub data)
+    LOD_VERTEX_LOCKED,
+};
+
+/* Weight of the planes keeping open edges and seams in place relative to
+   those of the triangles */
+static const float LOD_BORDER_WEIGHT = 10.0f;
+
+/* Largest fraction of the triangles of the previous level a level of detail
+   can have and still be worth keeping */
+static const float LOD_MIN_REDUCTION = 0.95f;
+
+/* Quadric error metric - the weighted sum of the squared distances to a set
+   of planes (stored as the upper half of a symmetric 4x4 matrix) */
+struct Quadric {
+    double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+    double ab = 0.0, ac = 0.0, ad = 0.0;
+    double bc = 0.0, bd = 0.0, cd = 0.0;
+    double weight = 0.0;
+
+    /* Adds the plane normal.p + distance = 0 */
+    inline void addPlane(const Vector3f& normal, float distance, float planeWeight) {
+        double a = normal.getX();
+        double b = normal.getY();
+        double c = normal.getZ();
+        double d = distance;
+        double w = planeWeight;
+
+        a2 += w * a * a;
+        b2 += w * b * b;
+        c2 += w * c * c;
+        d2 += w * d * d;
+        ab += w * a * b;
+        ac += w * a * c;
+        ad += w * a * d;
+        bc += w * b * c;
+        bd += w * b * d;
+        cd += w * c * d;
+        weight += w;
+    }
+
+    inline void add(const Quadric& other) {
+        a2 += other.a2;
+        b2 += other.b2;
+        c2 += other.c2;
+        d2 += other.d2;
+        ab += other.ab;
+        ac += other.ac;
+        ad += other.ad;
+        bc += other.bc;
+        bd += other.bd;
+        cd += other.cd;
+        weight += other.weight;
+    }
+
+    /* Returns the weighted sum of the squared distances from a point to the
+       planes */
+    inline double evaluate(const Vector3f& point) const {
+        double x      = point.getX();
+        double y      = point.getY();
+        double z      = point.getZ();
+        double result = a2 * x * x + b2 * y * y + c2 * z * z + d2 + 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+        return std::max(result, 0.0);
+    }
+};
+
+/* Collapse of an edge - moving vertex onto target */
+struct EdgeCollapse {
+    uint32_t vertex;
+    uint32_t target;
+    double cost;
+};
+
+/* Simplifies triangles by collapsing edges onto existing vertices (so every
+   level can use the same vertex buffer) in order of the error they add. The
+   state is kept between calls to simplify so each level of detail continues
+   from the last and its error includes that of every level before it. */
+struct LODSimplifier {
+    const float* positions;
+    size_t stride;
+    unsigned int dimensions;
+    size_t vertexCount;
+
+    // Current triangles (with the vertex offset of their sub data added)
+    // and the sub data each belongs to - triangles are only ever removed so
+    // those of each sub data stay together in order
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> triangleSubData;
+
+    // Vertex with the smallest index sharing the position of each vertex,
+    // and the next vertex sharing it (which loops back to the first)
+    std::vector<uint32_t> positionVertices;
+    std::vector<uint32_t> nextWedges;
+
+    // Kind of each vertex along with the other ends of the open edges
+    // leaving and entering each border and seam vertex
+    std::vector<uint8_t> kinds;
+    std::vector<uint32_t> openTargets;
+    std::vector<uint32_t> openSources;
+
+    // Quadric of each position (indexed by its position vertex)
+    std::vector<Quadric> quadrics;
+
+    // Vertex each vertex was collapsed onto during the current pass
+    std::vector<uint32_t> remap;
+
+    // Triangles using each vertex (see findAdjacency)
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> adjacency;
+
+    // Largest cost of any collapse so far
+    double cost = 0.0;
+
+    /* Returns a position as a 3D vector (with a z of 0 for 2D positions) */
+    inline Vector3f getPosition(uint32_t vertex) const {
+        const float* position = positions + vertex * stride;
+        return Vector3f(position[0], position[1], dimensions == MeshData::DIMENSIONS_3D ? position[2] : 0.0f);
+    }
+
+    /* Returns whether a triangle has the edge from a to b */
+    inline bool hasEdge(uint32_t a, uint32_t b) const {
+        for (uint32_t i = offsets[a]; i < offsets[a + 1]; ++i) {
+            const uint32_t* triangle = indices.data() + adjacency[i] * 3;
+            for (unsigned int corner = 0; corner < 3; ++corner) {
+                if (triangle[corner] == a && triangle[(corner + 1) % 3] == b)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    /* Returns whether a triangle has an edge from the position of a to the
+       position of b (using any of the vertices sharing them) */
+    inline bool hasPositionEdge(uint32_t a, uint32_t b) const {
+        uint32_t wedge = a;
+        do {
+            for (uint32_t i = offsets[wedge]; i < offsets[wedge + 1]; ++i) {
+                const uint32_t* triangle = indices.data() + adjacency[i] * 3;
+                for (unsigned int corner = 0; corner < 3; ++corner) {
+                    if (triangle[corner] == wedge && positionVertices[triangle[(corner + 1) % 3]] == positionVertices[b])
+                        return true;
+                }
+            }
+            wedge = nextWedges[wedge];
+        } while (wedge != a);
+        return false;
+    }
+
+    LODSimplifier(const float* positions, size_t stride, unsigned int dimensions, size_t vertexCount, std::vector<uint32_t>& triangleIndices, std::vector<uint32_t>& subData) : positions(positions), stride(stride), dimensions(dimensions), vertexCount(vertexCount) {
+        indices.swap(triangleIndices);
+        triangleSubData.swap(subData);
+        remap.resize(vertexCount);
+        std::iota(remap.begin(), remap.end(), 0);
+        findAdjacency(indices.data(), indices.size(), 0, vertexCount, offsets, adjacency);
+
+        // Group the vertices by position
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        auto comparePositions = [&](uint32_t a, uint32_t b) {
+            const float* positionA = positions + a * stride;
+            const float* positionB = positions + b * stride;
+            return std::lexicographical_compare(positionA, positionA + dimensions, positionB, positionB + dimensions);
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return comparePositions(a, b) || (! comparePositions(b, a) && a < b);
+        });
+
+        positionVertices.resize(vertexCount);
+        nextWedges.resize(vertexCount);
+        for (size_t first = 0, last; first < vertexCount; first = last) {
+            for (last = first + 1; last < vertexCount && ! comparePositions(order[first], order[last]);)
+                ++last;
+            for (size_t i = first; i < last; ++i) {
+                positionVertices[order[i]] = order[first];
+                nextWedges[order[i]]       = order[i + 1 < last ? i + 1 : first];
+            }
+        }
+
+        // Find the open edges - those without a triangle on the other side
+        // that uses the same vertices. They are on a border when there isn't
+        // one using the same positions either, otherwise on a seam.
+        std::vector<uint8_t> openOut(vertexCount, 0);
+        std::vector<uint8_t> openIn(vertexCount, 0);
+        std::vector<uint8_t> borderOut(vertexCount, 0);
+        std::vector<uint8_t> borderIn(vertexCount, 0);
+        openTargets.assign(vertexCount, NO_VERTEX);
+        openSources.assign(vertexCount, NO_VERTEX);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            uint32_t a = indices[i];
+            uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+            if (hasEdge(b, a))
+                continue;
+            openOut[a]     = std::min(openOut[a] + 1, 2);
+            openIn[b]      = std::min(openIn[b] + 1, 2);
+            openTargets[a] = b;
+            openSources[b] = a;
+            if (! hasPositionEdge(b, a)) {
+                borderOut[a] = std::min(borderOut[a] + 1, 2);
+                borderIn[b]  = std::min(borderIn[b] + 1, 2);
+            }
+        }
+
+        kinds.assign(vertexCount, LOD_VERTEX_LOCKED);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            bool unique = nextWedges[v] == v;
+            if (openOut[v] == 0 && openIn[v] == 0)
+                kinds[v] = LOD_VERTEX_MANIFOLD;
+            else if (openOut[v] == 1 && openIn[v] == 1) {
+                if (unique && borderOut[v] == 1 && borderIn[v] == 1)
+                    kinds[v] = LOD_VERTEX_BORDER;
+                else if (! unique && nextWedges[nextWedges[v]] == v && borderOut[v] == 0 && borderIn[v] == 0) {
+                    // The other side of the seam must run between the same
+                    // positions in the opposite direction
+                    uint32_t wedge = nextWedges[v];
+                    if (openOut[wedge] == 1 && openIn[wedge] == 1 && positionVertices[openTargets[v]] == positionVertices[openSources[wedge]] && positionVertices[openSources[v]] == positionVertices[openTargets[wedge]])
+                        kinds[v] = LOD_VERTEX_SEAM;
+                }
+            }
+        }
+
+        // Lock the positions used by more than one sub data so neighbouring
+        // parts can't separate
+        std::vector<uint32_t> positionSubData(vertexCount, NO_VERTEX);
+        std::vector<uint8_t> shared(vertexCount, false);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            uint32_t position = positionVertices[indices[i]];
+            uint32_t subData  = triangleSubData[i / 3];
+            if (positionSubData[position] == NO_VERTEX)
+                positionSubData[position] = subData;
+            else if (positionSubData[position] != subData)
+                shared[position] = true;
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (shared[positionVertices[v]])
+                kinds[v] = LOD_VERTEX_LOCKED;
+        }
+
+        // The quadric of each position starts with the planes of the
+        // triangles around it (weighted by their area) and of any open edges
+        // (perpendicular to the triangle) so borders and seams keep their
+        // shape
+        quadrics.assign(vertexCount, Quadric());
+        for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle) {
+            const uint32_t* corners = indices.data() + triangle * 3;
+            Vector3f a              = getPosition(corners[0]);
+            Vector3f normal         = Vector3f(getPosition(corners[1]) - a).cross(getPosition(corners[2]) - a);
+            float length            = normal.length();
+            if (length == 0.0f)
+                continue;
+            normal /= length;
+            for (unsigned int corner = 0; corner < 3; ++corner)
+                quadrics[positionVertices[corners[corner]]].addPlane(normal, -normal.dot(a), length * 0.5f);
+
+            for (unsigned int corner = 0; corner < 3; ++corner) {
+                uint32_t from = corners[corner];
+                uint32_t to   = corners[(corner + 1) % 3];
+                if (hasEdge(to, from))
+                    continue;
+                Vector3f start      = getPosition(from);
+                Vector3f edge       = getPosition(to) - start;
+                Vector3f edgeNormal = edge.cross(normal);
+                float edgeLength    = edgeNormal.length();
+                if (edgeLength == 0.0f)
+                    continue;
+                edgeNormal /= edgeLength;
+                for (uint32_t vertex : {from, to})
+                    quadrics[positionVertices[vertex]].addPlane(edgeNormal, -edgeNormal.dot(start), edge.dot(edge) * LOD_BORDER_WEIGHT);
+            }
+        }
+    }
+
+    /* Returns the number of triangles left */
+    inline size_t getTriangleCount() const { return indices.size() / 3; }
+
+    /* Returns whether vertex can be collapsed onto target */
+    inline bool canCollapse(uint32_t vertex, uint32_t target) const {
+        if (positionVertices[vertex] == positionVertices[target])
+            return false;
+        switch (kinds[vertex]) {
+            case LOD_VERTEX_MANIFOLD:
+                return true;
+            case LOD_VERTEX_BORDER:
+            case LOD_VERTEX_SEAM:
+                return target == openTargets[vertex] || target == openSources[vertex];
+            default:
+                return false;
+        }
+    }
+
+    /* Returns the error (the mean squared distance to the planes of both
+       vertices) of collapsing vertex onto target */
+    inline double getCollapseCost(uint32_t vertex, uint32_t target) const {
+        Quadric quadric = quadrics[positionVertices[vertex]];
+        quadric.add(quadrics[positionVertices[target]]);
+        return quadric.weight > 0.0 ? quadric.evaluate(getPosition(target)) / quadric.weight : 0.0;
+    }
+
+    /* Returns whether collapsing vertex onto target would turn any triangle
+       that remains by more than about 75 degrees (or make it degenerate) */
+    inline bool hasFlips(uint32_t vertex, uint32_t target) const {
+        Vector3f from = getPosition(vertex);
+        Vector3f to   = getPosition(target);
+        for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const uint32_t* triangle = indices.data() + adjacency[i] * 3;
+            unsigned int corner      = triangle[0] == vertex ? 0 : (triangle[1] == vertex ? 1 : 2);
+            uint32_t b               = remap[triangle[(corner + 1) % 3]];
+            uint32_t c               = remap[triangle[(corner + 2) % 3]];
+            if (b == target || c == target || b == c)
+                continue;
+
+            Vector3f positionB = getPosition(b);
+            Vector3f positionC = getPosition(c);
+            Vector3f before    = Vector3f(positionB - from).cross(positionC - from);
+            Vector3f after     = Vector3f(positionB - to).cross(positionC - to);
+            float lengthBefore = before.length();
+            if (lengthBefore > 0.0f && before.dot(after) <= 0.25f * lengthBefore * after.length())
+                return true;
+        }
+        return false;
+    }
+
+    /* Collapses vertex onto target, joining up the open edge it was on */
+    inline void collapse(uint32_t vertex, uint32_t target) {
+        remap[vertex] = target;
+        if (kinds[vertex] == LOD_VERTEX_MANIFOLD)
+            return;
+        if (target == openTargets[vertex]) {
+            uint32_t source = openSources[vertex];
+            if (source != NO_VERTEX)
+                openTargets[source] = target;
+            openSources[target] = source;
+        } else {
+            uint32_t next = openTargets[vertex];
+            if (next != NO_VERTEX)
+                openSources[next] = target;
+            openTargets[target] = next;
+        }
+    }
+
+    /* Collapses edges until at most targetTriangles remain or every
+       remaining collapse would cost more than maxCost */
+    void simplify(size_t targetTriangles, double maxCost) {
+        std::vector<EdgeCollapse> collapses;
+        std::vector<uint8_t> touched(vertexCount);
+        while (getTriangleCount() > targetTriangles) {
+            size_t triangleCount = getTriangleCount();
+            findAdjacency(indices.data(), indices.size(), 0, vertexCount, offsets, adjacency);
+
+            // Find the cheapest way to collapse each edge (edges shared by
+            // two triangles are only looked at from one of them)
+            collapses.clear();
+            for (size_t i = 0; i < indices.size(); ++i) {
+                uint32_t a = indices[i];
+                uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+                if (a > b && hasEdge(b, a))
+                    continue;
+                EdgeCollapse best = {NO_VERTEX, NO_VERTEX, 0.0};
+                for (const EdgeCollapse& option : {EdgeCollapse{a, b, 0.0}, EdgeCollapse{b, a, 0.0}}) {
+                    if (! canCollapse(option.vertex, option.target))
+                        continue;
+                    double optionCost = getCollapseCost(option.vertex, option.target);
+                    if (best.vertex == NO_VERTEX || optionCost < best.cost)
+                        best = {option.vertex, option.target, optionCost};
+                }
+                if (best.vertex != NO_VERTEX)
+                    collapses.push_back(best);
+            }
+            if (collapses.empty())
+                return;
+
+            // Each collapse removes up to 2 triangles - only collapses that
+            // are close to as cheap as the number needed are made in one
+            // pass so the rest can be reconsidered once the quadrics change
+            // (and only those need sorting)
+            auto compareCollapses = [](const EdgeCollapse& a, const EdgeCollapse& b) {
+                return a.cost < b.cost || (a.cost == b.cost && (a.vertex < b.vertex || (a.vertex == b.vertex && a.target < b.target)));
+            };
+            size_t goal = std::min((triangleCount - targetTriangles) / 2 + 1, collapses.size());
+            std::nth_element(collapses.begin(), collapses.begin() + (goal - 1), collapses.end(), compareCollapses);
+            double costLimit = collapses[goal - 1].cost * 1.5;
+            collapses.erase(std::partition(collapses.begin(), collapses.end(), [&](const EdgeCollapse& collapse) { return collapse.cost <= costLimit; }), collapses.end());
+            std::sort(collapses.begin(), collapses.end(), compareCollapses);
+
+            // Vertices are collapsed at most once per pass, and those
+            // collapsed onto can't move again until the next
+            std::fill(touched.begin(), touched.end(), false);
+            size_t removed   = 0;
+            size_t collapsed = 0;
+            for (const EdgeCollapse& edge : collapses) {
+                if (removed >= triangleCount - targetTriangles || edge.cost > maxCost)
+                    break;
+                uint32_t vertex = edge.vertex;
+                uint32_t target = edge.target;
+                if (touched[positionVertices[vertex]] || touched[positionVertices[target]])
+                    continue;
+
+                // The vertex on the other side of a seam moves onto the
+                // vertex with the target's position on that side
+                uint32_t wedge       = NO_VERTEX;
+                uint32_t wedgeTarget = NO_VERTEX;
+                if (kinds[vertex] == LOD_VERTEX_SEAM) {
+                    wedge       = nextWedges[vertex];
+                    wedgeTarget = target == openTargets[vertex] ? openSources[wedge] : openTargets[wedge];
+                    if (wedgeTarget == NO_VERTEX || positionVertices[wedgeTarget] != positionVertices[target])
+                        continue;
+                }
+                if (hasFlips(vertex, target) || (wedge != NO_VERTEX && hasFlips(wedge, wedgeTarget)))
+                    continue;
+
+                collapse(vertex, target);
+                if (wedge != NO_VERTEX)
+                    collapse(wedge, wedgeTarget);
+                quadrics[positionVertices[target]].add(quadrics[positionVertices[vertex]]);
+                touched[positionVertices[vertex]] = true;
+                touched[positionVertices[target]] = true;
+
+                cost = std::max(cost, edge.cost);
+                removed += kinds[vertex] == LOD_VERTEX_BORDER ? 1 : 2;
+                ++collapsed;
+            }
+            if (collapsed == 0)
+                return;
+
+            // Apply the collapses, removing the triangles that are now
+            // degenerate
+            size_t remaining = 0;
+            for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+                uint32_t a = remap[indices[triangle * 3]];
+                uint32_t b = remap[indices[triangle * 3 + 1]];
+                uint32_t c = remap[indices[triangle * 3 + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+                indices[remaining * 3]       = a;
+                indices[remaining * 3 + 1]   = b;
+                indices[remaining * 3 + 2]   = c;
+                triangleSubData[remaining++] = triangleSubData[triangle];
+            }
+            indices.resize(remaining * 3);
+            triangleSubData.resize(remaining);
+        }
+    }
+};
+
+void MeshOptimiser::weldVertices(MeshData* data, float epsilon) {
+    size_t vertexCount = data->getVertexCount();
+    if (vertexCount == 0)
+        return;
+
+    // Triangle soups are given indices first (relative to the vertex offset
+    // of their sub data as usual)
+    std::vector<uint32_t>& indices = data->getIndices();
+    if (! data->hasIndices()) {
+        indices.resize(vertexCount);
+        std::iota(indices.begin(), indices.end(), 0u);
+        forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+            for (size_t i = first; i < last; ++i) {
+                if (i < vertexOffset)
+                    Logger::logAndThrowError("Vertex " + utils_string::str(i) + " is before the vertex offset of its sub data " + utils_string::str(vertexOffset), "MeshOptimiser");
+                indices[i] = static_cast<uint32_t>(i - vertexOffset);
+            }
+        });
+    }
+
+    std::vector<uint32_t> rangeStarts;
+    std::vector<uint32_t> vertexRanges;
+    findVertexRanges(data, rangeStarts, vertexRanges);
+
+    VertexHasher hasher(vertexRanges.data(), vertexCount, epsilon);
+    hasher.add(data->getPositions());
+    hasher.add(data->getColours());
+    hasher.add(data->getTextureCoords());
+    hasher.add(data->getNormals());
+    hasher.add(data->getTangents());
+    hasher.add(data->getBitangents());
+    hasher.add(data->getOthers());
+    hasher.add(data->getBoneIndices());
+    hasher.add(data->getBoneWeights());
+    hasher.add(data->getMaterialIndices());
+    hasher.add(data->getOffsetIndices());
+
+    // Find the first of the vertices that match each one using an open
+    // addressing hash table - vertices keep their order so the ranges stay
+    // in order, each starting where the vertices kept before it end
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<uint32_t> table(tableSize, NO_VERTEX);
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint32_t> vertices;
+    std::vector<uint32_t> newRangeStarts;
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+        while (newRangeStarts.size() <= vertexRanges[vertex])
+            newRangeStarts.push_back(static_cast<uint32_t>(vertices.size()));
+
+        size_t slot = hasher.hash(vertex) & (tableSize - 1);
+        while (table[slot] != NO_VERTEX && ! hasher.equal(table[slot], vertex))
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == NO_VERTEX) {
+            table[slot] = vertex;
+            remap[vertex] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertex);
+        } else
+            remap[vertex] = remap[table[slot]];
+    }
+    newRangeStarts.resize(rangeStarts.size(), static_cast<uint32_t>(vertices.size()));
+
+    // Returns the vertex offset that replaces one
+    auto getVertexOffset = [&](uint32_t vertexOffset) {
+        return newRangeStarts[std::lower_bound(rangeStarts.begin(), rangeStarts.end(), vertexOffset) - rangeStarts.begin()];
+    };
+
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+        uint32_t newVertexOffset = getVertexOffset(vertexOffset);
+        for (size_t i = first; i < last; ++i) {
+            size_t vertex = static_cast<size_t>(indices[i]) + vertexOffset;
+            if (vertex >= vertexCount)
+                Logger::logAndThrowError("Index " + utils_string::str(indices[i]) + " is out of range of the " + utils_string::str(vertexCount) + " vertices", "MeshOptimiser");
+            indices[i] = remap[vertex] - newVertexOffset;
+        }
+    });
+
+    std::vector<uint32_t>& lodIndices = data->getLODIndices();
+    for (unsigned int lod = 0; lod < data->getLODs().size(); ++lod) {
+        for (unsigned int i = 0; i < std::max(data->getSubDataCount(), static_cast<size_t>(1)); ++i) {
+            size_t first, last;
+            data->getLODSubDataRange(lod, i, first, last);
+            uint32_t vertexOffset    = data->hasSubData() ? data->getSubData(i).vertexOffset : 0;
+            uint32_t newVertexOffset = getVertexOffset(vertexOffset);
+            for (size_t index = first; index < last; ++index)
+                lodIndices[index] = remap[lodIndices[index] + vertexOffset] - newVertexOffset;
+        }
+    }
+
+    for (uint32_t& vertex : data->getMeshletVertices())
+        vertex = remap[vertex];
+
+    compactVertices(data->getPositions(), vertices, vertexCount);
+    compactVertices(data->getColours(), vertices, vertexCount);
+    compactVertices(data->getTextureCoords(), vertices, vertexCount);
+    compactVertices(data->getNormals(), vertices, vertexCount);
+    compactVertices(data->getTangents(), vertices, vertexCount);
+    compactVertices(data->getBitangents(), vertices, vertexCount);
+    compactVertices(data->getOthers(), vertices, vertexCount);
+    compactVertices(data->getBoneIndices(), vertices, vertexCount);
+    compactVertices(data->getBoneWeights(), vertices, vertexCount);
+    compactVertices(data->getMaterialIndices(), vertices, vertexCount);
+    compactVertices(data->getOffsetIndices(), vertices, vertexCount);
+
+    // Offset indices hold the vertex offset of each vertex's sub data
+    std::vector<uint32_t>& offsetIndices = data->getOffsetIndices();
+    if (offsetIndices.size() == vertices.size() * 2) {
+        for (size_t i = 1; i < offsetIndices.size(); i += 2) {
+            if (std::binary_search(rangeStarts.begin(), rangeStarts.end(), offsetIndices[i]))
+                offsetIndices[i] = getVertexOffset(offsetIndices[i]);
+        }
+    }
+
+    for (unsigned int i = 0; i < data->getSubDataCount(); ++i)
+        data->getSubData(i).vertexOffset = getVertexOffset(data->getSubData(i).vertexOffset);
+    data->vertexCount = static_cast<unsigned int>(vertices.size());
+
+    Logger::log("Welded " + utils_string::str(vertexCount) + " vertices into " + utils_string::str(vertices.size()), "MeshOptimiser", LogType::Debug);
+}
+
+MeshOptimiser::VertexCacheStatistics MeshOptimiser::analyseVertexCache(const uint32_t* indices, size_t indexCount, unsigned int cacheSize) {
+    size_t misses   = 0;
+    size_t vertices = 0;
+    simulateVertexCache(indices, indexCount, cacheSize, misses, vertices);
+    return toStatistics(misses, vertices, indexCount);
+}
+
+MeshOptimiser::VertexCacheStatistics MeshOptimiser::analyseVertexCache(MeshData* data, unsigned int cacheSize) {
+    return analyseSubData(data, data->getIndices().data(), cacheSize);
+}
+
+void MeshOptimiser::optimiseVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, unsigned int cacheSize) {
+    if (indexCount % 3 != 0)
+        Logger::logAndThrowError("Number of indices (" + utils_string::str(indexCount) + ") is not a multiple of 3", "MeshOptimiser");
+    if (indexCount == 0)
+        return;
+
+    // The original indices are read while the output is written
+    std::vector<uint32_t> copy;
+    if (destination == indices) {
+        copy.assign(indices, indices + indexCount);
+        indices = copy.data();
+    }
+
+    // Only the vertices used need to be tracked
+    uint32_t minimum, maximum;
+    findIndexRange(indices, indexCount, minimum, maximum);
+    tipsify(destination, indices, indexCount, minimum, static_cast<size_t>(maximum - minimum) + 1, cacheSize);
+}
+
+void MeshOptimiser::optimiseVertexCache(MeshData* data, std::vector<uint32_t>& destination, unsigned int cacheSize) {
+    if (! data->hasIndices()) {
+        destination.clear();
+        return;
+    }
+    VertexCacheStatistics before = analyseVertexCache(data, cacheSize);
+
+    destination.resize(data->getIndices().size());
+    const uint32_t* indices = data->getIndices().data();
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t) {
+        optimiseVertexCache(destination.data() + first, indices + first, last - first, cacheSize);
+    });
+
+    VertexCacheStatistics after = analyseSubData(data, destination.data(), cacheSize);
+    Logger::log("Vertex cache ACMR " + utils_string::str(before.acmr) + " -> " + utils_string::str(after.acmr) + ", ATVR " + utils_string::str(before.atvr) + " -> " + utils_string::str(after.atvr), "MeshOptimiser", LogType::Debug);
+}
+
+void MeshOptimiser::optimiseOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t stride, float threshold, unsigned int cacheSize) {
+    if (indexCount % 3 != 0)
+        Logger::logAndThrowError("Number of indices (" + utils_string::str(indexCount) + ") is not a multiple of 3", "MeshOptimiser");
+    if (indexCount == 0)
+        return;
+
+    std::vector<uint32_t> copy;
+    if (destination == indices) {
+        copy.assign(indices, indices + indexCount);
+        indices = copy.data();
+    }
+
+    uint32_t minimum, maximum;
+    findIndexRange(indices, indexCount, minimum, maximum);
+    std::vector<uint32_t> timeStamps(maximum - minimum + 1, 0);
+    uint32_t time = cacheSize + 1;
+
+    // Returns the number of cache misses caused by a triangle
+    auto simulateTriangle = [&](size_t triangle) {
+        unsigned int misses = 0;
+        for (unsigned int corner = 0; corner < 3; ++corner) {
+            uint32_t& timeStamp = timeStamps[indices[triangle * 3 + corner] - minimum];
+            if (time - timeStamp > cacheSize) {
+                timeStamp = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    };
+
+    // Hard boundaries - wherever every vertex of a triangle misses the cache
+    // (i.e. where Tipsify had to start again) so splitting there costs nothing
+    size_t triangleCount = indexCount / 3;
+    std::vector<uint8_t> misses(triangleCount);
+    std::vector<size_t> hardBoundaries;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        misses[triangle] = static_cast<uint8_t>(simulateTriangle(triangle));
+        if (triangle == 0 || misses[triangle] == 3)
+            hardBoundaries.push_back(triangle);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries - split each cluster as soon as the part so far has an
+    // ACMR within the threshold of the whole (simulating the cache being
+    // emptied at each split)
+    std::vector<size_t> clusters;
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); ++i) {
+        size_t start = hardBoundaries[i];
+        size_t end   = hardBoundaries[i + 1];
+
+        size_t clusterMisses = 0;
+        for (size_t triangle = start; triangle < end; ++triangle)
+            clusterMisses += misses[triangle];
+        float limit = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+        clusters.push_back(start);
+        time += cacheSize + 1;
+        size_t partStart  = start;
+        size_t partMisses = 0;
+        for (size_t triangle = start; triangle + 1 < end; ++triangle) {
+            partMisses += simulateTriangle(triangle);
+            if (static_cast<float>(partMisses) <= limit * static_cast<float>(triangle + 1 - partStart)) {
+                clusters.push_back(triangle + 1);
+                time += cacheSize + 1;
+                partStart  = triangle + 1;
+                partMisses = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    size_t clusterCount = clusters.size() - 1;
+
+    // Area weighted centre and normal of each cluster (the length of a cross
+    // product is twice the area of its triangle)
+    std::vector<Vector3f> clusterCentres(clusterCount);
+    std::vector<Vector3f> clusterNormals(clusterCount);
+    Vector3f meshCentre;
+    float meshArea = 0.0f;
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        Vector3f centre;
+        Vector3f normal;
+        float area = 0.0f;
+        for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle) {
+            Vector3f a = getPosition(positions, stride, indices[triangle * 3]);
+            Vector3f b = getPosition(positions, stride, indices[triangle * 3 + 1]);
+            Vector3f c = getPosition(positions, stride, indices[triangle * 3 + 2]);
+
+            Vector3f cross     = Vector3f(b - a).cross(c - a);
+            float triangleArea = cross.length();
+            centre             = Vector3f::multiplyAdd(Vector3f(a + b + c), triangleArea / 3.0f, centre);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentre += centre;
+        meshArea += area;
+        clusterCentres[cluster] = area > 0.0f ? Vector3f(centre / area) : centre;
+        clusterNormals[cluster] = normal;
+    }
+    if (meshArea > 0.0f)
+        meshCentre /= meshArea;
+
+    // Draw the clusters facing furthest outwards first (with the original
+    // order kept for equal values so the result is deterministic)
+    std::vector<float> sortValues(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        float length        = clusterNormals[cluster].length();
+        sortValues[cluster] = length > 0.0f ? Vector3f(clusterCentres[cluster] - meshCentre).dot(clusterNormals[cluster]) / length : 0.0f;
+        order[cluster]      = static_cast<uint32_t>(cluster);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortValues[a] > sortValues[b]; });
+
+    uint32_t* current = destination;
+    for (uint32_t cluster : order)
+        current = std::copy(indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3, current);
+}
+
+void MeshOptimiser::optimiseOverdraw(MeshData* data, float threshold, unsigned int cacheSize) {
+    size_t offset, stride;
+    std::vector<float>* stream = data->getStream(MeshData::POSITION, offset, stride);
+    if (data->getNumDimensions() != MeshData::DIMENSIONS_3D || ! stream || ! data->hasIndices())
+        return;
+
+    uint32_t* indices = data->getIndices().data();
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+        optimiseOverdraw(indices + first, indices + first, last - first, stream->data() + offset + vertexOffset * stride, stride, threshold, cacheSize);
+    });
+}
+
+void MeshOptimiser::optimiseVertexFetch(MeshData* data) {
+    size_t vertexCount = data->getVertexCount();
+    if (vertexCount == 0 || ! data->hasIndices())
+        return;
+
+    // Vertices are only moved within the ranges that start at each vertex
+    // offset, so indices relative to any of them stay positive
+    std::vector<uint32_t> rangeStarts;
+    std::vector<uint32_t> vertexRanges;
+    findVertexRanges(data, rangeStarts, vertexRanges);
+
+    // New location of each vertex - the next free one in its range when it
+    // is first used
+    std::vector<uint32_t> next(rangeStarts);
+    std::vector<uint32_t> remap(vertexCount, NO_VERTEX);
+    std::vector<uint32_t>& indices = data->getIndices();
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+        for (size_t i = first; i < last; ++i) {
+            size_t vertex = static_cast<size_t>(indices[i]) + vertexOffset;
+            if (vertex >= vertexCount)
+                Logger::logAndThrowError("Index " + utils_string::str(indices[i]) + " is out of range of the " + utils_string::str(vertexCount) + " vertices", "MeshOptimiser");
+            if (remap[vertex] == NO_VERTEX)
+                remap[vertex] = next[vertexRanges[vertex]]++;
+            indices[i] = remap[vertex] - vertexOffset;
+        }
+    });
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (remap[vertex] == NO_VERTEX)
+            remap[vertex] = next[vertexRanges[vertex]]++;
+    }
+
+    remapVertices(data->getPositions(), remap);
+    remapVertices(data->getColours(), remap);
+    remapVertices(data->getTextureCoords(), remap);
+    remapVertices(data->getNormals(), remap);
+    remapVertices(data->getTangents(), remap);
+    remapVertices(data->getBitangents(), remap);
+    remapVertices(data->getOthers(), remap);
+    remapVertices(data->getBoneIndices(), remap);
+    remapVertices(data->getBoneWeights(), remap);
+    remapVertices(data->getMaterialIndices(), remap);
+    remapVertices(data->getOffsetIndices(), remap);
+
+    for (uint32_t& vertex : data->getMeshletVertices())
+        vertex = remap[vertex];
+
+    // Levels of detail use the same vertices
+    std::vector<uint32_t>& lodIndices = data->getLODIndices();
+    for (unsigned int lod = 0; lod < data->getLODs().size(); ++lod) {
+        for (unsigned int i = 0; i < std::max(data->getSubDataCount(), static_cast<size_t>(1)); ++i) {
+            size_t first, last;
+            data->getLODSubDataRange(lod, i, first, last);
+            uint32_t vertexOffset = data->hasSubData() ? data->getSubData(i).vertexOffset : 0;
+            for (size_t index = first; index < last; ++index)
+                lodIndices[index] = remap[lodIndices[index] + vertexOffset] - vertexOffset;
+        }
+    }
+}
+
+void MeshOptimiser::buildMeshlets(MeshData* data, unsigned int maxVertices, unsigned int maxTriangles) {
+    if (maxVertices < 3 || maxVertices > 256 || maxTriangles == 0)
+        Logger::logAndThrowError("Invalid meshlet limits (" + utils_string::str(maxVertices) + " vertices, " + utils_string::str(maxTriangles) + " triangles)", "MeshOptimiser");
+
+    data->getMeshlets().clear();
+    data->getMeshletBounds().clear();
+    data->getMeshletVertices().clear();
+    data->getMeshletTriangles().clear();
+
+    size_t offset, stride;
+    std::vector<float>* stream = data->getStream(MeshData::POSITION, offset, stride);
+    if (! stream)
+        return;
+    const float* positions = stream->data() + offset;
+
+    // Meshes without indices are treated as having an index for each vertex
+    std::vector<uint32_t> sequentialIndices;
+    const uint32_t* indices = data->getIndices().data();
+    if (! data->hasIndices()) {
+        sequentialIndices.resize(data->getVertexCount());
+        std::iota(sequentialIndices.begin(), sequentialIndices.end(), 0);
+        indices = sequentialIndices.data();
+    }
+
+    // Split each sub data into blocks
+    std::vector<MeshletBlock> blocks;
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+        if ((last - first) % 3 != 0)
+            Logger::logAndThrowError("Number of indices (" + utils_string::str(last - first) + ") is not a multiple of 3", "MeshOptimiser");
+        for (size_t triangle = first / 3; triangle < last / 3; triangle += MESHLET_BLOCK_TRIANGLES) {
+            MeshletBlock block;
+            block.indices       = indices + triangle * 3;
+            block.triangleCount = std::min(MESHLET_BLOCK_TRIANGLES, last / 3 - triangle);
+            block.vertexOffset  = vertexOffset;
+            blocks.push_back(std::move(block));
+        }
+    });
+
+    // Build the blocks using a thread per hardware thread
+    std::atomic<size_t> nextBlock(0);
+    auto buildBlocks = [&]() {
+        std::vector<uint32_t> vertexMap(data->getVertexCount(), NO_VERTEX);
+        for (size_t i = nextBlock++; i < blocks.size(); i = nextBlock++)
+            buildMeshletBlock(blocks[i], positions, stride, data->getNumDimensions(), maxVertices, maxTriangles, vertexMap);
+    };
+    size_t threads = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), blocks.size());
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 1; i < threads; ++i)
+        tasks.push_back(std::async(std::launch::async, buildBlocks));
+    buildBlocks();
+    for (std::future<void>& task : tasks)
+        task.get();
+
+    // Combine the results
+    for (MeshletBlock& block : blocks) {
+        uint32_t vertexOffset   = static_cast<uint32_t>(data->getMeshletVertices().size());
+        uint32_t triangleOffset = static_cast<uint32_t>(data->getMeshletTriangles().size());
+        for (MeshData::Meshlet meshlet : block.meshlets) {
+            meshlet.vertexOffset += vertexOffset;
+            meshlet.triangleOffset += triangleOffset;
+            data->getMeshlets().push_back(meshlet);
+        }
+        data->getMeshletBounds().insert(data->getMeshletBounds().end(), block.bounds.begin(), block.bounds.end());
+        data->getMeshletVertices().insert(data->getMeshletVertices().end(), block.vertices.begin(), block.vertices.end());
+        data->getMeshletTriangles().insert(data->getMeshletTriangles().end(), block.triangles.begin(), block.triangles.end());
+    }
+}
+
+void MeshOptimiser::generateLODs(MeshData* data, unsigned int count, float ratio, float maxError) {
+    if (ratio <= 0.0f || ratio >= 1.0f)
+        Logger::logAndThrowError("Invalid level of detail ratio (" + utils_string::str(ratio) + ")", "MeshOptimiser");
+
+    std::vector<MeshData::LOD>& lods              = data->getLODs();
+    std::vector<uint32_t>& lodIndices             = data->getLODIndices();
+    std::vector<uint32_t>& lodSubDataFirstIndices = data->getLODSubDataFirstIndices();
+    lods.clear();
+    lodIndices.clear();
+    lodSubDataFirstIndices.clear();
+
+    size_t offset, stride;
+    std::vector<float>* stream = data->getStream(MeshData::POSITION, offset, stride);
+    if (! stream || ! data->hasIndices() || count == 0)
+        return;
+
+    // Gather the triangles of every sub data with their vertex offsets added
+    // so shared positions can be found across all of them
+    size_t vertexCount                    = data->getVertexCount();
+    const std::vector<uint32_t>& original = data->getIndices();
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> triangleSubData;
+    std::vector<uint32_t> vertexOffsets;
+    indices.reserve(original.size());
+    triangleSubData.reserve(original.size() / 3);
+    forEachSubDataRange(data, [&](size_t first, size_t last, uint32_t vertexOffset) {
+        if ((last - first) % 3 != 0)
+            Logger::logAndThrowError("Number of indices (" + utils_string::str(last - first) + ") is not a multiple of 3", "MeshOptimiser");
+        for (size_t i = first; i < last; ++i) {
+            size_t vertex = static_cast<size_t>(original[i]) + vertexOffset;
+            if (vertex >= vertexCount)
+                Logger::logAndThrowError("Index " + utils_string::str(original[i]) + " is out of range of the " + utils_string::str(vertexCount) + " vertices", "MeshOptimiser");
+            indices.push_back(static_cast<uint32_t>(vertex));
+        }
+        triangleSubData.insert(triangleSubData.end(), (last - first) / 3, static_cast<uint32_t>(vertexOffsets.size()));
+        vertexOffsets.push_back(vertexOffset);
+    });
+
+    LODSimplifier simplifier(stream->data() + offset, stride, data->getNumDimensions(), vertexCount, indices, triangleSubData);
+    double maxCost = static_cast<double>(maxError) * maxError;
+    double target  = static_cast<double>(simplifier.getTriangleCount());
+    for (unsigned int lod = 0; lod < count; ++lod) {
+        size_t previousCount = simplifier.getTriangleCount();
+        target *= ratio;
+        simplifier.simplify(static_cast<size_t>(target), maxCost);
+
+        // Stop once a level would barely be simpler than the one before
+        size_t triangleCount = simplifier.getTriangleCount();
+        if (triangleCount == 0 || triangleCount > previousCount * LOD_MIN_REDUCTION)
+            break;
+
+        // Add the level with each sub data in turn made relative to its
+        // vertex offset again, then ordered for the vertex cache
+        MeshData::LOD level;
+        level.firstIndex = static_cast<uint32_t>(lodIndices.size());
+        level.error      = static_cast<float>(std::sqrt(simplifier.cost));
+        size_t triangle  = 0;
+        for (uint32_t subData = 0; subData < vertexOffsets.size(); ++subData) {
+            size_t first = lodIndices.size();
+            if (data->hasSubData())
+                lodSubDataFirstIndices.push_back(static_cast<uint32_t>(first));
+            for (; triangle < triangleCount && simplifier.triangleSubData[triangle] == subData; ++triangle) {
+                for (unsigned int corner = 0; corner < 3; ++corner)
+                    lodIndices.push_back(simplifier.indices[triangle * 3 + corner] - vertexOffsets[subData]);
+            }
+            optimiseVertexCache(lodIndices.data() + first, lodIndices.data() + first, lodIndices.size() - first);
+        }
+        level.indexCount = static_cast<uint32_t>(lodIndices.size() - level.firstIndex);
+        lods.push_back(level);
+
+        Logger::log("LOD " + utils_string::str(lod + 1) + " has " + utils_string::str(triangleCount) + " triangles (error " + utils_string::str(level.error) + ")", "MeshOptimiser", LogType::Debug);
+    }
+}
@@ -19,8 +19,7 @@ RenderData::~RenderData() {
         delete ibo;
 }
 
-void RenderData::render(VkCommandBuffer commandBuffer) {
-    // Bind the vertex buffers
+void RenderData::bindVertexBuffers(VkCommandBuffer commandBuffer) {
     // TODO: Use offsets for materials
     // TODO: Allow instances
     // TODO: Stop doing this here (unless need multiple for each frame in flight)
@@ -29,6 +28,11 @@ void RenderData::render(VkCommandBuffer commandBuffer) {
         vertexBufferInstances[i] = vbos[i]->getCurrentBuffer()->getVkInstance();
 
     vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<uint32_t>(vertexBufferInstances.size()), vertexBufferInstances.data(), offsets);
+}
+
+void RenderData::render(VkCommandBuffer commandBuffer) {
+    // Bind the vertex buffers
+    bindVertexBuffers(commandBuffer);
 
     // Check if have indices
     if (ibo) {
@@ -41,3 +45,10 @@ void RenderData::render(VkCommandBuffer commandBuffer) {
         vkCmdDraw(commandBuffer, count, instanceCount, 0, 0);
     }
 }
+
+void RenderData::render(VkCommandBuffer commandBuffer, IBO* ibo, uint32_t firstIndex, uint32_t count) {
+    bindVertexBuffers(commandBuffer);
+
+    ibo->bind(commandBuffer);
+    vkCmdDrawIndexed(commandBuffer, count, instanceCount, firstIndex, 0, 0);
+}
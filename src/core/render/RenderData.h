@@ -27,6 +27,9 @@ private:
     /* Instance count */
     uint32_t instanceCount = 1;
 
+    /* Binds the vertex buffers */
+    void bindVertexBuffers(VkCommandBuffer commandBuffer);
+
 public:
     /* Constructor and destructor */
     RenderData(std::vector<VBO*> vbos, IBO* ibo, uint32_t count);
@@ -35,6 +38,11 @@ public:
     /* Issues the command to render this mesh */
     void render(VkCommandBuffer commandBuffer);
 
+    /* Issues the command to render count indices starting at firstIndex
+       from another index buffer that uses the same vertices (e.g. a level
+       of detail) */
+    void render(VkCommandBuffer commandBuffer, IBO* ibo, uint32_t firstIndex, uint32_t count);
+
     /* Assigns the number of instances to render */
     inline void setInstanceCount(uint32_t instanceCount) { this->instanceCount = instanceCount; }
 };
\ No newline at end of file
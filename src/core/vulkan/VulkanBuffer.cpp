@@ -4,7 +4,7 @@
  * VulkanBuffer class
  *****************************************************************************/
 
-VulkanBuffer::VulkanBuffer(VulkanDevice* device, VkDeviceSize size, void* data, VkBufferUsageFlags usage, VkSharingMode sharingMode, bool deviceLocal, bool persistent) : VulkanResource(device), size(size), persistentMapping(persistentMapping) {
+VulkanBuffer::VulkanBuffer(VulkanDevice* device, VkDeviceSize size, void* data, VkBufferUsageFlags usage, VkSharingMode sharingMode, bool deviceLocal, bool persistent) : VulkanResource(device), size(size), persistentMapping(persistent) {
     // Create the buffer
     // TODO: Try and get rid of need for VK_BUFFER_USAGE_TRANSFER_DST_BIT -
     //       trouble is cant be sure of supported memoryTypeBits until
@@ -54,10 +54,7 @@ VulkanBuffer::~VulkanBuffer() {
     device->freeMemory(memory);
 }
 
-void VulkanBuffer::copy(const void* data, VkDeviceSize size, VkDeviceMemory deviceMemory) {
-    // Ensure the size is okay
-    if (size > this->size)
-        Logger::logAndThrowError("Cannot copy of size " + utils_string::str(size) + " into buffer of smaller size " + utils_string::str(this->size), "VulkanBuffer");
+void VulkanBuffer::copy(const void* data, VkDeviceSize size, VkDeviceMemory deviceMemory, VkDeviceSize offset) {
     // Map memory and copy
     // This method requires memory with the flag
     // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT to ensure it will finish copying
@@ -66,19 +63,19 @@ void VulkanBuffer::copy(const void* data, VkDeviceSize size, VkDeviceMemory devi
     // TODO: Look at these and other types of memory flags
 
     if (persistentMapping)
-        memcpy(mappedMemory, data, static_cast<size_t>(size));
+        memcpy(static_cast<uint8_t*>(mappedMemory) + offset, data, static_cast<size_t>(size));
     else {
         void* mappedMemory;
-        vkMapMemory(device->getVkLogical(), deviceMemory, 0, size, 0, &mappedMemory);
+        vkMapMemory(device->getVkLogical(), deviceMemory, offset, size, 0, &mappedMemory);
         memcpy(mappedMemory, data, static_cast<size_t>(size));
         vkUnmapMemory(device->getVkLogical(), deviceMemory);
     }
 }
 
-void VulkanBuffer::copy(const void* data, VkDeviceSize size) {
+void VulkanBuffer::copy(const void* data, VkDeviceSize size, VkDeviceSize offset) {
     // Ensure the size is okay
-    if (size > this->size)
-        Logger::logAndThrowError("Cannot copy of size " + utils_string::str(size) + " into buffer of smaller size " + utils_string::str(this->size), "VulkanBuffer");
+    if (offset > this->size || size > this->size - offset)
+        Logger::logAndThrowError("Cannot copy of size " + utils_string::str(size) + " at offset " + utils_string::str(offset) + " into buffer of smaller size " + utils_string::str(this->size), "VulkanBuffer");
 
     // Check for staging
     if (stagingNeeded) {
@@ -89,15 +86,15 @@ void VulkanBuffer::copy(const void* data, VkDeviceSize size) {
         device->allocateBufferMemory(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBufferMemory);
 
         // Copy data into the staging buffer
-        copy(data, size, stagingBufferMemory);
+        copy(data, size, stagingBufferMemory, 0);
 
         // Copy dta to the actual buffer being used
-        device->copyBuffer(stagingBuffer, instance, size);
+        device->copyBuffer(stagingBuffer, instance, size, offset);
 
         // Free staging resources
         device->destroyBuffer(stagingBuffer);
         device->freeMemory(stagingBufferMemory);
     } else
         // Copy directly
-        copy(data, size, memory);
+        copy(data, size, memory, offset);
 }
\ No newline at end of file
@@ -35,16 +35,16 @@ private:
     /* Descriptor buffer info - only used for descriptor sets */
     VkDescriptorBufferInfo bufferInfo;
 
-    /* Copies data into some device memory */
-    void copy(const void* data, VkDeviceSize size, VkDeviceMemory deviceMemory);
+    /* Copies data into some device memory at an offset (in bytes) */
+    void copy(const void* data, VkDeviceSize size, VkDeviceMemory deviceMemory, VkDeviceSize offset);
 
 public:
     /* Constructor and destructor (data can be nullptr) */
     VulkanBuffer(VulkanDevice* device, VkDeviceSize size, void* data, VkBufferUsageFlags usage, VkSharingMode sharingMode, bool deviceLocal, bool persistentMapping);
     virtual ~VulkanBuffer();
 
-    /* Copies data into the buffer */
-    void copy(const void* data, VkDeviceSize size);
+    /* Copies data into the buffer starting at an offset (in bytes) */
+    void copy(const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
 
     /* Returns the Vulkan instance of this buffer */
     inline VkBuffer getVkInstance() { return instance; }
@@ -279,13 +279,13 @@ void VulkanDevice::endSingleTimeGraphicsCommands(VkCommandBuffer commandBuffer)
     vkFreeCommandBuffers(logicalDevice, graphicsCommandPool, 1, &commandBuffer);
 }
 
-void VulkanDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+void VulkanDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
     // Copy the buffer using a new command buffer
     VkCommandBuffer commandBuffer = beginSingleTimeGraphicsCommands();
 
     VkBufferCopy copyRegion{};
     copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
+    copyRegion.dstOffset = dstOffset;
     copyRegion.size      = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -298,8 +298,9 @@ public:
        before waiting for the queue to become idle */
     void endSingleTimeGraphicsCommands(VkCommandBuffer commandBuffer);
 
-    /* Uses the graphics queue to copy one buffer into another */
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    /* Uses the graphics queue to copy one buffer into another (starting at
+       dstOffset bytes into it) */
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
 
     /* Re-queries swap chain support and updates the support info */
     inline void requerySwapChainSupport(VkSurfaceKHR windowSurface) {
@@ -1,5 +1,15 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "FileUtils.h"
 
+#include <cstring>
 #include <fstream>
 #include <boost/filesystem.hpp>
 
@@ -32,4 +42,139 @@ std::vector<char> utils_file::readBinChar(const std::string& path) {
 
 bool utils_file::isFile(const std::string& path) {
     return boost::filesystem::is_regular_file(path.c_str());
-}
\ No newline at end of file
+}
+
+void utils_file::createDirectories(const std::string& path) {
+    boost::filesystem::create_directories(path.c_str());
+}
+
+/* Constants and mixing functions used by hash (based on xxHash64) */
+static const uint64_t HASH_PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t HASH_PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t HASH_PRIME3 = 0x165667B19E3779F9ull;
+static const uint64_t HASH_PRIME4 = 0x85EBCA77C2B2AE63ull;
+
+static inline uint64_t rotateLeft(uint64_t value, unsigned int amount) {
+    return (value << amount) | (value >> (64 - amount));
+}
+
+static inline uint64_t hashRound(uint64_t accumulator, uint64_t value) {
+    return rotateLeft(accumulator + value * HASH_PRIME2, 31) * HASH_PRIME1;
+}
+
+uint64_t utils_file::hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* end   = bytes + size;
+
+    // Four independent accumulators for blocks of 32 bytes, so large files
+    // aren't limited by the latency of a single chain of multiplies
+    uint64_t result;
+    if (size >= 32) {
+        uint64_t accumulators[4] = {seed + HASH_PRIME1 + HASH_PRIME2, seed + HASH_PRIME2, seed, seed - HASH_PRIME1};
+        for (; bytes + 32 <= end; bytes += 32) {
+            for (unsigned int i = 0; i < 4; ++i) {
+                uint64_t value;
+                memcpy(&value, bytes + i * 8, sizeof(value));
+                accumulators[i] = hashRound(accumulators[i], value);
+            }
+        }
+        result = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) + rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18);
+        for (unsigned int i = 0; i < 4; ++i)
+            result = (result ^ hashRound(0, accumulators[i])) * HASH_PRIME1 + HASH_PRIME4;
+    } else
+        result = seed + HASH_PRIME3;
+    result += static_cast<uint64_t>(size);
+
+    // Remaining bytes (8 and then 1 at a time)
+    for (; bytes + 8 <= end; bytes += 8) {
+        uint64_t value;
+        memcpy(&value, bytes, sizeof(value));
+        result = rotateLeft(result ^ hashRound(0, value), 27) * HASH_PRIME1 + HASH_PRIME4;
+    }
+    for (; bytes < end; ++bytes)
+        result = rotateLeft(result ^ (*bytes * HASH_PRIME3), 11) * HASH_PRIME1;
+
+    // Mix the bits so every input bit affects every output bit
+    result ^= result >> 33;
+    result *= HASH_PRIME2;
+    result ^= result >> 29;
+    result *= HASH_PRIME3;
+    result ^= result >> 32;
+    return result;
+}
+
+uint64_t utils_file::hashFile(const std::string& path) {
+    // Hash the file in place when possible (falling back to reading it,
+    // which also reports missing files)
+    MappedFile file;
+    if (file.open(path))
+        return hash(file.getData(), file.getSize());
+    std::vector<char> contents = readBinChar(path);
+    return hash(contents.data(), contents.size());
+}
+
+/*****************************************************************************
+ * MappedFile class
+ *****************************************************************************/
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (! GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle)
+        data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileStat.st_size);
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapped != MAP_FAILED)
+        data = static_cast<const char*>(mapped);
+#endif
+    if (! data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+#else
+    if (data)
+        munmap(const_cast<char*>(data), size);
+    if (fileDescriptor >= 0)
+        ::close(fileDescriptor);
+#endif
+    data           = nullptr;
+    size           = 0;
+    fileHandle     = nullptr;
+    mappingHandle  = nullptr;
+    fileDescriptor = -1;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -13,4 +14,52 @@ namespace utils_file {
 
     /* Returns whether the specefied path is a file */
     bool isFile(const std::string& path);
-};  // namespace utils_file
\ No newline at end of file
+
+    /* Creates a directory (along with any missing parents) */
+    void createDirectories(const std::string& path);
+
+    /* Returns a 64 bit hash of some data or of the contents of a file (fast
+       rather than cryptographic - intended for noticing when an asset has
+       changed) */
+    uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+    uint64_t hashFile(const std::string& path);
+};  // namespace utils_file
+
+/*****************************************************************************
+ * MappedFile class - Maps the contents of a file into memory (read only) so
+ *                    it can be accessed without reading it all in first
+ *****************************************************************************/
+
+class MappedFile {
+private:
+    /* Mapped contents of the file */
+    const char* data = nullptr;
+    size_t size      = 0;
+
+    /* Handles for the file and mapping (only the file descriptor is used on
+       platforms other than Windows) */
+    void* fileHandle    = nullptr;
+    void* mappingHandle = nullptr;
+    int fileDescriptor  = -1;
+
+public:
+    /* Constructor and destructor */
+    MappedFile() {}
+    virtual ~MappedFile() { close(); }
+
+    /* A mapping can't be shared */
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    /* Maps a file, returning whether it succeeded (fails for empty files as
+       they can't be mapped) */
+    bool open(const std::string& path);
+
+    /* Unmaps the file */
+    void close();
+
+    /* Getters */
+    inline bool isOpen() const { return data != nullptr; }
+    inline const char* getData() const { return data; }
+    inline size_t getSize() const { return size; }
+};
\ No newline at end of file